@@ -0,0 +1,250 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file async_log.c
+/// @brief Asynchronous low-latency logger built on SPSC rings (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <utils/spsc_ring/spsc_ring.h>
+
+#include "async_log.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Longest formatted message. Longer ones are truncated.
+#define MAX_LINE 256
+
+/* === Private data type declarations ========================================================== */
+
+/// Record layout in the rings. Only the used arguments are stored.
+typedef struct
+{
+    const char* fmt;                    ///< Format string, which doubles as the message id.
+    uint64_t count;                     ///< Number of arguments that follow.
+    uint64_t args[ASYNC_LOG_MAX_ARGS];  ///< Arguments.
+} record_t;
+
+/// Record header size, i.e. the part that is always present.
+#define RECORD_HEADER_SIZE offsetof(record_t, args)
+
+/// Slot of the calling thread, valid for one logger generation.
+typedef struct
+{
+    unsigned int generation;  ///< Logger generation the slot belongs to, 0 if none.
+    int slot;                 ///< Index in `rings`, or -1 if the thread could not get one.
+} thread_slot_t;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static spsc_ring_t thread_ring(void);
+static void write_all(const char* data, size_t len);
+static size_t drain_rings(void);
+static void* logger_thread(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+/// Per-thread rings and their storage. Ring pointers are published with release semantics.
+static _Atomic(spsc_ring_t) rings[ASYNC_LOG_MAX_THREADS];
+static uint8_t* containers[ASYNC_LOG_MAX_THREADS];
+#if defined(UTILS_NO_HEAP)
+static uint8_t storage[ASYNC_LOG_MAX_THREADS][ASYNC_LOG_RING_SIZE];
+#endif
+static atomic_uint registered = 0;
+
+/// Bumped on every init, so threads re-register after a restart.
+static atomic_uint generation = 0;
+static _Thread_local thread_slot_t current = {0, -1};
+
+static atomic_bool running = false;
+static atomic_uint_fast64_t dropped = 0;
+static pthread_t thread;
+static int output_fd = -1;
+
+/// Output batch, only touched by whoever drains the rings.
+static char batch[ASYNC_LOG_BATCH_SIZE];
+static size_t batch_len = 0;
+
+/* === Private function implementation ========================================================= */
+
+static spsc_ring_t thread_ring(void)
+{
+    unsigned int gen = atomic_load_explicit(&generation, memory_order_acquire);
+
+    if (current.generation != gen) {
+        current.generation = gen;
+        current.slot = -1;
+
+        unsigned int slot = atomic_fetch_add_explicit(&registered, 1, memory_order_relaxed);
+        if (slot >= ASYNC_LOG_MAX_THREADS) { return NULL; }
+
+#if defined(UTILS_NO_HEAP)
+        containers[slot] = storage[slot];
+#else
+        containers[slot] = malloc(ASYNC_LOG_RING_SIZE);
+        assert(containers[slot]);
+#endif
+        atomic_store_explicit(&rings[slot], spsc_ring_init(containers[slot], ASYNC_LOG_RING_SIZE),
+                              memory_order_release);
+        current.slot = (int)slot;
+    }
+
+    return (current.slot < 0) ? NULL : atomic_load_explicit(&rings[current.slot], memory_order_relaxed);
+}
+
+static void write_all(const char* data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(output_fd, data, len);
+        if (n <= 0) { return; }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+static size_t drain_rings(void)
+{
+    size_t records = 0;
+    unsigned int count = atomic_load_explicit(&registered, memory_order_relaxed);
+
+    if (count > ASYNC_LOG_MAX_THREADS) { count = ASYNC_LOG_MAX_THREADS; }
+
+    for (unsigned int i = 0; i < count; i++) {
+        spsc_ring_t rb = atomic_load_explicit(&rings[i], memory_order_acquire);
+        if (!rb) { continue; }
+
+        record_t record;
+
+        // Records are written all or nothing, so a present header means its arguments are there too.
+        while (spsc_ring_read(rb, (uint8_t*)&record, RECORD_HEADER_SIZE) == RECORD_HEADER_SIZE) {
+            spsc_ring_read(rb, (uint8_t*)record.args, record.count * sizeof(uint64_t));
+
+            if (sizeof(batch) - batch_len < MAX_LINE) {
+                write_all(batch, batch_len);
+                batch_len = 0;
+            }
+
+            // ASYNC_LOG() checked the format against 64-bit arguments, so reading four is safe whatever it holds.
+            int n = snprintf(&batch[batch_len], MAX_LINE, record.fmt, record.args[0], record.args[1], record.args[2],
+                             record.args[3]);
+            if (n > 0) { batch_len += ((size_t)n < MAX_LINE) ? (size_t)n : MAX_LINE - 1; }
+
+            records++;
+        }
+    }
+
+    if (batch_len > 0) {
+        write_all(batch, batch_len);
+        batch_len = 0;
+    }
+
+    return records;
+}
+
+static void* logger_thread(void* arg)
+{
+    (void)arg;
+    struct timespec idle = {.tv_sec = 0, .tv_nsec = ASYNC_LOG_IDLE_US * 1000L};
+
+    while (atomic_load_explicit(&running, memory_order_acquire)) {
+        if (drain_rings() == 0) { nanosleep(&idle, NULL); }
+    }
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+int async_log_init(int fd)
+{
+    assert(fd >= 0 && !atomic_load(&running));
+
+    output_fd = fd;
+    atomic_store(&dropped, 0);
+    atomic_store(&registered, 0);
+    atomic_fetch_add_explicit(&generation, 1, memory_order_release);
+    atomic_store_explicit(&running, true, memory_order_release);
+
+    if (pthread_create(&thread, NULL, logger_thread, NULL) != 0) {
+        atomic_store(&running, false);
+        return -1;
+    }
+
+    return 0;
+}
+
+void async_log_deinit(void)
+{
+    if (!atomic_load(&running)) { return; }
+
+    atomic_store_explicit(&running, false, memory_order_release);
+    pthread_join(thread, NULL);
+
+    // Anything logged before the call is still in the rings.
+    drain_rings();
+
+    unsigned int count = atomic_load(&registered);
+    if (count > ASYNC_LOG_MAX_THREADS) { count = ASYNC_LOG_MAX_THREADS; }
+
+    for (unsigned int i = 0; i < count; i++) {
+        spsc_ring_t rb = atomic_exchange(&rings[i], NULL);
+        if (rb) { spsc_ring_deinit(&rb); }
+#if !defined(UTILS_NO_HEAP)
+        free(containers[i]);
+#endif
+        containers[i] = NULL;
+    }
+
+    atomic_store(&registered, 0);
+    atomic_fetch_add_explicit(&generation, 1, memory_order_release);
+}
+
+void async_log_write(const char* fmt, const uint64_t* args, size_t count)
+{
+    assert(fmt && count <= ASYNC_LOG_MAX_ARGS);
+
+    spsc_ring_t rb = atomic_load_explicit(&running, memory_order_relaxed) ? thread_ring() : NULL;
+    record_t record = {.fmt = fmt, .count = count};
+
+    for (size_t i = 0; i < count; i++) { record.args[i] = args[i]; }
+
+    if (!rb || spsc_ring_write(rb, (const uint8_t*)&record, RECORD_HEADER_SIZE + count * sizeof(uint64_t)) != 0) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+    }
+}
+
+uint64_t async_log_dropped(void) { return atomic_load_explicit(&dropped, memory_order_relaxed); }
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,154 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file async_log.h
+/// @brief Asynchronous low-latency logger built on SPSC rings.
+///
+/// Logging from a hot thread only copies the address of the format string (its id) and up to
+/// ASYNC_LOG_MAX_ARGS integer arguments into a per-thread spsc_ring: no formatting, no locks and no
+/// syscalls. A background thread formats the records and writes them to the output in batches. When
+/// a thread's ring is full the record is dropped and counted, the caller never blocks.
+///
+/// Arguments are stored as uint64_t and formatted later against the stored format string, so the only
+/// conversions allowed are the 64-bit ones from <inttypes.h> (`PRIu64`, `PRId64`, `PRIx64`, `PRIX64`,
+/// `PRIo64`, e.g. `"port %" PRIu64 " stalled\n"`), one per argument. Pointers must be cast to uintptr_t,
+/// and strings are not supported. ASYNC_LOG() checks this at compile time, as an error, on compilers
+/// with printf format checking (GCC and Clang).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+/// Maximum number of arguments per log call.
+#define ASYNC_LOG_MAX_ARGS 4
+
+#ifndef ASYNC_LOG_RING_SIZE
+/// Size of each thread's ring, in bytes. Must be a power of two.
+#define ASYNC_LOG_RING_SIZE 16384
+#endif
+
+#ifndef ASYNC_LOG_MAX_THREADS
+/// Maximum number of logging threads. Calls from further threads are dropped.
+#define ASYNC_LOG_MAX_THREADS 16
+#endif
+
+/// Size of the output batch the background thread fills before each write().
+#define ASYNC_LOG_BATCH_SIZE 4096
+
+/// Sleep time of the background thread when every ring is empty, in microseconds.
+#define ASYNC_LOG_IDLE_US 1000
+
+///
+/// @brief Logs a message. @p fmt must be a string literal, followed by up to ASYNC_LOG_MAX_ARGS integer arguments.
+///
+/// @p fmt is checked against the arguments converted to uint64_t, as they will be when it is formatted.
+///
+#define ASYNC_LOG(fmt, ...)                                                                     \
+    do {                                                                                        \
+        ASYNC_LOG_CHECK_FORMAT_(fmt, ##__VA_ARGS__);                                            \
+        async_log_write("" fmt, (const uint64_t[]){0, ##__VA_ARGS__} + 1,                       \
+                        (sizeof((const uint64_t[]){0, ##__VA_ARGS__}) / sizeof(uint64_t)) - 1); \
+    } while (0)
+
+/// Never evaluated: only there for the compiler to check the format of the call it is given.
+#define ASYNC_LOG_CHECK_FORMAT_(fmt, ...)                                         \
+    _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic error \"-Wformat\"")   \
+        (void)(0 && async_log_check_format_(fmt ASYNC_LOG_AS_U64_(__VA_ARGS__))); \
+    _Pragma("GCC diagnostic pop")
+
+/// Arguments, with a leading comma and converted to uint64_t.
+#define ASYNC_LOG_AS_U64_(...) ASYNC_LOG_CAT_(ASYNC_LOG_AS_U64_, ASYNC_LOG_NARGS_(__VA_ARGS__))(__VA_ARGS__)
+
+/// Number of arguments, from 0 to 4.
+#define ASYNC_LOG_NARGS_(...) ASYNC_LOG_NARGS_PICK_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define ASYNC_LOG_NARGS_PICK_(_0, _1, _2, _3, _4, n, ...) n
+
+#define ASYNC_LOG_CAT_(a, b) ASYNC_LOG_CAT2_(a, b)
+#define ASYNC_LOG_CAT2_(a, b) a##b
+
+#define ASYNC_LOG_AS_U64_0()
+#define ASYNC_LOG_AS_U64_1(a) , (uint64_t)(a)
+#define ASYNC_LOG_AS_U64_2(a, b) , (uint64_t)(a), (uint64_t)(b)
+#define ASYNC_LOG_AS_U64_3(a, b, c) , (uint64_t)(a), (uint64_t)(b), (uint64_t)(c)
+#define ASYNC_LOG_AS_U64_4(a, b, c, d) , (uint64_t)(a), (uint64_t)(b), (uint64_t)(c), (uint64_t)(d)
+
+/* === Public data type declarations =========================================================== */
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Does nothing. Only called from ASYNC_LOG(), in code that never runs, to have its format checked.
+///
+#if defined(__GNUC__)
+__attribute__((format(printf, 1, 2)))
+#endif
+static inline int async_log_check_format_(const char* fmt, ...)
+{
+    (void)fmt;
+    return 0;
+}
+
+///
+/// @brief Starts the background thread.
+/// @param fd File descriptor the formatted messages are written to.
+/// @return 0 on success, or -1 if the thread could not be started.
+///
+int async_log_init(int fd);
+
+///
+/// @brief Stops the background thread after writing out every pending record, and frees the rings.
+///
+/// Logging threads must be done logging.
+///
+void async_log_deinit(void);
+
+///
+/// @brief Queues a record in the calling thread's ring. Prefer the ASYNC_LOG() macro.
+/// @param fmt Format string. Must outlive the logger (use literals).
+/// @param args Arguments.
+/// @param count Number of arguments, at most ASYNC_LOG_MAX_ARGS.
+///
+void async_log_write(const char* fmt, const uint64_t* args, size_t count);
+
+///
+/// @brief Returns the number of records dropped since async_log_init(), because a ring was full, too many threads
+/// were logging, or the logger was not running. Still valid after async_log_deinit().
+///
+uint64_t async_log_dropped(void);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
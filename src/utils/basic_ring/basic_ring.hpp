@@ -0,0 +1,449 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file basic_ring.hpp
+/// @brief Ring template for C++ callers, composed from policies.
+///
+/// The C rings each fix one combination of choices: ring_buffer is unsynchronized and overwrites the
+/// oldest byte when full, spsc_ring is lock-free for one producer and one consumer and rejects new
+/// bytes. basic_ring makes every choice a template parameter: the concurrency model, what a full ring
+/// does, the width of its indices and whether it keeps statistics. Policies are empty types selected
+/// at compile time, so a given instantiation carries no flags, no dead branches and no storage for
+/// the features it does not use, and compiles to the same code as a ring written by hand for it.
+///
+/// Indices are free-running counters of the chosen width, masked into the storage, so Capacity must
+/// be a power of two no larger than half the index range: a `std::uint8_t` index allows up to 128
+/// elements. Elements must be trivially copyable and are stored inline.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+/* === Public data type declarations =========================================================== */
+
+namespace utils {
+
+namespace ring_policy {
+
+/// No synchronization: a single thread, or callers masking the ISR around accesses, like ring_buffer.
+struct unsync {};
+
+/// One producer and one consumer, lock-free, like spsc_ring.
+struct spsc {};
+
+/// Any number of producers and one consumer, lock-free. Each slot carries a sequence number telling
+/// whether its producer is done with it.
+struct mpsc {};
+
+/// A full ring refuses new elements, like spsc_ring.
+struct reject {};
+
+/// A full ring drops its oldest element to make room, like ring_buffer. Only with unsync, since the
+/// producer has to move the consumer's index.
+struct overwrite {};
+
+/// No statistics.
+struct no_stats {};
+
+/// Counts elements pushed, popped and refused or overwritten. Each counter is written from one side
+/// only, so it costs a plain increment except for the producers of an mpsc ring.
+struct stats {};
+
+}  // namespace ring_policy
+
+/// Statistics of a ring built with ring_policy::stats.
+struct ring_stats
+{
+    std::uint64_t pushed;     ///< Elements written.
+    std::uint64_t popped;     ///< Elements read.
+    std::uint64_t overflows;  ///< Elements refused (reject) or dropped (overwrite).
+};
+
+namespace detail {
+
+/// Size of the blocks kept apart to avoid false sharing between the producer and the consumer.
+inline constexpr std::size_t ring_cache_line = 64;
+
+template <class Concurrency, class Index>
+using ring_index_cell = std::conditional_t<std::is_same_v<Concurrency, ring_policy::unsync>, Index, std::atomic<Index>>;
+
+template <class Index> inline Index ring_load(const Index& cell, std::memory_order) { return cell; }
+
+template <class Index> inline Index ring_load(const std::atomic<Index>& cell, std::memory_order order)
+{
+    return cell.load(order);
+}
+
+template <class Index> inline void ring_store(Index& cell, Index value, std::memory_order) { cell = value; }
+
+template <class Index> inline void ring_store(std::atomic<Index>& cell, Index value, std::memory_order order)
+{
+    cell.store(value, order);
+}
+
+struct pushed_tag {};
+struct popped_tag {};
+struct overflow_tag {};
+
+/// One statistics counter. Empty, and free, unless statistics are enabled. `Tag` keeps the counters of
+/// a side distinct base classes, so the empty ones take no room.
+template <class Stats, class Concurrency, class Tag> struct ring_counter
+{
+    void count(std::uint64_t) {}
+    std::uint64_t counted() const { return 0; }
+};
+
+template <class Concurrency, class Tag> struct ring_counter<ring_policy::stats, Concurrency, Tag>
+{
+    ring_index_cell<Concurrency, std::uint64_t> value{};
+
+    void count(std::uint64_t n)
+    {
+        if constexpr (std::is_same_v<Concurrency, ring_policy::mpsc> && !std::is_same_v<Tag, popped_tag>) {
+            value.fetch_add(n, std::memory_order_relaxed);
+        } else {
+            // Single writer: a plain increment, published with a relaxed store when others may read it.
+            ring_store(value, ring_load(value, std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t counted() const { return ring_load(value, std::memory_order_relaxed); }
+};
+
+/// Per-slot sequence numbers, only needed by the mpsc policy.
+template <class Concurrency, class Index, std::size_t Capacity> struct ring_sequences
+{
+    void reset() {}
+};
+
+template <class Index, std::size_t Capacity> struct ring_sequences<ring_policy::mpsc, Index, Capacity>
+{
+    std::atomic<Index> sequence[Capacity];
+
+    void reset()
+    {
+        for (std::size_t i = 0; i < Capacity; i++) {
+            sequence[i].store(static_cast<Index>(i), std::memory_order_relaxed);
+        }
+    }
+};
+
+/// Producer-owned state.
+template <class Concurrency, class Index, class Stats>
+struct alignas(std::is_same_v<Concurrency, ring_policy::unsync> ? alignof(Index) : ring_cache_line) ring_producer
+    : ring_counter<Stats, Concurrency, pushed_tag>,
+      ring_counter<Stats, Concurrency, overflow_tag>
+{
+    ring_index_cell<Concurrency, Index> head{};
+};
+
+/// Consumer-owned state.
+template <class Concurrency, class Index, class Stats>
+struct alignas(std::is_same_v<Concurrency, ring_policy::unsync> ? alignof(Index) : ring_cache_line) ring_consumer
+    : ring_counter<Stats, Concurrency, popped_tag>
+{
+    ring_index_cell<Concurrency, Index> tail{};
+};
+
+}  // namespace detail
+
+///
+/// @brief Fixed-capacity ring of trivially copyable elements, composed from policies.
+///
+/// @tparam T Element type.
+/// @tparam Capacity Number of elements, a power of two.
+/// @tparam Concurrency ring_policy::unsync, ring_policy::spsc or ring_policy::mpsc.
+/// @tparam Overflow ring_policy::reject or ring_policy::overwrite.
+/// @tparam Index Unsigned type of the free-running indices, e.g. `std::uint8_t` on small MCUs.
+/// @tparam Stats ring_policy::no_stats or ring_policy::stats.
+///
+template <class T, std::size_t Capacity, class Concurrency = ring_policy::spsc, class Overflow = ring_policy::reject,
+          class Index = std::size_t, class Stats = ring_policy::no_stats>
+class basic_ring : private detail::ring_sequences<Concurrency, Index, Capacity>
+{
+    static constexpr bool is_unsync = std::is_same_v<Concurrency, ring_policy::unsync>;
+    static constexpr bool is_mpsc = std::is_same_v<Concurrency, ring_policy::mpsc>;
+    static constexpr bool overwrites = std::is_same_v<Overflow, ring_policy::overwrite>;
+    static constexpr Index mask = static_cast<Index>(Capacity - 1);
+
+    static_assert(std::is_trivially_copyable_v<T>, "elements are copied around as raw memory");
+    static_assert(is_unsync || is_mpsc || std::is_same_v<Concurrency, ring_policy::spsc>,
+                  "unknown concurrency policy");
+    static_assert(overwrites || std::is_same_v<Overflow, ring_policy::reject>, "unknown overflow policy");
+    static_assert(std::is_same_v<Stats, ring_policy::stats> || std::is_same_v<Stats, ring_policy::no_stats>,
+                  "unknown statistics policy");
+    static_assert(!overwrites || is_unsync, "overwriting moves the consumer's index: only with ring_policy::unsync");
+    static_assert(std::is_unsigned_v<Index>, "indices must be unsigned");
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert(Capacity <= (static_cast<std::size_t>(std::numeric_limits<Index>::max()) >> 1) + 1,
+                  "capacity must not exceed half the index range");
+    static_assert(!is_mpsc || std::atomic<Index>::is_always_lock_free, "index type has no lock-free atomics");
+
+  public:
+    using value_type = T;
+    using index_type = Index;
+
+    basic_ring() { this->reset(); }
+
+    basic_ring(const basic_ring&) = delete;
+    basic_ring& operator=(const basic_ring&) = delete;
+
+    /// Returns the number of elements the ring holds when full.
+    static constexpr std::size_t capacity() { return Capacity; }
+
+    ///
+    /// @brief Returns the number of elements in the ring.
+    ///
+    /// Exact from the consumer. From elsewhere, or with producers of an mpsc ring mid-push, a hint.
+    ///
+    std::size_t size() const
+    {
+        Index head = detail::ring_load(producer_.head, std::memory_order_acquire);
+        Index tail = detail::ring_load(consumer_.tail, std::memory_order_acquire);
+        return static_cast<Index>(head - tail);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    bool full() const { return size() == Capacity; }
+
+    ///
+    /// @brief Appends an element. From a producer.
+    /// @return true, or false if the ring is full and refuses it.
+    ///
+    bool push(const T& value)
+    {
+        if constexpr (is_mpsc) {
+            if (push_shared(value)) { return true; }
+            counter<detail::overflow_tag>(producer_).count(1);
+            return false;
+        } else {
+            Index head = detail::ring_load(producer_.head, std::memory_order_relaxed);
+            Index tail = detail::ring_load(consumer_.tail, std::memory_order_acquire);
+
+            if (static_cast<Index>(head - tail) == Capacity) {
+                counter<detail::overflow_tag>(producer_).count(1);
+                if constexpr (!overwrites) { return false; }
+                detail::ring_store(consumer_.tail, static_cast<Index>(tail + 1), std::memory_order_relaxed);
+            }
+
+            slots_[head & mask] = value;
+            detail::ring_store(producer_.head, static_cast<Index>(head + 1), std::memory_order_release);
+            counter<detail::pushed_tag>(producer_).count(1);
+            return true;
+        }
+    }
+
+    ///
+    /// @brief Removes the oldest element. From the consumer.
+    /// @return true, or false if the ring is empty.
+    ///
+    bool pop(T& value)
+    {
+        Index tail = detail::ring_load(consumer_.tail, std::memory_order_relaxed);
+
+        if constexpr (is_mpsc) {
+            Index seq = this->sequence[tail & mask].load(std::memory_order_acquire);
+            if (seq != static_cast<Index>(tail + 1)) { return false; }
+
+            value = slots_[tail & mask];
+            this->sequence[tail & mask].store(static_cast<Index>(tail + Capacity), std::memory_order_release);
+        } else {
+            Index head = detail::ring_load(producer_.head, std::memory_order_acquire);
+            if (head == tail) { return false; }
+
+            value = slots_[tail & mask];
+        }
+
+        detail::ring_store(consumer_.tail, static_cast<Index>(tail + 1), std::memory_order_release);
+        counter<detail::popped_tag>(consumer_).count(1);
+        return true;
+    }
+
+    ///
+    /// @brief Appends a block of elements. From a producer.
+    ///
+    /// With overwrite, the whole block goes in, and if it is larger than the ring only its tail is kept.
+    /// With reject, as much of it as fits. The producers of an mpsc ring may interleave their blocks.
+    ///
+    /// @return Number of elements written.
+    ///
+    std::size_t write(const T* data, std::size_t count)
+    {
+        if constexpr (is_mpsc) {
+            std::size_t written = 0;
+            while (written < count && push_shared(data[written])) { written++; }
+            if (written < count) { counter<detail::overflow_tag>(producer_).count(count - written); }
+            return written;
+        } else {
+            Index head = detail::ring_load(producer_.head, std::memory_order_relaxed);
+            Index tail = detail::ring_load(consumer_.tail, std::memory_order_acquire);
+            std::size_t room = Capacity - static_cast<Index>(head - tail);
+            std::size_t accepted = count;
+
+            if constexpr (overwrites) {
+                if (count > Capacity) {
+                    data += count - Capacity;
+                    count = Capacity;
+                }
+                if (count > room) {
+                    detail::ring_store(consumer_.tail, static_cast<Index>(tail + (count - room)),
+                                       std::memory_order_relaxed);
+                }
+                counter<detail::overflow_tag>(producer_).count((accepted > room) ? accepted - room : 0);
+            } else {
+                if (count > room) {
+                    counter<detail::overflow_tag>(producer_).count(count - room);
+                    count = room;
+                    accepted = room;
+                }
+            }
+
+            copy_in(head, data, count);
+            detail::ring_store(producer_.head, static_cast<Index>(head + count), std::memory_order_release);
+            counter<detail::pushed_tag>(producer_).count(accepted);
+            return accepted;
+        }
+    }
+
+    ///
+    /// @brief Removes up to @p count of the oldest elements. From the consumer.
+    /// @return Number of elements read.
+    ///
+    std::size_t read(T* data, std::size_t count)
+    {
+        if constexpr (is_mpsc) {
+            std::size_t read = 0;
+            while (read < count && pop(data[read])) { read++; }
+            return read;
+        } else {
+            Index tail = detail::ring_load(consumer_.tail, std::memory_order_relaxed);
+            Index head = detail::ring_load(producer_.head, std::memory_order_acquire);
+            std::size_t available = static_cast<Index>(head - tail);
+
+            if (count > available) { count = available; }
+
+            std::size_t offset = tail & mask;
+            std::size_t first = (count < Capacity - offset) ? count : Capacity - offset;
+            std::memcpy(data, &slots_[offset], first * sizeof(T));
+            std::memcpy(data + first, &slots_[0], (count - first) * sizeof(T));
+
+            detail::ring_store(consumer_.tail, static_cast<Index>(tail + count), std::memory_order_release);
+            counter<detail::popped_tag>(consumer_).count(count);
+            return count;
+        }
+    }
+
+    ///
+    /// @brief Discards every element. Only for unsync rings, where nobody else can be using it.
+    ///
+    void clear()
+    {
+        static_assert(is_unsync, "clearing a shared ring would race with its other side");
+        consumer_.tail = producer_.head;
+    }
+
+    ///
+    /// @brief Returns the statistics. Exact once both sides are idle, a hint meanwhile.
+    ///
+    ring_stats stats() const
+    {
+        static_assert(std::is_same_v<Stats, ring_policy::stats>, "built without ring_policy::stats");
+        return {counter<detail::pushed_tag>(producer_).counted(), counter<detail::popped_tag>(consumer_).counted(),
+                counter<detail::overflow_tag>(producer_).counted()};
+    }
+
+  private:
+    using producer_t = detail::ring_producer<Concurrency, Index, Stats>;
+    using consumer_t = detail::ring_consumer<Concurrency, Index, Stats>;
+
+    template <class Tag, class Side> static auto& counter(Side& side)
+    {
+        return static_cast<detail::ring_counter<Stats, Concurrency, Tag>&>(side);
+    }
+
+    template <class Tag, class Side> static const auto& counter(const Side& side)
+    {
+        return static_cast<const detail::ring_counter<Stats, Concurrency, Tag>&>(side);
+    }
+
+    /// Claims the head slot against the other producers, then publishes it through its sequence number.
+    bool push_shared(const T& value)
+    {
+        Index head = producer_.head.load(std::memory_order_relaxed);
+
+        for (;;) {
+            Index seq = this->sequence[head & mask].load(std::memory_order_acquire);
+            auto lag = static_cast<std::make_signed_t<Index>>(static_cast<Index>(seq - head));
+
+            if (lag == 0) {
+                Index next = static_cast<Index>(head + 1);
+                if (producer_.head.compare_exchange_weak(head, next, std::memory_order_relaxed)) { break; }
+            } else if (lag < 0) {
+                // The slot still holds an element the consumer has not taken: full.
+                return false;
+            } else {
+                head = producer_.head.load(std::memory_order_relaxed);
+            }
+        }
+
+        slots_[head & mask] = value;
+        this->sequence[head & mask].store(static_cast<Index>(head + 1), std::memory_order_release);
+        counter<detail::pushed_tag>(producer_).count(1);
+        return true;
+    }
+
+    void copy_in(Index head, const T* data, std::size_t count)
+    {
+        std::size_t offset = head & mask;
+        std::size_t first = (count < Capacity - offset) ? count : Capacity - offset;
+        std::memcpy(&slots_[offset], data, first * sizeof(T));
+        std::memcpy(&slots_[0], data + first, (count - first) * sizeof(T));
+    }
+
+    producer_t producer_;
+    consumer_t consumer_;
+    T slots_[Capacity];
+};
+
+/// Same behaviour as ring_buffer: bytes, unsynchronized, overwriting the oldest when full.
+template <std::size_t Capacity>
+using byte_ring = basic_ring<std::uint8_t, Capacity, ring_policy::unsync, ring_policy::overwrite>;
+
+/// Same behaviour as spsc_ring: bytes, one producer and one consumer, refusing data when full.
+template <std::size_t Capacity>
+using spsc_byte_ring = basic_ring<std::uint8_t, Capacity, ring_policy::spsc, ring_policy::reject>;
+
+/// Message queue fed by several threads, e.g. the per-port workers, and drained by one.
+template <class T, std::size_t Capacity> using mpsc_queue = basic_ring<T, Capacity, ring_policy::mpsc>;
+
+}  // namespace utils
+
+/* === End of documentation ==================================================================== */
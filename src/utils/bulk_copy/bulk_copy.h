@@ -0,0 +1,263 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file bulk_copy.h
+/// @brief Bulk copies into and out of ring backing arrays.
+///
+/// Shared by the ring implementations for their block operations: a copy that may wrap around the end
+/// of the backing array, done in at most two pieces.
+///
+/// Copies into a ring at or above a size threshold use non-temporal (streaming) stores, which bypass
+/// the cache: a multi-megabyte dump written into a large ring is not read again by the producing core,
+/// and copying it through the cache would evict everything hot, including other rings' indices and
+/// data. Streaming stores are weakly ordered, so the copy ends with a store fence and the caller's
+/// release store still publishes the data correctly.
+///
+/// Reads and scans of large rings prefetch a configurable distance ahead of the bytes being walked.
+/// Hardware prefetchers follow a sequential walk well within a page, but they lose it at page
+/// boundaries and at the wrap back to the start of the array, which on a ring larger than the last
+/// level cache means a stall on every page.
+///
+/// Header-only, so the threshold check costs nothing on the small writes that make up most traffic.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef BULK_COPY_STREAM_THRESHOLD
+/// Default size from which copies into a ring use streaming stores, in bytes. Well above the L2 size of
+/// current cores: smaller copies are likely to be read back while still cached. Can be overridden at
+/// build time, and per ring at runtime.
+#define BULK_COPY_STREAM_THRESHOLD (256U * 1024U)
+#endif
+
+/// Threshold value that disables streaming stores.
+#define BULK_COPY_NO_STREAM SIZE_MAX
+
+#ifndef BULK_COPY_PREFETCH_DISTANCE
+/// Default distance reads and scans prefetch ahead, in bytes. 0 disables prefetching. Can be overridden
+/// at build time, and per ring at runtime.
+#define BULK_COPY_PREFETCH_DISTANCE 512U
+#endif
+
+/// Cache line size assumed when prefetching.
+#define BULK_COPY_LINE_SIZE 64U
+
+/* === Public data type declarations =========================================================== */
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Copies with non-temporal stores where the architecture has them, with memcpy() elsewhere.
+/// @param dst Destination.
+/// @param src Source.
+/// @param len Number of bytes to copy.
+///
+static inline void bulk_copy_stream(uint8_t* dst, const uint8_t* src, size_t len)
+{
+#if defined(__SSE2__)
+    // Streaming stores need 16-byte aligned destinations: copy the head normally.
+    size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+    if (head > len) { head = len; }
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    len -= head;
+
+    // Full cache lines, so the write-combining buffers are flushed whole.
+    for (; len >= 64; len -= 64, dst += 64, src += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)src);
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + 48));
+        _mm_stream_si128((__m128i*)dst, a);
+        _mm_stream_si128((__m128i*)(dst + 16), b);
+        _mm_stream_si128((__m128i*)(dst + 32), c);
+        _mm_stream_si128((__m128i*)(dst + 48), d);
+    }
+    for (; len >= 16; len -= 16, dst += 16, src += 16) {
+        _mm_stream_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+    }
+    memcpy(dst, src, len);
+
+    // Order the streaming stores before the caller publishes them.
+    _mm_sfence();
+#else
+    memcpy(dst, src, len);
+#endif
+}
+
+///
+/// @brief Copies a block into a ring backing array, wrapping around its end.
+/// @param buffer Backing array.
+/// @param capacity Size of @p buffer.
+/// @param offset Position of the first byte to write, below @p capacity.
+/// @param data Data to copy.
+/// @param len Number of bytes to copy, up to @p capacity.
+/// @param stream_threshold Size from which streaming stores are used, BULK_COPY_NO_STREAM to never use them.
+///
+static inline void bulk_copy_in(uint8_t* buffer, size_t capacity, size_t offset, const uint8_t* data, size_t len,
+                                size_t stream_threshold)
+{
+    size_t first = capacity - offset;
+
+    if (first > len) { first = len; }
+
+    if (len >= stream_threshold) {
+        bulk_copy_stream(&buffer[offset], data, first);
+        bulk_copy_stream(buffer, &data[first], len - first);
+    } else {
+        memcpy(&buffer[offset], data, first);
+        memcpy(buffer, &data[first], len - first);
+    }
+}
+
+///
+/// @brief Prefetches a range of a ring backing array, wrapping around its end.
+/// @param buffer Backing array.
+/// @param capacity Size of @p buffer.
+/// @param offset Position of the first byte, below @p capacity.
+/// @param len Number of bytes, up to @p capacity.
+/// @param for_write Whether the lines are about to be written rather than read.
+///
+static inline void bulk_copy_prefetch(const uint8_t* buffer, size_t capacity, size_t offset, size_t len,
+                                      bool for_write)
+{
+#if defined(__GNUC__)
+    for (size_t done = 0; done < len; done += BULK_COPY_LINE_SIZE) {
+        size_t at = offset + done;
+        if (at >= capacity) { at -= capacity; }
+
+        if (for_write) {
+            __builtin_prefetch(&buffer[at], 1, 3);
+        } else {
+            __builtin_prefetch(&buffer[at], 0, 3);
+        }
+    }
+#else
+    (void)buffer;
+    (void)capacity;
+    (void)offset;
+    (void)len;
+    (void)for_write;
+#endif
+}
+
+///
+/// @brief Copies a block out of a ring backing array, wrapping around its end.
+///
+/// Copies in windows of @p prefetch_distance bytes, prefetching the next window before copying the
+/// current one.
+///
+/// @param buffer Backing array.
+/// @param capacity Size of @p buffer.
+/// @param offset Position of the first byte to read, below @p capacity.
+/// @param out Destination.
+/// @param len Number of bytes to copy, up to @p capacity.
+/// @param prefetch_distance Prefetch distance in bytes, 0 to copy without prefetching.
+///
+static inline void bulk_copy_out(const uint8_t* buffer, size_t capacity, size_t offset, uint8_t* out, size_t len,
+                                 size_t prefetch_distance)
+{
+    size_t window = (prefetch_distance && prefetch_distance < len) ? prefetch_distance : len;
+
+    for (size_t done = 0; done < len; done += window) {
+        size_t chunk = (len - done < window) ? len - done : window;
+        size_t at = offset + done;
+        if (at >= capacity) { at -= capacity; }
+
+        size_t next = at + chunk;
+        if (next >= capacity) { next -= capacity; }
+        if (done + chunk < len) {
+            size_t ahead = len - done - chunk;
+            bulk_copy_prefetch(buffer, capacity, next, ahead < window ? ahead : window, false);
+        }
+
+        size_t first = capacity - at;
+        if (first > chunk) { first = chunk; }
+        memcpy(&out[done], &buffer[at], first);
+        memcpy(&out[done + first], buffer, chunk - first);
+    }
+}
+
+///
+/// @brief Looks for a byte in a range of a ring backing array, wrapping around its end.
+/// @param buffer Backing array.
+/// @param capacity Size of @p buffer.
+/// @param offset Position of the first byte to scan, below @p capacity.
+/// @param len Number of bytes to scan, up to @p capacity.
+/// @param value Byte to look for.
+/// @param prefetch_distance Prefetch distance in bytes, 0 to scan without prefetching.
+/// @return Position of the first match relative to @p offset, or @p len if there is none.
+///
+static inline size_t bulk_copy_find(const uint8_t* buffer, size_t capacity, size_t offset, size_t len, uint8_t value,
+                                    size_t prefetch_distance)
+{
+    size_t window = (prefetch_distance && prefetch_distance < len) ? prefetch_distance : len;
+
+    for (size_t done = 0; done < len; done += window) {
+        size_t chunk = (len - done < window) ? len - done : window;
+        size_t at = offset + done;
+        if (at >= capacity) { at -= capacity; }
+
+        size_t next = at + chunk;
+        if (next >= capacity) { next -= capacity; }
+        if (done + chunk < len) {
+            size_t ahead = len - done - chunk;
+            bulk_copy_prefetch(buffer, capacity, next, ahead < window ? ahead : window, false);
+        }
+
+        size_t first = capacity - at;
+        if (first > chunk) { first = chunk; }
+
+        const uint8_t* match = memchr(&buffer[at], value, first);
+        if (match) { return done + (size_t)(match - &buffer[at]); }
+        match = memchr(buffer, value, chunk - first);
+        if (match) { return done + first + (size_t)(match - buffer); }
+    }
+
+    return len;
+}
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,250 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file core_runtime.c
+/// @brief Thread-per-core runtime with a mesh of cross-core message rings (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <utils/obj_pool/obj_pool.h>
+#include <utils/spsc_ring/spsc_ring.h>
+
+#include "core_runtime.h"
+
+/* === Macros definitions ====================================================================== */
+/* === Private data type declarations ========================================================== */
+
+/// Message header in the rings, followed by the payload.
+typedef uint16_t message_len_t;
+
+/// Argument of each worker thread.
+typedef struct
+{
+    core_runtime_t rt;  ///< Owning runtime.
+    size_t core;        ///< Core run by the thread.
+    pthread_t thread;   ///< Worker thread.
+} worker_t;
+
+///
+/// @brief Structure representing a runtime.
+///
+struct core_runtime_obj_t
+{
+    core_runtime_config_t config;                                         ///< Runtime parameters.
+    atomic_bool running;                                                  ///< Cleared to stop the workers.
+    size_t started;                                                       ///< Number of workers started.
+    spsc_ring_t rings[CORE_RUNTIME_MAX_CORES][CORE_RUNTIME_MAX_CORES];    ///< Mesh, indexed [from][to].
+    uint8_t* containers[CORE_RUNTIME_MAX_CORES][CORE_RUNTIME_MAX_CORES];  ///< Mesh ring storage.
+    worker_t workers[CORE_RUNTIME_MAX_CORES];                             ///< Workers.
+#if defined(UTILS_NO_HEAP)
+    /// Backing store of `containers`.
+    uint8_t storage[CORE_RUNTIME_MAX_CORES][CORE_RUNTIME_MAX_CORES][CORE_RUNTIME_RING_SIZE];
+#endif
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static void pin_thread(size_t core);
+static size_t receive(core_runtime_t rt, size_t core);
+static void* worker_thread(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(runtime_pool, core_runtime_obj_t, CORE_RUNTIME_POOL_SIZE)
+
+/// Core run by the calling thread, -1 outside the workers.
+static _Thread_local int current_core = -1;
+
+/* === Private function implementation ========================================================= */
+
+static void pin_thread(size_t core)
+{
+#if defined(__linux__)
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET((int)(core % (size_t)((cpus > 0) ? cpus : 1)), &set);
+
+    // Best effort: an unpinned worker is slower, not wrong.
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)core;
+#endif
+}
+
+static size_t receive(core_runtime_t rt, size_t core)
+{
+    uint8_t payload[CORE_RUNTIME_MAX_MESSAGE];
+    size_t count = 0;
+
+    for (size_t from = 0; from < rt->config.cores; from++) {
+        spsc_ring_t ring = rt->rings[from][core];
+        message_len_t len;
+
+        // Messages are written all or nothing, so a present header means its payload is there too.
+        while (spsc_ring_read(ring, (uint8_t*)&len, sizeof(len)) == sizeof(len)) {
+            spsc_ring_read(ring, payload, len);
+            rt->config.on_message(rt, rt->config.ctx, core, from, payload, len);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void* worker_thread(void* arg)
+{
+    worker_t* worker = arg;
+    core_runtime_t rt = worker->rt;
+    struct timespec idle = {.tv_sec = 0, .tv_nsec = CORE_RUNTIME_IDLE_US * 1000L};
+
+    current_core = (int)worker->core;
+    if (rt->config.pin) { pin_thread(worker->core); }
+
+    while (atomic_load_explicit(&rt->running, memory_order_acquire)) {
+        size_t work = receive(rt, worker->core);
+        if (rt->config.on_poll) { work += rt->config.on_poll(rt, rt->config.ctx, worker->core); }
+        if (work == 0) { nanosleep(&idle, NULL); }
+    }
+
+    current_core = -1;
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+core_runtime_t core_runtime_init(const core_runtime_config_t* config)
+{
+    assert(config && config->cores && config->cores <= CORE_RUNTIME_MAX_CORES && config->on_message);
+
+    core_runtime_t rt = runtime_pool_take();
+    assert(rt);
+
+    rt->config = *config;
+    atomic_init(&rt->running, true);
+    rt->started = 0;
+
+    for (size_t from = 0; from < config->cores; from++) {
+        for (size_t to = 0; to < config->cores; to++) {
+#if defined(UTILS_NO_HEAP)
+            rt->containers[from][to] = rt->storage[from][to];
+#else
+            rt->containers[from][to] = malloc(CORE_RUNTIME_RING_SIZE);
+            assert(rt->containers[from][to]);
+#endif
+            rt->rings[from][to] = spsc_ring_init(rt->containers[from][to], CORE_RUNTIME_RING_SIZE);
+        }
+    }
+
+    for (size_t core = 0; core < config->cores; core++) {
+        rt->workers[core].rt = rt;
+        rt->workers[core].core = core;
+    }
+
+    for (size_t core = 0; core < config->cores; core++) {
+        if (pthread_create(&rt->workers[core].thread, NULL, worker_thread, &rt->workers[core]) != 0) {
+            core_runtime_deinit(&rt);
+            return NULL;
+        }
+        rt->started++;
+    }
+
+    return rt;
+}
+
+void core_runtime_deinit(core_runtime_t* rt)
+{
+    assert(rt != NULL);
+
+    if (*rt) {
+        atomic_store_explicit(&(*rt)->running, false, memory_order_release);
+        for (size_t core = 0; core < (*rt)->started; core++) { pthread_join((*rt)->workers[core].thread, NULL); }
+
+        for (size_t from = 0; from < (*rt)->config.cores; from++) {
+            for (size_t to = 0; to < (*rt)->config.cores; to++) {
+                spsc_ring_deinit(&(*rt)->rings[from][to]);
+#if !defined(UTILS_NO_HEAP)
+                free((*rt)->containers[from][to]);
+#endif
+            }
+        }
+    }
+
+    runtime_pool_give(*rt);
+    *rt = NULL;
+}
+
+size_t core_runtime_cores(core_runtime_t rt)
+{
+    assert(rt);
+    return rt->config.cores;
+}
+
+size_t core_runtime_port_core(core_runtime_t rt, uint32_t port)
+{
+    assert(rt);
+
+    // Murmur3 finalizer: consecutive port numbers spread evenly over the cores.
+    port ^= port >> 16;
+    port *= 0x85EBCA6BU;
+    port ^= port >> 13;
+    port *= 0xC2B2AE35U;
+    port ^= port >> 16;
+
+    return port % rt->config.cores;
+}
+
+int core_runtime_current_core(void) { return current_core; }
+
+int core_runtime_send(core_runtime_t rt, size_t to, const void* data, size_t len)
+{
+    assert(rt && to < rt->config.cores && (data || !len) && len <= CORE_RUNTIME_MAX_MESSAGE);
+    assert(current_core >= 0);
+
+    uint8_t message[sizeof(message_len_t) + CORE_RUNTIME_MAX_MESSAGE];
+    message_len_t header = (message_len_t)len;
+
+    memcpy(message, &header, sizeof(header));
+    if (len) { memcpy(&message[sizeof(header)], data, len); }
+
+    return spsc_ring_write(rt->rings[current_core][to], message, sizeof(header) + len);
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,142 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file core_runtime.h
+/// @brief Thread-per-core runtime with a mesh of cross-core message rings.
+///
+/// Shared-nothing model: one worker thread per core, each owning the ports that hash to it. Workers
+/// never share state; they talk through an N×N mesh of spsc_ring, one per ordered pair of cores, so
+/// every ring has exactly one producer and one consumer and no lock is ever taken. Each worker loop
+/// drains the rings addressed to it, handing every message to the message callback, then calls the
+/// poll callback, where the core does its own work and sends messages.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef CORE_RUNTIME_POOL_SIZE
+/// Runtimes available when built with UTILS_NO_HEAP (see obj_pool.h). Each one takes cores² spsc_ring objects.
+#define CORE_RUNTIME_POOL_SIZE 1
+#endif
+
+/// Maximum number of cores.
+#define CORE_RUNTIME_MAX_CORES 16
+
+#ifndef CORE_RUNTIME_RING_SIZE
+/// Size of each mesh ring, in bytes. Must be a power of two.
+#define CORE_RUNTIME_RING_SIZE 4096
+#endif
+
+/// Largest message payload, in bytes.
+#define CORE_RUNTIME_MAX_MESSAGE 256
+
+/// Sleep time of a worker that had nothing to do, in microseconds.
+#define CORE_RUNTIME_IDLE_US 50
+
+/* === Public data type declarations =========================================================== */
+
+/// Opaque runtime structure
+typedef struct core_runtime_obj_t core_runtime_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef core_runtime_obj_t* core_runtime_t;
+
+/// Called on core @p core for every message sent to it by core @p from. Workers start before core_runtime_init()
+/// returns, so the callbacks get the runtime as @p rt instead of reading it from where the caller stores it.
+typedef void (*core_runtime_message_fn)(core_runtime_t rt, void* ctx, size_t core, size_t from, const uint8_t* data,
+                                        size_t len);
+
+/// Called on core @p core once per loop iteration. Returns the amount of work done, 0 if it was idle.
+typedef size_t (*core_runtime_poll_fn)(core_runtime_t rt, void* ctx, size_t core);
+
+/// Runtime parameters.
+typedef struct
+{
+    size_t cores;                        ///< Number of workers, at most CORE_RUNTIME_MAX_CORES.
+    bool pin;                            ///< Whether worker i is pinned to CPU i (modulo the online CPUs).
+    core_runtime_message_fn on_message;  ///< Message callback.
+    core_runtime_poll_fn on_poll;        ///< Poll callback, may be NULL.
+    void* ctx;                           ///< Argument for the callbacks.
+} core_runtime_config_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Creates the mesh and starts the workers.
+/// @param config Runtime parameters. Copied.
+/// @return The runtime, or NULL if the workers could not be started.
+///
+core_runtime_t core_runtime_init(const core_runtime_config_t* config);
+
+///
+/// @brief Stops the workers and frees the mesh. Messages not delivered yet are lost.
+/// @param rt Runtime to free. Set to NULL afterwards.
+///
+void core_runtime_deinit(core_runtime_t* rt);
+
+///
+/// @brief Returns the number of cores.
+/// @param rt Runtime to check.
+///
+size_t core_runtime_cores(core_runtime_t rt);
+
+///
+/// @brief Returns the core owning a port. Stable for a given number of cores.
+/// @param rt Runtime to check.
+/// @param port Port identifier.
+///
+size_t core_runtime_port_core(core_runtime_t rt, uint32_t port);
+
+///
+/// @brief Returns the core the calling thread runs, or -1 if it is not a worker.
+///
+int core_runtime_current_core(void);
+
+///
+/// @brief Sends a message from the calling worker to a core (itself included). Workers only.
+/// @param rt Runtime to use.
+/// @param to Destination core.
+/// @param data Payload.
+/// @param len Payload size, at most CORE_RUNTIME_MAX_MESSAGE.
+/// @return 0 on success, or -1 if the ring to @p to is full.
+///
+int core_runtime_send(core_runtime_t rt, size_t to, const void* data, size_t len);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
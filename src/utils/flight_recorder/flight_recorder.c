@@ -0,0 +1,326 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file flight_recorder.c
+/// @brief Per-thread binary flight recorder, dumped on crash (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <utils/tsc_clock/tsc_clock.h>
+
+#include "flight_recorder.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define RECORD_MASK (FLIGHT_RECORDER_RECORDS - 1U)
+
+/// Records copied per write() while dumping.
+#define DUMP_CHUNK_RECORDS 32
+
+/* === Private data type declarations ========================================================== */
+
+/// A record as stored in a ring: the sequence number is the only field read concurrently.
+typedef struct
+{
+    uint64_t cycles;           ///< See flight_recorder_record_t.
+    uint32_t event;            ///< See flight_recorder_record_t.
+    uint32_t thread;           ///< See flight_recorder_record_t.
+    uint64_t args[2];          ///< See flight_recorder_record_t.
+    atomic_uint_fast64_t seq;  ///< Position of the record plus one, or 0 while it is being written.
+} entry_t;
+
+/// A thread's ring. Only its owner writes to it.
+typedef struct
+{
+    atomic_bool owned;                         ///< Whether a live thread holds the slot.
+    atomic_uint_fast64_t head;                 ///< Records written so far, by this thread and the previous owners.
+    entry_t entries[FLIGHT_RECORDER_RECORDS];  ///< The most recent records, at their position modulo the size.
+} ring_t;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static ring_t* thread_ring(void);
+static void release_slot(void* value);
+static void create_slot_key(void);
+static void copy_entry(const entry_t* entry, uint64_t pos, flight_recorder_record_t* record);
+static int write_all(int fd, const void* data, size_t len);
+static void crash_handler(int sig);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+_Static_assert((FLIGHT_RECORDER_RECORDS & RECORD_MASK) == 0, "FLIGHT_RECORDER_RECORDS must be a power of two");
+
+/// Ring storage, statically allocated so that recording threads never fail to get one.
+static ring_t rings[FLIGHT_RECORDER_MAX_THREADS];
+
+/// Alternate signal stacks, one per slot.
+static _Alignas(16) uint8_t alt_stacks[FLIGHT_RECORDER_MAX_THREADS][FLIGHT_RECORDER_ALT_STACK_SIZE];
+
+/// Slot of the calling thread, or -1 if it hasn't recorded anything yet.
+static _Thread_local int current_slot = -1;
+
+/// Releases the slot of a thread when it exits. Its value is the slot plus one.
+static pthread_key_t slot_key;
+
+/// Whether flight_recorder_init() created `slot_key`.
+static atomic_bool slot_key_created = false;
+
+/// Creates `slot_key` once, however many times flight_recorder_init() is called.
+static pthread_once_t slot_key_once = PTHREAD_ONCE_INIT;
+
+/// Where the crash handler dumps to.
+static volatile sig_atomic_t crash_fd = -1;
+
+/* === Private function implementation ========================================================= */
+
+static ring_t* thread_ring(void)
+{
+    if (current_slot < 0) {
+        size_t slot = 0;
+        bool expected = false;
+
+        // Acquire pairs with the release in release_slot(): the previous owner's records happen before ours.
+        while (!atomic_compare_exchange_strong_explicit(&rings[slot].owned, &expected, true, memory_order_acquire,
+                                                        memory_order_relaxed)) {
+            expected = false;
+            if (++slot == FLIGHT_RECORDER_MAX_THREADS) { return NULL; }
+        }
+        current_slot = (int)slot;
+
+        if (atomic_load_explicit(&slot_key_created, memory_order_acquire)) {
+            pthread_setspecific(slot_key, (void*)(uintptr_t)(slot + 1));
+        }
+
+        // Without it, a stack overflow would fault again as soon as the crash handler runs.
+        stack_t ss;
+        if (sigaltstack(NULL, &ss) == 0 && (ss.ss_flags & SS_DISABLE)) {
+            ss.ss_sp = alt_stacks[slot];
+            ss.ss_size = sizeof(alt_stacks[slot]);
+            ss.ss_flags = 0;
+            sigaltstack(&ss, NULL);
+        }
+    }
+
+    return &rings[current_slot];
+}
+
+static void release_slot(void* value)
+{
+    size_t slot = (size_t)(uintptr_t)value - 1;
+
+    // The thread is gone: its stack must not be handed to the next owner while the kernel still points to it.
+    stack_t ss;
+    if (sigaltstack(NULL, &ss) == 0 && ss.ss_sp == alt_stacks[slot] && !(ss.ss_flags & SS_ONSTACK)) {
+        ss.ss_flags = SS_DISABLE;
+        sigaltstack(&ss, NULL);
+    }
+
+    // The records stay: they are still dumped, followed by those of the next owner.
+    current_slot = -1;
+    atomic_store_explicit(&rings[slot].owned, false, memory_order_release);
+}
+
+static void create_slot_key(void)
+{
+    if (pthread_key_create(&slot_key, release_slot) == 0) {
+        atomic_store_explicit(&slot_key_created, true, memory_order_release);
+    }
+}
+
+static void copy_entry(const entry_t* entry, uint64_t pos, flight_recorder_record_t* record)
+{
+    // Seqlock-style: the copy is only good if the sequence number was set and stayed the same across it.
+    uint64_t seq = atomic_load_explicit(&entry->seq, memory_order_acquire);
+
+    record->cycles = entry->cycles;
+    record->event = entry->event;
+    record->thread = entry->thread;
+    record->args[0] = entry->args[0];
+    record->args[1] = entry->args[1];
+
+    atomic_thread_fence(memory_order_acquire);
+    bool stable = atomic_load_explicit(&entry->seq, memory_order_relaxed) == seq;
+
+    record->seq = (stable && seq == pos + 1) ? seq : 0;
+}
+
+static int write_all(int fd, const void* data, size_t len)
+{
+    const uint8_t* p = data;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0) { return -1; }
+        p += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+static void crash_handler(int sig)
+{
+    if (crash_fd >= 0) { flight_recorder_dump(crash_fd); }
+
+    // SA_RESETHAND restored the default action: let it terminate the process (and dump core).
+    raise(sig);
+}
+
+/* === Public function implementation ========================================================== */
+
+int flight_recorder_init(void)
+{
+    pthread_once(&slot_key_once, create_slot_key);
+    flight_recorder_clear();
+
+    return atomic_load_explicit(&slot_key_created, memory_order_acquire) ? 0 : -1;
+}
+
+void flight_recorder_record(uint32_t event, uint64_t arg0, uint64_t arg1)
+{
+    ring_t* ring = thread_ring();
+    if (!ring) { return; }
+
+    uint64_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    entry_t* entry = &ring->entries[pos & RECORD_MASK];
+
+    // Invalidate the entry before touching it, so a dump never takes half of it for a whole record.
+    atomic_store_explicit(&entry->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    entry->cycles = tsc_clock_cycles();
+    entry->event = event;
+    entry->thread = (uint32_t)current_slot;
+    entry->args[0] = arg0;
+    entry->args[1] = arg1;
+
+    atomic_store_explicit(&entry->seq, pos + 1, memory_order_release);
+    atomic_store_explicit(&ring->head, pos + 1, memory_order_release);
+}
+
+int flight_recorder_dump(int fd)
+{
+    flight_recorder_record_t chunk[DUMP_CHUNK_RECORDS];
+    flight_recorder_header_t header = {
+        .magic = FLIGHT_RECORDER_MAGIC,
+        .record_size = sizeof(flight_recorder_record_t),
+        .ns_per_2_32 = tsc_clock_cycles_mult(),
+    };
+
+    if (write_all(fd, &header, sizeof(header)) != 0) { return -1; }
+
+    for (size_t i = 0; i < FLIGHT_RECORDER_MAX_THREADS; i++) {
+        // Copy rather than drain: the owner may still be recording, or have crashed in the middle of a record.
+        uint64_t head = atomic_load_explicit(&rings[i].head, memory_order_acquire);
+        uint64_t pos = (head > FLIGHT_RECORDER_RECORDS) ? head - FLIGHT_RECORDER_RECORDS : 0;
+
+        while (pos < head) {
+            size_t n = 0;
+            for (; n < DUMP_CHUNK_RECORDS && pos < head; n++, pos++) {
+                copy_entry(&rings[i].entries[pos & RECORD_MASK], pos, &chunk[n]);
+            }
+            if (write_all(fd, chunk, n * sizeof(chunk[0])) != 0) { return -1; }
+        }
+    }
+
+    return 0;
+}
+
+void flight_recorder_clear(void)
+{
+    for (size_t i = 0; i < FLIGHT_RECORDER_MAX_THREADS; i++) {
+        for (size_t j = 0; j < FLIGHT_RECORDER_RECORDS; j++) {
+            atomic_store_explicit(&rings[i].entries[j].seq, 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&rings[i].head, 0, memory_order_release);
+    }
+}
+
+int flight_recorder_install_crash_handler(int fd)
+{
+    static const int signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGABRT};
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = crash_handler;
+    sa.sa_flags = SA_RESETHAND | SA_NODEFER | SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+
+    crash_fd = fd;
+    (void)thread_ring();
+
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) {
+        if (sigaction(signals[i], &sa, NULL) != 0) { return -1; }
+    }
+
+    return 0;
+}
+
+int flight_recorder_decode(const uint8_t* dump, size_t len, FILE* out)
+{
+    assert(dump && out);
+
+    flight_recorder_header_t header;
+    flight_recorder_record_t record;
+
+    if (len < sizeof(header)) { return -1; }
+    memcpy(&header, dump, sizeof(header));
+    if (header.magic != FLIGHT_RECORDER_MAGIC || header.record_size != sizeof(record)) { return -1; }
+
+    // Timestamps are printed relative to the oldest record of the dump, whichever thread recorded it.
+    uint64_t origin = UINT64_MAX;
+    for (size_t offset = sizeof(header); offset + sizeof(record) <= len; offset += sizeof(record)) {
+        memcpy(&record, &dump[offset], sizeof(record));
+        if (record.seq != 0 && record.cycles < origin) { origin = record.cycles; }
+    }
+
+    int count = 0;
+
+    for (size_t offset = sizeof(header); offset + sizeof(record) <= len; offset += sizeof(record)) {
+        memcpy(&record, &dump[offset], sizeof(record));
+
+        // Torn: being written or overwritten while it was dumped.
+        if (record.seq == 0) { continue; }
+
+        uint64_t ns = (uint64_t)(((double)(record.cycles - origin) * (double)header.ns_per_2_32) / 4294967296.0);
+
+        fprintf(out, "[%" PRIu64 " ns] thread=%" PRIu32 " event=%" PRIu32 " args=0x%" PRIx64 ",0x%" PRIx64 "\n", ns,
+                record.thread, record.event, record.args[0], record.args[1]);
+        count++;
+    }
+
+    return count;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,157 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file flight_recorder.h
+/// @brief Per-thread binary flight recorder, dumped on crash.
+///
+/// Every thread gets its own ring of fixed-size binary trace records (timestamp in cycles, event id and
+/// two arguments), written in place and overwriting the oldest, so each ring always holds the most
+/// recent events. Recording takes no locks. The rings are static, one per slot; a thread claims a free
+/// slot the first time it records and gives it back when it exits, keeping its records in the ring
+/// for the next owner to append to. On SIGSEGV/SIGABRT an async-signal-safe routine writes
+/// every ring to a file descriptor, as is: raw cycle counts and the raw clock calibration, without
+/// touching the rings or waiting on anything. flight_recorder_decode() turns such a dump into text
+/// offline, converting the timestamps to nanoseconds.
+///
+/// The other threads keep recording while a dump is taken, and the crashed thread may have been in the
+/// middle of a record. Each record ends with its sequence number, cleared before the record is written
+/// and stored last: the dump zeroes it in records that changed while they were copied, and the decoder
+/// skips those.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef FLIGHT_RECORDER_MAX_THREADS
+/// Maximum number of threads that can record at the same time. Further threads' records are ignored.
+#define FLIGHT_RECORDER_MAX_THREADS 16
+#endif
+
+#ifndef FLIGHT_RECORDER_RECORDS
+/// Records kept per thread. Must be a power of two.
+#define FLIGHT_RECORDER_RECORDS 1024
+#endif
+
+#ifndef FLIGHT_RECORDER_ALT_STACK_SIZE
+/// Size of the alternate signal stack given to each recording thread, in bytes.
+#define FLIGHT_RECORDER_ALT_STACK_SIZE 16384
+#endif
+
+/// Magic number at the start of a dump ("FREC").
+#define FLIGHT_RECORDER_MAGIC 0x43455246U
+
+/* === Public data type declarations =========================================================== */
+
+/// A single trace record, as stored in the rings and in the dumps.
+typedef struct
+{
+    uint64_t cycles;   ///< tsc_clock_cycles() when the event was recorded.
+    uint32_t event;    ///< User-defined event identifier.
+    uint32_t thread;   ///< Recorder slot of the thread that recorded the event.
+    uint64_t args[2];  ///< User-defined arguments.
+    uint64_t seq;      ///< Position of the record in its thread's stream, from 1. 0 if it was torn when dumped.
+} flight_recorder_record_t;
+
+/// Dump header, followed by every thread's records, oldest first.
+typedef struct
+{
+    uint32_t magic;        ///< FLIGHT_RECORDER_MAGIC.
+    uint32_t record_size;  ///< sizeof(flight_recorder_record_t).
+    uint64_t ns_per_2_32;  ///< Nanoseconds per 2^32 cycles (tsc_clock_cycles_mult()), to convert timestamps offline.
+} flight_recorder_header_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Resets every ring and arranges for threads to give their slots back when they exit.
+///
+/// Call once at startup, before any thread records. Without it, slots are never released and threads
+/// started after the first FLIGHT_RECORDER_MAX_THREADS record nothing.
+///
+/// @return 0 on success, or -1 if slots can't be recycled.
+///
+int flight_recorder_init(void);
+
+///
+/// @brief Records an event in the calling thread's ring. Lock-free.
+///
+/// The first call from a thread claims a free recorder slot for it, along with an alternate signal stack so that
+/// the crash handler can still run after the thread overflows its own stack. A thread that already has an
+/// alternate stack keeps it.
+///
+/// @param event Event identifier.
+/// @param arg0 First argument.
+/// @param arg1 Second argument.
+///
+void flight_recorder_record(uint32_t event, uint64_t arg0, uint64_t arg1);
+
+///
+/// @brief Writes every thread's records to @p fd. Async-signal-safe. The rings are left as they are.
+/// @param fd File descriptor to write to.
+/// @return 0 on success, or -1 if a write failed.
+///
+int flight_recorder_dump(int fd);
+
+///
+/// @brief Discards every recorded event. Must not run concurrently with recording threads.
+///
+void flight_recorder_clear(void);
+
+///
+/// @brief Installs SIGSEGV, SIGBUS, SIGFPE and SIGABRT handlers that dump to @p fd and then re-raise the signal.
+///
+/// The handlers run on the alternate stack of the crashing thread, if it has one. The calling thread claims
+/// its recorder slot, and with it its alternate stack, right away.
+///
+/// @param fd File descriptor to dump to, opened in advance since open() can't be trusted after a crash.
+/// @return 0 on success, or -1 if a handler could not be installed.
+///
+int flight_recorder_install_crash_handler(int fd);
+
+///
+/// @brief Prints the records of a dump as text, one per line. Torn records are skipped.
+/// @param dump Dump contents.
+/// @param len Dump length, in bytes.
+/// @param out Where to print.
+/// @return Number of records printed, or -1 if @p dump is not a valid dump.
+///
+int flight_recorder_decode(const uint8_t* dump, size_t len, FILE* out);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,202 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file lz_block.c
+/// @brief LZ4-style block compression (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lz_block.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Shortest match worth encoding.
+#define MIN_MATCH 4
+
+/// Matches must not start within this many bytes of the end, which are always literals.
+#define END_LITERALS 12
+
+/// Longest offset a sequence can encode.
+#define MAX_OFFSET 65535
+
+/// Hash table size, as a power of two.
+#define HASH_BITS 12
+
+/* === Private data type declarations ========================================================== */
+
+/// Output cursor, stops writing once the capacity is exceeded.
+typedef struct
+{
+    uint8_t* data;    ///< Destination buffer.
+    size_t len;       ///< Bytes written so far.
+    size_t capacity;  ///< Size of the destination buffer.
+    bool overflow;    ///< Whether something did not fit.
+} output_t;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static uint32_t hash4(const uint8_t* p);
+static void put_bytes(output_t* out, const uint8_t* data, size_t len);
+static void put_length(output_t* out, size_t len);
+static void put_sequence(output_t* out, const uint8_t* literals, size_t literal_len, size_t offset, size_t match_len);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static uint32_t hash4(const uint8_t* p)
+{
+    uint32_t value;
+
+    memcpy(&value, p, sizeof(value));
+    return (value * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static void put_bytes(output_t* out, const uint8_t* data, size_t len)
+{
+    if (out->overflow || out->capacity - out->len < len) {
+        out->overflow = true;
+        return;
+    }
+
+    memcpy(&out->data[out->len], data, len);
+    out->len += len;
+}
+
+static void put_length(output_t* out, size_t len)
+{
+    // Lengths that overflow their nibble continue as a run of 255s and a final byte.
+    for (; len >= 255; len -= 255) { put_bytes(out, (const uint8_t[]){255}, 1); }
+    put_bytes(out, (const uint8_t[]){(uint8_t)len}, 1);
+}
+
+static void put_sequence(output_t* out, const uint8_t* literals, size_t literal_len, size_t offset, size_t match_len)
+{
+    size_t match_code = match_len ? match_len - MIN_MATCH : 0;
+    uint8_t token = (uint8_t)(((literal_len < 15 ? literal_len : 15) << 4) | (match_code < 15 ? match_code : 15));
+
+    put_bytes(out, &token, 1);
+    if (literal_len >= 15) { put_length(out, literal_len - 15); }
+    put_bytes(out, literals, literal_len);
+
+    // The last sequence has literals only.
+    if (match_len == 0) { return; }
+
+    put_bytes(out, (const uint8_t[]){(uint8_t)offset, (uint8_t)(offset >> 8)}, 2);
+    if (match_code >= 15) { put_length(out, match_code - 15); }
+}
+
+/* === Public function implementation ========================================================== */
+
+size_t lz_block_compress(const uint8_t* src, size_t len, uint8_t* dst, size_t capacity)
+{
+    assert((src || !len) && dst);
+
+    uint32_t table[1U << HASH_BITS];
+    output_t out = {.data = dst, .len = 0, .capacity = capacity, .overflow = false};
+    size_t anchor = 0;
+
+    memset(table, 0, sizeof(table));
+
+    for (size_t pos = 0; len > END_LITERALS && pos < len - END_LITERALS && !out.overflow;) {
+        uint32_t h = hash4(&src[pos]);
+        size_t candidate = table[h];
+        table[h] = (uint32_t)pos;
+
+        if (candidate >= pos || pos - candidate > MAX_OFFSET || memcmp(&src[candidate], &src[pos], MIN_MATCH) != 0) {
+            pos++;
+            continue;
+        }
+
+        size_t match_len = MIN_MATCH;
+        while (pos + match_len < len - END_LITERALS / 2 && src[candidate + match_len] == src[pos + match_len]) {
+            match_len++;
+        }
+
+        put_sequence(&out, &src[anchor], pos - anchor, pos - candidate, match_len);
+        pos += match_len;
+        anchor = pos;
+    }
+
+    put_sequence(&out, &src[anchor], len - anchor, 0, 0);
+
+    return out.overflow ? 0 : out.len;
+}
+
+long lz_block_decompress(const uint8_t* src, size_t len, uint8_t* dst, size_t capacity)
+{
+    assert((src || !len) && dst);
+
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < len) {
+        uint8_t token = src[in++];
+        size_t literal_len = token >> 4;
+
+        if (literal_len == 15) {
+            uint8_t byte;
+            do {
+                if (in >= len) { return -1; }
+                byte = src[in++];
+                literal_len += byte;
+            } while (byte == 255);
+        }
+
+        if (literal_len > len - in || literal_len > capacity - out) { return -1; }
+        memcpy(&dst[out], &src[in], literal_len);
+        in += literal_len;
+        out += literal_len;
+
+        if (in == len) { break; }
+
+        if (len - in < 2) { return -1; }
+        size_t offset = src[in] | ((size_t)src[in + 1] << 8);
+        in += 2;
+        if (offset == 0 || offset > out) { return -1; }
+
+        size_t match_len = (token & 0x0F) + MIN_MATCH;
+        if ((token & 0x0F) == 15) {
+            uint8_t byte;
+            do {
+                if (in >= len) { return -1; }
+                byte = src[in++];
+                match_len += byte;
+            } while (byte == 255);
+        }
+
+        if (match_len > capacity - out) { return -1; }
+
+        // Byte by byte: the match may overlap the bytes it produces (runs).
+        for (size_t i = 0; i < match_len; i++, out++) { dst[out] = dst[out - offset]; }
+    }
+
+    return (long)out;
+}
+
+/* === End of documentation ==================================================================== */
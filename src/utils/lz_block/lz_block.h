@@ -0,0 +1,74 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file lz_block.h
+/// @brief LZ4-style block compression.
+///
+/// Byte-oriented LZ77 in the LZ4 block layout: each sequence is a token (literal and match length
+/// nibbles), the literals, a 16-bit little-endian offset and the extra match length. Single-pass
+/// greedy matching over a small hash table, tuned for speed rather than ratio: meant for capture
+/// blocks full of repeated MIDI messages.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+/* === Public data type declarations =========================================================== */
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Compresses a block.
+/// @param src Data to compress.
+/// @param len Size of @p src.
+/// @param dst Destination buffer.
+/// @param capacity Size of @p dst.
+/// @return Compressed size, or 0 if it would not fit in @p capacity bytes.
+///
+size_t lz_block_compress(const uint8_t* src, size_t len, uint8_t* dst, size_t capacity);
+
+///
+/// @brief Decompresses a block.
+/// @param src Compressed data.
+/// @param len Size of @p src.
+/// @param dst Destination buffer.
+/// @param capacity Size of @p dst.
+/// @return Decompressed size, or -1 if the data is corrupted or does not fit in @p capacity bytes.
+///
+long lz_block_decompress(const uint8_t* src, size_t len, uint8_t* dst, size_t capacity);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
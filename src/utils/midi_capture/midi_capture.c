@@ -0,0 +1,639 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file midi_capture.c
+/// @brief Compact binary capture of MIDI traffic (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <utils/lz_block/lz_block.h>
+#include <utils/obj_pool/obj_pool.h>
+
+#include "midi_capture.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Longest encoding of a 64-bit varint.
+#define VARINT_MAX 10
+
+/// Largest encoded record: flags byte, delta and length varints, data.
+#define RECORD_MAX (1 + VARINT_MAX + VARINT_MAX + MIDI_CAPTURE_MAX_RECORD)
+
+/// Header field offsets.
+#define OFFSET_MAGIC    0
+#define OFFSET_FLAGS    4
+#define OFFSET_RECORDS  8
+#define OFFSET_RAW      12
+#define OFFSET_STORED   16
+#define OFFSET_CHECKSUM 20
+#define OFFSET_BASE     24
+
+/// Trailer field offsets.
+#define TRAILER_INDEX    0
+#define TRAILER_COUNT    8
+#define TRAILER_CHECKSUM 12
+#define TRAILER_MAGIC    20
+
+/// Initial time index capacity, in entries.
+#define INDEX_INITIAL 64
+
+/// FNV-1a parameters.
+#define FNV_OFFSET 2166136261U
+#define FNV_PRIME  16777619U
+
+/* === Private data type declarations ========================================================== */
+
+/// Structure representing a capture writer.
+struct midi_capture_obj_t
+{
+    int fd;                                       ///< Destination file.
+    bool compress;                                ///< Whether blocks are compressed.
+    size_t len;                                   ///< Bytes used in the current block.
+    uint32_t records;                             ///< Records in the current block.
+    uint64_t base_ns;                             ///< Timestamp of the first record in the current block.
+    uint64_t last_ns;                             ///< Timestamp of the previous record.
+    midi_capture_stats_t stats;                   ///< Writer statistics.
+    uint8_t* index;                               ///< Encoded time index entries.
+    size_t index_count;                           ///< Entries in the time index.
+    size_t index_capacity;                        ///< Entries the time index can hold.
+    uint8_t block[MIDI_CAPTURE_BLOCK_SIZE];       ///< Current block payload.
+    uint8_t compressed[MIDI_CAPTURE_BLOCK_SIZE];  ///< Compression output.
+#if defined(UTILS_NO_HEAP)
+    size_t index_stride;  ///< Blocks per index entry, doubled whenever the index fills up.
+    /// Backing store of `index`.
+    uint8_t index_storage[MIDI_CAPTURE_INDEX_ENTRIES * MIDI_CAPTURE_INDEX_ENTRY_SIZE];
+#endif
+};
+
+/// Structure representing a capture reader.
+struct midi_capture_reader_obj_t
+{
+    const uint8_t* data;                      ///< Capture contents.
+    size_t len;                               ///< Size of the capture, without the index footer.
+    size_t mapped;                            ///< Size of the mapping, 0 if the data is not owned.
+    const uint8_t* index;                     ///< Time index entries, NULL if there is none.
+    size_t index_count;                       ///< Entries in the time index.
+    bool pending;                             ///< Whether `next` holds a record to return again.
+    midi_capture_record_t next;               ///< Record put back by a seek or a full ring.
+    size_t pos;                               ///< Offset of the next block header.
+    size_t skipped;                           ///< Bytes skipped while resynchronizing.
+    const uint8_t* block;                     ///< Payload of the current block.
+    size_t block_len;                         ///< Size of the current block payload.
+    size_t block_pos;                         ///< Offset of the next record in the current block.
+    uint64_t timestamp_ns;                    ///< Timestamp of the previous record.
+    uint8_t buffer[MIDI_CAPTURE_BLOCK_SIZE];  ///< Decompression output.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static void put_u16(uint8_t* p, uint16_t value);
+static void put_u32(uint8_t* p, uint32_t value);
+static void put_u64(uint8_t* p, uint64_t value);
+static uint16_t get_u16(const uint8_t* p);
+static uint32_t get_u32(const uint8_t* p);
+static uint64_t get_u64(const uint8_t* p);
+static size_t put_varint(uint8_t* p, uint64_t value);
+static size_t get_varint(const uint8_t* p, size_t len, uint64_t* value);
+static uint32_t fnv1a(uint32_t hash, const uint8_t* data, size_t len);
+static int write_all(int fd, struct iovec* iov, int count);
+static bool load_block(midi_capture_reader_t reader);
+static bool decode_record(midi_capture_reader_t reader, midi_capture_record_t* record);
+static void load_index(midi_capture_reader_t reader);
+static void index_block(midi_capture_t cap);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(writer_pool, midi_capture_obj_t, MIDI_CAPTURE_POOL_SIZE)
+OBJ_POOL_DEFINE(reader_pool, midi_capture_reader_obj_t, MIDI_CAPTURE_READER_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static void put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t value)
+{
+    put_u16(p, (uint16_t)value);
+    put_u16(p + 2, (uint16_t)(value >> 16));
+}
+
+static void put_u64(uint8_t* p, uint64_t value)
+{
+    put_u32(p, (uint32_t)value);
+    put_u32(p + 4, (uint32_t)(value >> 32));
+}
+
+static uint16_t get_u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint32_t get_u32(const uint8_t* p) { return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16); }
+
+static uint64_t get_u64(const uint8_t* p) { return get_u32(p) | ((uint64_t)get_u32(p + 4) << 32); }
+
+static size_t put_varint(uint8_t* p, uint64_t value)
+{
+    size_t len = 0;
+
+    for (; value >= 0x80; value >>= 7) { p[len++] = (uint8_t)(value | 0x80); }
+    p[len++] = (uint8_t)value;
+
+    return len;
+}
+
+static size_t get_varint(const uint8_t* p, size_t len, uint64_t* value)
+{
+    *value = 0;
+
+    for (size_t i = 0; i < len && i < VARINT_MAX; i++) {
+        *value |= (uint64_t)(p[i] & 0x7F) << (7 * i);
+        if (!(p[i] & 0x80)) { return i + 1; }
+    }
+
+    return 0;
+}
+
+static uint32_t fnv1a(uint32_t hash, const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) { hash = (hash ^ data[i]) * FNV_PRIME; }
+    return hash;
+}
+
+static int write_all(int fd, struct iovec* iov, int count)
+{
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) { continue; }
+            return -1;
+        }
+
+        // Short write: skip what went out and retry with the rest.
+        for (; count > 0 && (size_t)written >= iov->iov_len; iov++, count--) { written -= (ssize_t)iov->iov_len; }
+        if (count > 0) {
+            iov->iov_base = (uint8_t*)iov->iov_base + written;
+            iov->iov_len -= (size_t)written;
+        }
+    }
+
+    return 0;
+}
+
+static bool load_block(midi_capture_reader_t reader)
+{
+    const uint8_t* header = &reader->data[reader->pos];
+    size_t available = reader->len - reader->pos;
+
+    if (available < MIDI_CAPTURE_HEADER_SIZE || get_u32(&header[OFFSET_MAGIC]) != MIDI_CAPTURE_MAGIC) { return false; }
+
+    uint16_t flags = get_u16(&header[OFFSET_FLAGS]);
+    uint32_t raw_len = get_u32(&header[OFFSET_RAW]);
+    uint32_t stored_len = get_u32(&header[OFFSET_STORED]);
+    const uint8_t* payload = &header[MIDI_CAPTURE_HEADER_SIZE];
+
+    if (flags & ~MIDI_CAPTURE_FLAG_COMPRESSED || raw_len > MIDI_CAPTURE_BLOCK_SIZE ||
+        stored_len > available - MIDI_CAPTURE_HEADER_SIZE) {
+        return false;
+    }
+    if (!(flags & MIDI_CAPTURE_FLAG_COMPRESSED) && stored_len != raw_len) { return false; }
+
+    uint8_t copy[MIDI_CAPTURE_HEADER_SIZE];
+    memcpy(copy, header, sizeof(copy));
+    put_u32(&copy[OFFSET_CHECKSUM], 0);
+    if (fnv1a(fnv1a(FNV_OFFSET, copy, sizeof(copy)), payload, stored_len) != get_u32(&header[OFFSET_CHECKSUM])) {
+        return false;
+    }
+
+    if (flags & MIDI_CAPTURE_FLAG_COMPRESSED) {
+        if (lz_block_decompress(payload, stored_len, reader->buffer, sizeof(reader->buffer)) != (long)raw_len) {
+            return false;
+        }
+        payload = reader->buffer;
+    }
+
+    reader->block = payload;
+    reader->block_len = raw_len;
+    reader->block_pos = 0;
+    reader->timestamp_ns = get_u64(&header[OFFSET_BASE]);
+    reader->pos += MIDI_CAPTURE_HEADER_SIZE + stored_len;
+
+    return true;
+}
+
+static bool decode_record(midi_capture_reader_t reader, midi_capture_record_t* record)
+{
+    const uint8_t* p = &reader->block[reader->block_pos];
+    size_t left = reader->block_len - reader->block_pos;
+    size_t used = 1;
+    uint64_t delta;
+    uint64_t len;
+    size_t n;
+
+    if ((n = get_varint(&p[used], left - used, &delta)) == 0) { return false; }
+    used += n;
+    if ((n = get_varint(&p[used], left - used, &len)) == 0) { return false; }
+    used += n;
+    if (len > left - used) { return false; }
+
+    reader->timestamp_ns += delta;
+    reader->block_pos += used + (size_t)len;
+
+    record->timestamp_ns = reader->timestamp_ns;
+    record->port = p[0] >> 1;
+    record->dir = (midi_capture_dir_t)(p[0] & 1);
+    record->data = &p[used];
+    record->len = (size_t)len;
+
+    return true;
+}
+
+static void load_index(midi_capture_reader_t reader)
+{
+    if (reader->len < MIDI_CAPTURE_TRAILER_SIZE) { return; }
+
+    const uint8_t* trailer = &reader->data[reader->len - MIDI_CAPTURE_TRAILER_SIZE];
+    uint64_t offset = get_u64(&trailer[TRAILER_INDEX]);
+    uint64_t count = get_u32(&trailer[TRAILER_COUNT]);
+
+    if (get_u32(&trailer[TRAILER_MAGIC]) != MIDI_CAPTURE_INDEX_MAGIC || offset > reader->len ||
+        offset + count * MIDI_CAPTURE_INDEX_ENTRY_SIZE != reader->len - MIDI_CAPTURE_TRAILER_SIZE) {
+        return;
+    }
+
+    const uint8_t* index = &reader->data[offset];
+    if (fnv1a(FNV_OFFSET, index, count * MIDI_CAPTURE_INDEX_ENTRY_SIZE) != get_u32(&trailer[TRAILER_CHECKSUM])) {
+        return;
+    }
+
+    // Seeks jump straight to these offsets: every block must start before the footer, in file order.
+    uint64_t previous = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t block = get_u64(&index[i * MIDI_CAPTURE_INDEX_ENTRY_SIZE + 8]);
+        if (block >= offset || block < previous) { return; }
+        previous = block;
+    }
+
+    // Blocks end where the footer starts, so it is never mistaken for damaged data.
+    reader->index = index;
+    reader->index_count = (size_t)count;
+    reader->len = (size_t)offset;
+}
+
+static void index_block(midi_capture_t cap)
+{
+#if defined(UTILS_NO_HEAP)
+    // No heap to grow into: halve the resolution instead, keeping every other entry. Seeks scan forward
+    // from the entry they land on, so a sparser index only makes them read more blocks.
+    if (cap->stats.blocks % cap->index_stride != 0) { return; }
+    if (cap->index_count == cap->index_capacity) {
+        for (size_t i = 1; i < cap->index_count / 2; i++) {
+            memcpy(&cap->index[i * MIDI_CAPTURE_INDEX_ENTRY_SIZE], &cap->index[2 * i * MIDI_CAPTURE_INDEX_ENTRY_SIZE],
+                   MIDI_CAPTURE_INDEX_ENTRY_SIZE);
+        }
+        cap->index_count /= 2;
+        cap->index_stride *= 2;
+        if (cap->stats.blocks % cap->index_stride != 0) { return; }
+    }
+#else
+    if (cap->index_count == cap->index_capacity) {
+        size_t capacity = cap->index_capacity ? 2 * cap->index_capacity : INDEX_INITIAL;
+        uint8_t* index = realloc(cap->index, capacity * MIDI_CAPTURE_INDEX_ENTRY_SIZE);
+
+        // Running out of memory only costs seek speed: the capture itself is complete.
+        if (!index) { return; }
+        cap->index = index;
+        cap->index_capacity = capacity;
+    }
+#endif
+
+    uint8_t* entry = &cap->index[cap->index_count++ * MIDI_CAPTURE_INDEX_ENTRY_SIZE];
+    put_u64(entry, cap->base_ns);
+    put_u64(entry + 8, cap->stats.written_bytes);
+}
+
+/* === Public function implementation ========================================================== */
+
+midi_capture_t midi_capture_init(int fd, bool compress)
+{
+    assert(fd >= 0);
+
+    midi_capture_t cap = writer_pool_take();
+    assert(cap);
+
+    cap->fd = fd;
+    cap->compress = compress;
+    cap->len = 0;
+    cap->records = 0;
+    cap->base_ns = 0;
+    cap->last_ns = 0;
+    memset(&cap->stats, 0, sizeof(cap->stats));
+    cap->index_count = 0;
+#if defined(UTILS_NO_HEAP)
+    cap->index = cap->index_storage;
+    cap->index_capacity = MIDI_CAPTURE_INDEX_ENTRIES;
+    cap->index_stride = 1;
+#else
+    // Allocated up front, so recording does not touch the heap until the index has to grow.
+    cap->index = malloc(INDEX_INITIAL * MIDI_CAPTURE_INDEX_ENTRY_SIZE);
+    cap->index_capacity = cap->index ? INDEX_INITIAL : 0;
+#endif
+
+    return cap;
+}
+
+void midi_capture_deinit(midi_capture_t* cap)
+{
+    assert(cap != NULL);
+
+    midi_capture_t writer = *cap;
+
+    if (writer && midi_capture_flush(writer) == 0 && writer->index_count > 0) {
+        uint8_t trailer[MIDI_CAPTURE_TRAILER_SIZE] = {0};
+        size_t size = writer->index_count * MIDI_CAPTURE_INDEX_ENTRY_SIZE;
+
+        put_u64(&trailer[TRAILER_INDEX], writer->stats.written_bytes);
+        put_u32(&trailer[TRAILER_COUNT], (uint32_t)writer->index_count);
+        put_u32(&trailer[TRAILER_CHECKSUM], fnv1a(FNV_OFFSET, writer->index, size));
+        put_u32(&trailer[TRAILER_MAGIC], MIDI_CAPTURE_INDEX_MAGIC);
+
+        struct iovec iov[] = {
+            {.iov_base = writer->index, .iov_len = size},
+            {.iov_base = trailer, .iov_len = sizeof(trailer)},
+        };
+        write_all(writer->fd, iov, 2);
+    }
+
+#if !defined(UTILS_NO_HEAP)
+    if (writer) { free(writer->index); }
+#endif
+    writer_pool_give(*cap);
+    *cap = NULL;
+}
+
+int midi_capture_record(midi_capture_t cap, uint8_t port, midi_capture_dir_t dir, uint64_t timestamp_ns,
+                        const uint8_t* data, size_t len)
+{
+    assert(cap && port <= MIDI_CAPTURE_MAX_PORT && dir <= MIDI_CAPTURE_RX && (data || !len));
+
+    do {
+        size_t chunk = len < MIDI_CAPTURE_MAX_RECORD ? len : MIDI_CAPTURE_MAX_RECORD;
+
+        if (cap->len + RECORD_MAX > MIDI_CAPTURE_BLOCK_SIZE && midi_capture_flush(cap) != 0) { return -1; }
+
+        // Timestamps never go backwards, not even across blocks, so the time index stays sorted.
+        if (cap->stats.records == 0) { cap->last_ns = timestamp_ns; }
+        uint64_t delta = timestamp_ns > cap->last_ns ? timestamp_ns - cap->last_ns : 0;
+        cap->last_ns += delta;
+        if (cap->records == 0) {
+            cap->base_ns = cap->last_ns;
+            delta = 0;
+        }
+
+        uint8_t* p = &cap->block[cap->len];
+        *p++ = (uint8_t)(port << 1 | dir);
+        p += put_varint(p, delta);
+        p += put_varint(p, chunk);
+        if (chunk) { memcpy(p, data, chunk); }
+        p += chunk;
+
+        cap->len = (size_t)(p - cap->block);
+        cap->records++;
+        cap->stats.records++;
+        data = chunk ? data + chunk : data;
+        len -= chunk;
+    } while (len > 0);
+
+    return 0;
+}
+
+int midi_capture_flush(midi_capture_t cap)
+{
+    assert(cap);
+
+    if (cap->records == 0) { return 0; }
+
+    uint8_t header[MIDI_CAPTURE_HEADER_SIZE] = {0};
+    const uint8_t* payload = cap->block;
+    size_t stored_len = cap->len;
+    uint16_t flags = 0;
+
+    // Compressed output must be strictly smaller than the raw block, or it is not worth decoding.
+    if (cap->compress) {
+        size_t compressed = lz_block_compress(cap->block, cap->len, cap->compressed, cap->len - 1);
+        if (compressed) {
+            payload = cap->compressed;
+            stored_len = compressed;
+            flags |= MIDI_CAPTURE_FLAG_COMPRESSED;
+        }
+    }
+
+    put_u32(&header[OFFSET_MAGIC], MIDI_CAPTURE_MAGIC);
+    put_u16(&header[OFFSET_FLAGS], flags);
+    put_u32(&header[OFFSET_RECORDS], cap->records);
+    put_u32(&header[OFFSET_RAW], (uint32_t)cap->len);
+    put_u32(&header[OFFSET_STORED], (uint32_t)stored_len);
+    put_u64(&header[OFFSET_BASE], cap->base_ns);
+    put_u32(&header[OFFSET_CHECKSUM], fnv1a(fnv1a(FNV_OFFSET, header, sizeof(header)), payload, stored_len));
+
+    struct iovec iov[] = {
+        {.iov_base = header, .iov_len = sizeof(header)},
+        {.iov_base = (void*)payload, .iov_len = stored_len},
+    };
+    if (write_all(cap->fd, iov, 2) != 0) { return -1; }
+
+    index_block(cap);
+    cap->stats.blocks++;
+    cap->stats.raw_bytes += cap->len;
+    cap->stats.written_bytes += sizeof(header) + stored_len;
+    cap->len = 0;
+    cap->records = 0;
+
+    return 0;
+}
+
+void midi_capture_get_stats(midi_capture_t cap, midi_capture_stats_t* stats)
+{
+    assert(cap && stats);
+    *stats = cap->stats;
+}
+
+midi_capture_reader_t midi_capture_reader_init(const uint8_t* data, size_t len)
+{
+    assert(data || !len);
+
+    midi_capture_reader_t reader = reader_pool_take();
+    assert(reader);
+
+    reader->data = data;
+    reader->len = len;
+    reader->pos = 0;
+    reader->skipped = 0;
+    reader->block = NULL;
+    reader->block_len = 0;
+    reader->block_pos = 0;
+    reader->timestamp_ns = 0;
+    reader->mapped = 0;
+    reader->index = NULL;
+    reader->index_count = 0;
+    reader->pending = false;
+
+    load_index(reader);
+
+    return reader;
+}
+
+midi_capture_reader_t midi_capture_reader_open(const char* path)
+{
+    assert(path);
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) { return NULL; }
+    if (fstat(fd, &st) == 0 && st.st_size > 0) { data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0); }
+    close(fd);
+
+    if (data == MAP_FAILED) { return NULL; }
+
+    midi_capture_reader_t reader = midi_capture_reader_init(data, (size_t)st.st_size);
+    reader->mapped = (size_t)st.st_size;
+
+    return reader;
+}
+
+void midi_capture_reader_deinit(midi_capture_reader_t* reader)
+{
+    assert(reader != NULL);
+
+    if (*reader && (*reader)->mapped) { munmap((void*)(*reader)->data, (*reader)->mapped); }
+
+    reader_pool_give(*reader);
+    *reader = NULL;
+}
+
+bool midi_capture_reader_next(midi_capture_reader_t reader, midi_capture_record_t* record)
+{
+    assert(reader && record);
+
+    if (reader->pending) {
+        reader->pending = false;
+        *record = reader->next;
+        return true;
+    }
+
+    while (true) {
+        if (reader->block_pos < reader->block_len) {
+            // The checksum matched, so a malformed record means a writer bug: drop the rest of the block.
+            if (decode_record(reader, record)) { return true; }
+            reader->block_pos = reader->block_len;
+            continue;
+        }
+
+        // Look for the next valid block, one byte at a time past damaged data.
+        while (!load_block(reader)) {
+            if (reader->pos >= reader->len) { return false; }
+            reader->pos++;
+            reader->skipped++;
+        }
+    }
+}
+
+bool midi_capture_reader_seek(midi_capture_reader_t reader, uint64_t timestamp_ns)
+{
+    assert(reader);
+
+    size_t low = 0;
+    size_t high = reader->index_count;
+
+    // Last block starting strictly before the target: earlier blocks may end with records at that very time.
+    while (high - low > 1) {
+        size_t mid = low + (high - low) / 2;
+        if (get_u64(&reader->index[mid * MIDI_CAPTURE_INDEX_ENTRY_SIZE]) < timestamp_ns) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    reader->pos = reader->index_count ? (size_t)get_u64(&reader->index[low * MIDI_CAPTURE_INDEX_ENTRY_SIZE + 8]) : 0;
+    reader->block_len = 0;
+    reader->block_pos = 0;
+    reader->pending = false;
+
+    while (midi_capture_reader_next(reader, &reader->next)) {
+        if (reader->next.timestamp_ns >= timestamp_ns) {
+            reader->pending = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t midi_capture_reader_stream(midi_capture_reader_t reader, spsc_ring_t ring, uint8_t port,
+                                  midi_capture_dir_t dir)
+{
+    assert(reader && ring && spsc_ring_capacity(ring) >= MIDI_CAPTURE_MAX_RECORD);
+
+    size_t count = 0;
+
+    while (midi_capture_reader_next(reader, &reader->next)) {
+        if (reader->next.port != port || reader->next.dir != dir) { continue; }
+
+        if (spsc_ring_write(ring, reader->next.data, reader->next.len) != 0) {
+            reader->pending = true;
+            break;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+bool midi_capture_reader_indexed(midi_capture_reader_t reader)
+{
+    assert(reader);
+    return reader->index != NULL;
+}
+
+size_t midi_capture_reader_skipped(midi_capture_reader_t reader)
+{
+    assert(reader);
+    return reader->skipped;
+}
+
+/* === End of documentation ==================================================================== */
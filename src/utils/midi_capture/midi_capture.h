@@ -0,0 +1,267 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file midi_capture.h
+/// @brief Compact binary capture of MIDI traffic.
+///
+/// Meant to be fed from ring drains (e.g. a tx_drain sink): every drained chunk becomes a record
+/// holding the port, the direction, the time elapsed since the previous record as a varint and the
+/// bytes themselves. Records are packed into large blocks, written with a single system call once
+/// full, so the capture costs a few bytes of encoding per chunk and one write per block.
+///
+/// Each block starts with a header carrying a sync word, its sizes, the timestamp of its first record
+/// and a checksum: a reader that hits a damaged block skips forward to the next sync word. Blocks can
+/// optionally be compressed with lz_block, which is kept only when it actually saves space.
+///
+/// On disk, a record is: `port << 1 | direction` (1 byte), timestamp delta in nanoseconds (varint),
+/// length (varint), data. All header fields are little-endian.
+///
+/// When the writer is freed, a sparse time index (the first timestamp and the offset of every block)
+/// is appended as a footer, followed by a fixed-size trailer pointing at it. Readers opened with
+/// midi_capture_reader_open() map the file and binary-search that index, so seeking costs a handful of
+/// page faults regardless of the capture size. Captures without a valid footer (e.g. cut short by a
+/// crash) are still readable, seeking then falls back to a scan.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/spsc_ring/spsc_ring.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+/// Block sync word ("MCB1").
+#define MIDI_CAPTURE_MAGIC 0x3142434DU
+
+/// Size of a block header, in bytes.
+#define MIDI_CAPTURE_HEADER_SIZE 32
+
+/// Largest uncompressed block payload, in bytes.
+#define MIDI_CAPTURE_BLOCK_SIZE 65536
+
+/// Largest record payload. Longer chunks are split into several records with the same timestamp.
+#define MIDI_CAPTURE_MAX_RECORD 1024
+
+/// Highest port number a record can hold.
+#define MIDI_CAPTURE_MAX_PORT 127
+
+/// Block flag: the payload is compressed with lz_block.
+#define MIDI_CAPTURE_FLAG_COMPRESSED 0x0001U
+
+/// Trailer sync word ("MCX1"), the last four bytes of an indexed capture.
+#define MIDI_CAPTURE_INDEX_MAGIC 0x3158434DU
+
+/// Size of a time index entry: first timestamp and offset of a block, in bytes.
+#define MIDI_CAPTURE_INDEX_ENTRY_SIZE 16
+
+/// Size of the trailer: index offset, entry count, checksum, reserved word and sync word, in bytes.
+#define MIDI_CAPTURE_TRAILER_SIZE 24
+
+#ifndef MIDI_CAPTURE_POOL_SIZE
+/// Writers available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define MIDI_CAPTURE_POOL_SIZE 2
+#endif
+
+#ifndef MIDI_CAPTURE_READER_POOL_SIZE
+/// Readers available when built with UTILS_NO_HEAP. A checking midi_replay takes one more per port.
+#define MIDI_CAPTURE_READER_POOL_SIZE 16
+#endif
+
+#ifndef MIDI_CAPTURE_INDEX_ENTRIES
+/// Time index entries of a writer built with UTILS_NO_HEAP. Even. Once full, every other block is indexed.
+#define MIDI_CAPTURE_INDEX_ENTRIES 1024
+#endif
+
+/* === Public data type declarations =========================================================== */
+
+/// Direction of the captured traffic.
+typedef enum
+{
+    MIDI_CAPTURE_TX,  ///< Sent to the port.
+    MIDI_CAPTURE_RX,  ///< Received from the port.
+} midi_capture_dir_t;
+
+/// Opaque capture writer structure
+typedef struct midi_capture_obj_t midi_capture_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef midi_capture_obj_t* midi_capture_t;
+
+/// Opaque capture reader structure
+typedef struct midi_capture_reader_obj_t midi_capture_reader_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef midi_capture_reader_obj_t* midi_capture_reader_t;
+
+/// Decoded record.
+typedef struct
+{
+    uint64_t timestamp_ns;   ///< Capture time.
+    uint8_t port;            ///< Port the traffic belongs to.
+    midi_capture_dir_t dir;  ///< Direction of the traffic.
+    const uint8_t* data;     ///< Captured bytes, valid until the next call on the reader.
+    size_t len;              ///< Number of captured bytes.
+} midi_capture_record_t;
+
+/// Writer statistics.
+typedef struct
+{
+    uint64_t records;        ///< Records encoded.
+    uint64_t blocks;         ///< Blocks written.
+    uint64_t raw_bytes;      ///< Block payload bytes before compression.
+    uint64_t written_bytes;  ///< Bytes written to the file, headers included.
+} midi_capture_stats_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Creates a capture writer.
+/// @param fd File descriptor blocks are written to. Not owned by the writer.
+/// @param compress Whether blocks should be compressed.
+///
+midi_capture_t midi_capture_init(int fd, bool compress);
+
+///
+/// @brief Writes the pending block and the time index, and frees the writer.
+///
+/// Index offsets are relative to where the writer started, so the capture must start at the beginning
+/// of the file for midi_capture_reader_open() to use them.
+///
+/// @param cap Writer to free. Set to NULL afterwards.
+///
+void midi_capture_deinit(midi_capture_t* cap);
+
+///
+/// @brief Appends a record, writing the current block out first if it is full.
+///
+/// Not thread-safe: use one writer per draining thread, or serialize the calls.
+///
+/// @param cap Writer to use.
+/// @param port Port the traffic belongs to, up to MIDI_CAPTURE_MAX_PORT.
+/// @param dir Direction of the traffic.
+/// @param timestamp_ns Capture time (e.g. tsc_clock_now_ns()). Times earlier than the previous record are
+/// recorded as simultaneous to it.
+/// @param data Captured bytes.
+/// @param len Number of captured bytes.
+/// @return 0 on success, or -1 if a block could not be written.
+///
+int midi_capture_record(midi_capture_t cap, uint8_t port, midi_capture_dir_t dir, uint64_t timestamp_ns,
+                        const uint8_t* data, size_t len);
+
+///
+/// @brief Writes the current block out, even if it is not full.
+/// @param cap Writer to flush.
+/// @return 0 on success, or -1 if the block could not be written.
+///
+int midi_capture_flush(midi_capture_t cap);
+
+///
+/// @brief Returns the writer statistics.
+/// @param cap Writer to check.
+/// @param stats Where to store the statistics.
+///
+void midi_capture_get_stats(midi_capture_t cap, midi_capture_stats_t* stats);
+
+///
+/// @brief Creates a reader over a capture held in memory.
+/// @param data Capture contents. Must outlive the reader.
+/// @param len Size of @p data.
+///
+midi_capture_reader_t midi_capture_reader_init(const uint8_t* data, size_t len);
+
+///
+/// @brief Creates a reader over a capture file, mapped in memory.
+/// @param path Capture file.
+/// @return The reader, or NULL if the file cannot be mapped.
+///
+midi_capture_reader_t midi_capture_reader_open(const char* path);
+
+///
+/// @brief Free a capture reader, unmapping its file if it was opened with midi_capture_reader_open().
+/// @param reader Reader to free. Set to NULL afterwards.
+///
+void midi_capture_reader_deinit(midi_capture_reader_t* reader);
+
+///
+/// @brief Decodes the next record, skipping damaged blocks.
+/// @param reader Reader to use.
+/// @param record Where to store the record.
+/// @return true if a record was decoded, false at the end of the capture.
+///
+bool midi_capture_reader_next(midi_capture_reader_t reader, midi_capture_record_t* record);
+
+///
+/// @brief Positions the reader on the first record at or after the given time.
+///
+/// Binary-searches the time index for the last block starting before @p timestamp_ns and decodes from
+/// there. Without an index the whole capture is scanned from the start.
+///
+/// @param reader Reader to move.
+/// @param timestamp_ns Time to seek to.
+/// @return true if such a record exists, false if the reader was left at the end of the capture.
+///
+bool midi_capture_reader_seek(midi_capture_reader_t reader, uint64_t timestamp_ns);
+
+///
+/// @brief Writes the bytes of the next records of a port and direction into a ring, skipping the others.
+///
+/// Every record is written as a whole. Stops at the end of the capture or at the first record the ring
+/// has no room for, which is kept for the next call.
+///
+/// @param reader Reader to use.
+/// @param ring Destination ring, at least MIDI_CAPTURE_MAX_RECORD bytes long. Producer side.
+/// @param port Port to stream.
+/// @param dir Direction to stream.
+/// @return Number of records written to the ring.
+///
+size_t midi_capture_reader_stream(midi_capture_reader_t reader, spsc_ring_t ring, uint8_t port,
+                                  midi_capture_dir_t dir);
+
+///
+/// @brief Checks whether the capture has a valid time index.
+/// @param reader Reader to check.
+///
+bool midi_capture_reader_indexed(midi_capture_reader_t reader);
+
+///
+/// @brief Returns the number of bytes skipped so far while looking for valid blocks.
+/// @param reader Reader to check.
+///
+size_t midi_capture_reader_skipped(midi_capture_reader_t reader);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,270 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file midi_replay.c
+/// @brief Deterministic replay of MIDI captures (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <utils/obj_pool/obj_pool.h>
+#include <utils/tsc_clock/tsc_clock.h>
+
+#include "midi_replay.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define NS_PER_SEC 1000000000ULL
+
+/* === Private data type declarations ========================================================== */
+
+/// Per port state.
+typedef struct
+{
+    uint8_t id;                           ///< Port number.
+    ring_buffer_t rx;                     ///< RX ring fed with the recorded RX traffic, or NULL.
+    spsc_ring_t tx;                       ///< TX ring fed with the recorded TX traffic, or NULL.
+    midi_capture_reader_t expected;       ///< Reader over the recorded TX traffic, for midi_replay_check().
+    midi_capture_record_t record;         ///< Recorded TX record being compared.
+    size_t offset;                        ///< Bytes of `record` already compared.
+    uint64_t position;                    ///< Bytes of output compared so far.
+    bool diverged;                        ///< Whether the output has diverged.
+    midi_replay_divergence_t divergence;  ///< First divergence.
+} port_t;
+
+/// Structure representing a replay.
+struct midi_replay_obj_t
+{
+    midi_replay_mode_t mode;                  ///< Pacing.
+    midi_capture_reader_t reader;             ///< Reader feeding the records.
+    midi_capture_record_t next;               ///< Next record to feed.
+    bool has_next;                            ///< Whether `next` is valid.
+    bool exhausted;                           ///< Whether the reader reached the end of the capture.
+    bool started;                             ///< Whether a record has been fed.
+    uint64_t first_ns;                        ///< Capture time of the first record fed.
+    uint64_t start_ns;                        ///< Time the first record was fed.
+    uint64_t last_ns;                         ///< Time the last record was fed.
+    midi_replay_stats_t stats;                ///< Replay statistics.
+    size_t port_count;                        ///< Number of ports.
+    port_t ports[MIDI_CAPTURE_MAX_PORT + 1];  ///< Per port state, the first `port_count` in use.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static bool fetch_next(midi_replay_t replay);
+static int feed(midi_replay_t replay, const midi_capture_record_t* record);
+static int expected_byte(port_t* port);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(replay_pool, midi_replay_obj_t, MIDI_REPLAY_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static bool fetch_next(midi_replay_t replay)
+{
+    // Skip records nobody is fed with.
+    while (!replay->exhausted) {
+        if (!midi_capture_reader_next(replay->reader, &replay->next)) {
+            replay->exhausted = true;
+            break;
+        }
+
+        if (replay->next.port >= replay->port_count) { continue; }
+
+        port_t* port = &replay->ports[replay->next.port];
+        if ((replay->next.dir == MIDI_CAPTURE_RX && port->rx) || (replay->next.dir == MIDI_CAPTURE_TX && port->tx)) {
+            replay->has_next = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int feed(midi_replay_t replay, const midi_capture_record_t* record)
+{
+    port_t* port = &replay->ports[record->port];
+
+    if (record->dir == MIDI_CAPTURE_TX) { return spsc_ring_write(port->tx, record->data, record->len); }
+
+    ring_buffer_write(port->rx, record->data, record->len);
+    return 0;
+}
+
+static int expected_byte(port_t* port)
+{
+    while (port->offset == port->record.len) {
+        if (!midi_capture_reader_next(port->expected, &port->record)) { return -1; }
+        port->offset = 0;
+
+        // Other ports and directions count as empty records.
+        if (port->record.port != port->id || port->record.dir != MIDI_CAPTURE_TX) { port->record.len = 0; }
+    }
+
+    return port->record.data[port->offset];
+}
+
+/* === Public function implementation ========================================================== */
+midi_replay_t midi_replay_init(const char* path, const midi_replay_config_t* config)
+{
+    assert(path && config && config->port_count <= MIDI_CAPTURE_MAX_PORT + 1);
+
+    midi_replay_t replay = replay_pool_take();
+    assert(replay);
+
+    replay->mode = config->mode;
+    replay->port_count = config->port_count;
+    replay->reader = midi_capture_reader_open(path);
+
+    bool opened = replay->reader != NULL;
+    for (size_t i = 0; opened && i < config->port_count; i++) {
+        port_t* port = &replay->ports[i];
+
+        port->id = (uint8_t)i;
+        port->rx = config->rx ? config->rx[i] : NULL;
+        port->tx = config->tx ? config->tx[i] : NULL;
+
+        // One reader per port keeps every expected stream independent of how far the others got.
+        if (config->check) {
+            port->expected = midi_capture_reader_open(path);
+            opened = port->expected != NULL;
+            if (opened) { midi_capture_reader_seek(port->expected, config->start_ns); }
+        }
+    }
+
+    if (!opened) {
+        midi_replay_deinit(&replay);
+        return NULL;
+    }
+
+    midi_capture_reader_seek(replay->reader, config->start_ns);
+
+    return replay;
+}
+
+void midi_replay_deinit(midi_replay_t* replay)
+{
+    assert(replay != NULL);
+
+    if (*replay) {
+        for (size_t i = 0; i < (*replay)->port_count; i++) {
+            if ((*replay)->ports[i].expected) { midi_capture_reader_deinit(&(*replay)->ports[i].expected); }
+        }
+        if ((*replay)->reader) { midi_capture_reader_deinit(&(*replay)->reader); }
+    }
+
+    replay_pool_give(*replay);
+    *replay = NULL;
+}
+
+size_t midi_replay_poll(midi_replay_t replay, size_t max)
+{
+    assert(replay);
+
+    uint64_t now = tsc_clock_now_ns();
+    size_t count = 0;
+
+    while (count < max && (replay->has_next || fetch_next(replay))) {
+        const midi_capture_record_t* record = &replay->next;
+
+        if (!replay->started) {
+            replay->started = true;
+            replay->first_ns = record->timestamp_ns;
+            replay->start_ns = now;
+        }
+
+        if (replay->mode == MIDI_REPLAY_PACED && record->timestamp_ns - replay->first_ns > now - replay->start_ns) {
+            break;
+        }
+
+        if (feed(replay, record) != 0) { break; }
+
+        replay->has_next = false;
+        replay->last_ns = now;
+        replay->stats.records++;
+        replay->stats.bytes += record->len;
+        replay->stats.span_ns = record->timestamp_ns - replay->first_ns;
+        count++;
+    }
+
+    return count;
+}
+
+bool midi_replay_done(midi_replay_t replay)
+{
+    assert(replay);
+    return !replay->has_next && !fetch_next(replay);
+}
+
+int midi_replay_check(midi_replay_t replay, uint8_t port, const uint8_t* data, size_t len)
+{
+    assert(replay && port < replay->port_count && replay->ports[port].expected && (data || !len));
+
+    port_t* state = &replay->ports[port];
+
+    for (size_t i = 0; i < len && !state->diverged; i++) {
+        int expected = expected_byte(state);
+
+        if (expected != data[i]) {
+            state->diverged = true;
+            state->divergence.offset = state->position;
+            state->divergence.timestamp_ns = state->record.timestamp_ns;
+            state->divergence.expected = expected;
+            state->divergence.actual = data[i];
+            replay->stats.divergent_ports++;
+            break;
+        }
+
+        state->offset++;
+        state->position++;
+        replay->stats.checked++;
+    }
+
+    return state->diverged ? -1 : 0;
+}
+
+bool midi_replay_divergence(midi_replay_t replay, uint8_t port, midi_replay_divergence_t* divergence)
+{
+    assert(replay && port < replay->port_count && divergence);
+
+    if (!replay->ports[port].diverged) { return false; }
+
+    *divergence = replay->ports[port].divergence;
+    return true;
+}
+
+void midi_replay_get_stats(midi_replay_t replay, midi_replay_stats_t* stats)
+{
+    assert(replay && stats);
+
+    *stats = replay->stats;
+    stats->elapsed_ns = replay->last_ns - replay->start_ns;
+    stats->bytes_per_sec = stats->elapsed_ns ? (uint64_t)((double)stats->bytes * NS_PER_SEC / stats->elapsed_ns) : 0;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,177 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file midi_replay.h
+/// @brief Deterministic replay of MIDI captures.
+///
+/// Reads a capture written by midi_capture through a mapped reader and feeds its records back: the
+/// recorded RX traffic into the RX ring_buffer of each port, to exercise the processing, and/or the
+/// recorded TX traffic into the TX ring of each port, to exercise the scheduler and transports.
+/// Records are fed in capture order, either at their original pace or as fast as the caller polls.
+///
+/// While replaying RX traffic, the output the pipeline produces can be passed to midi_replay_check(),
+/// which compares it byte by byte against the recorded TX traffic of the same port and reports where
+/// each port first diverged.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/midi_capture/midi_capture.h>
+#include <utils/ring_buffer/ring_buffer.h>
+#include <utils/spsc_ring/spsc_ring.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef MIDI_REPLAY_POOL_SIZE
+/// Replays available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define MIDI_REPLAY_POOL_SIZE 2
+#endif
+
+/* === Public data type declarations =========================================================== */
+
+/// Replay pacing.
+typedef enum
+{
+    MIDI_REPLAY_PACED,  ///< Each record is fed once as much time has passed as in the capture.
+    MIDI_REPLAY_FAST,   ///< Records are fed as fast as midi_replay_poll() is called.
+} midi_replay_mode_t;
+
+/// Replay parameters.
+typedef struct
+{
+    midi_replay_mode_t mode;  ///< Pacing.
+    uint64_t start_ns;        ///< Capture time to start from, 0 for the beginning.
+    size_t port_count;        ///< Number of entries in `rx` and `tx`, up to MIDI_CAPTURE_MAX_PORT + 1.
+    ring_buffer_t* rx;        ///< RX ring of each port, fed with the recorded RX traffic. NULL or NULL entries to skip.
+    spsc_ring_t* tx;          ///< TX ring of each port, fed with the recorded TX traffic. NULL or NULL entries to skip.
+    bool check;               ///< Whether midi_replay_check() is going to be used.
+} midi_replay_config_t;
+
+/// Replay statistics.
+typedef struct
+{
+    uint64_t records;          ///< Records fed.
+    uint64_t bytes;            ///< Bytes fed.
+    uint64_t span_ns;          ///< Capture time covered by the records fed.
+    uint64_t elapsed_ns;       ///< Time between feeding the first and the last record.
+    uint64_t bytes_per_sec;    ///< Feeding throughput.
+    uint64_t checked;          ///< Output bytes that matched the recorded TX traffic.
+    uint64_t divergent_ports;  ///< Ports whose output diverged from the recorded TX traffic.
+} midi_replay_stats_t;
+
+/// First divergence of a port.
+typedef struct
+{
+    uint64_t offset;        ///< Position of the divergent byte in the port's TX stream.
+    uint64_t timestamp_ns;  ///< Capture time of the expected record (of the last one if the recording had ended).
+    int expected;           ///< Recorded byte, or -1 if the recording had ended.
+    uint8_t actual;         ///< Byte produced instead.
+} midi_replay_divergence_t;
+
+/// Opaque replay structure
+typedef struct midi_replay_obj_t midi_replay_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef midi_replay_obj_t* midi_replay_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Opens a capture for replay.
+/// @param path Capture file, mapped in memory.
+/// @param config Replay parameters. Copied, the rings must outlive the replay.
+/// @return The replay, or NULL if the capture cannot be opened.
+///
+midi_replay_t midi_replay_init(const char* path, const midi_replay_config_t* config);
+
+///
+/// @brief Free a replay structure.
+/// @param replay Replay to free. Set to NULL afterwards.
+///
+void midi_replay_deinit(midi_replay_t* replay);
+
+///
+/// @brief Feeds the records that are due.
+///
+/// RX rings overwrite their oldest data when full, so in fast mode @p max should not exceed what the
+/// pipeline consumes between two polls. A full TX ring pauses the replay until the next poll.
+///
+/// @param replay Replay to advance.
+/// @param max Maximum number of records to feed.
+/// @return Number of records fed.
+///
+size_t midi_replay_poll(midi_replay_t replay, size_t max);
+
+///
+/// @brief Checks whether every record has been fed.
+/// @param replay Replay to check.
+///
+bool midi_replay_done(midi_replay_t replay);
+
+///
+/// @brief Compares output of the pipeline against the recorded TX traffic of a port.
+///
+/// Meant to be called from the TX sink (e.g. a tx_drain sink) with everything the port sends. After the
+/// first divergence the port is no longer compared, since its stream is out of step.
+///
+/// @param replay Replay created with `check` set.
+/// @param port Port that produced the output.
+/// @param data Output bytes.
+/// @param len Number of output bytes.
+/// @return 0 if the output matches, or -1 if the port has diverged.
+///
+int midi_replay_check(midi_replay_t replay, uint8_t port, const uint8_t* data, size_t len);
+
+///
+/// @brief Returns the first divergence of a port.
+/// @param replay Replay to check.
+/// @param port Port to check.
+/// @param divergence Where to store the divergence.
+/// @return true if the port has diverged.
+///
+bool midi_replay_divergence(midi_replay_t replay, uint8_t port, midi_replay_divergence_t* divergence);
+
+///
+/// @brief Returns the replay statistics.
+/// @param replay Replay to check.
+/// @param stats Where to store the statistics.
+///
+void midi_replay_get_stats(midi_replay_t replay, midi_replay_stats_t* stats);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
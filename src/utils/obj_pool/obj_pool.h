@@ -0,0 +1,118 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file obj_pool.h
+/// @brief Allocation of module objects, from the heap or from static pools.
+///
+/// Modules allocate their objects through the functions OBJ_POOL_DEFINE() generates, which makes the
+/// heap a build option. By default they call aligned_alloc() and free(). With `UTILS_NO_HEAP` defined,
+/// every pool is a static array with an in-use flag per slot, claimed lock-free, and the library does
+/// not reference malloc() and friends at all: memory use is fixed at link time, and nothing allocates
+/// after startup by construction. Each module sizes its pools with a `<MODULE>_POOL_SIZE` macro, and
+/// an exhausted pool fails the same way as an exhausted heap.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include <utils/port_atomic/port_atomic.h>
+
+#if !defined(UTILS_NO_HEAP)
+#include <stdlib.h>
+#endif
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#if defined(UTILS_NO_HEAP)
+
+///
+/// @brief Defines `name_take()`, returning a zeroed object or NULL, and `name_give()`, releasing it.
+///
+/// Meant for the private section of a module's translation unit, after the object's type definition.
+///
+/// @param name Pool name.
+/// @param type Object type.
+/// @param count Number of objects, only used when built with UTILS_NO_HEAP.
+///
+#define OBJ_POOL_DEFINE(name, type, count)                                                              \
+    static type name##_items_[count];                                                                   \
+    static port_atomic_bool_t name##_used_[count];                                                      \
+    static inline type* name##_take(void)                                                               \
+    {                                                                                                   \
+        size_t slot = obj_pool_claim_(name##_used_, count);                                             \
+        if (slot == (count)) { return NULL; }                                                           \
+        memset(&name##_items_[slot], 0, sizeof(type));                                                  \
+        return &name##_items_[slot];                                                                    \
+    }                                                                                                   \
+    static inline void name##_give(type* obj)                                                           \
+    {                                                                                                   \
+        if (obj) { PORT_ATOMIC_STORE(&name##_used_[obj - name##_items_], false, PORT_ATOMIC_RELEASE); } \
+    }
+
+#else
+
+#define OBJ_POOL_DEFINE(name, type, count)                       \
+    static inline type* name##_take(void)                        \
+    {                                                            \
+        type* obj = aligned_alloc(_Alignof(type), sizeof(type)); \
+        if (obj) { memset(obj, 0, sizeof(type)); }               \
+        return obj;                                              \
+    }                                                            \
+    static inline void name##_give(type* obj) { free(obj); }
+
+#endif
+
+/* === Public data type declarations =========================================================== */
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+#if defined(UTILS_NO_HEAP)
+
+/// Claims the first free slot of a pool, returning @p count if there is none.
+static inline size_t obj_pool_claim_(port_atomic_bool_t* used, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        // Only try to claim slots seen free, so a busy pool is scanned without writing to it.
+        if (PORT_ATOMIC_LOAD(&used[i], PORT_ATOMIC_RELAXED)) { continue; }
+        if (!PORT_ATOMIC_EXCHANGE(&used[i], true, PORT_ATOMIC_ACQUIRE)) { return i; }
+    }
+
+    return count;
+}
+
+#endif
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,127 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file pipeline.c
+/// @brief Compile-time pipeline builder over a seq_ring (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/obj_pool/obj_pool.h>
+
+#include "pipeline.h"
+
+/* === Macros definitions ====================================================================== */
+/* === Private data type declarations ========================================================== */
+
+/// Argument of each worker thread.
+typedef struct
+{
+    pipeline_workers_t workers;  ///< Owning workers structure.
+    size_t index;                ///< Step run by the thread.
+} worker_t;
+
+/// Structure representing the threads of a running pipeline.
+struct pipeline_workers_obj_t
+{
+    seq_ring_t ring;                              ///< Ring the pipeline runs over.
+    pipeline_step_fn steps[SEQ_RING_MAX_STAGES];  ///< Step run by each thread.
+    size_t count;                                 ///< Number of threads.
+    atomic_bool running;                          ///< Cleared to stop the threads.
+    pthread_t threads[SEQ_RING_MAX_STAGES];       ///< Thread handles.
+    worker_t worker[SEQ_RING_MAX_STAGES];         ///< Thread arguments.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static void* worker_thread(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(workers_pool, pipeline_workers_obj_t, PIPELINE_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static void* worker_thread(void* arg)
+{
+    worker_t* worker = arg;
+    pipeline_workers_t workers = worker->workers;
+    pipeline_step_fn step = workers->steps[worker->index];
+
+    while (atomic_load_explicit(&workers->running, memory_order_relaxed)) {
+        if (step(workers->ring, worker->index + 1) == 0) { sched_yield(); }
+    }
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+pipeline_workers_t pipeline_start(seq_ring_t ring, const pipeline_step_fn* steps, size_t count)
+{
+    assert(ring && steps && count && count + 2 <= seq_ring_stages(ring));
+
+    pipeline_workers_t workers = workers_pool_take();
+    assert(workers);
+
+    workers->ring = ring;
+    memcpy(workers->steps, steps, count * sizeof(steps[0]));
+    workers->count = 0;
+    atomic_init(&workers->running, true);
+
+    for (size_t i = 0; i < count; i++) {
+        workers->worker[i].workers = workers;
+        workers->worker[i].index = i;
+        if (pthread_create(&workers->threads[i], NULL, worker_thread, &workers->worker[i]) != 0) {
+            pipeline_stop(&workers);
+            return NULL;
+        }
+        workers->count++;
+    }
+
+    return workers;
+}
+
+void pipeline_stop(pipeline_workers_t* workers)
+{
+    assert(workers != NULL);
+
+    if (*workers) {
+        atomic_store_explicit(&(*workers)->running, false, memory_order_relaxed);
+        for (size_t i = 0; i < (*workers)->count; i++) { pthread_join((*workers)->threads[i], NULL); }
+    }
+
+    workers_pool_give(*workers);
+    *workers = NULL;
+}
+
+/* === End of documentation ==================================================================== */
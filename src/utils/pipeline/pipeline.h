@@ -0,0 +1,185 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file pipeline.h
+/// @brief Compile-time pipeline builder over a seq_ring.
+///
+/// A pipeline is a list of stage functions taking a pointer to the entry type, declared as an X-macro:
+///
+///     static inline void parse(midi_msg_t* msg) { ... }
+///     static inline void route(midi_msg_t* msg) { ... }
+///     #define TX_STAGES(X) X(parse) X(route)
+///     PIPELINE_DEFINE(tx, midi_msg_t, TX_STAGES)
+///
+/// In fused form all the stages are inlined into a single loop over spans of the ring, which is the
+/// cheapest option when the whole pipeline runs on one core. In split form each stage owns a seq_ring
+/// cursor, so the stages can run on separate threads. PIPELINE_FUSE_STAGES picks the form of
+/// PIPELINE_DEFINE(); both forms have the same interface:
+///
+/// - `tx_RING_STAGES`: number of stages the seq_ring must be created with.
+/// - `tx_OUTPUT_STAGE`: cursor the consumer of the processed entries advances. The producer uses stage 0.
+/// - `tx_poll(ring)`: runs the pipeline once from the calling thread.
+/// - `tx_start(ring)`: runs the pipeline on its own threads until pipeline_stop().
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <utils/seq_ring/seq_ring.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef PIPELINE_POOL_SIZE
+/// Worker sets available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define PIPELINE_POOL_SIZE 4
+#endif
+
+#ifndef PIPELINE_FUSE_STAGES
+/// Whether PIPELINE_DEFINE() fuses the stages into a single loop (1) or gives each one its own cursor (0).
+#define PIPELINE_FUSE_STAGES 1
+#endif
+
+/// Defines a pipeline named @p name over entries of @p type, in the form selected by PIPELINE_FUSE_STAGES.
+#if PIPELINE_FUSE_STAGES
+#define PIPELINE_DEFINE(name, type, STAGES) PIPELINE_DEFINE_FUSED(name, type, STAGES)
+#else
+#define PIPELINE_DEFINE(name, type, STAGES) PIPELINE_DEFINE_SPLIT(name, type, STAGES)
+#endif
+
+/// Defines a pipeline whose stages are fused into a single loop, driven by a single cursor. The loop walks contiguous
+/// spans as arrays of @p type, so the ring's entries must be exactly that size.
+#define PIPELINE_DEFINE_FUSED(name, type, STAGES)                             \
+    enum { name##_RING_STAGES = 3, name##_OUTPUT_STAGE = 2 };                 \
+                                                                              \
+    static inline void name##_apply(type* item) { STAGES(PIPELINE_CALL_) }    \
+                                                                              \
+    static inline size_t name##_step(seq_ring_t ring, size_t stage)           \
+    {                                                                         \
+        size_t count = seq_ring_available(ring, stage);                       \
+        size_t seq = seq_ring_cursor(ring, stage);                            \
+                                                                              \
+        for (size_t done = 0; done < count;) {                                \
+            size_t len = seq_ring_contiguous(ring, seq + done, count - done); \
+            type* items = seq_ring_entry(ring, seq + done);                   \
+            for (size_t i = 0; i < len; i++) { name##_apply(&items[i]); }     \
+            done += len;                                                      \
+        }                                                                     \
+                                                                              \
+        seq_ring_advance(ring, stage, count);                                 \
+        return count;                                                         \
+    }                                                                         \
+                                                                              \
+    static inline size_t name##_poll(seq_ring_t ring)                         \
+    {                                                                         \
+        assert(seq_ring_entry_size(ring) == sizeof(type));                    \
+        return name##_step(ring, 1);                                          \
+    }                                                                         \
+                                                                              \
+    static inline pipeline_workers_t name##_start(seq_ring_t ring)            \
+    {                                                                         \
+        static const pipeline_step_fn steps[] = {name##_step};                \
+        assert(seq_ring_entry_size(ring) == sizeof(type));                    \
+        return pipeline_start(ring, steps, 1);                                \
+    }
+
+/// Defines a pipeline whose stages each own a cursor, so they can run on separate threads. Stage i drives cursor i + 1.
+#define PIPELINE_DEFINE_SPLIT(name, type, STAGES)                                                           \
+    enum { name##_RING_STAGES = 2 STAGES(PIPELINE_COUNT_), name##_OUTPUT_STAGE = name##_RING_STAGES - 1 };  \
+    _Static_assert(name##_RING_STAGES <= SEQ_RING_MAX_STAGES, "too many stages for a seq_ring");            \
+                                                                                                            \
+    static inline size_t name##_step(seq_ring_t ring, size_t index)                                         \
+    {                                                                                                       \
+        size_t count = seq_ring_available(ring, index);                                                     \
+        size_t seq = seq_ring_cursor(ring, index);                                                          \
+        size_t position = 0;                                                                                \
+        STAGES(PIPELINE_SPLIT_STAGE_)                                                                       \
+        seq_ring_advance(ring, index, count);                                                               \
+        return count;                                                                                       \
+    }                                                                                                       \
+                                                                                                            \
+    static inline size_t name##_poll(seq_ring_t ring)                                                       \
+    {                                                                                                       \
+        size_t count = 0;                                                                                   \
+        for (size_t index = 1; index < name##_OUTPUT_STAGE; index++) { count += name##_step(ring, index); } \
+        return count;                                                                                       \
+    }                                                                                                       \
+                                                                                                            \
+    static inline pipeline_workers_t name##_start(seq_ring_t ring)                                          \
+    {                                                                                                       \
+        pipeline_step_fn steps[name##_RING_STAGES - 2];                                                     \
+        for (size_t i = 0; i < name##_RING_STAGES - 2; i++) { steps[i] = name##_step; }                     \
+        return pipeline_start(ring, steps, name##_RING_STAGES - 2);                                         \
+    }
+
+/// @cond INTERNAL
+#define PIPELINE_CALL_(stage) stage(item);
+#define PIPELINE_COUNT_(stage) +1
+#define PIPELINE_SPLIT_STAGE_(stage)                                                 \
+    if (++position == index) {                                                       \
+        for (size_t i = 0; i < count; i++) { stage(seq_ring_entry(ring, seq + i)); } \
+    }
+/// @endcond
+
+/* === Public data type declarations =========================================================== */
+
+/// Runs one stage once over the entries available to its cursor. Returns the number of entries processed.
+typedef size_t (*pipeline_step_fn)(seq_ring_t ring, size_t stage);
+
+/// Opaque pipeline workers structure
+typedef struct pipeline_workers_obj_t pipeline_workers_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef pipeline_workers_obj_t* pipeline_workers_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Starts one thread per step. Step i drives cursor i + 1 of the ring. Prefer the generated `name_start()`.
+/// @param ring Ring the pipeline runs over.
+/// @param steps Steps to run. Copied.
+/// @param count Number of steps.
+/// @return The workers, or NULL if the threads could not be started.
+///
+pipeline_workers_t pipeline_start(seq_ring_t ring, const pipeline_step_fn* steps, size_t count);
+
+///
+/// @brief Stops and frees the pipeline threads. Entries not processed yet stay in the ring.
+/// @param workers Workers to stop. Set to NULL afterwards.
+///
+void pipeline_stop(pipeline_workers_t* workers);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
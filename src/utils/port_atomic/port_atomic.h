@@ -0,0 +1,249 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file port_atomic.h
+/// @brief Portable atomic primitives for the concurrent rings.
+///
+/// The concurrent data structures are written against this layer instead of <stdatomic.h>, so the same
+/// code builds for hosts (threads on several cores) and for single-core microcontrollers (interrupts).
+/// One backend is selected at build time:
+///
+/// - `PORT_ATOMIC_USE_C11`: C11 <stdatomic.h>. Default wherever the compiler provides it and the target
+///   has read-modify-write instructions.
+/// - `PORT_ATOMIC_USE_GCC`: GCC/Clang `__atomic` builtins, for toolchains without <stdatomic.h>.
+/// - `PORT_ATOMIC_USE_CRITICAL`: plain volatile loads and stores with compiler barriers, and read-modify-
+///   write operations inside a critical section. Only valid when all the concurrency happens on one
+///   core: an ISR and the main loop on a Cortex-M (the critical section masks interrupts), or a signal
+///   handler and the thread it interrupts on a host (the critical section blocks signals), which is
+///   how the MCU build is exercised on Linux. Default on targets without read-modify-write instructions,
+///   such as ARMv6-M (Cortex-M0/M0+), where the other two backends turn every fetch-add and exchange
+///   into an `__atomic_*_4` library call. A multi-core one (e.g. RP2040) has to select one of them
+///   explicitly, along with a toolchain that provides those calls.
+///
+/// Loads and stores of a naturally aligned word are single instructions on every supported target,
+/// so only read-modify-write operations pay for a critical section.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if !defined(PORT_ATOMIC_USE_C11) && !defined(PORT_ATOMIC_USE_GCC) && !defined(PORT_ATOMIC_USE_CRITICAL)
+#if defined(__ARM_ARCH_6M__) || (defined(__GCC_ATOMIC_INT_LOCK_FREE) && __GCC_ATOMIC_INT_LOCK_FREE < 2)
+#define PORT_ATOMIC_USE_CRITICAL
+#elif !defined(__STDC_NO_ATOMICS__)
+#define PORT_ATOMIC_USE_C11
+#elif defined(__GNUC__)
+#define PORT_ATOMIC_USE_GCC
+#else
+#define PORT_ATOMIC_USE_CRITICAL
+#endif
+#endif
+
+#if defined(PORT_ATOMIC_USE_C11)
+#include <stdatomic.h>
+#elif defined(PORT_ATOMIC_USE_CRITICAL) && !defined(PORT_CRITICAL_ENTER) && !defined(__ARM_ARCH_7M__) && \
+    !defined(__ARM_ARCH_7EM__) && !defined(__ARM_ARCH_6M__) && !defined(__ARM_ARCH_8M_MAIN__)
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#if defined(PORT_ATOMIC_USE_C11)
+
+/// Name of the selected backend.
+#define PORT_ATOMIC_BACKEND "c11"
+
+#define PORT_ATOMIC_RELAXED memory_order_relaxed
+#define PORT_ATOMIC_ACQUIRE memory_order_acquire
+#define PORT_ATOMIC_RELEASE memory_order_release
+#define PORT_ATOMIC_SEQ_CST memory_order_seq_cst
+
+#define PORT_ATOMIC_INIT(obj, value)             atomic_init(obj, value)
+#define PORT_ATOMIC_LOAD(obj, order)             atomic_load_explicit(obj, order)
+#define PORT_ATOMIC_STORE(obj, value, order)     atomic_store_explicit(obj, value, order)
+#define PORT_ATOMIC_FETCH_ADD(obj, value, order) atomic_fetch_add_explicit(obj, value, order)
+#define PORT_ATOMIC_EXCHANGE(obj, value, order)  atomic_exchange_explicit(obj, value, order)
+#define PORT_ATOMIC_FENCE(order)                 atomic_thread_fence(order)
+
+#elif defined(PORT_ATOMIC_USE_GCC)
+
+/// Name of the selected backend.
+#define PORT_ATOMIC_BACKEND "gcc"
+
+#define PORT_ATOMIC_RELAXED __ATOMIC_RELAXED
+#define PORT_ATOMIC_ACQUIRE __ATOMIC_ACQUIRE
+#define PORT_ATOMIC_RELEASE __ATOMIC_RELEASE
+#define PORT_ATOMIC_SEQ_CST __ATOMIC_SEQ_CST
+
+#define PORT_ATOMIC_INIT(obj, value)             __atomic_store_n(obj, value, __ATOMIC_RELAXED)
+#define PORT_ATOMIC_LOAD(obj, order)             __atomic_load_n(obj, order)
+#define PORT_ATOMIC_STORE(obj, value, order)     __atomic_store_n(obj, value, order)
+#define PORT_ATOMIC_FETCH_ADD(obj, value, order) __atomic_fetch_add(obj, value, order)
+#define PORT_ATOMIC_EXCHANGE(obj, value, order)  __atomic_exchange_n(obj, value, order)
+#define PORT_ATOMIC_FENCE(order)                 __atomic_thread_fence(order)
+
+#else
+
+/// Name of the selected backend.
+#define PORT_ATOMIC_BACKEND "critical"
+
+// Orders only decide where the compiler barriers go: a single core sees its own accesses in order.
+#define PORT_ATOMIC_RELAXED 0
+#define PORT_ATOMIC_ACQUIRE 1
+#define PORT_ATOMIC_RELEASE 2
+#define PORT_ATOMIC_SEQ_CST 3
+
+#ifndef PORT_COMPILER_BARRIER
+/// Keeps the compiler from moving memory accesses across it.
+#define PORT_COMPILER_BARRIER() __asm__ volatile("" ::: "memory")
+#endif
+
+#ifndef PORT_CRITICAL_ENTER
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_6M__) || defined(__ARM_ARCH_8M_MAIN__)
+/// Saved interrupt state.
+typedef unsigned int port_critical_state_t;
+/// Masks interrupts, saving the previous mask in @p state.
+#define PORT_CRITICAL_ENTER(state) __asm__ volatile("mrs %0, primask\n\tcpsid i" : "=r"(state)::"memory")
+/// Restores the interrupt mask saved in @p state.
+#define PORT_CRITICAL_EXIT(state) __asm__ volatile("msr primask, %0" ::"r"(state) : "memory")
+#else
+/// Saved signal mask: on a host, signal handlers play the part of interrupts.
+typedef sigset_t port_critical_state_t;
+/// Blocks every signal, saving the previous mask in @p state.
+#define PORT_CRITICAL_ENTER(state)                   \
+    do {                                             \
+        sigset_t all_;                               \
+        sigfillset(&all_);                           \
+        pthread_sigmask(SIG_BLOCK, &all_, &(state)); \
+    } while (0)
+/// Restores the signal mask saved in @p state.
+#define PORT_CRITICAL_EXIT(state) pthread_sigmask(SIG_SETMASK, &(state), NULL)
+#endif
+#endif
+
+#define PORT_ATOMIC_INIT(obj, value) (*(obj) = (value))
+#define PORT_ATOMIC_LOAD(obj, order) \
+    _Generic((obj), volatile bool*: port_atomic_load_bool_, default: port_atomic_load_size_)(obj, order)
+#define PORT_ATOMIC_STORE(obj, value, order)                             \
+    do {                                                                 \
+        if ((order) != PORT_ATOMIC_RELAXED) { PORT_COMPILER_BARRIER(); } \
+        *(obj) = (value);                                                \
+        if ((order) == PORT_ATOMIC_SEQ_CST) { PORT_COMPILER_BARRIER(); } \
+    } while (0)
+#define PORT_ATOMIC_FETCH_ADD(obj, value, order) port_atomic_fetch_add_(obj, value)
+#define PORT_ATOMIC_EXCHANGE(obj, value, order) \
+    _Generic((obj), volatile bool*: port_atomic_exchange_bool_, default: port_atomic_exchange_size_)(obj, value)
+#define PORT_ATOMIC_FENCE(order)                 PORT_COMPILER_BARRIER()
+
+#endif
+
+/* === Public data type declarations =========================================================== */
+
+#if defined(PORT_ATOMIC_USE_C11)
+typedef atomic_size_t port_atomic_size_t;  ///< Atomic size_t.
+typedef atomic_bool port_atomic_bool_t;    ///< Atomic bool.
+#elif defined(PORT_ATOMIC_USE_GCC)
+typedef size_t port_atomic_size_t;  ///< Atomic size_t, only accessed through the builtins.
+typedef bool port_atomic_bool_t;    ///< Atomic bool, only accessed through the builtins.
+#else
+typedef volatile size_t port_atomic_size_t;  ///< Atomic size_t: a word, so loads and stores are single accesses.
+typedef volatile bool port_atomic_bool_t;    ///< Atomic bool.
+#endif
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+#if defined(PORT_ATOMIC_USE_CRITICAL)
+
+/// Critical backend load: the barrier keeps later accesses from being hoisted above an acquire.
+static inline size_t port_atomic_load_size_(const volatile size_t* obj, int order)
+{
+    size_t value = *obj;
+    if (order != PORT_ATOMIC_RELAXED) { PORT_COMPILER_BARRIER(); }
+    return value;
+}
+
+/// Critical backend load, bool flavour.
+static inline bool port_atomic_load_bool_(const volatile bool* obj, int order)
+{
+    bool value = *obj;
+    if (order != PORT_ATOMIC_RELAXED) { PORT_COMPILER_BARRIER(); }
+    return value;
+}
+
+/// Critical backend fetch-and-add.
+static inline size_t port_atomic_fetch_add_(volatile size_t* obj, size_t value)
+{
+    port_critical_state_t state;
+
+    PORT_CRITICAL_ENTER(state);
+    size_t previous = *obj;
+    *obj = previous + value;
+    PORT_CRITICAL_EXIT(state);
+
+    return previous;
+}
+
+/// Critical backend exchange.
+static inline size_t port_atomic_exchange_size_(volatile size_t* obj, size_t value)
+{
+    port_critical_state_t state;
+
+    PORT_CRITICAL_ENTER(state);
+    size_t previous = *obj;
+    *obj = value;
+    PORT_CRITICAL_EXIT(state);
+
+    return previous;
+}
+
+/// Critical backend exchange, bool flavour.
+static inline bool port_atomic_exchange_bool_(volatile bool* obj, bool value)
+{
+    port_critical_state_t state;
+
+    PORT_CRITICAL_ENTER(state);
+    bool previous = *obj;
+    *obj = value;
+    PORT_CRITICAL_EXIT(state);
+
+    return previous;
+}
+
+#endif
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,177 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file ring_alloc.c
+/// @brief Circular allocator for transient, variable-size messages (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdlib.h>
+
+#include <utils/obj_pool/obj_pool.h>
+#include <utils/port_atomic/port_atomic.h>
+
+#include "ring_alloc.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Cache line size assumed to keep the head and the tail apart.
+#define CACHE_LINE_SIZE 64
+
+/// Header flag marking the space skipped at the end of the storage. Lengths are multiples of
+/// RING_ALLOC_ALIGN, so the low bit is free.
+#define SKIP_FLAG ((size_t)1)
+
+/* === Private data type declarations ========================================================== */
+
+///
+/// @brief Structure representing a circular allocator.
+///
+/// Head and tail are free-running byte positions, owned by the allocating and the freeing side
+/// respectively. The allocating side keeps a private copy of the tail, and only reads the real one
+/// when the copy says the storage is full.
+///
+struct ring_alloc_obj_t
+{
+    uint8_t* buffer;                                   ///< Pointer to the underlying storage.
+    size_t size;                                       ///< Size of the storage.
+    size_t mask;                                       ///< size - 1, used to wrap the positions.
+    alignas(CACHE_LINE_SIZE) port_atomic_size_t head;  ///< Position of the next block. Allocating side.
+    size_t tail_cache;                                 ///< Last tail seen by the allocating side.
+    alignas(CACHE_LINE_SIZE) port_atomic_size_t tail;  ///< Position of the oldest block. Freeing side.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static size_t* header(ring_alloc_t ra, size_t offset);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(ring_alloc_pool, ring_alloc_obj_t, RING_ALLOC_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static size_t* header(ring_alloc_t ra, size_t offset) { return (size_t*)(void*)&ra->buffer[offset]; }
+
+/* === Public function implementation ========================================================== */
+
+ring_alloc_t ring_alloc_init(uint8_t* buffer, size_t size)
+{
+    assert(buffer && ((uintptr_t)buffer % RING_ALLOC_ALIGN) == 0);
+    assert(size >= 2 * RING_ALLOC_ALIGN && ((size & (size - 1)) == 0));
+
+    ring_alloc_t ra = ring_alloc_pool_take();
+    assert(ra);
+
+    ra->buffer = buffer;
+    ra->size = size;
+    ra->mask = size - 1;
+    PORT_ATOMIC_INIT(&ra->head, 0);
+    PORT_ATOMIC_INIT(&ra->tail, 0);
+    ra->tail_cache = 0;
+
+    return ra;
+}
+
+void ring_alloc_deinit(ring_alloc_t* ra)
+{
+    assert(ra != NULL);
+    ring_alloc_pool_give(*ra);
+    *ra = NULL;
+}
+
+void* ring_alloc_alloc(ring_alloc_t ra, size_t size)
+{
+    assert(ra);
+
+    if (size > ring_alloc_max_size(ra)) { return NULL; }
+
+    size_t need = RING_ALLOC_ALIGN + ((size + RING_ALLOC_ALIGN - 1) & ~(RING_ALLOC_ALIGN - 1));
+    size_t head = PORT_ATOMIC_LOAD(&ra->head, PORT_ATOMIC_RELAXED);
+    size_t offset = head & ra->mask;
+
+    // A block never wraps around: if it does not fit before the end, the end is skipped.
+    size_t skip = (need > ra->size - offset) ? ra->size - offset : 0;
+
+    if (head + skip + need - ra->tail_cache > ra->size) {
+        ra->tail_cache = PORT_ATOMIC_LOAD(&ra->tail, PORT_ATOMIC_ACQUIRE);
+        if (head + skip + need - ra->tail_cache > ra->size) { return NULL; }
+    }
+
+    if (skip) {
+        *header(ra, offset) = skip | SKIP_FLAG;
+        offset = 0;
+    }
+    *header(ra, offset) = need;
+
+    PORT_ATOMIC_STORE(&ra->head, head + skip + need, PORT_ATOMIC_RELEASE);
+    return &ra->buffer[offset + RING_ALLOC_ALIGN];
+}
+
+void ring_alloc_free(ring_alloc_t ra, void* ptr)
+{
+    assert(ra);
+
+    if (!ptr) { return; }
+
+    size_t tail = PORT_ATOMIC_LOAD(&ra->tail, PORT_ATOMIC_RELAXED);
+    size_t offset = tail & ra->mask;
+    size_t len = *header(ra, offset);
+
+    if (len & SKIP_FLAG) {
+        tail += len & ~SKIP_FLAG;
+        offset = 0;
+        len = *header(ra, offset);
+    }
+
+    // Blocks must be released in allocation order.
+    assert(ptr == &ra->buffer[offset + RING_ALLOC_ALIGN]);
+
+    PORT_ATOMIC_STORE(&ra->tail, tail + len, PORT_ATOMIC_RELEASE);
+}
+
+size_t ring_alloc_used(ring_alloc_t ra)
+{
+    assert(ra);
+
+    size_t tail = PORT_ATOMIC_LOAD(&ra->tail, PORT_ATOMIC_ACQUIRE);
+    return PORT_ATOMIC_LOAD(&ra->head, PORT_ATOMIC_ACQUIRE) - tail;
+}
+
+size_t ring_alloc_capacity(ring_alloc_t ra)
+{
+    assert(ra);
+    return ra->size;
+}
+
+size_t ring_alloc_max_size(ring_alloc_t ra)
+{
+    assert(ra);
+    return ra->size - RING_ALLOC_ALIGN;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,125 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file ring_alloc.h
+/// @brief Circular allocator for transient, variable-size messages.
+///
+/// Messages going through the daemon live briefly and die in the order they were born, which the
+/// general heap knows nothing about. This allocator carves them out of a ring's storage instead:
+/// ring_alloc_alloc() returns contiguous memory at the head, and ring_alloc_free() must release the
+/// oldest block, moving the tail. Allocating is a pointer bump, freeing a header read, and consecutive
+/// messages sit next to each other in memory, so the consumer walks them in order while they are
+/// still in cache.
+///
+/// Each block is preceded by a header of RING_ALLOC_ALIGN bytes holding its length, and every block
+/// is RING_ALLOC_ALIGN aligned. A block that does not fit before the end of the storage starts over at
+/// its beginning, and the space left at the end is skipped. Allocations may come from one thread and
+/// frees from another, as long as each side sticks to a single thread, with blocks handed over through
+/// some other channel (e.g. a seq_ring of pointers).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef RING_ALLOC_POOL_SIZE
+/// Allocators available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define RING_ALLOC_POOL_SIZE 8
+#endif
+
+/// Alignment of every block, and size of the header preceding it.
+#define RING_ALLOC_ALIGN alignof(max_align_t)
+
+/* === Public data type declarations =========================================================== */
+
+/// Opaque circular allocator structure
+typedef struct ring_alloc_obj_t ring_alloc_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef ring_alloc_obj_t* ring_alloc_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Initializes a circular allocator over a pre-allocated buffer.
+/// @param buffer Pointer to the pre-allocated storage, RING_ALLOC_ALIGN aligned.
+/// @param size Size of the storage. Must be a power of two, at least twice RING_ALLOC_ALIGN.
+///
+ring_alloc_t ring_alloc_init(uint8_t* buffer, size_t size);
+
+///
+/// @brief Free an allocator structure. The storage is not free'd, since it's owner's responsibility.
+/// @param ra Allocator to free. Set to NULL afterwards.
+///
+void ring_alloc_deinit(ring_alloc_t* ra);
+
+///
+/// @brief Allocates a contiguous block at the head. Allocating thread only.
+/// @param ra Allocator to use.
+/// @param size Size of the block.
+/// @return RING_ALLOC_ALIGN aligned block, or NULL if the free space cannot hold it contiguously.
+///
+void* ring_alloc_alloc(ring_alloc_t ra, size_t size);
+
+///
+/// @brief Releases the oldest block. Freeing thread only.
+/// @param ra Allocator the block comes from.
+/// @param ptr Block to release, which must be the oldest one still allocated. NULL is ignored.
+///
+void ring_alloc_free(ring_alloc_t ra, void* ptr);
+
+///
+/// @brief Returns the number of bytes in use, headers and skipped space included. A hint while in use.
+/// @param ra Allocator to check.
+///
+size_t ring_alloc_used(ring_alloc_t ra);
+
+///
+/// @brief Returns the size of the storage.
+/// @param ra Allocator to check.
+///
+size_t ring_alloc_capacity(ring_alloc_t ra);
+
+///
+/// @brief Returns the largest block a single allocation could ever get: the storage minus a header.
+/// @param ra Allocator to check.
+///
+size_t ring_alloc_max_size(ring_alloc_t ra);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
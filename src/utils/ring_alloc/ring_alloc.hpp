@@ -0,0 +1,81 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file ring_alloc.hpp
+/// @brief `std::pmr::memory_resource` on top of a circular allocator.
+///
+/// Lets C++ code put transient messages, e.g. a `std::pmr::vector<std::uint8_t>` built per message, in
+/// a ring_alloc storage instead of the heap. The allocator's rules carry over: deallocations must
+/// happen in allocation order, so containers that reallocate as they grow should reserve() first, and
+/// each side of the resource must stay on its own thread.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+#include <utils/ring_alloc/ring_alloc.h>
+
+/* === Public data type declarations =========================================================== */
+
+namespace utils {
+
+///
+/// @brief Memory resource drawing from a ring_alloc allocator.
+///
+/// Allocation failures throw `std::bad_alloc`, as the interface requires, and so do alignments above
+/// RING_ALLOC_ALIGN. Resources compare equal only to themselves.
+///
+class ring_memory_resource : public std::pmr::memory_resource
+{
+  public:
+    /// Wraps an allocator, which must outlive the resource and is not released by it.
+    explicit ring_memory_resource(ring_alloc_t ra) : ra_(ra) {}
+
+    ring_memory_resource(const ring_memory_resource&) = delete;
+    ring_memory_resource& operator=(const ring_memory_resource&) = delete;
+
+    /// Returns the underlying allocator.
+    ring_alloc_t get() const { return ra_; }
+
+  private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        void* ptr = (alignment <= RING_ALLOC_ALIGN) ? ring_alloc_alloc(ra_, bytes) : nullptr;
+        if (!ptr) { throw std::bad_alloc(); }
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, std::size_t, std::size_t) override { ring_alloc_free(ra_, ptr); }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    ring_alloc_t ra_;
+};
+
+}  // namespace utils
+
+/* === End of documentation ==================================================================== */
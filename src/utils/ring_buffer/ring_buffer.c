@@ -29,6 +29,8 @@ SPDX-License-Identifier: MIT
 #include <assert.h>
 #include <stdlib.h>
 
+#include <utils/obj_pool/obj_pool.h>
+
 #include "ring_buffer.h"
 
 /* === Macros definitions ====================================================================== */
@@ -41,11 +43,14 @@ SPDX-License-Identifier: MIT
 ///
 struct ring_buf_t
 {
-    uint8_t* buffer;  ///< Pointer to the underlying buffer.
-    size_t capacity;  ///< Length of the buffer.
-    size_t tail;      ///< Index pointing to the next element to be read.
-    size_t head;      ///< Index pointing to the next element to be written.
-    bool is_full;     ///< Whether is full or not
+    uint8_t* buffer;           ///< Pointer to the underlying buffer.
+    size_t capacity;           ///< Length of the buffer.
+    size_t mask;               ///< capacity - 1, wraps indices without a division.
+    size_t tail;               ///< Index pointing to the next element to be read.
+    size_t head;               ///< Index pointing to the next element to be written.
+    bool is_full;              ///< Whether is full or not
+    size_t stream_threshold;   ///< Block size from which writes use streaming stores.
+    size_t prefetch_distance;  ///< Bytes reads prefetch ahead.
 };
 
 /* === Private variable declarations =========================================================== */
@@ -55,17 +60,20 @@ static void advance_head_pointer(ring_buffer_t rb);
 
 /* === Public variable definitions ============================================================= */
 /* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(ring_pool, ring_buf_t, RING_BUFFER_POOL_SIZE)
+
 /* === Private function implementation ========================================================= */
 
-static inline size_t advance_headtail_value(size_t value, size_t capacity) { return (value + 1) % capacity; }
+static inline size_t advance_headtail_value(size_t value, size_t mask) { return (value + 1) & mask; }
 
 static void advance_head_pointer(ring_buffer_t rb)
 {
     assert(rb);
 
-    if (ring_buffer_is_full(rb)) { rb->tail = advance_headtail_value(rb->tail, rb->capacity); }
+    if (ring_buffer_is_full(rb)) { rb->tail = advance_headtail_value(rb->tail, rb->mask); }
 
-    rb->head = advance_headtail_value(rb->head, rb->capacity);
+    rb->head = advance_headtail_value(rb->head, rb->mask);
     rb->is_full = (rb->head == rb->tail);
 }
 
@@ -73,13 +81,16 @@ static void advance_head_pointer(ring_buffer_t rb)
 
 ring_buffer_t ring_buffer_init(uint8_t* buffer, size_t size)
 {
-    assert(buffer && size);
+    assert(buffer && size && (size & (size - 1)) == 0);
 
-    ring_buffer_t rb = malloc(sizeof(ring_buf_t));
+    ring_buffer_t rb = ring_pool_take();
     assert(rb);
 
     rb->buffer = buffer;
     rb->capacity = size;
+    rb->mask = size - 1;
+    rb->stream_threshold = BULK_COPY_STREAM_THRESHOLD;
+    rb->prefetch_distance = BULK_COPY_PREFETCH_DISTANCE;
     ring_buffer_reset(rb);
 
     assert(ring_buffer_is_empty(rb));
@@ -90,7 +101,7 @@ ring_buffer_t ring_buffer_init(uint8_t* buffer, size_t size)
 void ring_buffer_deinit(ring_buffer_t* rb)
 {
     assert(rb != NULL);
-    free(*rb);
+    ring_pool_give(*rb);
     *rb = NULL;
 }
 
@@ -153,16 +164,80 @@ int ring_buffer_read_byte(ring_buffer_t rb, uint8_t* data)
 {
     assert(rb && data && rb->buffer);
 
-    int r = -1;
+    // Hot path of a TX-empty interrupt: test the indices directly rather than through the (asserting)
+    // public predicates, and wrap with the mask.
+    size_t tail = rb->tail;
+    if (tail == rb->head && !rb->is_full) { return -1; }
+
+    *data = rb->buffer[tail];
+    rb->tail = advance_headtail_value(tail, rb->mask);
+    rb->is_full = false;
+
+    return 0;
+}
+
+void ring_buffer_write(ring_buffer_t rb, const uint8_t* data, size_t len)
+{
+    assert(rb && rb->buffer && (data || !len));
+
+    // Only the last `capacity` bytes would survive anyway.
+    if (len > rb->capacity) {
+        data += len - rb->capacity;
+        len = rb->capacity;
+    }
+
+    size_t available = rb->capacity - ring_buffer_size(rb);
+
+    bulk_copy_in(rb->buffer, rb->capacity, rb->head, data, len, rb->stream_threshold);
+
+    rb->head = (rb->head + len) & rb->mask;
 
-    if (!ring_buffer_is_empty(rb)) {
-        *data = rb->buffer[rb->tail];
-        rb->tail = advance_headtail_value(rb->tail, rb->capacity);
-        rb->is_full = false;
-        r = 0;
+    if (len >= available && len > 0) {
+        // The oldest data was overwritten (or the buffer is exactly full): the new oldest byte is at head.
+        rb->tail = rb->head;
+        rb->is_full = true;
     }
+}
+
+size_t ring_buffer_read(ring_buffer_t rb, uint8_t* data, size_t len)
+{
+    assert(rb && rb->buffer && (data || !len));
+
+    size_t size = ring_buffer_size(rb);
+    size_t count = (size < len) ? size : len;
 
-    return r;
+    bulk_copy_out(rb->buffer, rb->capacity, rb->tail, data, count, rb->prefetch_distance);
+
+    rb->tail = (rb->tail + count) & rb->mask;
+    if (count > 0) { rb->is_full = false; }
+
+    return count;
+}
+
+size_t ring_buffer_peek(ring_buffer_t rb, size_t offset, uint8_t* data, size_t len)
+{
+    assert(rb && rb->buffer && (data || !len));
+
+    size_t size = ring_buffer_size(rb);
+    if (offset >= size) { return 0; }
+
+    size_t count = (size - offset < len) ? size - offset : len;
+
+    bulk_copy_out(rb->buffer, rb->capacity, (rb->tail + offset) & rb->mask, data, count, rb->prefetch_distance);
+
+    return count;
+}
+
+void ring_buffer_set_stream_threshold(ring_buffer_t rb, size_t threshold)
+{
+    assert(rb);
+    rb->stream_threshold = threshold;
+}
+
+void ring_buffer_set_prefetch_distance(ring_buffer_t rb, size_t distance)
+{
+    assert(rb);
+    rb->prefetch_distance = distance;
 }
 
 /* === End of documentation ==================================================================== */
@@ -39,6 +39,8 @@ SPDX-License-Identifier: MIT
 #include <stddef.h>
 #include <stdint.h>
 
+#include <utils/bulk_copy/bulk_copy.h>
+
 /* === C++ Guard =============================================================================== */
 
 #ifdef __cplusplus
@@ -47,6 +49,11 @@ extern "C" {
 
 /* === Public macros definitions =============================================================== */
 
+#ifndef RING_BUFFER_POOL_SIZE
+/// Rings available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define RING_BUFFER_POOL_SIZE 32
+#endif
+
 /* === Public data type declarations =========================================================== */
 
 /// Opaque circular buffer structure
@@ -135,6 +142,60 @@ void ring_buffer_write_byte(ring_buffer_t rb, uint8_t data);
 ///
 int ring_buffer_read_byte(ring_buffer_t rb, uint8_t* data);
 
+///
+/// @brief Writes a block of data to the ring buffer.
+///
+/// Same semantics as calling ring_buffer_write_byte() once per byte, with at most two copies: if the
+/// buffer runs out of space the oldest data is discarded, and if the block is larger than the buffer
+/// only its last bytes are kept.
+///
+/// @param rb Pointer to the ring buffer structure to write to.
+/// @param data The data to write.
+/// @param len Number of bytes to write.
+///
+void ring_buffer_write(ring_buffer_t rb, const uint8_t* data, size_t len);
+
+///
+/// @brief Reads a block of data from the ring buffer.
+///
+/// @param rb Pointer to the ring buffer structure to read from.
+/// @param data Buffer to store the read data, at least @p len bytes long.
+/// @param len Maximum number of bytes to read.
+/// @return Number of bytes actually read (0 if the buffer is empty).
+///
+size_t ring_buffer_read(ring_buffer_t rb, uint8_t* data, size_t len);
+
+///
+/// @brief Copies data out of the ring buffer without consuming it.
+///
+/// Only reads the ring, so it is async-signal-safe as long as the ring is not written concurrently.
+///
+/// @param rb Pointer to the ring buffer structure to read from.
+/// @param offset Number of stored bytes to skip, counted from the oldest.
+/// @param data Buffer to store the copied data, at least @p len bytes long.
+/// @param len Maximum number of bytes to copy.
+/// @return Number of bytes actually copied (0 if fewer than @p offset bytes are stored).
+///
+size_t ring_buffer_peek(ring_buffer_t rb, size_t offset, uint8_t* data, size_t len);
+
+///
+/// @brief Sets the block size from which ring_buffer_write() uses non-temporal stores.
+///
+/// Streaming stores keep large blocks that this core will not read back from evicting hot data. The
+/// default is BULK_COPY_STREAM_THRESHOLD.
+///
+/// @param rb Pointer to the ring buffer structure to configure.
+/// @param threshold Size in bytes, or BULK_COPY_NO_STREAM to always write through the cache.
+///
+void ring_buffer_set_stream_threshold(ring_buffer_t rb, size_t threshold);
+
+///
+/// @brief Sets how far ahead ring_buffer_read() prefetches. The default is BULK_COPY_PREFETCH_DISTANCE.
+/// @param rb Pointer to the ring buffer structure to configure.
+/// @param distance Distance in bytes, or 0 to disable prefetching.
+///
+void ring_buffer_set_prefetch_distance(ring_buffer_t rb, size_t distance);
+
 /* === End of documentation ==================================================================== */
 
 #ifdef __cplusplus
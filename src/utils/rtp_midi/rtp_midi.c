@@ -0,0 +1,486 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file rtp_midi.c
+/// @brief Network MIDI transport: RTP-MIDI (RFC 6295) over UDP with batched I/O (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <utils/obj_pool/obj_pool.h>
+#include <utils/tsc_clock/tsc_clock.h>
+
+#include "rtp_midi.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// RTP fixed header size.
+#define RTP_HEADER_SIZE 12
+
+/// MIDI command section header size, always sent in its two-byte form.
+#define COMMAND_HEADER_SIZE 2
+
+/// Largest datagram sent.
+#define TX_PACKET_SIZE (RTP_HEADER_SIZE + COMMAND_HEADER_SIZE + RTP_MIDI_MAX_COMMANDS)
+
+/// Largest datagram accepted.
+#define RX_PACKET_SIZE 1500
+
+/// RTP-MIDI timestamps run at 10 kHz, i.e. 100 us per tick.
+#define NS_PER_TICK 100000U
+
+/// Command section header flags.
+#define FLAG_B 0x80U  ///< Long (12-bit) length field.
+#define FLAG_Z 0x20U  ///< First command preceded by a delta time.
+
+/* === Private data type declarations ========================================================== */
+
+///
+/// @brief Structure representing a transport.
+///
+/// Besides the socket, it keeps the state needed to split the TX byte stream into messages across
+/// calls, and the packet buffers of a whole batch in each direction. TX packets the socket did not
+/// take stay in their buffers until a later call sends them.
+///
+struct rtp_midi_obj_t
+{
+    int fd;                                      ///< UDP socket.
+    struct sockaddr_in peer;                     ///< Destination of the sent packets.
+    bool connected;                              ///< Whether `peer` is set.
+    uint32_t ssrc;                               ///< RTP synchronization source identifier.
+    uint16_t seq;                                ///< Next RTP sequence number.
+    uint8_t partial[3];                          ///< TX message being assembled.
+    size_t partial_len;                          ///< Bytes in `partial`.
+    size_t expected;                             ///< Length of the message in `partial`.
+    uint8_t running_status;                      ///< Last channel status byte seen in the TX stream, 0 if none.
+    bool in_sysex;                               ///< Whether the TX stream is inside a system exclusive message.
+    rtp_midi_stats_t stats;                      ///< Statistics.
+    size_t tx_len[RTP_MIDI_BATCH];               ///< Size of each TX packet.
+    size_t tx_messages[RTP_MIDI_BATCH];          ///< MIDI messages in each TX packet.
+    size_t tx_next;                              ///< First TX packet not handed to the kernel yet.
+    size_t tx_count;                             ///< TX packets in the batch.
+    uint8_t tx[RTP_MIDI_BATCH][TX_PACKET_SIZE];  ///< TX packets.
+    size_t rx_len[RTP_MIDI_BATCH];               ///< Size of each RX packet.
+    uint8_t rx[RTP_MIDI_BATCH][RX_PACKET_SIZE];  ///< RX packets.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static size_t next_message(rtp_midi_t rtp, spsc_ring_t tx, uint8_t* out);
+static void put_be16(uint8_t* dst, uint16_t value);
+static void put_be32(uint8_t* dst, uint32_t value);
+static void packets_sent(rtp_midi_t rtp, size_t count);
+static int send_batch(rtp_midi_t rtp);
+static int receive_batch(rtp_midi_t rtp);
+static int decode_packet(rtp_midi_t rtp, const uint8_t* packet, size_t len, spsc_ring_t rx);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(session_pool, rtp_midi_obj_t, RTP_MIDI_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static size_t next_message(rtp_midi_t rtp, spsc_ring_t tx, uint8_t* out)
+{
+    uint8_t byte;
+
+    while (spsc_ring_read_byte(tx, &byte) == 0) {
+        if (byte >= 0xF8) {
+            // Real-time messages may show up anywhere, even inside another message.
+            out[0] = byte;
+            return 1;
+        }
+
+        if (byte == 0xF0 || byte == 0xF7) {
+            rtp->in_sysex = (byte == 0xF0);
+            rtp->partial_len = 0;
+            continue;
+        }
+
+        if (byte & 0x80) {
+            rtp->in_sysex = false;
+            rtp->partial[0] = byte;
+            rtp->partial_len = 1;
+            rtp->expected = rtp_midi_message_length(byte);
+            // System common messages cancel running status.
+            rtp->running_status = (byte < 0xF0) ? byte : 0;
+        } else {
+            if (rtp->in_sysex) { continue; }
+            if (rtp->partial_len == 0) {
+                if (!rtp->running_status) { continue; }
+                rtp->partial[0] = rtp->running_status;
+                rtp->partial_len = 1;
+                rtp->expected = rtp_midi_message_length(rtp->running_status);
+            }
+            rtp->partial[rtp->partial_len++] = byte;
+        }
+
+        if (rtp->expected == 0) {
+            // Undefined status: nothing to send.
+            rtp->partial_len = 0;
+        } else if (rtp->partial_len == rtp->expected) {
+            memcpy(out, rtp->partial, rtp->expected);
+            rtp->partial_len = 0;
+            return rtp->expected;
+        }
+    }
+
+    return 0;
+}
+
+static void put_be16(uint8_t* dst, uint16_t value)
+{
+    dst[0] = (uint8_t)(value >> 8);
+    dst[1] = (uint8_t)value;
+}
+
+static void put_be32(uint8_t* dst, uint32_t value)
+{
+    put_be16(dst, (uint16_t)(value >> 16));
+    put_be16(&dst[2], (uint16_t)value);
+}
+
+static void packets_sent(rtp_midi_t rtp, size_t count)
+{
+    for (size_t i = 0; i < count; i++) { rtp->stats.messages_sent += rtp->tx_messages[rtp->tx_next + i]; }
+    rtp->stats.packets_sent += count;
+    rtp->tx_next += count;
+}
+
+static int send_batch(rtp_midi_t rtp)
+{
+#if defined(__linux__)
+    struct mmsghdr msgs[RTP_MIDI_BATCH];
+    struct iovec iov[RTP_MIDI_BATCH];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (size_t i = rtp->tx_next; i < rtp->tx_count; i++) {
+        iov[i].iov_base = rtp->tx[i];
+        iov[i].iov_len = rtp->tx_len[i];
+        msgs[i].msg_hdr.msg_name = &rtp->peer;
+        msgs[i].msg_hdr.msg_namelen = sizeof(rtp->peer);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // The kernel may take only part of the batch: resubmit the rest, or keep it for later if the socket is full.
+    while (rtp->tx_next < rtp->tx_count) {
+        int n = sendmmsg(rtp->fd, &msgs[rtp->tx_next], (unsigned int)(rtp->tx_count - rtp->tx_next), 0);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        packets_sent(rtp, (size_t)n);
+    }
+#else
+    while (rtp->tx_next < rtp->tx_count) {
+        size_t i = rtp->tx_next;
+        if (sendto(rtp->fd, rtp->tx[i], rtp->tx_len[i], 0, (struct sockaddr*)&rtp->peer, sizeof(rtp->peer)) < 0) {
+            if (errno == EINTR) { continue; }
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        packets_sent(rtp, 1);
+    }
+#endif
+
+    return 0;
+}
+
+static int receive_batch(rtp_midi_t rtp)
+{
+#if defined(__linux__)
+    struct mmsghdr msgs[RTP_MIDI_BATCH];
+    struct iovec iov[RTP_MIDI_BATCH];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (size_t i = 0; i < RTP_MIDI_BATCH; i++) {
+        iov[i].iov_base = rtp->rx[i];
+        iov[i].iov_len = RX_PACKET_SIZE;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int n = recvmmsg(rtp->fd, msgs, RTP_MIDI_BATCH, MSG_DONTWAIT, NULL);
+    if (n < 0) { return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1; }
+
+    for (int i = 0; i < n; i++) { rtp->rx_len[i] = msgs[i].msg_len; }
+#else
+    int n = 0;
+
+    while (n < RTP_MIDI_BATCH) {
+        ssize_t len = recv(rtp->fd, rtp->rx[n], RX_PACKET_SIZE, 0);
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) { break; }
+            return -1;
+        }
+        rtp->rx_len[n++] = (size_t)len;
+    }
+#endif
+
+    return n;
+}
+
+static int decode_packet(rtp_midi_t rtp, const uint8_t* packet, size_t len, spsc_ring_t rx)
+{
+    if (len < RTP_HEADER_SIZE + 1 || (packet[0] & 0xC0) != 0x80 || (packet[0] & 0x10) ||
+        (packet[1] & 0x7F) != RTP_MIDI_PAYLOAD_TYPE) {
+        return -1;
+    }
+
+    // Skip the contributing sources, then read the command section header.
+    size_t pos = RTP_HEADER_SIZE + 4U * (packet[0] & 0x0F);
+    if (pos >= len) { return -1; }
+
+    uint8_t flags = packet[pos];
+    size_t list_len = flags & 0x0F;
+
+    if (flags & FLAG_B) {
+        if (pos + 1 >= len) { return -1; }
+        list_len = (list_len << 8) | packet[pos + 1];
+        pos += 2;
+    } else {
+        pos += 1;
+    }
+    if (pos + list_len > len) { return -1; }
+
+    // Any journal follows the command list, so it is skipped by simply stopping at its end.
+    const uint8_t* list = &packet[pos];
+    uint8_t status = 0;
+    int count = 0;
+
+    for (size_t i = 0; i < list_len;) {
+        if (count > 0 || (flags & FLAG_Z)) {
+            // Delta time: up to four bytes, all but the last with the high bit set.
+            while (i < list_len && (list[i] & 0x80)) { i++; }
+            i++;
+            if (i >= list_len) { break; }
+        }
+
+        uint8_t message[3];
+        size_t message_len;
+
+        if (list[i] == 0xF0) {
+            // System exclusive segment: not supported, skip up to its terminator.
+            for (i++; i < list_len && list[i] != 0xF7 && list[i] != 0xF0 && list[i] != 0xF4; i++) {}
+            i++;
+            count++;
+            continue;
+        }
+
+        if (list[i] & 0x80) {
+            message[0] = list[i++];
+            if (message[0] < 0xF0) { status = message[0]; }
+        } else if (status) {
+            message[0] = status;
+        } else {
+            return -1;
+        }
+
+        message_len = rtp_midi_message_length(message[0]);
+        if (message_len == 0 || i + message_len - 1 > list_len) { return -1; }
+
+        memcpy(&message[1], &list[i], message_len - 1);
+        i += message_len - 1;
+        count++;
+
+        if (spsc_ring_write(rx, message, message_len) == 0) {
+            rtp->stats.messages_received++;
+        } else {
+            rtp->stats.dropped++;
+        }
+    }
+
+    return count;
+}
+
+/* === Public function implementation ========================================================== */
+
+rtp_midi_t rtp_midi_init(const char* address, uint16_t port, uint32_t ssrc)
+{
+    assert(address);
+
+    struct sockaddr_in local = {.sin_family = AF_INET, .sin_port = htons(port)};
+    if (inet_pton(AF_INET, address, &local.sin_addr) != 1) { return NULL; }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) { return NULL; }
+
+    if (bind(fd, (struct sockaddr*)&local, sizeof(local)) != 0 ||
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    rtp_midi_t rtp = session_pool_take();
+    assert(rtp);
+
+    rtp->fd = fd;
+    rtp->ssrc = ssrc;
+
+    return rtp;
+}
+
+void rtp_midi_deinit(rtp_midi_t* rtp)
+{
+    assert(rtp != NULL);
+
+    if (*rtp) { close((*rtp)->fd); }
+
+    session_pool_give(*rtp);
+    *rtp = NULL;
+}
+
+uint16_t rtp_midi_local_port(rtp_midi_t rtp)
+{
+    assert(rtp);
+
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+
+    if (getsockname(rtp->fd, (struct sockaddr*)&local, &len) != 0) { return 0; }
+
+    return ntohs(local.sin_port);
+}
+
+int rtp_midi_connect(rtp_midi_t rtp, const char* address, uint16_t port)
+{
+    assert(rtp && address);
+
+    struct sockaddr_in peer = {.sin_family = AF_INET, .sin_port = htons(port)};
+    if (inet_pton(AF_INET, address, &peer.sin_addr) != 1) { return -1; }
+
+    rtp->peer = peer;
+    rtp->connected = true;
+
+    return 0;
+}
+
+int rtp_midi_send(rtp_midi_t rtp, spsc_ring_t tx)
+{
+    assert(rtp && tx && rtp->connected);
+
+    uint32_t timestamp = (uint32_t)(tsc_clock_now_ns() / NS_PER_TICK);
+    uint64_t before = rtp->stats.messages_sent;
+    size_t packets = 0;
+
+    // Packets left over by a full socket go first, and hold back the ring until they are out.
+    if (rtp->tx_next < rtp->tx_count) {
+        if (send_batch(rtp) != 0) { return -1; }
+        if (rtp->tx_next < rtp->tx_count) { return (int)(rtp->stats.messages_sent - before); }
+    }
+
+    while (packets < RTP_MIDI_BATCH) {
+        uint8_t* packet = rtp->tx[packets];
+        uint8_t* list = &packet[RTP_HEADER_SIZE + COMMAND_HEADER_SIZE];
+        size_t list_len = 0;
+        size_t count = 0;
+
+        // Every command but the first is preceded by a one-byte zero delta time.
+        while (list_len + 1 + 3 <= RTP_MIDI_MAX_COMMANDS) {
+            uint8_t message[3];
+            size_t len = next_message(rtp, tx, message);
+            if (len == 0) { break; }
+
+            if (count > 0) { list[list_len++] = 0; }
+            memcpy(&list[list_len], message, len);
+            list_len += len;
+            count++;
+        }
+
+        if (count == 0) { break; }
+
+        packet[0] = 0x80;
+        packet[1] = RTP_MIDI_PAYLOAD_TYPE;
+        put_be16(&packet[2], rtp->seq++);
+        put_be32(&packet[4], timestamp);
+        put_be32(&packet[8], rtp->ssrc);
+        packet[RTP_HEADER_SIZE] = (uint8_t)(FLAG_B | (list_len >> 8));
+        packet[RTP_HEADER_SIZE + 1] = (uint8_t)list_len;
+
+        rtp->tx_len[packets] = RTP_HEADER_SIZE + COMMAND_HEADER_SIZE + list_len;
+        rtp->tx_messages[packets++] = count;
+    }
+
+    rtp->tx_next = 0;
+    rtp->tx_count = packets;
+    if (send_batch(rtp) != 0) { return -1; }
+
+    return (int)(rtp->stats.messages_sent - before);
+}
+
+int rtp_midi_receive(rtp_midi_t rtp, spsc_ring_t rx)
+{
+    assert(rtp && rx);
+
+    uint64_t before = rtp->stats.messages_received;
+    int packets = receive_batch(rtp);
+
+    if (packets < 0) { return -1; }
+
+    for (int i = 0; i < packets; i++) {
+        if (decode_packet(rtp, rtp->rx[i], rtp->rx_len[i], rx) < 0) {
+            rtp->stats.malformed++;
+        } else {
+            rtp->stats.packets_received++;
+        }
+    }
+
+    return (int)(rtp->stats.messages_received - before);
+}
+
+void rtp_midi_get_stats(rtp_midi_t rtp, rtp_midi_stats_t* stats)
+{
+    assert(rtp && stats);
+    *stats = rtp->stats;
+}
+
+size_t rtp_midi_message_length(uint8_t status)
+{
+    static const uint8_t system_lengths[8] = {0, 2, 3, 2, 0, 0, 1, 0};
+
+    if (status < 0x80) { return 0; }
+    if (status >= 0xF8) { return 1; }
+    if (status >= 0xF0) { return system_lengths[status & 0x07]; }
+
+    // Program change and channel pressure carry one data byte, the other channel messages two.
+    return ((status & 0xE0) == 0xC0) ? 2 : 3;
+}
+
+/* === End of documentation ==================================================================== */
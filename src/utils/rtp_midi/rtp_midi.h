@@ -0,0 +1,157 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file rtp_midi.h
+/// @brief Network MIDI transport: RTP-MIDI (RFC 6295) over UDP with batched I/O.
+///
+/// rtp_midi_send() drains a TX ring holding a MIDI byte stream into RTP-MIDI packets, packing as many
+/// messages per packet and as many packets per sendmmsg() call as available. rtp_midi_receive() reads
+/// a batch of packets with a single recvmmsg() call and writes the messages they carry into an RX ring.
+///
+/// Only the RTP payload is handled, without session management. Packets are sent without recovery
+/// journal, for the lowest latency; journals in received packets are skipped. System exclusive
+/// messages are not supported and are discarded.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/spsc_ring/spsc_ring.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef RTP_MIDI_POOL_SIZE
+/// Sessions available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define RTP_MIDI_POOL_SIZE 4
+#endif
+
+/// RTP payload type used for RTP-MIDI (dynamic range).
+#define RTP_MIDI_PAYLOAD_TYPE 97
+
+/// Largest MIDI command section per packet, in bytes. Keeps packets below a typical MTU.
+#define RTP_MIDI_MAX_COMMANDS 1024
+
+/// Number of packets per sendmmsg() or recvmmsg() call.
+#define RTP_MIDI_BATCH 32
+
+/* === Public data type declarations =========================================================== */
+
+/// Opaque transport structure
+typedef struct rtp_midi_obj_t rtp_midi_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef rtp_midi_obj_t* rtp_midi_t;
+
+/// Transport statistics.
+typedef struct
+{
+    uint64_t packets_sent;       ///< Packets handed to the kernel, not counting those waiting for a retry.
+    uint64_t messages_sent;      ///< MIDI messages in those packets.
+    uint64_t packets_received;   ///< Valid packets received.
+    uint64_t messages_received;  ///< MIDI messages written to the RX ring.
+    uint64_t dropped;            ///< Received messages lost because the RX ring was full.
+    uint64_t malformed;          ///< Received datagrams that were not valid RTP-MIDI.
+} rtp_midi_stats_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Opens a non-blocking UDP endpoint.
+/// @param address Local IPv4 address to bind to, e.g. "127.0.0.1" or "0.0.0.0".
+/// @param port Local UDP port, or 0 to let the system pick one (see rtp_midi_local_port()).
+/// @param ssrc RTP synchronization source identifier of this endpoint.
+/// @return The transport, or NULL if the socket could not be opened.
+///
+rtp_midi_t rtp_midi_init(const char* address, uint16_t port, uint32_t ssrc);
+
+///
+/// @brief Closes the endpoint and frees the transport structure.
+/// @param rtp Transport to free. Set to NULL afterwards.
+///
+void rtp_midi_deinit(rtp_midi_t* rtp);
+
+///
+/// @brief Returns the local UDP port.
+/// @param rtp Transport to check.
+///
+uint16_t rtp_midi_local_port(rtp_midi_t rtp);
+
+///
+/// @brief Sets the destination of the sent packets.
+/// @param rtp Transport to configure.
+/// @param address Peer IPv4 address.
+/// @param port Peer UDP port.
+/// @return 0 on success, or -1 if the address is invalid.
+///
+int rtp_midi_connect(rtp_midi_t rtp, const char* address, uint16_t port);
+
+///
+/// @brief Sends every complete MIDI message pending in a TX ring. The transport is the ring's consumer.
+///
+/// A message still being written by the producer is kept and sent by a later call. So are the packets
+/// the socket does not take because its send buffer is full: nothing read from the ring is lost, the
+/// next call sends them first and reads no more from the ring until they are out.
+///
+/// @param rtp Transport to use. Must be connected.
+/// @param tx Ring holding the MIDI byte stream.
+/// @return Number of MIDI messages sent, or -1 if the socket failed.
+///
+int rtp_midi_send(rtp_midi_t rtp, spsc_ring_t tx);
+
+///
+/// @brief Receives the pending packets, without blocking. The transport is the ring's producer.
+/// @param rtp Transport to use.
+/// @param rx Ring to write the MIDI messages to.
+/// @return Number of MIDI messages written to @p rx, or -1 if the socket failed.
+///
+int rtp_midi_receive(rtp_midi_t rtp, spsc_ring_t rx);
+
+///
+/// @brief Returns the transport statistics.
+/// @param rtp Transport to check.
+/// @param stats Where to store the statistics.
+///
+void rtp_midi_get_stats(rtp_midi_t rtp, rtp_midi_stats_t* stats);
+
+///
+/// @brief Returns the length of a MIDI message given its status byte.
+/// @param status Status byte.
+/// @return Length in bytes, status included, or 0 for system exclusive and non-status bytes.
+///
+size_t rtp_midi_message_length(uint8_t status);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,184 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file seq_ring.c
+/// @brief Sequenced ring shared by the stages of a pipeline (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdlib.h>
+
+#include <utils/obj_pool/obj_pool.h>
+#include <utils/port_atomic/port_atomic.h>
+
+#include "seq_ring.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Cache line size assumed to keep the stage cursors apart.
+#define CACHE_LINE_SIZE 64
+
+/* === Private data type declarations ========================================================== */
+
+/// Per-stage state, on its own cache line.
+typedef struct
+{
+    alignas(CACHE_LINE_SIZE) port_atomic_size_t cursor;  ///< Free-running sequence of the next entry to process.
+    size_t limit_cache;                                  ///< Owner's last observed processing limit.
+} stage_t;
+
+///
+/// @brief Structure representing a sequenced ring.
+///
+/// Each stage only writes its own cursor and reads its upstream one, keeping a private copy of the
+/// resulting limit so it only touches the upstream cache line when the copy runs out.
+///
+struct seq_ring_obj_t
+{
+    uint8_t* entries;                    ///< Pointer to the underlying entries.
+    size_t entry_size;                   ///< Size of each entry.
+    size_t count;                        ///< Number of entries.
+    size_t mask;                         ///< count - 1, used to wrap the sequences.
+    size_t stages;                       ///< Number of stages in use.
+    stage_t stage[SEQ_RING_MAX_STAGES];  ///< Stage cursors.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static size_t stage_limit(seq_ring_t ring, size_t stage);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(ring_pool, seq_ring_obj_t, SEQ_RING_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static size_t stage_limit(seq_ring_t ring, size_t stage)
+{
+    // The producer may run a whole ring ahead of the last stage, the rest up to their upstream stage.
+    if (stage == 0) {
+        return PORT_ATOMIC_LOAD(&ring->stage[ring->stages - 1].cursor, PORT_ATOMIC_ACQUIRE) + ring->count;
+    }
+    return PORT_ATOMIC_LOAD(&ring->stage[stage - 1].cursor, PORT_ATOMIC_ACQUIRE);
+}
+
+/* === Public function implementation ========================================================== */
+
+seq_ring_t seq_ring_init(void* entries, size_t entry_size, size_t count, size_t stages)
+{
+    assert(entries && entry_size && count && ((count & (count - 1)) == 0));
+    assert(stages >= 2 && stages <= SEQ_RING_MAX_STAGES);
+
+    seq_ring_t ring = ring_pool_take();
+    assert(ring);
+
+    ring->entries = entries;
+    ring->entry_size = entry_size;
+    ring->count = count;
+    ring->mask = count - 1;
+    ring->stages = stages;
+
+    for (size_t i = 0; i < SEQ_RING_MAX_STAGES; i++) {
+        PORT_ATOMIC_INIT(&ring->stage[i].cursor, 0);
+        ring->stage[i].limit_cache = 0;
+    }
+    ring->stage[0].limit_cache = count;
+
+    return ring;
+}
+
+void seq_ring_deinit(seq_ring_t* ring)
+{
+    assert(ring != NULL);
+    ring_pool_give(*ring);
+    *ring = NULL;
+}
+
+size_t seq_ring_count(seq_ring_t ring)
+{
+    assert(ring);
+    return ring->count;
+}
+
+size_t seq_ring_entry_size(seq_ring_t ring)
+{
+    assert(ring);
+    return ring->entry_size;
+}
+
+size_t seq_ring_stages(seq_ring_t ring)
+{
+    assert(ring);
+    return ring->stages;
+}
+
+size_t seq_ring_cursor(seq_ring_t ring, size_t stage)
+{
+    assert(ring && stage < ring->stages);
+    return PORT_ATOMIC_LOAD(&ring->stage[stage].cursor, PORT_ATOMIC_RELAXED);
+}
+
+size_t seq_ring_available(seq_ring_t ring, size_t stage)
+{
+    assert(ring && stage < ring->stages);
+
+    stage_t* self = &ring->stage[stage];
+    size_t cursor = PORT_ATOMIC_LOAD(&self->cursor, PORT_ATOMIC_RELAXED);
+
+    if (self->limit_cache == cursor) { self->limit_cache = stage_limit(ring, stage); }
+
+    return self->limit_cache - cursor;
+}
+
+void* seq_ring_entry(seq_ring_t ring, size_t seq)
+{
+    assert(ring);
+    return &ring->entries[(seq & ring->mask) * ring->entry_size];
+}
+
+size_t seq_ring_contiguous(seq_ring_t ring, size_t seq, size_t count)
+{
+    assert(ring);
+
+    size_t until_end = ring->count - (seq & ring->mask);
+    return (count < until_end) ? count : until_end;
+}
+
+void seq_ring_advance(seq_ring_t ring, size_t stage, size_t count)
+{
+    assert(ring && stage < ring->stages);
+
+    stage_t* self = &ring->stage[stage];
+    size_t cursor = PORT_ATOMIC_LOAD(&self->cursor, PORT_ATOMIC_RELAXED);
+
+    assert(count <= self->limit_cache - cursor);
+
+    // Release: the entries' new contents are visible to the next stage before the cursor.
+    PORT_ATOMIC_STORE(&self->cursor, cursor + count, PORT_ATOMIC_RELEASE);
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,157 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file seq_ring.h
+/// @brief Sequenced ring shared by the stages of a pipeline.
+///
+/// Instead of chaining one ring per stage (and copying every message at each hop), all the stages of
+/// a pipeline share a single ring of fixed-size entries. Each stage owns a free-running cursor and may
+/// only process entries its upstream stage is done with; entries are modified in place. Stage 0 is the
+/// producer: it fills entries and may only reuse those the last stage is done with. Every stage can run
+/// on its own thread, but each cursor must be advanced by a single thread.
+///
+/// A stage typically does:
+///
+///     size_t n = seq_ring_available(ring, stage);
+///     size_t seq = seq_ring_cursor(ring, stage);
+///     for (size_t i = 0; i < n; i++) { process(seq_ring_entry(ring, seq + i)); }
+///     seq_ring_advance(ring, stage, n);
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef SEQ_RING_POOL_SIZE
+/// Rings available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define SEQ_RING_POOL_SIZE 4
+#endif
+
+/// Maximum number of stages, producer included.
+#define SEQ_RING_MAX_STAGES 8
+
+/* === Public data type declarations =========================================================== */
+
+/// Opaque sequenced ring structure
+typedef struct seq_ring_obj_t seq_ring_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef seq_ring_obj_t* seq_ring_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Initializes a sequenced ring over a pre-allocated array of entries.
+/// @param entries Pointer to the pre-allocated entries, @p count * @p entry_size bytes.
+/// @param entry_size Size of each entry.
+/// @param count Number of entries. Must be a power of two.
+/// @param stages Number of stages, producer included. Between 2 and SEQ_RING_MAX_STAGES.
+///
+seq_ring_t seq_ring_init(void* entries, size_t entry_size, size_t count, size_t stages);
+
+///
+/// @brief Free a sequenced ring structure. Entries are not free'd, since it's owner's responsibility.
+/// @param ring Ring to free. Set to NULL afterwards.
+///
+void seq_ring_deinit(seq_ring_t* ring);
+
+///
+/// @brief Returns the number of entries.
+/// @param ring Ring to check.
+///
+size_t seq_ring_count(seq_ring_t ring);
+
+///
+/// @brief Returns the size of each entry, as given to seq_ring_init().
+/// @param ring Ring to check.
+///
+size_t seq_ring_entry_size(seq_ring_t ring);
+
+///
+/// @brief Returns the number of stages, producer included.
+/// @param ring Ring to check.
+///
+size_t seq_ring_stages(seq_ring_t ring);
+
+///
+/// @brief Returns the sequence of the next entry a stage will process. Owning thread only.
+/// @param ring Ring to check.
+/// @param stage Stage to check.
+///
+size_t seq_ring_cursor(seq_ring_t ring, size_t stage);
+
+///
+/// @brief Returns how many entries a stage may process right now. Owning thread only.
+///
+/// For the producer (stage 0) these are free entries, for the others entries their upstream stage is done with.
+///
+/// The upstream cursor is only re-read once the previously seen entries are used up, so the result may
+/// be lower than what is actually available, but the upstream cache line is left alone on most calls.
+///
+/// @param ring Ring to check.
+/// @param stage Stage to check.
+///
+size_t seq_ring_available(seq_ring_t ring, size_t stage);
+
+///
+/// @brief Returns the entry holding a sequence.
+/// @param ring Ring to access.
+/// @param seq Sequence, within the range the calling stage may process.
+///
+void* seq_ring_entry(seq_ring_t ring, size_t seq);
+
+///
+/// @brief Returns how many of the entries starting at a sequence are contiguous in memory.
+///
+/// Lets a stage walk its available entries as at most two plain arrays instead of one entry at a time.
+///
+/// @param ring Ring to check.
+/// @param seq First sequence.
+/// @param count Number of entries wanted.
+///
+size_t seq_ring_contiguous(seq_ring_t ring, size_t seq, size_t count);
+
+///
+/// @brief Marks entries as done, handing them over to the next stage. Owning thread only.
+/// @param ring Ring to update.
+/// @param stage Stage that is done.
+/// @param count Number of entries done, at most what seq_ring_available() returned.
+///
+void seq_ring_advance(seq_ring_t ring, size_t stage, size_t count);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
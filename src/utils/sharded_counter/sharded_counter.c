@@ -0,0 +1,137 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file sharded_counter.c
+/// @brief Per-thread sharded counters, aggregated lazily by the readers (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include <utils/obj_pool/obj_pool.h>
+
+#include "sharded_counter.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Cache line size assumed to keep the slots apart.
+#define CACHE_LINE_SIZE 64
+
+/* === Private data type declarations ========================================================== */
+
+/// A single slot, alone in its cache line.
+typedef struct
+{
+    alignas(CACHE_LINE_SIZE) atomic_uint_fast64_t value;  ///< Partial count of the threads mapped to this slot.
+} slot_t;
+
+///
+/// @brief Structure representing a sharded counter.
+///
+struct sharded_counter_obj_t
+{
+    slot_t slots[SHARDED_COUNTER_SLOTS];  ///< One slot per thread (modulo SHARDED_COUNTER_SLOTS).
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static unsigned int thread_slot(void);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(counter_pool, sharded_counter_obj_t, SHARDED_COUNTER_POOL_SIZE)
+
+/// Next slot to hand out to a thread that increments a counter for the first time.
+static atomic_uint next_slot = 0;
+
+/// Slot assigned to the calling thread, shared by every counter.
+static _Thread_local unsigned int current_slot = UINT_MAX;
+
+/* === Private function implementation ========================================================= */
+
+static unsigned int thread_slot(void)
+{
+    if (current_slot == UINT_MAX) {
+        current_slot = atomic_fetch_add_explicit(&next_slot, 1, memory_order_relaxed) & (SHARDED_COUNTER_SLOTS - 1);
+    }
+
+    return current_slot;
+}
+
+/* === Public function implementation ========================================================== */
+
+sharded_counter_t sharded_counter_init(void)
+{
+    sharded_counter_t counter = counter_pool_take();
+    assert(counter);
+
+    for (unsigned int i = 0; i < SHARDED_COUNTER_SLOTS; i++) { atomic_init(&counter->slots[i].value, 0); }
+
+    return counter;
+}
+
+void sharded_counter_deinit(sharded_counter_t* counter)
+{
+    assert(counter != NULL);
+    counter_pool_give(*counter);
+    *counter = NULL;
+}
+
+void sharded_counter_add(sharded_counter_t counter, uint64_t value)
+{
+    assert(counter);
+
+    // The line is owned by this thread's core, so the atomic add stays local. It's only needed for
+    // the rare threads sharing a slot.
+    atomic_fetch_add_explicit(&counter->slots[thread_slot()].value, value, memory_order_relaxed);
+}
+
+uint64_t sharded_counter_sum(sharded_counter_t counter)
+{
+    assert(counter);
+
+    uint64_t sum = 0;
+
+    for (unsigned int i = 0; i < SHARDED_COUNTER_SLOTS; i++) {
+        sum += atomic_load_explicit(&counter->slots[i].value, memory_order_relaxed);
+    }
+
+    return sum;
+}
+
+void sharded_counter_reset(sharded_counter_t counter)
+{
+    assert(counter);
+
+    for (unsigned int i = 0; i < SHARDED_COUNTER_SLOTS; i++) {
+        atomic_store_explicit(&counter->slots[i].value, 0, memory_order_relaxed);
+    }
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,98 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file sharded_counter.h
+/// @brief Per-thread sharded counters, aggregated lazily by the readers.
+///
+/// Each thread increments its own cache-line-padded slot, so writers never bounce a shared line
+/// between cores. Readers (e.g. the metrics endpoint) add all the slots up on demand; the result is
+/// exact once the writers are quiescent and a good estimate while they are running.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef SHARDED_COUNTER_POOL_SIZE
+/// Counters available when built with UTILS_NO_HEAP (see obj_pool.h). spsc_ring statistics take four.
+#define SHARDED_COUNTER_POOL_SIZE 32
+#endif
+
+/// Number of slots per counter. Must be a power of two. Threads beyond this number share slots.
+#define SHARDED_COUNTER_SLOTS 16U
+
+/* === Public data type declarations =========================================================== */
+
+/// Opaque sharded counter structure
+typedef struct sharded_counter_obj_t sharded_counter_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef sharded_counter_obj_t* sharded_counter_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Creates a sharded counter, initialized to zero.
+///
+sharded_counter_t sharded_counter_init(void);
+
+///
+/// @brief Free a sharded counter structure.
+/// @param counter Counter to free. Set to NULL afterwards.
+///
+void sharded_counter_deinit(sharded_counter_t* counter);
+
+///
+/// @brief Adds @p value to the calling thread's slot.
+/// @param counter Counter to increment.
+/// @param value Amount to add.
+///
+void sharded_counter_add(sharded_counter_t counter, uint64_t value);
+
+///
+/// @brief Returns the sum of all slots.
+/// @param counter Counter to read.
+///
+uint64_t sharded_counter_sum(sharded_counter_t counter);
+
+///
+/// @brief Sets every slot to zero. Increments running concurrently may survive the reset.
+/// @param counter Counter to reset.
+///
+void sharded_counter_reset(sharded_counter_t counter);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
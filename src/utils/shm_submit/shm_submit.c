@@ -0,0 +1,474 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file shm_submit.c
+/// @brief Local MIDI submission over shared memory, set up through a Unix socket (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <utils/obj_pool/obj_pool.h>
+
+#include "shm_submit.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Cache line size assumed to keep producer and consumer fields apart.
+#define CACHE_LINE_SIZE 64
+
+/// Marks a mapping as a submission ring.
+#define RING_MAGIC 0x534D4952U
+
+/// Record header: port and length.
+#define RECORD_HEADER_SIZE 2
+
+/* === Private data type declarations ========================================================== */
+
+///
+/// @brief Ring shared between a client and the daemon.
+///
+/// Lives in the memfd, so it holds no pointers: only free-running byte positions and the data. The
+/// client can scribble over all of it, so the daemon never trusts `capacity`, masks every position,
+/// keeps its own copy of `tail` and checks `head` and every record length against it.
+///
+typedef struct
+{
+    alignas(CACHE_LINE_SIZE) _Atomic uint64_t head;  ///< Bytes ever written, moved by the client.
+    alignas(CACHE_LINE_SIZE) _Atomic uint64_t tail;  ///< Bytes ever read, moved by the daemon.
+    alignas(CACHE_LINE_SIZE) atomic_bool parked;     ///< Whether the daemon sleeps and wants an eventfd write.
+    uint32_t magic;                                  ///< RING_MAGIC.
+    uint32_t capacity;                               ///< Size of `data`.
+    alignas(CACHE_LINE_SIZE) uint8_t data[];         ///< Records: port, length, payload.
+} shm_ring_t;
+
+/// Daemon side of a connected client.
+typedef struct
+{
+    int conn;          ///< Unix socket connection, watched for hang-ups.
+    int event;         ///< Eventfd the client writes to wake the daemon.
+    shm_ring_t* ring;  ///< Shared ring.
+    uint64_t tail;     ///< Bytes read. The copy in the ring is only published, never read back.
+    bool closed;       ///< Whether the client left.
+} client_t;
+
+/// Structure representing the daemon side.
+struct shm_server_obj_t
+{
+    int listener;                                           ///< Listening Unix socket.
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];  ///< Socket path.
+    spsc_ring_t* ports;                                     ///< TX ring of each port.
+    size_t port_count;                                      ///< Number of ports.
+    size_t count;                                           ///< Number of clients.
+    client_t clients[SHM_SUBMIT_MAX_CLIENTS];               ///< Connected clients.
+};
+
+/// Structure representing the client side.
+struct shm_client_obj_t
+{
+    int conn;             ///< Unix socket connection.
+    int event;            ///< Eventfd to wake the daemon.
+    shm_ring_t* ring;     ///< Shared ring.
+    size_t map_size;      ///< Size of the mapping.
+    uint64_t tail_cache;  ///< Last observed value of `ring->tail`.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static size_t map_size(void);
+static void ring_copy_in(shm_ring_t* ring, uint64_t pos, const uint8_t* data, size_t len);
+static void ring_copy_out(const shm_ring_t* ring, uint64_t pos, uint8_t* data, size_t len);
+static int send_fds(int conn, int memfd, int event);
+static int receive_fds(int conn, int* memfd, int* event);
+static int add_client(shm_server_t srv, int conn);
+static void remove_client(shm_server_t srv, size_t index);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(server_pool, shm_server_obj_t, SHM_SUBMIT_SERVER_POOL_SIZE)
+OBJ_POOL_DEFINE(client_pool, shm_client_obj_t, SHM_SUBMIT_CLIENT_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static size_t map_size(void) { return sizeof(shm_ring_t) + SHM_SUBMIT_RING_SIZE; }
+
+static void ring_copy_in(shm_ring_t* ring, uint64_t pos, const uint8_t* data, size_t len)
+{
+    size_t offset = pos & (SHM_SUBMIT_RING_SIZE - 1);
+    size_t first = SHM_SUBMIT_RING_SIZE - offset;
+
+    if (first > len) { first = len; }
+    memcpy(&ring->data[offset], data, first);
+    memcpy(ring->data, &data[first], len - first);
+}
+
+static void ring_copy_out(const shm_ring_t* ring, uint64_t pos, uint8_t* data, size_t len)
+{
+    size_t offset = pos & (SHM_SUBMIT_RING_SIZE - 1);
+    size_t first = SHM_SUBMIT_RING_SIZE - offset;
+
+    if (first > len) { first = len; }
+    memcpy(data, &ring->data[offset], first);
+    memcpy(&data[first], ring->data, len - first);
+}
+
+static int send_fds(int conn, int memfd, int event)
+{
+    int fds[2] = {memfd, event};
+    char control[CMSG_SPACE(sizeof(fds))];
+    uint8_t byte = 0;
+    struct iovec iov = {.iov_base = &byte, .iov_len = 1};
+    struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = control, .msg_controllen = sizeof(control)};
+
+    memset(control, 0, sizeof(control));
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    return (sendmsg(conn, &msg, MSG_NOSIGNAL) == 1) ? 0 : -1;
+}
+
+static int receive_fds(int conn, int* memfd, int* event)
+{
+    int fds[2];
+    char control[CMSG_SPACE(sizeof(fds))];
+    uint8_t byte;
+    struct iovec iov = {.iov_base = &byte, .iov_len = 1};
+    struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = control, .msg_controllen = sizeof(control)};
+
+    if (recvmsg(conn, &msg, MSG_CMSG_CLOEXEC) != 1) { return -1; }
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) { return -1; }
+
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    *memfd = fds[0];
+    *event = fds[1];
+
+    return 0;
+}
+
+static int add_client(shm_server_t srv, int conn)
+{
+    if (srv->count == SHM_SUBMIT_MAX_CLIENTS) { return -1; }
+
+    int memfd = memfd_create("shm_submit", MFD_CLOEXEC);
+    int event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    shm_ring_t* ring = MAP_FAILED;
+
+    if (memfd >= 0 && event >= 0 && ftruncate(memfd, (off_t)map_size()) == 0) {
+        ring = mmap(NULL, map_size(), PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    }
+
+    if (ring != MAP_FAILED) {
+        atomic_init(&ring->head, 0);
+        atomic_init(&ring->tail, 0);
+        atomic_init(&ring->parked, false);
+        ring->capacity = SHM_SUBMIT_RING_SIZE;
+        ring->magic = RING_MAGIC;
+    }
+
+    if (ring == MAP_FAILED || send_fds(conn, memfd, event) != 0) {
+        if (ring != MAP_FAILED) { munmap(ring, map_size()); }
+        if (event >= 0) { close(event); }
+        if (memfd >= 0) { close(memfd); }
+        return -1;
+    }
+
+    // The mapping keeps the memory alive, the descriptor is no longer needed.
+    close(memfd);
+
+    srv->clients[srv->count++] = (client_t){.conn = conn, .event = event, .ring = ring, .tail = 0, .closed = false};
+
+    return 0;
+}
+
+static void remove_client(shm_server_t srv, size_t index)
+{
+    client_t* client = &srv->clients[index];
+
+    munmap(client->ring, map_size());
+    close(client->event);
+    close(client->conn);
+
+    srv->clients[index] = srv->clients[--srv->count];
+}
+
+/* === Public function implementation ========================================================== */
+
+shm_server_t shm_server_init(const char* path, spsc_ring_t* ports, size_t port_count)
+{
+    assert(path && (ports || !port_count));
+
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) { return NULL; }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) { return NULL; }
+
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SHM_SUBMIT_MAX_CLIENTS) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    shm_server_t srv = server_pool_take();
+    assert(srv);
+
+    srv->listener = fd;
+    strcpy(srv->path, path);
+    srv->ports = ports;
+    srv->port_count = port_count;
+    srv->count = 0;
+
+    return srv;
+}
+
+void shm_server_deinit(shm_server_t* srv)
+{
+    assert(srv != NULL);
+
+    if (*srv) {
+        while ((*srv)->count) { remove_client(*srv, 0); }
+        close((*srv)->listener);
+        unlink((*srv)->path);
+    }
+
+    server_pool_give(*srv);
+    *srv = NULL;
+}
+
+size_t shm_server_accept(shm_server_t srv)
+{
+    assert(srv);
+
+    size_t accepted = 0;
+    int conn;
+
+    while ((conn = accept4(srv->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        if (add_client(srv, conn) == 0) {
+            accepted++;
+        } else {
+            close(conn);
+        }
+    }
+
+    return accepted;
+}
+
+size_t shm_server_merge(shm_server_t srv)
+{
+    assert(srv);
+
+    size_t merged = 0;
+
+    for (size_t i = srv->count; i-- > 0;) {
+        client_t* client = &srv->clients[i];
+        shm_ring_t* ring = client->ring;
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t tail = client->tail;
+        bool corrupt = (head - tail > SHM_SUBMIT_RING_SIZE);
+
+        while (!corrupt && tail != head) {
+            uint8_t header[RECORD_HEADER_SIZE];
+            uint8_t payload[SHM_SUBMIT_MAX_MESSAGE];
+
+            // A record must lie entirely within what the client published.
+            ring_copy_out(ring, tail, header, sizeof(header));
+            if (head - tail < sizeof(header) || head - tail - sizeof(header) < header[1]) {
+                corrupt = true;
+                break;
+            }
+            ring_copy_out(ring, tail + sizeof(header), payload, header[1]);
+
+            // Leave the message in place while its port is congested.
+            if (header[0] < srv->port_count && spsc_ring_write(srv->ports[header[0]], payload, header[1]) != 0) {
+                break;
+            }
+
+            tail += sizeof(header) + header[1];
+            merged++;
+        }
+
+        client->tail = tail;
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        // A client that corrupted its ring is dropped along with whatever it had left in it.
+        if (corrupt || (client->closed && tail == head)) { remove_client(srv, i); }
+    }
+
+    return merged;
+}
+
+void shm_server_wait(shm_server_t srv, int timeout_ms)
+{
+    assert(srv);
+
+    struct pollfd fds[1 + 2 * SHM_SUBMIT_MAX_CLIENTS];
+    bool pending = false;
+
+    // Dekker-style handshake with shm_client_submit(): either the client sees `parked`, or we see its data.
+    for (size_t i = 0; i < srv->count; i++) {
+        atomic_store_explicit(&srv->clients[i].ring->parked, true, memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_seq_cst);
+    for (size_t i = 0; i < srv->count; i++) {
+        pending |= atomic_load_explicit(&srv->clients[i].ring->head, memory_order_relaxed) != srv->clients[i].tail;
+    }
+
+    if (!pending) {
+        fds[0] = (struct pollfd){.fd = srv->listener, .events = POLLIN};
+        for (size_t i = 0; i < srv->count; i++) {
+            fds[1 + 2 * i] = (struct pollfd){.fd = srv->clients[i].event, .events = POLLIN};
+            fds[2 + 2 * i] = (struct pollfd){.fd = srv->clients[i].conn, .events = POLLIN};
+        }
+
+        if (poll(fds, 1 + 2 * srv->count, timeout_ms) > 0) {
+            for (size_t i = 0; i < srv->count; i++) {
+                uint64_t value;
+                uint8_t byte;
+
+                if (fds[1 + 2 * i].revents & POLLIN) { (void)!read(srv->clients[i].event, &value, sizeof(value)); }
+                // Clients never send anything after the handshake: readable means gone.
+                if (fds[2 + 2 * i].revents & (POLLIN | POLLHUP)) {
+                    ssize_t n = recv(srv->clients[i].conn, &byte, 1, MSG_DONTWAIT);
+                    srv->clients[i].closed |= (n == 0) || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < srv->count; i++) {
+        atomic_store_explicit(&srv->clients[i].ring->parked, false, memory_order_relaxed);
+    }
+}
+
+size_t shm_server_clients(shm_server_t srv)
+{
+    assert(srv);
+    return srv->count;
+}
+
+shm_client_t shm_client_connect(const char* path)
+{
+    assert(path);
+
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) { return NULL; }
+    strcpy(addr.sun_path, path);
+
+    int conn = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int memfd = -1;
+    int event = -1;
+    struct stat st;
+    shm_ring_t* ring = MAP_FAILED;
+
+    if (conn >= 0 && connect(conn, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+        receive_fds(conn, &memfd, &event) == 0 && fstat(memfd, &st) == 0 && (size_t)st.st_size >= map_size()) {
+        ring = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    }
+    if (memfd >= 0) { close(memfd); }
+
+    if (ring == MAP_FAILED || ring->magic != RING_MAGIC || ring->capacity != SHM_SUBMIT_RING_SIZE) {
+        if (ring != MAP_FAILED) { munmap(ring, (size_t)st.st_size); }
+        if (event >= 0) { close(event); }
+        if (conn >= 0) { close(conn); }
+        return NULL;
+    }
+
+    shm_client_t cl = client_pool_take();
+    assert(cl);
+
+    cl->conn = conn;
+    cl->event = event;
+    cl->ring = ring;
+    cl->map_size = (size_t)st.st_size;
+    cl->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    return cl;
+}
+
+void shm_client_disconnect(shm_client_t* cl)
+{
+    assert(cl != NULL);
+
+    if (*cl) {
+        munmap((*cl)->ring, (*cl)->map_size);
+        close((*cl)->event);
+        close((*cl)->conn);
+    }
+
+    client_pool_give(*cl);
+    *cl = NULL;
+}
+
+int shm_client_submit(shm_client_t cl, uint8_t port, const uint8_t* data, size_t len)
+{
+    assert(cl && (data || !len) && len <= SHM_SUBMIT_MAX_MESSAGE);
+
+    shm_ring_t* ring = cl->ring;
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t needed = RECORD_HEADER_SIZE + len;
+
+    if (SHM_SUBMIT_RING_SIZE - (head - cl->tail_cache) < needed) {
+        cl->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (SHM_SUBMIT_RING_SIZE - (head - cl->tail_cache) < needed) { return -1; }
+    }
+
+    const uint8_t header[RECORD_HEADER_SIZE] = {port, (uint8_t)len};
+    ring_copy_in(ring, head, header, sizeof(header));
+    ring_copy_in(ring, head + sizeof(header), data, len);
+    atomic_store_explicit(&ring->head, head + needed, memory_order_release);
+
+    // Only pay for a syscall when the daemon actually sleeps.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->parked, memory_order_relaxed)) {
+        uint64_t one = 1;
+        (void)!write(cl->event, &one, sizeof(one));
+    }
+
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
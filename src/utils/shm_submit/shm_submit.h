@@ -0,0 +1,161 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file shm_submit.h
+/// @brief Local MIDI submission over shared memory, set up through a Unix socket (Linux only).
+///
+/// A client connects once to the daemon's Unix socket and receives, through `SCM_RIGHTS`, a memfd
+/// holding a single-producer single-consumer ring and an eventfd. From then on it submits messages by
+/// writing them into the shared ring: no copy through the kernel and no syscall, except for a wake-up
+/// write on the eventfd when the daemon went to sleep. The daemon merges every client ring into the
+/// TX ring of each message's port.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/spsc_ring/spsc_ring.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef SHM_SUBMIT_SERVER_POOL_SIZE
+/// Servers available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define SHM_SUBMIT_SERVER_POOL_SIZE 1
+#endif
+
+#ifndef SHM_SUBMIT_CLIENT_POOL_SIZE
+/// Clients available per process when built with UTILS_NO_HEAP (see obj_pool.h).
+#define SHM_SUBMIT_CLIENT_POOL_SIZE 4
+#endif
+
+/// Maximum number of clients connected at once.
+#define SHM_SUBMIT_MAX_CLIENTS 16
+
+#ifndef SHM_SUBMIT_RING_SIZE
+/// Size of each client ring, in bytes. Must be a power of two.
+#define SHM_SUBMIT_RING_SIZE 65536
+#endif
+
+/// Largest message, in bytes.
+#define SHM_SUBMIT_MAX_MESSAGE 255
+
+/* === Public data type declarations =========================================================== */
+
+/// Opaque daemon side structure
+typedef struct shm_server_obj_t shm_server_obj_t;
+
+/// Handle type, the way users interact with the daemon side API
+typedef shm_server_obj_t* shm_server_t;
+
+/// Opaque client side structure
+typedef struct shm_client_obj_t shm_client_obj_t;
+
+/// Handle type, the way users interact with the client side API
+typedef shm_client_obj_t* shm_client_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Creates the daemon's listening socket.
+/// @param path Filesystem path of the Unix socket. Replaced if it exists.
+/// @param ports TX ring of each port. The daemon is their producer.
+/// @param port_count Number of ports.
+/// @return The daemon side, or NULL if the socket could not be created.
+///
+shm_server_t shm_server_init(const char* path, spsc_ring_t* ports, size_t port_count);
+
+///
+/// @brief Disconnects every client, removes the socket and frees the daemon side.
+/// @param srv Daemon side to free. Set to NULL afterwards.
+///
+void shm_server_deinit(shm_server_t* srv);
+
+///
+/// @brief Accepts the pending connections, handing each one its ring. Never blocks.
+/// @param srv Daemon side to use.
+/// @return Number of clients accepted.
+///
+size_t shm_server_accept(shm_server_t srv);
+
+///
+/// @brief Moves the submitted messages into the TX ring of their port, and forgets clients that left.
+///
+/// A message whose TX ring is full stays in its client ring (and holds back the ones after it) until
+/// a later call. Messages for unknown ports are discarded.
+///
+/// @param srv Daemon side to use.
+/// @return Number of messages moved.
+///
+size_t shm_server_merge(shm_server_t srv);
+
+///
+/// @brief Sleeps until a client submits, connects or leaves, or until the timeout expires.
+/// @param srv Daemon side to use.
+/// @param timeout_ms Longest sleep, in milliseconds, or -1 for no limit.
+///
+void shm_server_wait(shm_server_t srv, int timeout_ms);
+
+///
+/// @brief Returns the number of connected clients.
+/// @param srv Daemon side to check.
+///
+size_t shm_server_clients(shm_server_t srv);
+
+///
+/// @brief Connects to the daemon and maps the ring it hands over.
+/// @param path Filesystem path of the daemon's Unix socket.
+/// @return The client side, or NULL on failure.
+///
+shm_client_t shm_client_connect(const char* path);
+
+///
+/// @brief Disconnects from the daemon. Messages already submitted are still delivered.
+/// @param cl Client side to free. Set to NULL afterwards.
+///
+void shm_client_disconnect(shm_client_t* cl);
+
+///
+/// @brief Submits a message for a port. No syscall unless the daemon is sleeping. Single thread per client.
+/// @param cl Client side to use.
+/// @param port Destination port.
+/// @param data Message bytes.
+/// @param len Message size, at most SHM_SUBMIT_MAX_MESSAGE.
+/// @return 0 on success, or -1 if the ring is full.
+///
+int shm_client_submit(shm_client_t cl, uint8_t port, const uint8_t* data, size_t len);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,484 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file spsc_ring.c
+/// @brief Lock-free single-producer single-consumer ring buffer (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdlib.h>
+
+#include <utils/obj_pool/obj_pool.h>
+#include <utils/port_atomic/port_atomic.h>
+
+#include "spsc_ring.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Cache line size assumed to keep producer and consumer fields apart.
+#define CACHE_LINE_SIZE 64
+
+/// Number of copies spsc_ring_snapshot() attempts before trimming the result.
+#define SNAPSHOT_RETRIES 4
+
+/* === Private data type declarations ========================================================== */
+
+///
+/// @brief Structure representing a SPSC ring.
+///
+/// Producer and consumer fields live on separate cache lines, and each side keeps a private copy of
+/// the other side's index so it only touches the shared line when the copy says full (or empty).
+///
+struct spsc_ring_buf_t
+{
+    alignas(CACHE_LINE_SIZE) port_atomic_size_t head;  ///< Free-running index of the next element to be written.
+    size_t tail_cache;                                 ///< Producer's last observed value of `tail`.
+    port_atomic_bool_t drop_mode;                      ///< Whether writes discard their data.
+    size_t stream_threshold;                           ///< Block size from which writes use streaming stores.
+
+    alignas(CACHE_LINE_SIZE) port_atomic_size_t tail;  ///< Free-running index of the next element to be read.
+    size_t head_cache;                                 ///< Consumer's last observed value of `head`.
+    port_atomic_bool_t flush_requested;                ///< Whether the consumer must discard everything pending.
+
+    alignas(CACHE_LINE_SIZE) uint8_t* buffer;  ///< Pointer to the underlying buffer.
+    size_t capacity;                           ///< Length of the buffer.
+    size_t mask;                               ///< capacity - 1, used to wrap the indices.
+    size_t prefetch_distance;                  ///< Bytes both sides prefetch ahead of their index.
+    wait_strategy_t waiter;                    ///< Consumer's wait strategy, notified on every write.
+    sharded_counter_t written;                 ///< Bytes accepted, or NULL if statistics are disabled.
+    sharded_counter_t read;                    ///< Bytes taken out, or NULL if statistics are disabled.
+    sharded_counter_t rejected;                ///< Bytes refused, or NULL if statistics are disabled.
+    sharded_counter_t dropped;                 ///< Bytes discarded, or NULL if statistics are disabled.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static bool has_data(void* ctx);
+static void handle_flush_request(spsc_ring_t rb);
+static size_t copy_out(spsc_ring_t rb, size_t from, uint8_t* out, size_t count);
+static void prefetch_for_write(spsc_ring_t rb, size_t from, size_t to);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(ring_pool, spsc_ring_buf_t, SPSC_RING_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static bool has_data(void* ctx) { return !spsc_ring_is_empty((spsc_ring_t)ctx); }
+
+static void handle_flush_request(spsc_ring_t rb)
+{
+    if (!PORT_ATOMIC_LOAD(&rb->flush_requested, PORT_ATOMIC_RELAXED)) { return; }
+
+    PORT_ATOMIC_STORE(&rb->flush_requested, false, PORT_ATOMIC_RELAXED);
+
+    size_t tail = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_RELAXED);
+    rb->head_cache = PORT_ATOMIC_LOAD(&rb->head, PORT_ATOMIC_ACQUIRE);
+    PORT_ATOMIC_STORE(&rb->tail, rb->head_cache, PORT_ATOMIC_RELEASE);
+
+    if (rb->dropped) { sharded_counter_add(rb->dropped, rb->head_cache - tail); }
+}
+
+static size_t copy_out(spsc_ring_t rb, size_t from, uint8_t* out, size_t count)
+{
+    bulk_copy_out(rb->buffer, rb->capacity, from & rb->mask, out, count, rb->prefetch_distance);
+    return count;
+}
+
+static void prefetch_for_write(spsc_ring_t rb, size_t from, size_t to)
+{
+    // Never past the free space: those lines still hold unread data, and pulling them in for writing would steal
+    // them from the consumer. The cached tail is at most stale, which only makes the window smaller.
+    size_t free = rb->capacity - (to - rb->tail_cache);
+    size_t distance = rb->prefetch_distance < free ? rb->prefetch_distance : free;
+
+    if (!distance) { return; }
+
+    // Only the lines that just entered the window: a stream of small writes issues about one prefetch per line.
+    size_t line = (from + distance + BULK_COPY_LINE_SIZE - 1) & ~(size_t)(BULK_COPY_LINE_SIZE - 1);
+    for (; line < to + distance; line += BULK_COPY_LINE_SIZE) {
+        bulk_copy_prefetch(rb->buffer, rb->capacity, line & rb->mask, 1, true);
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+spsc_ring_t spsc_ring_init(uint8_t* buffer, size_t size)
+{
+    assert(buffer && size && ((size & (size - 1)) == 0));
+
+    spsc_ring_t rb = ring_pool_take();
+    assert(rb);
+
+    rb->buffer = buffer;
+    rb->capacity = size;
+    rb->mask = size - 1;
+    rb->stream_threshold = BULK_COPY_STREAM_THRESHOLD;
+    rb->prefetch_distance = BULK_COPY_PREFETCH_DISTANCE;
+    rb->waiter = NULL;
+    rb->written = NULL;
+    rb->read = NULL;
+    rb->rejected = NULL;
+    rb->dropped = NULL;
+    PORT_ATOMIC_INIT(&rb->drop_mode, false);
+    PORT_ATOMIC_INIT(&rb->flush_requested, false);
+    PORT_ATOMIC_INIT(&rb->head, 0);
+    PORT_ATOMIC_INIT(&rb->tail, 0);
+    spsc_ring_reset(rb);
+
+    assert(spsc_ring_is_empty(rb));
+
+    return rb;
+}
+
+void spsc_ring_deinit(spsc_ring_t* rb)
+{
+    assert(rb != NULL);
+
+    if (*rb && (*rb)->written) {
+        sharded_counter_deinit(&(*rb)->written);
+        sharded_counter_deinit(&(*rb)->read);
+        sharded_counter_deinit(&(*rb)->rejected);
+        sharded_counter_deinit(&(*rb)->dropped);
+    }
+
+    ring_pool_give(*rb);
+    *rb = NULL;
+}
+
+void spsc_ring_reset(spsc_ring_t rb)
+{
+    assert(rb);
+
+    PORT_ATOMIC_STORE(&rb->head, 0, PORT_ATOMIC_RELAXED);
+    PORT_ATOMIC_STORE(&rb->tail, 0, PORT_ATOMIC_RELAXED);
+    rb->tail_cache = 0;
+    rb->head_cache = 0;
+}
+
+size_t spsc_ring_size(spsc_ring_t rb)
+{
+    assert(rb);
+
+    // Tail first: head never moves backwards, so the difference can't underflow.
+    size_t tail = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_ACQUIRE);
+    size_t head = PORT_ATOMIC_LOAD(&rb->head, PORT_ATOMIC_ACQUIRE);
+    size_t size = head - tail;
+
+    return (size > rb->capacity) ? rb->capacity : size;
+}
+
+size_t spsc_ring_capacity(spsc_ring_t rb)
+{
+    assert(rb);
+    return rb->capacity;
+}
+
+bool spsc_ring_is_empty(spsc_ring_t rb)
+{
+    assert(rb);
+    return spsc_ring_size(rb) == 0;
+}
+
+bool spsc_ring_is_full(spsc_ring_t rb)
+{
+    assert(rb);
+    return spsc_ring_size(rb) == rb->capacity;
+}
+
+int spsc_ring_write_byte(spsc_ring_t rb, uint8_t data)
+{
+    assert(rb && rb->buffer);
+
+    if (PORT_ATOMIC_LOAD(&rb->drop_mode, PORT_ATOMIC_RELAXED)) {
+        if (rb->dropped) { sharded_counter_add(rb->dropped, 1); }
+        return 0;
+    }
+
+    size_t head = PORT_ATOMIC_LOAD(&rb->head, PORT_ATOMIC_RELAXED);
+
+    if ((head - rb->tail_cache) == rb->capacity) {
+        rb->tail_cache = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_ACQUIRE);
+        if ((head - rb->tail_cache) == rb->capacity) {
+            if (rb->rejected) { sharded_counter_add(rb->rejected, 1); }
+            return -1;
+        }
+    }
+
+    rb->buffer[head & rb->mask] = data;
+    PORT_ATOMIC_STORE(&rb->head, head + 1, PORT_ATOMIC_RELEASE);
+
+    if (rb->written) { sharded_counter_add(rb->written, 1); }
+
+    if (rb->waiter) { wait_strategy_notify(rb->waiter); }
+
+    return 0;
+}
+
+int spsc_ring_write(spsc_ring_t rb, const uint8_t* data, size_t len)
+{
+    assert(rb && rb->buffer && (data || !len));
+
+    if (PORT_ATOMIC_LOAD(&rb->drop_mode, PORT_ATOMIC_RELAXED)) {
+        if (rb->dropped) { sharded_counter_add(rb->dropped, len); }
+        return 0;
+    }
+
+    size_t head = PORT_ATOMIC_LOAD(&rb->head, PORT_ATOMIC_RELAXED);
+
+    if ((rb->capacity - (head - rb->tail_cache)) < len) {
+        rb->tail_cache = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_ACQUIRE);
+        if ((rb->capacity - (head - rb->tail_cache)) < len) {
+            if (rb->rejected) { sharded_counter_add(rb->rejected, len); }
+            return -1;
+        }
+    }
+
+    bulk_copy_in(rb->buffer, rb->capacity, head & rb->mask, data, len, rb->stream_threshold);
+
+    PORT_ATOMIC_STORE(&rb->head, head + len, PORT_ATOMIC_RELEASE);
+
+    // Streamed blocks bypass the cache on purpose, no point in pulling the next lines in.
+    if (len < rb->stream_threshold) { prefetch_for_write(rb, head, head + len); }
+
+    if (rb->written) { sharded_counter_add(rb->written, len); }
+    if (rb->waiter) { wait_strategy_notify(rb->waiter); }
+
+    return 0;
+}
+
+int spsc_ring_read_byte(spsc_ring_t rb, uint8_t* data)
+{
+    assert(rb && data && rb->buffer);
+
+    handle_flush_request(rb);
+
+    size_t tail = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_RELAXED);
+
+    if (rb->head_cache == tail) {
+        rb->head_cache = PORT_ATOMIC_LOAD(&rb->head, PORT_ATOMIC_ACQUIRE);
+        if (rb->head_cache == tail) { return -1; }
+    }
+
+    *data = rb->buffer[tail & rb->mask];
+    PORT_ATOMIC_STORE(&rb->tail, tail + 1, PORT_ATOMIC_RELEASE);
+
+    if (rb->read) { sharded_counter_add(rb->read, 1); }
+
+    return 0;
+}
+
+size_t spsc_ring_read(spsc_ring_t rb, uint8_t* data, size_t len)
+{
+    assert(rb && data && rb->buffer);
+
+    handle_flush_request(rb);
+
+    size_t tail = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_RELAXED);
+
+    if ((rb->head_cache - tail) < len) { rb->head_cache = PORT_ATOMIC_LOAD(&rb->head, PORT_ATOMIC_ACQUIRE); }
+
+    size_t available = rb->head_cache - tail;
+    size_t count = copy_out(rb, tail, data, (available < len) ? available : len);
+
+    PORT_ATOMIC_STORE(&rb->tail, tail + count, PORT_ATOMIC_RELEASE);
+
+    if (rb->read) { sharded_counter_add(rb->read, count); }
+
+    return count;
+}
+
+size_t spsc_ring_consume(spsc_ring_t rb, spsc_ring_consume_fn fn, void* ctx, size_t max)
+{
+    assert(rb && fn && rb->buffer);
+
+    handle_flush_request(rb);
+
+    size_t tail = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_RELAXED);
+    rb->head_cache = PORT_ATOMIC_LOAD(&rb->head, PORT_ATOMIC_ACQUIRE);
+
+    size_t available = rb->head_cache - tail;
+    size_t count = (available < max) ? available : max;
+    size_t window = (rb->prefetch_distance && rb->prefetch_distance < count) ? rb->prefetch_distance : count;
+    size_t done = 0;
+
+    // Hand the data over in place, one contiguous window at a time, prefetching the next one meanwhile.
+    while (done < count) {
+        size_t offset = (tail + done) & rb->mask;
+        size_t chunk = count - done;
+        if (chunk > window) { chunk = window; }
+        if (chunk > rb->capacity - offset) { chunk = rb->capacity - offset; }
+
+        if (done + chunk < count) {
+            size_t ahead = count - done - chunk;
+            bulk_copy_prefetch(rb->buffer, rb->capacity, (offset + chunk) & rb->mask, ahead < window ? ahead : window,
+                               false);
+        }
+
+        size_t used = fn(ctx, &rb->buffer[offset], chunk);
+        assert(used <= chunk);
+        done += used;
+        if (used < chunk) { break; }
+    }
+
+    PORT_ATOMIC_STORE(&rb->tail, tail + done, PORT_ATOMIC_RELEASE);
+
+    if (rb->read) { sharded_counter_add(rb->read, done); }
+
+    return done;
+}
+
+int spsc_ring_find(spsc_ring_t rb, uint8_t value, size_t* position)
+{
+    assert(rb && position && rb->buffer);
+
+    size_t tail = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_RELAXED);
+    rb->head_cache = PORT_ATOMIC_LOAD(&rb->head, PORT_ATOMIC_ACQUIRE);
+
+    size_t available = rb->head_cache - tail;
+    size_t found = bulk_copy_find(rb->buffer, rb->capacity, tail & rb->mask, available, value, rb->prefetch_distance);
+
+    if (found == available) { return -1; }
+
+    *position = found;
+    return 0;
+}
+
+size_t spsc_ring_snapshot(spsc_ring_t rb, uint8_t* out, size_t max, size_t* seq, bool* torn)
+{
+    assert(rb && (out || !max) && seq && torn && rb->buffer);
+
+    size_t start = 0;
+    size_t end = 0;
+    size_t count = 0;
+
+    for (unsigned int attempt = 0; attempt < SNAPSHOT_RETRIES; attempt++) {
+        start = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_ACQUIRE);
+        size_t head = PORT_ATOMIC_LOAD(&rb->head, PORT_ATOMIC_ACQUIRE);
+
+        count = head - start;
+        if (count > rb->capacity) { count = rb->capacity; }
+        if (count > max) { count = max; }
+        copy_out(rb, start, out, count);
+
+        // The producer only overwrites a byte after the consumer has moved past it, so the copy is
+        // intact if the consumer did not move meanwhile.
+        PORT_ATOMIC_FENCE(PORT_ATOMIC_ACQUIRE);
+        end = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_RELAXED);
+
+        if (end == start) {
+            *seq = start;
+            *torn = false;
+            return count;
+        }
+    }
+
+    // Keep only what was still pending when the last copy ended.
+    size_t lost = end - start;
+    if (lost > count) { lost = count; }
+    memmove(out, &out[lost], count - lost);
+
+    *seq = start + lost;
+    *torn = true;
+
+    return count - lost;
+}
+
+void spsc_ring_set_wait_strategy(spsc_ring_t rb, wait_strategy_t ws)
+{
+    assert(rb);
+    rb->waiter = ws;
+}
+
+void spsc_ring_read_byte_wait(spsc_ring_t rb, uint8_t* data)
+{
+    assert(rb && data && rb->waiter);
+
+    while (spsc_ring_read_byte(rb, data) != 0) { wait_strategy_wait(rb->waiter, has_data, rb); }
+}
+
+void spsc_ring_enable_stats(spsc_ring_t rb)
+{
+    assert(rb);
+
+    if (rb->written) { return; }
+
+    rb->written = sharded_counter_init();
+    rb->read = sharded_counter_init();
+    rb->rejected = sharded_counter_init();
+    rb->dropped = sharded_counter_init();
+}
+
+void spsc_ring_get_stats(spsc_ring_t rb, spsc_ring_stats_t* stats)
+{
+    assert(rb && stats);
+
+    stats->written = rb->written ? sharded_counter_sum(rb->written) : 0;
+    stats->read = rb->read ? sharded_counter_sum(rb->read) : 0;
+    stats->rejected = rb->rejected ? sharded_counter_sum(rb->rejected) : 0;
+    stats->dropped = rb->dropped ? sharded_counter_sum(rb->dropped) : 0;
+}
+
+void spsc_ring_positions(spsc_ring_t rb, size_t* written, size_t* read)
+{
+    assert(rb && written && read);
+
+    *read = PORT_ATOMIC_LOAD(&rb->tail, PORT_ATOMIC_RELAXED);
+    *written = PORT_ATOMIC_LOAD(&rb->head, PORT_ATOMIC_RELAXED);
+}
+
+void spsc_ring_set_drop_mode(spsc_ring_t rb, bool enabled)
+{
+    assert(rb);
+    PORT_ATOMIC_STORE(&rb->drop_mode, enabled, PORT_ATOMIC_RELAXED);
+}
+
+bool spsc_ring_drop_mode(spsc_ring_t rb)
+{
+    assert(rb);
+    return PORT_ATOMIC_LOAD(&rb->drop_mode, PORT_ATOMIC_RELAXED);
+}
+
+void spsc_ring_request_flush(spsc_ring_t rb)
+{
+    assert(rb);
+    PORT_ATOMIC_STORE(&rb->flush_requested, true, PORT_ATOMIC_RELAXED);
+}
+
+void spsc_ring_set_stream_threshold(spsc_ring_t rb, size_t threshold)
+{
+    assert(rb);
+    rb->stream_threshold = threshold;
+}
+
+void spsc_ring_set_prefetch_distance(spsc_ring_t rb, size_t distance)
+{
+    assert(rb);
+    rb->prefetch_distance = distance;
+}
+
+/* === End of documentation ==================================================================== */
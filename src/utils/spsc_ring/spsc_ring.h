@@ -0,0 +1,295 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file spsc_ring.h
+/// @brief Lock-free single-producer single-consumer ring buffer.
+///
+/// Concurrent counterpart of ring_buffer.h: one thread (or ISR) writes and another one reads, without
+/// locks. Head and tail are free-running indices owned by the producer and the consumer respectively,
+/// so unlike ring_buffer_write_byte() a full ring rejects new data instead of overwriting it (the
+/// producer is not allowed to move the consumer's index).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/bulk_copy/bulk_copy.h>
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef SPSC_RING_POOL_SIZE
+/// Rings available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define SPSC_RING_POOL_SIZE 64
+#endif
+
+/* === Public data type declarations =========================================================== */
+
+/// Opaque SPSC ring structure
+typedef struct spsc_ring_buf_t spsc_ring_buf_t;
+
+/// Handle type, the way users interact with the API
+typedef spsc_ring_buf_t* spsc_ring_t;
+
+///
+/// @brief Callback of spsc_ring_consume(), handed pending data in place.
+/// @return Number of bytes consumed, up to @p len. Returning less stops the consumption.
+///
+typedef size_t (*spsc_ring_consume_fn)(void* ctx, const uint8_t* data, size_t len);
+
+/// Ring statistics, see spsc_ring_enable_stats().
+typedef struct
+{
+    uint64_t written;   ///< Bytes accepted by the ring.
+    uint64_t read;      ///< Bytes taken out of the ring.
+    uint64_t rejected;  ///< Bytes refused because the ring was full.
+    uint64_t dropped;   ///< Bytes discarded by drop mode or by a flush.
+} spsc_ring_stats_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Initializes a SPSC ring with the given parameters.
+/// @param buffer Pointer to the pre-allocated buffer.
+/// @param size Size of the buffer. Must be a power of two.
+///
+spsc_ring_t spsc_ring_init(uint8_t* buffer, size_t size);
+
+///
+/// @brief Free a SPSC ring structure. Data is not free'd, since it's owner's responsibility.
+/// @param rb Ring to free. Set to NULL afterwards.
+///
+void spsc_ring_deinit(spsc_ring_t* rb);
+
+///
+/// @brief Resets the ring to empty. Only safe while neither side is running.
+/// @param rb Ring to reset.
+///
+void spsc_ring_reset(spsc_ring_t rb);
+
+///
+/// @brief Returns the number of elements stored on the ring. Exact from either side, a hint from anywhere else.
+/// @param rb Ring to check.
+///
+size_t spsc_ring_size(spsc_ring_t rb);
+
+///
+/// @brief Returns the ring capacity.
+/// @param rb Ring to check.
+///
+size_t spsc_ring_capacity(spsc_ring_t rb);
+
+///
+/// @brief Checks if the ring is empty.
+/// @param rb Ring to check.
+///
+bool spsc_ring_is_empty(spsc_ring_t rb);
+
+///
+/// @brief Checks if the ring is full.
+/// @param rb Ring to check.
+///
+bool spsc_ring_is_full(spsc_ring_t rb);
+
+///
+/// @brief Writes a byte of data to the ring. Producer side only.
+/// @param rb Ring to write to.
+/// @param data The byte of data to write.
+/// @return 0 on success (including data discarded by drop mode), or -1 if the ring is full.
+///
+int spsc_ring_write_byte(spsc_ring_t rb, uint8_t data);
+
+///
+/// @brief Writes a block of data to the ring, all or nothing. Producer side only.
+///
+/// The consumer sees either the whole block or none of it, which makes the ring usable for records.
+///
+/// @param rb Ring to write to.
+/// @param data The data to write.
+/// @param len Number of bytes to write.
+/// @return 0 on success (including data discarded by drop mode), or -1 if the ring lacks room for the whole block.
+///
+int spsc_ring_write(spsc_ring_t rb, const uint8_t* data, size_t len);
+
+///
+/// @brief Reads a byte of data from the ring. Consumer side only.
+/// @param rb Ring to read from.
+/// @param data Pointer to a variable to store the read data.
+/// @return 0 on success, or -1 if the ring is empty.
+///
+int spsc_ring_read_byte(spsc_ring_t rb, uint8_t* data);
+
+///
+/// @brief Reads up to @p len bytes from the ring. Consumer side only.
+/// @param rb Ring to read from.
+/// @param data Destination buffer, at least @p len bytes long.
+/// @param len Maximum number of bytes to read.
+/// @return Number of bytes actually read (0 if the ring is empty).
+///
+size_t spsc_ring_read(spsc_ring_t rb, uint8_t* data, size_t len);
+
+///
+/// @brief Hands pending data to a callback in place, without copying it. Consumer side only.
+///
+/// The data is handed over in contiguous pieces of at most the prefetch distance, the next piece being
+/// prefetched while the callback works on the current one.
+///
+/// @param rb Ring to read from.
+/// @param fn Callback consuming the data.
+/// @param ctx Argument for @p fn.
+/// @param max Maximum number of bytes to consume.
+/// @return Number of bytes consumed.
+///
+size_t spsc_ring_consume(spsc_ring_t rb, spsc_ring_consume_fn fn, void* ctx, size_t max);
+
+///
+/// @brief Looks for a byte in the pending data, without consuming it. Consumer side only.
+/// @param rb Ring to search.
+/// @param value Byte to look for.
+/// @param position Where to store the number of pending bytes before the first match.
+/// @return 0 if found, or -1 otherwise.
+///
+int spsc_ring_find(spsc_ring_t rb, uint8_t value, size_t* position);
+
+///
+/// @brief Copies the pending data without consuming it. Can be called from any thread.
+///
+/// Meant for monitoring: neither side is blocked nor slowed down. The copy is validated seqlock-style
+/// against the consumer's index and retried a few times if the consumer moved during it. If it keeps
+/// moving, only the part the producer cannot have overwritten is returned and @p torn is set.
+///
+/// @param rb Ring to copy.
+/// @param out Destination buffer, at least @p max bytes long.
+/// @param max Maximum number of bytes to copy.
+/// @param seq Where to store the stream position of the first copied byte (see spsc_ring_positions()).
+/// @param torn Where to store whether the snapshot had to be trimmed.
+/// @return Number of bytes copied.
+///
+size_t spsc_ring_snapshot(spsc_ring_t rb, uint8_t* out, size_t max, size_t* seq, bool* torn);
+
+///
+/// @brief Attaches the consumer's wait strategy, so the producer wakes it up after every write.
+/// @param rb Ring to configure.
+/// @param ws Wait strategy owned by the consumer, or NULL to detach.
+///
+void spsc_ring_set_wait_strategy(spsc_ring_t rb, wait_strategy_t ws);
+
+///
+/// @brief Reads a byte of data from the ring, waiting with the attached strategy while it is empty.
+/// @param rb Ring to read from. Must have a wait strategy attached.
+/// @param data Pointer to a variable to store the read data.
+///
+void spsc_ring_read_byte_wait(spsc_ring_t rb, uint8_t* data);
+
+///
+/// @brief Enables the ring statistics. Must be called before the producer and consumer start.
+///
+/// Counters are sharded per thread, so keeping them costs neither side any cache line traffic.
+///
+/// @param rb Ring to configure.
+///
+void spsc_ring_enable_stats(spsc_ring_t rb);
+
+///
+/// @brief Returns the ring statistics. Can be called from any thread.
+/// @param rb Ring to check.
+/// @param stats Where to store the statistics. All zero if statistics are disabled.
+///
+void spsc_ring_get_stats(spsc_ring_t rb, spsc_ring_stats_t* stats);
+
+///
+/// @brief Samples the free-running write and read positions with relaxed loads. Can be called from any thread.
+///
+/// Meant for monitoring: it never synchronizes with either side, so the values may be slightly stale.
+///
+/// @param rb Ring to check.
+/// @param written Where to store the number of bytes ever written.
+/// @param read Where to store the number of bytes ever read.
+///
+void spsc_ring_positions(spsc_ring_t rb, size_t* written, size_t* read);
+
+///
+/// @brief Switches drop mode. Can be called from any thread.
+///
+/// While enabled, writes succeed but discard their data, so a producer feeding a stalled consumer
+/// never blocks nor spins on a full ring.
+///
+/// @param rb Ring to configure.
+/// @param enabled Whether incoming data should be dropped.
+///
+void spsc_ring_set_drop_mode(spsc_ring_t rb, bool enabled);
+
+///
+/// @brief Checks whether drop mode is enabled.
+/// @param rb Ring to check.
+///
+bool spsc_ring_drop_mode(spsc_ring_t rb);
+
+///
+/// @brief Asks the consumer to discard everything pending. Can be called from any thread.
+///
+/// Only the consumer may move the read index, so the flush happens on its next read.
+///
+/// @param rb Ring to flush.
+///
+void spsc_ring_request_flush(spsc_ring_t rb);
+
+///
+/// @brief Sets the block size from which spsc_ring_write() uses non-temporal stores. Producer side only.
+///
+/// Streaming stores keep large blocks (dumps, captures) that the producer will not read back from
+/// evicting its hot data, and the consumer's. The default is BULK_COPY_STREAM_THRESHOLD.
+///
+/// @param rb Ring to configure.
+/// @param threshold Size in bytes, or BULK_COPY_NO_STREAM to always write through the cache.
+///
+void spsc_ring_set_stream_threshold(spsc_ring_t rb, size_t threshold);
+
+///
+/// @brief Sets how far ahead reads, scans and writes prefetch. Must be called before the producer and consumer start.
+///
+/// The consumer prefetches the data it is about to read, the producer the lines it is about to write.
+/// The default is BULK_COPY_PREFETCH_DISTANCE.
+///
+/// @param rb Ring to configure.
+/// @param distance Distance in bytes, or 0 to disable prefetching.
+///
+void spsc_ring_set_prefetch_distance(spsc_ring_t rb, size_t distance);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
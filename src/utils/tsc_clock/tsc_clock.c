@@ -0,0 +1,260 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file tsc_clock.c
+/// @brief Cheap calibrated clock for hot-path instrumentation (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include "tsc_clock.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Fractional bits of the cycles to nanoseconds multiplier.
+#define MULT_SHIFT 32U
+
+#define NS_PER_MS 1000000ULL
+#define NS_PER_S  1000000000ULL
+
+/// cpuid leaf and bit advertising an invariant TSC (constant rate, keeps running in deep C-states).
+#define CPUID_APM_LEAF       0x80000007U
+#define CPUID_INVARIANT_TSC  (1U << 8)
+
+/* === Private data type declarations ========================================================== */
+
+///
+/// @brief Calibration parameters: ns = base_ns + ((cycles - base_cycles) * mult) >> MULT_SHIFT.
+///
+typedef struct
+{
+    uint64_t base_cycles;  ///< Counter value at the calibration anchor.
+    uint64_t base_ns;      ///< CLOCK_MONOTONIC time at the calibration anchor.
+    uint64_t mult;         ///< Nanoseconds per cycle, with MULT_SHIFT fractional bits.
+} calibration_t;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static uint64_t monotonic_ns(void);
+static uint64_t read_counter(void);
+static bool counter_is_invariant(void);
+static uint64_t scale(uint64_t cycles, uint64_t mult);
+static void load_calibration(calibration_t* out);
+static void store_calibration(const calibration_t* in);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+/// Whether the counter is calibrated and in use.
+static atomic_bool reliable = false;
+
+/// Current calibration, guarded by `sequence` (odd while being written).
+static calibration_t calibration;
+static atomic_uint sequence = 0;
+
+/// Copy of `calibration.mult` that can be read on its own, without retrying.
+static _Atomic uint64_t current_mult = 0;
+
+/* === Private function implementation ========================================================= */
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_S + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t read_counter(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return monotonic_ns();
+#endif
+}
+
+static bool counter_is_invariant(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(CPUID_APM_LEAF, &eax, &ebx, &ecx, &edx)) { return false; }
+    return (edx & CPUID_INVARIANT_TSC) != 0;
+#elif defined(__aarch64__)
+    // The generic timer runs at a fixed frequency by architecture.
+    return true;
+#else
+    return false;
+#endif
+}
+
+static uint64_t scale(uint64_t cycles, uint64_t mult)
+{
+#if defined(__SIZEOF_INT128__)
+    return (uint64_t)(((unsigned __int128)cycles * mult) >> MULT_SHIFT);
+#else
+    uint64_t hi = (cycles >> 32) * mult;
+    uint64_t lo = ((cycles & 0xFFFFFFFFULL) * mult) >> MULT_SHIFT;
+    return hi + lo;
+#endif
+}
+
+static void load_calibration(calibration_t* out)
+{
+    unsigned int seq;
+
+    do {
+        seq = atomic_load_explicit(&sequence, memory_order_acquire);
+        out->base_cycles = calibration.base_cycles;
+        out->base_ns = calibration.base_ns;
+        out->mult = calibration.mult;
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1U) || seq != atomic_load_explicit(&sequence, memory_order_relaxed));
+}
+
+static void store_calibration(const calibration_t* in)
+{
+    atomic_fetch_add_explicit(&sequence, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    calibration = *in;
+    atomic_fetch_add_explicit(&sequence, 1, memory_order_release);
+    atomic_store_explicit(&current_mult, in->mult, memory_order_relaxed);
+}
+
+/* === Public function implementation ========================================================== */
+
+void tsc_clock_init(void)
+{
+    if (!counter_is_invariant()) {
+        atomic_store(&reliable, false);
+        return;
+    }
+
+    calibration_t cal = {.base_cycles = read_counter(), .base_ns = monotonic_ns()};
+
+    struct timespec pause = {.tv_sec = 0, .tv_nsec = TSC_CLOCK_CALIBRATION_MS * NS_PER_MS};
+    nanosleep(&pause, NULL);
+
+    uint64_t cycles = read_counter() - cal.base_cycles;
+    uint64_t ns = monotonic_ns() - cal.base_ns;
+
+    if (cycles == 0) {
+        atomic_store(&reliable, false);
+        return;
+    }
+
+    cal.mult = (ns << MULT_SHIFT) / cycles;
+    store_calibration(&cal);
+    atomic_store(&reliable, true);
+}
+
+void tsc_clock_recalibrate(void)
+{
+    if (!atomic_load(&reliable)) { return; }
+
+    calibration_t cal;
+    load_calibration(&cal);
+
+    uint64_t cycles = read_counter();
+    uint64_t ns = monotonic_ns();
+
+    // Re-anchor at the value the clock reports right now, so the time base doesn't jump.
+    calibration_t next = {.base_cycles = cycles, .base_ns = cal.base_ns + scale(cycles - cal.base_cycles, cal.mult)};
+
+    // The longer baseline gives a more precise rate. Drop low bits of both terms so the shift can't overflow.
+    uint64_t elapsed_cycles = cycles - cal.base_cycles;
+    uint64_t elapsed_ns = ns - cal.base_ns;
+    while (elapsed_ns > (UINT64_MAX >> MULT_SHIFT)) {
+        elapsed_ns >>= 1;
+        elapsed_cycles >>= 1;
+    }
+    if (elapsed_cycles == 0) { return; }
+    next.mult = (elapsed_ns << MULT_SHIFT) / elapsed_cycles;
+
+    // Steer the anchor halfway back towards CLOCK_MONOTONIC. Only forwards, so readers never see time going back.
+    if (ns > next.base_ns) { next.base_ns += (ns - next.base_ns) / 2; }
+
+    store_calibration(&next);
+}
+
+bool tsc_clock_is_reliable(void) { return atomic_load_explicit(&reliable, memory_order_relaxed); }
+
+uint64_t tsc_clock_cycles(void)
+{
+    return tsc_clock_is_reliable() ? read_counter() : monotonic_ns();
+}
+
+uint64_t tsc_clock_cycles_serialized(void)
+{
+    if (!tsc_clock_is_reliable()) { return monotonic_ns(); }
+
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int aux;
+    return __rdtscp(&aux);
+#elif defined(__aarch64__)
+    __asm__ volatile("isb" ::: "memory");
+    return read_counter();
+#else
+    return read_counter();
+#endif
+}
+
+uint64_t tsc_clock_cycles_to_ns(uint64_t cycles)
+{
+    if (!tsc_clock_is_reliable()) { return cycles; }
+
+    calibration_t cal;
+    load_calibration(&cal);
+
+    return scale(cycles, cal.mult);
+}
+
+uint64_t tsc_clock_cycles_mult(void)
+{
+    if (!tsc_clock_is_reliable()) { return 1ULL << MULT_SHIFT; }
+    return atomic_load_explicit(&current_mult, memory_order_relaxed);
+}
+
+uint64_t tsc_clock_now_ns(void)
+{
+    if (!tsc_clock_is_reliable()) { return monotonic_ns(); }
+
+    calibration_t cal;
+    load_calibration(&cal);
+
+    return cal.base_ns + scale(read_counter() - cal.base_cycles, cal.mult);
+}
+
+/* === End of documentation ==================================================================== */
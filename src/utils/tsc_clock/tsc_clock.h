@@ -0,0 +1,114 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file tsc_clock.h
+/// @brief Cheap calibrated clock for hot-path instrumentation.
+///
+/// Reads the CPU timestamp counter (`rdtsc` on x86 with invariant TSC, `cntvct_el0` on AArch64) and
+/// converts cycles to nanoseconds with a fixed-point multiply, calibrated against CLOCK_MONOTONIC.
+/// When the counter is not reliable (or before tsc_clock_init() is called) every function falls back
+/// to clock_gettime(CLOCK_MONOTONIC), so callers never need to care which source is in use.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+/// Duration of the initial calibration performed by tsc_clock_init(), in milliseconds.
+#define TSC_CLOCK_CALIBRATION_MS 10
+
+/* === Public data type declarations =========================================================== */
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Detects a reliable counter and calibrates it. Blocks for about TSC_CLOCK_CALIBRATION_MS.
+///
+/// Call once at startup, before the hot threads start.
+///
+void tsc_clock_init(void);
+
+///
+/// @brief Refines the calibration using the time elapsed since the previous one.
+///
+/// Meant to be called periodically (e.g. once per second) from a housekeeping thread. Does not block.
+///
+void tsc_clock_recalibrate(void);
+
+///
+/// @brief Checks whether the counter is in use, or the clock_gettime() fallback.
+/// @return true if tsc_clock_cycles() reads the CPU counter.
+///
+bool tsc_clock_is_reliable(void);
+
+///
+/// @brief Reads the counter. Not ordered with respect to surrounding instructions.
+/// @return Counter value, in cycles (or nanoseconds in fallback mode).
+///
+uint64_t tsc_clock_cycles(void);
+
+///
+/// @brief Reads the counter after all previous instructions have completed (`rdtscp`).
+///
+/// Use it to close a measured interval, so the measured code can't leak past the read.
+///
+/// @return Counter value, in cycles (or nanoseconds in fallback mode).
+///
+uint64_t tsc_clock_cycles_serialized(void);
+
+///
+/// @brief Converts a duration in cycles to nanoseconds.
+/// @param cycles Difference between two counter readings.
+///
+uint64_t tsc_clock_cycles_to_ns(uint64_t cycles);
+
+///
+/// @brief Returns the raw calibration: nanoseconds per cycle, with 32 fractional bits.
+///
+/// Unlike tsc_clock_cycles_to_ns(), it never waits for a recalibration in progress, so it is
+/// async-signal-safe. Meant for tools that store cycle counts and convert them later.
+///
+/// @return Nanoseconds per 2^32 cycles (exactly 2^32 in fallback mode, where cycles are nanoseconds).
+///
+uint64_t tsc_clock_cycles_mult(void);
+
+///
+/// @brief Returns the current time, in nanoseconds, on the CLOCK_MONOTONIC time base.
+///
+uint64_t tsc_clock_now_ns(void);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,179 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file tx_drain.c
+/// @brief Load-adaptive drain loop for TX rings (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <utils/obj_pool/obj_pool.h>
+#include <utils/tsc_clock/tsc_clock.h>
+
+#include "tx_drain.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Weight of a new sample in the arrival rate moving average, as a power of two (1/4).
+#define RATE_EWMA_SHIFT 2U
+
+#define NS_PER_US 1000ULL
+#define NS_PER_S  1000000000ULL
+#define US_PER_S  1000000ULL
+
+/* === Private data type declarations ========================================================== */
+
+///
+/// @brief Structure representing a drain.
+///
+struct tx_drain_obj_t
+{
+    spsc_ring_t ring;           ///< TX ring being drained.
+    tx_drain_config_t config;   ///< Tuning parameters.
+    uint8_t* batch;             ///< Scratch buffer, `config.max_batch` bytes long.
+    tx_drain_sink_fn sink;      ///< Destination of the drained bytes.
+    void* ctx;                  ///< Argument for `sink`.
+    uint64_t last_poll_ns;      ///< Time of the previous poll.
+    uint64_t pending_since_ns;  ///< Time at which the currently pending data was first seen.
+    size_t pending;             ///< Bytes left in the ring after the previous poll.
+    tx_drain_stats_t stats;     ///< Metrics.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static void update_arrival_rate(tx_drain_t drain, size_t arrivals, uint64_t elapsed_ns);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(drain_pool, tx_drain_obj_t, TX_DRAIN_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static void update_arrival_rate(tx_drain_t drain, size_t arrivals, uint64_t elapsed_ns)
+{
+    if (elapsed_ns == 0) { elapsed_ns = 1; }
+
+    uint64_t sample = ((uint64_t)arrivals * NS_PER_S) / elapsed_ns;
+    uint64_t rate = drain->stats.arrival_rate;
+
+    if (sample >= rate) {
+        rate += (sample - rate) >> RATE_EWMA_SHIFT;
+    } else {
+        rate -= (rate - sample) >> RATE_EWMA_SHIFT;
+    }
+
+    drain->stats.arrival_rate = rate;
+}
+
+/* === Public function implementation ========================================================== */
+
+tx_drain_t tx_drain_init(spsc_ring_t ring, const tx_drain_config_t* config, uint8_t* batch, tx_drain_sink_fn sink,
+                         void* ctx)
+{
+    assert(ring && config && config->max_batch && batch && sink);
+
+    tx_drain_t drain = drain_pool_take();
+    assert(drain);
+
+    drain->ring = ring;
+    drain->config = *config;
+    drain->batch = batch;
+    drain->sink = sink;
+    drain->ctx = ctx;
+    drain->last_poll_ns = tsc_clock_now_ns();
+    drain->stats.target_batch = 1;
+
+    return drain;
+}
+
+void tx_drain_deinit(tx_drain_t* drain)
+{
+    assert(drain != NULL);
+    drain_pool_give(*drain);
+    *drain = NULL;
+}
+
+size_t tx_drain_target_batch(const tx_drain_config_t* config, uint64_t arrival_rate)
+{
+    assert(config && config->max_batch);
+
+    // Microseconds keep the product far from overflowing even at absurd rates.
+    uint64_t expected = (arrival_rate * config->max_latency_us) / US_PER_S;
+
+    if (expected < 1) { expected = 1; }
+    if (expected > config->max_batch) { expected = config->max_batch; }
+
+    return (size_t)expected;
+}
+
+size_t tx_drain_poll(tx_drain_t drain)
+{
+    assert(drain);
+
+    uint64_t now = tsc_clock_now_ns();
+    size_t occupancy = spsc_ring_size(drain->ring);
+
+    // Only the drain's reads remove data, so anything above what was left last time has just arrived. A flush
+    // requested meanwhile can leave less than that: count it as no arrivals rather than wrapping around.
+    size_t arrivals = (occupancy > drain->pending) ? occupancy - drain->pending : 0;
+    update_arrival_rate(drain, arrivals, now - drain->last_poll_ns);
+    drain->last_poll_ns = now;
+
+    if (drain->pending == 0 && occupancy > 0) { drain->pending_since_ns = now; }
+
+    size_t target = tx_drain_target_batch(&drain->config, drain->stats.arrival_rate);
+    drain->stats.target_batch = target;
+
+    bool overdue = (now - drain->pending_since_ns) >= (drain->config.max_latency_us * NS_PER_US);
+    size_t sent = 0;
+
+    if (occupancy > 0 && (occupancy >= target || overdue)) {
+        size_t len = (occupancy < drain->config.max_batch) ? occupancy : drain->config.max_batch;
+        sent = spsc_ring_read(drain->ring, drain->batch, len);
+    }
+
+    // The read may have carried out a pending flush instead, leaving nothing to send.
+    if (sent > 0) {
+        if (drain->sink(drain->ctx, drain->batch, sent) != 0) { drain->stats.sink_errors++; }
+
+        drain->stats.batches++;
+        drain->stats.bytes += sent;
+        drain->stats.last_batch = sent;
+    }
+
+    drain->pending = spsc_ring_size(drain->ring);
+
+    return sent;
+}
+
+void tx_drain_get_stats(tx_drain_t drain, tx_drain_stats_t* stats)
+{
+    assert(drain && stats);
+    *stats = drain->stats;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,137 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file tx_drain.h
+/// @brief Load-adaptive drain loop for TX rings.
+///
+/// The drain moves bytes from a TX ring to a sink (typically the UART write call) in batches. The batch
+/// size follows the load: with a low arrival rate every poll flushes whatever is pending, so an idle
+/// port sends each message right away; with a high arrival rate the drain holds data back until
+/// the batch fills, so each sink call carries more bytes. A byte never waits longer than the
+/// configured latency budget, and a batch never exceeds the configured cap.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/spsc_ring/spsc_ring.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef TX_DRAIN_POOL_SIZE
+/// Drains available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define TX_DRAIN_POOL_SIZE 16
+#endif
+
+/* === Public data type declarations =========================================================== */
+
+/// Opaque drain structure
+typedef struct tx_drain_obj_t tx_drain_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef tx_drain_obj_t* tx_drain_t;
+
+///
+/// @brief Sink for the drained bytes, e.g. a write() on the UART file descriptor.
+/// @return 0 on success, or -1 on error. Bytes handed to a failing sink are lost.
+///
+typedef int (*tx_drain_sink_fn)(void* ctx, const uint8_t* data, size_t len);
+
+/// Drain tuning parameters.
+typedef struct
+{
+    size_t max_batch;         ///< Hard cap on the bytes handed to the sink in a single call.
+    uint32_t max_latency_us;  ///< Longest time a pending byte may be held back waiting for its batch to fill.
+} tx_drain_config_t;
+
+/// Drain metrics.
+typedef struct
+{
+    uint64_t batches;       ///< Number of sink calls.
+    uint64_t bytes;         ///< Number of bytes handed to the sink.
+    uint64_t sink_errors;   ///< Number of sink calls that failed.
+    size_t last_batch;      ///< Size of the most recent batch.
+    size_t target_batch;    ///< Batch size the drain is currently aiming for.
+    uint64_t arrival_rate;  ///< Smoothed arrival rate, in bytes per second.
+} tx_drain_stats_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Creates a drain for a TX ring. The drain is the ring's consumer.
+/// @param ring TX ring to drain.
+/// @param config Tuning parameters. Copied.
+/// @param batch Pre-allocated scratch buffer of at least `config->max_batch` bytes.
+/// @param sink Destination of the drained bytes.
+/// @param ctx Argument for @p sink.
+///
+tx_drain_t tx_drain_init(spsc_ring_t ring, const tx_drain_config_t* config, uint8_t* batch, tx_drain_sink_fn sink,
+                         void* ctx);
+
+///
+/// @brief Free a drain structure. Neither the ring nor the scratch buffer are free'd.
+/// @param drain Drain to free. Set to NULL afterwards.
+///
+void tx_drain_deinit(tx_drain_t* drain);
+
+///
+/// @brief Computes the batch size to aim for, given the current load.
+///
+/// The target is the number of bytes expected to arrive within the latency budget, so that waiting for
+/// it never costs more than the budget. Under light load this is 1 (flush immediately).
+///
+/// @param config Tuning parameters.
+/// @param arrival_rate Arrival rate, in bytes per second.
+/// @return Target batch size, between 1 and `config->max_batch`.
+///
+size_t tx_drain_target_batch(const tx_drain_config_t* config, uint64_t arrival_rate);
+
+///
+/// @brief Runs one iteration of the drain loop: hands at most one batch to the sink, if it is due.
+/// @param drain Drain to run.
+/// @return Number of bytes handed to the sink (0 if nothing was due).
+///
+size_t tx_drain_poll(tx_drain_t drain);
+
+///
+/// @brief Returns a copy of the drain metrics.
+/// @param drain Drain to check.
+/// @param stats Where to store the metrics.
+///
+void tx_drain_get_stats(tx_drain_t drain, tx_drain_stats_t* stats);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
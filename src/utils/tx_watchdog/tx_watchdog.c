@@ -0,0 +1,173 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file tx_watchdog.c
+/// @brief Stalled-consumer watchdog for TX rings (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <utils/obj_pool/obj_pool.h>
+#include <utils/tsc_clock/tsc_clock.h>
+
+#include "tx_watchdog.h"
+
+/* === Macros definitions ====================================================================== */
+
+#define NS_PER_MS 1000000ULL
+
+/* === Private data type declarations ========================================================== */
+
+/// Supervision state of a single ring.
+typedef struct
+{
+    spsc_ring_t ring;           ///< Supervised ring.
+    size_t last_read;           ///< Read position at the last observed progress.
+    uint64_t last_progress_ns;  ///< Time of the last observed progress.
+    bool stalled;               ///< Whether the consumer is currently considered stalled.
+} watched_ring_t;
+
+///
+/// @brief Structure representing a watchdog.
+///
+struct tx_watchdog_obj_t
+{
+    uint64_t deadline_ns;                         ///< Stall deadline.
+    tx_watchdog_action_t action;                  ///< Action applied to stalled rings.
+    tx_watchdog_event_fn on_event;                ///< Event callback, may be NULL.
+    void* ctx;                                    ///< Argument for `on_event`.
+    watched_ring_t rings[TX_WATCHDOG_MAX_RINGS];  ///< Supervised rings.
+    size_t count;                                 ///< Number of supervised rings.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static void set_stalled(tx_watchdog_t wd, int id, bool stalled);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(watchdog_pool, tx_watchdog_obj_t, TX_WATCHDOG_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static void set_stalled(tx_watchdog_t wd, int id, bool stalled)
+{
+    watched_ring_t* w = &wd->rings[id];
+
+    w->stalled = stalled;
+
+    switch (wd->action) {
+    case TX_WATCHDOG_ACTION_FLUSH:
+        if (stalled) { spsc_ring_request_flush(w->ring); }
+        break;
+    case TX_WATCHDOG_ACTION_DROP:
+        spsc_ring_set_drop_mode(w->ring, stalled);
+        break;
+    default:
+        break;
+    }
+
+    if (wd->on_event) { wd->on_event(wd->ctx, id, stalled); }
+}
+
+/* === Public function implementation ========================================================== */
+
+tx_watchdog_t tx_watchdog_init(uint32_t deadline_ms, tx_watchdog_action_t action, tx_watchdog_event_fn on_event,
+                               void* ctx)
+{
+    assert(deadline_ms && action <= TX_WATCHDOG_ACTION_DROP);
+
+    tx_watchdog_t wd = watchdog_pool_take();
+    assert(wd);
+
+    wd->deadline_ns = deadline_ms * NS_PER_MS;
+    wd->action = action;
+    wd->on_event = on_event;
+    wd->ctx = ctx;
+
+    return wd;
+}
+
+void tx_watchdog_deinit(tx_watchdog_t* wd)
+{
+    assert(wd != NULL);
+    watchdog_pool_give(*wd);
+    *wd = NULL;
+}
+
+int tx_watchdog_add(tx_watchdog_t wd, spsc_ring_t ring)
+{
+    assert(wd && ring);
+
+    if (wd->count == TX_WATCHDOG_MAX_RINGS) { return -1; }
+
+    size_t written;
+    watched_ring_t* w = &wd->rings[wd->count];
+
+    w->ring = ring;
+    spsc_ring_positions(ring, &written, &w->last_read);
+    w->last_progress_ns = tsc_clock_now_ns();
+    w->stalled = false;
+
+    return (int)wd->count++;
+}
+
+size_t tx_watchdog_sample(tx_watchdog_t wd)
+{
+    assert(wd);
+
+    uint64_t now = tsc_clock_now_ns();
+    size_t stalled = 0;
+
+    for (size_t i = 0; i < wd->count; i++) {
+        watched_ring_t* w = &wd->rings[i];
+        size_t written, read;
+
+        spsc_ring_positions(w->ring, &written, &read);
+
+        // An idle ring counts as progress: there is nothing the consumer could have done.
+        if (read != w->last_read || written == read) {
+            w->last_read = read;
+            w->last_progress_ns = now;
+            if (w->stalled) { set_stalled(wd, (int)i, false); }
+        } else if (!w->stalled && (now - w->last_progress_ns) >= wd->deadline_ns) {
+            set_stalled(wd, (int)i, true);
+        }
+
+        stalled += w->stalled ? 1 : 0;
+    }
+
+    return stalled;
+}
+
+bool tx_watchdog_is_stalled(tx_watchdog_t wd, int id)
+{
+    assert(wd && id >= 0 && (size_t)id < wd->count);
+    return wd->rings[id].stalled;
+}
+
+/* === End of documentation ==================================================================== */
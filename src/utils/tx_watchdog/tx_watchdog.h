@@ -0,0 +1,129 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file tx_watchdog.h
+/// @brief Stalled-consumer watchdog for TX rings.
+///
+/// When a UART stalls (disconnected cable, stuck hardware flow control) its TX ring fills up and stays
+/// full. The watchdog samples the read position and occupancy of every registered ring at a low rate.
+/// If a ring has data pending and its consumer hasn't made progress within the deadline, it raises an
+/// event and applies the configured action. Sampling only uses relaxed loads of the ring indices
+/// (spsc_ring_positions()) and never blocks either side.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/spsc_ring/spsc_ring.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef TX_WATCHDOG_POOL_SIZE
+/// Watchdogs available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define TX_WATCHDOG_POOL_SIZE 2
+#endif
+
+/// Maximum number of rings a single watchdog can supervise.
+#define TX_WATCHDOG_MAX_RINGS 32
+
+/* === Public data type declarations =========================================================== */
+
+/// What to do with a ring whose consumer has stalled.
+typedef enum
+{
+    TX_WATCHDOG_ACTION_NONE,   ///< Only raise the event.
+    TX_WATCHDOG_ACTION_FLUSH,  ///< Discard the pending data (spsc_ring_request_flush()), so stale messages are
+                               ///< not sent once the consumer resumes.
+    TX_WATCHDOG_ACTION_DROP,   ///< Drop new data until the consumer recovers (spsc_ring_set_drop_mode()).
+} tx_watchdog_action_t;
+
+///
+/// @brief Event raised when a ring stalls and when it recovers.
+/// @param ctx User argument given to tx_watchdog_init().
+/// @param id Identifier returned by tx_watchdog_add().
+/// @param stalled true when the consumer has just been declared stalled, false when it recovered.
+///
+typedef void (*tx_watchdog_event_fn)(void* ctx, int id, bool stalled);
+
+/// Opaque watchdog structure
+typedef struct tx_watchdog_obj_t tx_watchdog_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef tx_watchdog_obj_t* tx_watchdog_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Creates a watchdog.
+/// @param deadline_ms Time without consumer progress, while data is pending, after which a ring is stalled.
+/// @param action Action applied to stalled rings.
+/// @param on_event Event callback, may be NULL.
+/// @param ctx Argument for @p on_event.
+///
+tx_watchdog_t tx_watchdog_init(uint32_t deadline_ms, tx_watchdog_action_t action, tx_watchdog_event_fn on_event,
+                               void* ctx);
+
+///
+/// @brief Free a watchdog structure. Rings are not free'd.
+/// @param wd Watchdog to free. Set to NULL afterwards.
+///
+void tx_watchdog_deinit(tx_watchdog_t* wd);
+
+///
+/// @brief Registers a ring to supervise.
+/// @param wd Watchdog.
+/// @param ring TX ring.
+/// @return Identifier reported in events, or -1 if the watchdog is full.
+///
+int tx_watchdog_add(tx_watchdog_t wd, spsc_ring_t ring);
+
+///
+/// @brief Samples every registered ring once. Call it periodically (a few times per deadline is enough).
+/// @param wd Watchdog.
+/// @return Number of rings currently stalled.
+///
+size_t tx_watchdog_sample(tx_watchdog_t wd);
+
+///
+/// @brief Checks whether a ring is currently considered stalled.
+/// @param wd Watchdog.
+/// @param id Identifier returned by tx_watchdog_add().
+///
+bool tx_watchdog_is_stalled(tx_watchdog_t wd, int id);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
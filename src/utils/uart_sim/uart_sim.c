@@ -0,0 +1,403 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file uart_sim.c
+/// @brief Host-side simulator of a UART TX-empty interrupt (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <utils/obj_pool/obj_pool.h>
+#include <utils/tsc_clock/tsc_clock.h>
+
+#include "uart_sim.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Empty measurements taken to estimate the cost of reading the counter.
+#define OVERHEAD_SAMPLES 64U
+
+/// Nanoseconds per second.
+#define NS_PER_SEC 1000000000ULL
+
+/* === Private data type declarations ========================================================== */
+
+///
+/// @brief Structure representing a simulator.
+///
+/// Counters are written only from the ISR context and read with relaxed loads from anywhere else.
+///
+struct uart_sim_obj_t
+{
+    uart_sim_config_t config;                             ///< Simulator parameters.
+    uint64_t overhead;                                    ///< Cost of an empty measurement, subtracted from samples.
+    uint64_t due_ns;                                      ///< When the next interrupt is due. ISR side.
+    bool sending;                                         ///< Whether the last interrupt sent a byte. ISR side.
+    bool starved;                                         ///< Whether the ring ran dry mid-stream. ISR side.
+    bool running;                                         ///< Whether the simulator is started. Owner side.
+    bool realtime;                                        ///< Whether the ISR thread got SCHED_FIFO.
+    atomic_bool stopping;                                 ///< Asks the ISR thread to exit.
+    pthread_t thread;                                     ///< ISR thread, in thread mode.
+    pthread_mutex_t irq;                                  ///< Held while the ISR thread fires, or while masked.
+    struct sigaction previous;                            ///< SIGALRM action replaced in signal mode.
+    _Atomic uint64_t interrupts;                          ///< ISR invocations.
+    _Atomic uint64_t bytes;                               ///< Bytes sent.
+    _Atomic uint64_t underruns;                           ///< Empty ring between two bytes of a stream.
+    _Atomic uint64_t late;                                ///< Interrupts fired more than a byte period late.
+    _Atomic uint64_t min_cycles;                          ///< Cheapest invocation.
+    _Atomic uint64_t max_cycles;                          ///< Most expensive invocation.
+    _Atomic uint64_t total_cycles;                        ///< Cost of all invocations.
+    _Atomic uint64_t histogram[UART_SIM_HISTOGRAM_BINS];  ///< Invocations per cost bin.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static inline void counter_add(_Atomic uint64_t* counter, uint64_t value);
+static void record_cost(uart_sim_t sim, uint64_t cycles);
+static uint64_t monotonic_ns(void);
+static void fire(uart_sim_t sim);
+static void on_alarm(int signo);
+static void* isr_thread(void* arg);
+static int start_signal(uart_sim_t sim);
+static void stop_signal(uart_sim_t sim);
+static int start_thread(uart_sim_t sim);
+static void stop_thread(uart_sim_t sim);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(sim_pool, uart_sim_obj_t, UART_SIM_POOL_SIZE)
+
+/// Simulator owning SIGALRM, if any.
+static _Atomic(uart_sim_t) signal_sim = NULL;
+
+/* === Private function implementation ========================================================= */
+
+static inline void counter_add(_Atomic uint64_t* counter, uint64_t value)
+{
+    // Single writer: a plain load and store, no locked read-modify-write in the measured loop.
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+static void record_cost(uart_sim_t sim, uint64_t cycles)
+{
+    if (cycles < atomic_load_explicit(&sim->min_cycles, memory_order_relaxed)) {
+        atomic_store_explicit(&sim->min_cycles, cycles, memory_order_relaxed);
+    }
+    if (cycles > atomic_load_explicit(&sim->max_cycles, memory_order_relaxed)) {
+        atomic_store_explicit(&sim->max_cycles, cycles, memory_order_relaxed);
+    }
+    counter_add(&sim->total_cycles, cycles);
+
+    size_t bin = 0;
+    for (uint64_t c = cycles; c > 1 && bin < UART_SIM_HISTOGRAM_BINS - 1; c >>= 1) { bin++; }
+    counter_add(&sim->histogram[bin], 1);
+
+    counter_add(&sim->interrupts, 1);
+}
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static void fire(uart_sim_t sim)
+{
+    uint64_t period = sim->config.byte_period_ns;
+
+    // Not tsc_clock_now_ns(): in signal mode this runs in a handler, which could interrupt a recalibration
+    // and then spin forever on its seqlock. clock_gettime() is async-signal-safe and on the same time base.
+    uint64_t now = monotonic_ns();
+
+    if (now > sim->due_ns + period) {
+        // A whole byte time was lost: the line idled although data may have been pending.
+        counter_add(&sim->late, 1);
+        sim->due_ns = now;
+    }
+    sim->due_ns += period;
+
+    uint8_t byte;
+    uint64_t start = tsc_clock_cycles();
+    int r = sim->config.isr(sim->config.ctx, &byte);
+    uint64_t cycles = tsc_clock_cycles_serialized() - start;
+
+    record_cost(sim, (cycles > sim->overhead) ? cycles - sim->overhead : 0);
+
+    if (r == 0) {
+        uint64_t sent = atomic_load_explicit(&sim->bytes, memory_order_relaxed);
+        if (sim->config.line && sent < sim->config.line_size) { sim->config.line[sent] = byte; }
+        atomic_store_explicit(&sim->bytes, sent + 1, memory_order_relaxed);
+
+        if (sim->starved) { counter_add(&sim->underruns, 1); }
+        sim->sending = true;
+        sim->starved = false;
+    } else if (sim->sending) {
+        // Whether this is an underrun or the end of the stream is only known once the next byte shows up.
+        sim->sending = false;
+        sim->starved = true;
+    }
+}
+
+static void on_alarm(int signo)
+{
+    (void)signo;
+
+    int saved = errno;
+    uart_sim_t sim = atomic_load_explicit(&signal_sim, memory_order_acquire);
+    if (sim) { fire(sim); }
+    errno = saved;
+}
+
+static void* isr_thread(void* arg)
+{
+    uart_sim_t sim = arg;
+
+    while (!atomic_load_explicit(&sim->stopping, memory_order_acquire)) {
+        struct timespec due = {
+            .tv_sec = (time_t)(sim->due_ns / NS_PER_SEC),
+            .tv_nsec = (long)(sim->due_ns % NS_PER_SEC),
+        };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+
+        if (atomic_load_explicit(&sim->stopping, memory_order_acquire)) { break; }
+
+        pthread_mutex_lock(&sim->irq);
+        fire(sim);
+        pthread_mutex_unlock(&sim->irq);
+    }
+
+    return NULL;
+}
+
+static int start_signal(uart_sim_t sim)
+{
+    uart_sim_t expected = NULL;
+    if (!atomic_compare_exchange_strong(&signal_sim, &expected, sim)) { return -1; }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_alarm;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    // setitimer() has microsecond resolution: the due time keeps the exact period, so rounding only
+    // shows up as jitter, never as drift being reported late.
+    suseconds_t period_us = (suseconds_t)((sim->config.byte_period_ns + 999U) / 1000U);
+    struct itimerval timer = {
+        .it_interval = {.tv_sec = period_us / 1000000, .tv_usec = period_us % 1000000},
+        .it_value = {.tv_sec = period_us / 1000000, .tv_usec = period_us % 1000000},
+    };
+
+    if (sigaction(SIGALRM, &action, &sim->previous) != 0) {
+        atomic_store(&signal_sim, NULL);
+        return -1;
+    }
+    if (setitimer(ITIMER_REAL, &timer, NULL) != 0) {
+        sigaction(SIGALRM, &sim->previous, NULL);
+        atomic_store(&signal_sim, NULL);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void stop_signal(uart_sim_t sim)
+{
+    sigset_t alarm;
+    sigset_t old;
+    sigemptyset(&alarm);
+    sigaddset(&alarm, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &alarm, &old);
+
+    struct itimerval off;
+    memset(&off, 0, sizeof(off));
+    setitimer(ITIMER_REAL, &off, NULL);
+
+    // Ignoring the signal discards an expiry still pending, which the previous action could not handle.
+    struct sigaction ignore;
+    memset(&ignore, 0, sizeof(ignore));
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&ignore.sa_mask);
+    sigaction(SIGALRM, &ignore, NULL);
+    sigaction(SIGALRM, &sim->previous, NULL);
+
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    atomic_store(&signal_sim, NULL);
+}
+
+static int start_thread(uart_sim_t sim)
+{
+    atomic_store(&sim->stopping, false);
+
+    // An ISR preempts everything else: try to get the same from the scheduler, which needs privileges.
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    struct sched_param param = {.sched_priority = sched_get_priority_max(SCHED_FIFO)};
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    pthread_attr_setschedparam(&attr, &param);
+
+    sim->realtime = (pthread_create(&sim->thread, &attr, isr_thread, sim) == 0);
+    pthread_attr_destroy(&attr);
+
+    if (!sim->realtime && pthread_create(&sim->thread, NULL, isr_thread, sim) != 0) { return -1; }
+
+    return 0;
+}
+
+static void stop_thread(uart_sim_t sim)
+{
+    atomic_store(&sim->stopping, true);
+    pthread_join(sim->thread, NULL);
+}
+
+/* === Public function implementation ========================================================== */
+
+uart_sim_t uart_sim_init(const uart_sim_config_t* config)
+{
+    assert(config && config->isr && config->byte_period_ns);
+    assert(config->mode == UART_SIM_SIGNAL || config->mode == UART_SIM_THREAD);
+    assert(config->line || !config->line_size);
+
+    uart_sim_t sim = sim_pool_take();
+    assert(sim);
+
+    sim->config = *config;
+    atomic_init(&sim->stopping, false);
+    atomic_init(&sim->min_cycles, UINT64_MAX);
+    pthread_mutex_init(&sim->irq, NULL);
+
+    sim->overhead = UINT64_MAX;
+    for (size_t i = 0; i < OVERHEAD_SAMPLES; i++) {
+        uint64_t start = tsc_clock_cycles();
+        uint64_t cycles = tsc_clock_cycles_serialized() - start;
+        if (cycles < sim->overhead) { sim->overhead = cycles; }
+    }
+
+    return sim;
+}
+
+void uart_sim_deinit(uart_sim_t* sim)
+{
+    assert(sim != NULL);
+
+    if (*sim) {
+        uart_sim_stop(*sim);
+        pthread_mutex_destroy(&(*sim)->irq);
+    }
+    sim_pool_give(*sim);
+    *sim = NULL;
+}
+
+int uart_sim_start(uart_sim_t sim)
+{
+    assert(sim && !sim->running);
+
+    sim->due_ns = tsc_clock_now_ns() + sim->config.byte_period_ns;
+    sim->sending = false;
+    sim->starved = false;
+
+    int r = (sim->config.mode == UART_SIM_SIGNAL) ? start_signal(sim) : start_thread(sim);
+    sim->running = (r == 0);
+
+    return r;
+}
+
+void uart_sim_stop(uart_sim_t sim)
+{
+    assert(sim);
+
+    if (!sim->running) { return; }
+
+    if (sim->config.mode == UART_SIM_SIGNAL) {
+        stop_signal(sim);
+    } else {
+        stop_thread(sim);
+    }
+    sim->running = false;
+}
+
+void uart_sim_irq_disable(uart_sim_t sim)
+{
+    assert(sim);
+
+    if (sim->config.mode == UART_SIM_SIGNAL) {
+        sigset_t alarm;
+        sigemptyset(&alarm);
+        sigaddset(&alarm, SIGALRM);
+        pthread_sigmask(SIG_BLOCK, &alarm, NULL);
+    } else {
+        pthread_mutex_lock(&sim->irq);
+    }
+}
+
+void uart_sim_irq_enable(uart_sim_t sim)
+{
+    assert(sim);
+
+    if (sim->config.mode == UART_SIM_SIGNAL) {
+        sigset_t alarm;
+        sigemptyset(&alarm);
+        sigaddset(&alarm, SIGALRM);
+        pthread_sigmask(SIG_UNBLOCK, &alarm, NULL);
+    } else {
+        pthread_mutex_unlock(&sim->irq);
+    }
+}
+
+void uart_sim_get_stats(uart_sim_t sim, uart_sim_stats_t* stats)
+{
+    assert(sim && stats);
+
+    stats->interrupts = atomic_load_explicit(&sim->interrupts, memory_order_relaxed);
+    stats->bytes = atomic_load_explicit(&sim->bytes, memory_order_relaxed);
+    stats->underruns = atomic_load_explicit(&sim->underruns, memory_order_relaxed);
+    stats->late = atomic_load_explicit(&sim->late, memory_order_relaxed);
+    stats->min_cycles = stats->interrupts ? atomic_load_explicit(&sim->min_cycles, memory_order_relaxed) : 0;
+    stats->max_cycles = atomic_load_explicit(&sim->max_cycles, memory_order_relaxed);
+    stats->mean_cycles =
+        stats->interrupts ? atomic_load_explicit(&sim->total_cycles, memory_order_relaxed) / stats->interrupts : 0;
+    for (size_t i = 0; i < UART_SIM_HISTOGRAM_BINS; i++) {
+        stats->histogram[i] = atomic_load_explicit(&sim->histogram[i], memory_order_relaxed);
+    }
+    stats->realtime = sim->realtime;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,174 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file uart_sim.h
+/// @brief Host-side simulator of a UART TX-empty interrupt.
+///
+/// On the MCU the transmitter raises an interrupt every time its data register empties, and the ISR
+/// pulls the next byte out of the TX ring. The ISR runs once per byte, so its cost bounds the interrupt
+/// load. The simulator fires a user ISR at a fixed byte period (320 µs for MIDI's 31250 baud), either as
+/// a SIGALRM handler interrupting the process, which preempts the producer just like a real interrupt,
+/// or from a dedicated high-priority thread. It measures the cycles spent in every invocation, checks
+/// that interrupts are not fired late, and counts underruns: moments the ring ran dry while a stream
+/// was being sent.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef UART_SIM_POOL_SIZE
+/// Simulators available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define UART_SIM_POOL_SIZE 2
+#endif
+
+/// Byte period of a MIDI port: 10 bits at 31250 baud, in nanoseconds.
+#define UART_SIM_MIDI_BYTE_NS 320000U
+
+/// Number of bins of the cost histogram. Bin i counts invocations costing [2^i, 2^(i+1)) cycles.
+#define UART_SIM_HISTOGRAM_BINS 16U
+
+/* === Public data type declarations =========================================================== */
+
+/// How the interrupt is emulated.
+typedef enum
+{
+    UART_SIM_SIGNAL,  ///< SIGALRM handler, preempting whatever thread the process is running.
+    UART_SIM_THREAD,  ///< Dedicated thread, with SCHED_FIFO priority when the process is allowed to.
+} uart_sim_mode_t;
+
+///
+/// @brief Simulated ISR, e.g. a wrapper around ring_buffer_read_byte().
+/// @param ctx Argument given in the configuration.
+/// @param byte Where to store the byte to send.
+/// @return 0 if a byte was provided, or -1 if there is nothing to send.
+///
+typedef int (*uart_sim_isr_fn)(void* ctx, uint8_t* byte);
+
+/// Simulator parameters.
+typedef struct
+{
+    uart_sim_mode_t mode;     ///< Interrupt emulation.
+    uint32_t byte_period_ns;  ///< Time between interrupts, e.g. UART_SIM_MIDI_BYTE_NS.
+    uart_sim_isr_fn isr;      ///< ISR to fire.
+    void* ctx;                ///< Argument for `isr`.
+    uint8_t* line;            ///< Where to store the bytes sent, NULL to discard them.
+    size_t line_size;         ///< Size of `line`. Further bytes are discarded.
+} uart_sim_config_t;
+
+/// Simulator statistics.
+typedef struct
+{
+    uint64_t interrupts;                          ///< ISR invocations.
+    uint64_t bytes;                               ///< Bytes sent.
+    uint64_t underruns;                           ///< Empty ring between two bytes of a stream.
+    uint64_t late;                                ///< Interrupts fired more than a byte period late.
+    uint64_t min_cycles;                          ///< Cheapest invocation.
+    uint64_t max_cycles;                          ///< Most expensive invocation.
+    uint64_t mean_cycles;                         ///< Average invocation cost.
+    uint64_t histogram[UART_SIM_HISTOGRAM_BINS];  ///< Invocations per cost bin, the last one open-ended.
+    bool realtime;                                ///< Whether the ISR thread runs under SCHED_FIFO.
+} uart_sim_stats_t;
+
+/// Opaque simulator structure
+typedef struct uart_sim_obj_t uart_sim_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef uart_sim_obj_t* uart_sim_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Creates a simulator, stopped.
+///
+/// Costs are measured with tsc_clock_cycles(), so tsc_clock_init() should be called first to get them in
+/// CPU cycles rather than nanoseconds. The cost of reading the counter itself is measured here and
+/// subtracted from every sample.
+///
+/// @param config Simulator parameters. Copied.
+///
+uart_sim_t uart_sim_init(const uart_sim_config_t* config);
+
+///
+/// @brief Free a simulator structure, stopping it first.
+/// @param sim Simulator to free. Set to NULL afterwards.
+///
+void uart_sim_deinit(uart_sim_t* sim);
+
+///
+/// @brief Starts firing the ISR, one byte period from now.
+///
+/// Only one simulator can run in signal mode at a time, since SIGALRM is process-wide; it is delivered to
+/// any thread not blocking it, so other threads touching the ring should block it.
+///
+/// @param sim Simulator to start.
+/// @return 0 on success, or -1 if the timer or thread could not be set up.
+///
+int uart_sim_start(uart_sim_t sim);
+
+///
+/// @brief Stops firing the ISR. Once it returns, the ISR is not running and will not run again.
+/// @param sim Simulator to stop.
+///
+void uart_sim_stop(uart_sim_t sim);
+
+///
+/// @brief Keeps the ISR from firing, like disabling the UART interrupt around a ring update.
+///
+/// Needed when the ISR consumes a structure that is not safe against concurrent access, such as a
+/// ring_buffer. An interrupt falling due meanwhile fires on uart_sim_irq_enable(). Does not nest.
+///
+/// @param sim Simulator to mask.
+///
+void uart_sim_irq_disable(uart_sim_t sim);
+
+///
+/// @brief Lets the ISR fire again after uart_sim_irq_disable().
+/// @param sim Simulator to unmask.
+///
+void uart_sim_irq_enable(uart_sim_t sim);
+
+///
+/// @brief Returns the simulator statistics. Exact once stopped, a hint while running.
+/// @param sim Simulator to check.
+/// @param stats Where to store the statistics.
+///
+void uart_sim_get_stats(uart_sim_t sim, uart_sim_stats_t* stats);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
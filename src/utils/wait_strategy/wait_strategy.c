@@ -0,0 +1,223 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file wait_strategy.c
+/// @brief Configurable strategies for a consumer waiting on a concurrent ring (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sched.h>
+#endif
+
+#include <utils/obj_pool/obj_pool.h>
+
+#include "wait_strategy.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Weight of a new sample in the spin budget moving average, as a power of two (1/8).
+#define EWMA_SHIFT 3U
+
+/* === Private data type declarations ========================================================== */
+
+///
+/// @brief Structure representing a wait strategy.
+///
+/// `futex_word` and `parked` are touched by the producer, the rest only by the owning consumer.
+///
+struct wait_strategy_obj_t
+{
+    wait_strategy_kind_t kind;  ///< Waiting behaviour.
+    uint32_t spin_limit;        ///< Current spin budget, in relax iterations.
+    uint32_t spin_ewma;         ///< Moving average of the spin iterations a wait would have needed.
+    atomic_uint futex_word;     ///< Bumped by the producer on every wake-up.
+    atomic_bool parked;         ///< Whether the consumer is (about to be) sleeping.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static inline void cpu_relax(void);
+static void yield_cpu(void);
+static void park(atomic_uint* word, unsigned int expected);
+static void unpark(atomic_uint* word);
+static void adapt_spin_limit(wait_strategy_t ws, uint32_t sample);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(strategy_pool, wait_strategy_obj_t, WAIT_STRATEGY_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ volatile("yield");
+#endif
+}
+
+static void yield_cpu(void)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    sched_yield();
+#else
+    cpu_relax();
+#endif
+}
+
+static void park(atomic_uint* word, unsigned int expected)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, (unsigned int*)word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#else
+    (void)word;
+    (void)expected;
+    yield_cpu();
+#endif
+}
+
+static void unpark(atomic_uint* word)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, (unsigned int*)word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+static void adapt_spin_limit(wait_strategy_t ws, uint32_t sample)
+{
+    // Spin iterations are used as the inter-arrival time unit: they cost nothing to measure and are
+    // exactly the quantity the budget is expressed in. The budget is kept at twice the average gap.
+    int64_t delta = (int64_t)sample - (int64_t)ws->spin_ewma;
+    ws->spin_ewma = (uint32_t)((int64_t)ws->spin_ewma + delta / (1 << EWMA_SHIFT));
+
+    uint64_t limit = 2ULL * ws->spin_ewma;
+    if (limit < WAIT_STRATEGY_MIN_SPINS) { limit = WAIT_STRATEGY_MIN_SPINS; }
+    if (limit > WAIT_STRATEGY_MAX_SPINS) { limit = WAIT_STRATEGY_MAX_SPINS; }
+    ws->spin_limit = (uint32_t)limit;
+}
+
+/* === Public function implementation ========================================================== */
+
+wait_strategy_t wait_strategy_init(wait_strategy_kind_t kind, uint32_t spin_limit)
+{
+    assert(kind <= WAIT_STRATEGY_ADAPTIVE);
+
+    wait_strategy_t ws = strategy_pool_take();
+    assert(ws);
+
+    ws->kind = kind;
+    ws->spin_limit = spin_limit;
+    ws->spin_ewma = spin_limit / 2;
+    atomic_init(&ws->futex_word, 0);
+    atomic_init(&ws->parked, false);
+
+    return ws;
+}
+
+void wait_strategy_deinit(wait_strategy_t* ws)
+{
+    assert(ws != NULL);
+    strategy_pool_give(*ws);
+    *ws = NULL;
+}
+
+wait_strategy_kind_t wait_strategy_kind(wait_strategy_t ws)
+{
+    assert(ws);
+    return ws->kind;
+}
+
+uint32_t wait_strategy_spin_limit(wait_strategy_t ws)
+{
+    assert(ws);
+    return ws->spin_limit;
+}
+
+void wait_strategy_wait(wait_strategy_t ws, wait_strategy_ready_fn ready, void* ctx)
+{
+    assert(ws && ready);
+
+    // Phase 1: spin.
+    for (uint32_t i = 0; i < ws->spin_limit || ws->kind == WAIT_STRATEGY_SPIN; i++) {
+        if (ready(ctx)) {
+            if (ws->kind == WAIT_STRATEGY_ADAPTIVE) { adapt_spin_limit(ws, i); }
+            return;
+        }
+        cpu_relax();
+    }
+
+    // Phase 2: yield.
+    for (uint32_t i = 0; i < WAIT_STRATEGY_YIELDS || ws->kind == WAIT_STRATEGY_YIELD; i++) {
+        if (ready(ctx)) {
+            // Data arrived shortly after the spin budget ran out: spinning a bit longer would have paid off.
+            if (ws->kind == WAIT_STRATEGY_ADAPTIVE) { adapt_spin_limit(ws, ws->spin_limit); }
+            return;
+        }
+        yield_cpu();
+    }
+
+    // Phase 3: park. The seq_cst fence pairs with the one in wait_strategy_notify(): either the producer
+    // sees `parked` set, or we see its data in ready().
+    while (true) {
+        unsigned int seq = atomic_load_explicit(&ws->futex_word, memory_order_acquire);
+        atomic_store_explicit(&ws->parked, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if (ready(ctx)) { break; }
+
+        park(&ws->futex_word, seq);
+    }
+    atomic_store_explicit(&ws->parked, false, memory_order_relaxed);
+
+    // The gap was longer than the whole spin budget: spinning was wasted CPU, shrink it.
+    if (ws->kind == WAIT_STRATEGY_ADAPTIVE) { adapt_spin_limit(ws, ws->spin_limit / 4); }
+}
+
+void wait_strategy_notify(wait_strategy_t ws)
+{
+    assert(ws);
+
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (atomic_load_explicit(&ws->parked, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&ws->futex_word, 1, memory_order_release);
+        unpark(&ws->futex_word);
+    }
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,135 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file wait_strategy.h
+/// @brief Configurable strategies for a consumer waiting on a concurrent ring.
+///
+/// A consumer that finds its ring empty can either burn a core spinning (lowest wake-up latency) or
+/// sleep in the kernel (no CPU usage, microseconds of wake-up latency). The strategies defined here
+/// move through three phases: spin with a CPU relax hint, yield the processor, and finally park on a
+/// futex until the producer calls wait_strategy_notify(). Each consumer owns its own strategy.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef WAIT_STRATEGY_POOL_SIZE
+/// Strategies available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define WAIT_STRATEGY_POOL_SIZE 16
+#endif
+
+/// Lower bound for the adaptive spin budget, in relax iterations.
+#define WAIT_STRATEGY_MIN_SPINS 16U
+
+/// Upper bound for the adaptive spin budget, in relax iterations.
+#define WAIT_STRATEGY_MAX_SPINS 65536U
+
+/// Number of sched_yield() calls performed before parking.
+#define WAIT_STRATEGY_YIELDS 64U
+
+/* === Public data type declarations =========================================================== */
+
+/// Available waiting behaviours.
+typedef enum
+{
+    WAIT_STRATEGY_SPIN,      ///< Busy-wait only. Lowest latency, burns a whole core.
+    WAIT_STRATEGY_YIELD,     ///< Spin, then keep yielding the processor. Never sleeps.
+    WAIT_STRATEGY_PARK,      ///< Spin, yield, then sleep until notified. Fixed spin budget.
+    WAIT_STRATEGY_ADAPTIVE,  ///< Like WAIT_STRATEGY_PARK, with the spin budget following the observed arrivals.
+} wait_strategy_kind_t;
+
+/// Opaque wait strategy structure
+typedef struct wait_strategy_obj_t wait_strategy_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef wait_strategy_obj_t* wait_strategy_t;
+
+/// Predicate polled by wait_strategy_wait(). Must return true once the awaited condition holds.
+typedef bool (*wait_strategy_ready_fn)(void* ctx);
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Creates a wait strategy.
+/// @param kind Waiting behaviour.
+/// @param spin_limit Relax iterations performed before moving to the next phase. For WAIT_STRATEGY_ADAPTIVE this
+/// is only the initial value.
+///
+wait_strategy_t wait_strategy_init(wait_strategy_kind_t kind, uint32_t spin_limit);
+
+///
+/// @brief Free a wait strategy structure.
+/// @param ws Wait strategy to free. Set to NULL afterwards.
+///
+void wait_strategy_deinit(wait_strategy_t* ws);
+
+///
+/// @brief Returns the kind of the wait strategy.
+/// @param ws Wait strategy to check.
+///
+wait_strategy_kind_t wait_strategy_kind(wait_strategy_t ws);
+
+///
+/// @brief Returns the current spin budget, in relax iterations.
+/// @param ws Wait strategy to check.
+///
+uint32_t wait_strategy_spin_limit(wait_strategy_t ws);
+
+///
+/// @brief Blocks the calling consumer until @p ready returns true.
+///
+/// Must only be called by the thread that owns the strategy. Parking strategies rely on the producer
+/// calling wait_strategy_notify() after publishing new data.
+///
+/// @param ws Wait strategy to use.
+/// @param ready Predicate to poll.
+/// @param ctx Argument for @p ready.
+///
+void wait_strategy_wait(wait_strategy_t ws, wait_strategy_ready_fn ready, void* ctx);
+
+///
+/// @brief Wakes the consumer if it is parked. Cheap when it is not (a fence and a load).
+///
+/// Must be called by the producer after the new data has been published.
+///
+/// @param ws Wait strategy of the consumer to wake.
+///
+void wait_strategy_notify(wait_strategy_t ws);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
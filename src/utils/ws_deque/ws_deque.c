@@ -0,0 +1,187 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file ws_deque.c
+/// @brief Chase-Lev work-stealing deque (implementation).
+///
+/// Follows the C11 formulation by Lê, Pop, Cohen and Zappa Nardelli ("Correct and efficient
+/// work-stealing for weak memory models", PPoPP 2013), with a fixed-size buffer.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <utils/obj_pool/obj_pool.h>
+
+#include "ws_deque.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Cache line size assumed to keep the owner and thief indices apart.
+#define CACHE_LINE_SIZE 64
+
+/* === Private data type declarations ========================================================== */
+
+///
+/// @brief Structure representing a work-stealing deque.
+///
+/// Indices are signed and free-running: the owner's pop briefly moves `bottom` below `top`.
+///
+struct ws_deque_obj_t
+{
+    alignas(CACHE_LINE_SIZE) _Atomic int64_t top;     ///< Next item to steal, moved by thieves and the last pop.
+    alignas(CACHE_LINE_SIZE) _Atomic int64_t bottom;  ///< Next free slot, moved by the owner only.
+    alignas(CACHE_LINE_SIZE) _Atomic(void*) * items;  ///< Item slots.
+    int64_t mask;                                     ///< capacity - 1, used to wrap the indices.
+#if defined(UTILS_NO_HEAP)
+    _Atomic(void*) storage[WS_DEQUE_MAX_CAPACITY];  ///< Backing store of `items`.
+#endif
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(deque_pool, ws_deque_obj_t, WS_DEQUE_POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+/* === Public function implementation ========================================================== */
+
+ws_deque_t ws_deque_init(size_t capacity)
+{
+    assert(capacity && ((capacity & (capacity - 1)) == 0));
+
+    ws_deque_t dq = deque_pool_take();
+    assert(dq);
+
+#if defined(UTILS_NO_HEAP)
+    assert(capacity <= WS_DEQUE_MAX_CAPACITY);
+    dq->items = dq->storage;
+#else
+    dq->items = malloc(capacity * sizeof(*dq->items));
+    assert(dq->items);
+#endif
+
+    for (size_t i = 0; i < capacity; i++) { atomic_init(&dq->items[i], NULL); }
+    dq->mask = (int64_t)capacity - 1;
+    atomic_init(&dq->top, 0);
+    atomic_init(&dq->bottom, 0);
+
+    return dq;
+}
+
+void ws_deque_deinit(ws_deque_t* dq)
+{
+    assert(dq != NULL);
+
+#if !defined(UTILS_NO_HEAP)
+    if (*dq) { free((void*)(*dq)->items); }
+#endif
+
+    deque_pool_give(*dq);
+    *dq = NULL;
+}
+
+size_t ws_deque_size(ws_deque_t dq)
+{
+    assert(dq);
+
+    int64_t top = atomic_load_explicit(&dq->top, memory_order_acquire);
+    int64_t bottom = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+
+    return (bottom > top) ? (size_t)(bottom - top) : 0;
+}
+
+int ws_deque_push(ws_deque_t dq, void* item)
+{
+    assert(dq && item);
+
+    int64_t bottom = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+    int64_t top = atomic_load_explicit(&dq->top, memory_order_acquire);
+
+    if (bottom - top > dq->mask) { return -1; }
+
+    atomic_store_explicit(&dq->items[bottom & dq->mask], item, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&dq->bottom, bottom + 1, memory_order_relaxed);
+
+    return 0;
+}
+
+void* ws_deque_pop(ws_deque_t dq)
+{
+    assert(dq);
+
+    int64_t bottom = atomic_load_explicit(&dq->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&dq->bottom, bottom, memory_order_relaxed);
+
+    // Pairs with the fence in ws_deque_steal(): either the thief sees the lowered bottom, or we see its top.
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = atomic_load_explicit(&dq->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        // Empty.
+        atomic_store_explicit(&dq->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    void* item = atomic_load_explicit(&dq->items[bottom & dq->mask], memory_order_relaxed);
+
+    if (top == bottom) {
+        // Last item: race the thieves for it.
+        if (!atomic_compare_exchange_strong_explicit(&dq->top, &top, top + 1, memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            item = NULL;
+        }
+        atomic_store_explicit(&dq->bottom, bottom + 1, memory_order_relaxed);
+    }
+
+    return item;
+}
+
+void* ws_deque_steal(ws_deque_t dq)
+{
+    assert(dq);
+
+    int64_t top = atomic_load_explicit(&dq->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t bottom = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+
+    if (top >= bottom) { return NULL; }
+
+    void* item = atomic_load_explicit(&dq->items[top & dq->mask], memory_order_relaxed);
+
+    if (!atomic_compare_exchange_strong_explicit(&dq->top, &top, top + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return NULL;
+    }
+
+    return item;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,110 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file ws_deque.h
+/// @brief Chase-Lev work-stealing deque.
+///
+/// The owner thread pushes and pops at the bottom (LIFO, cache-warm) without any atomic read-modify-write
+/// in the common case; any other thread may steal from the top (FIFO). The capacity is fixed: a push
+/// on a full deque is refused, so the caller decides what to do with the item (e.g. run it inline).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef WS_DEQUE_POOL_SIZE
+/// Deques available when built with UTILS_NO_HEAP (see obj_pool.h). A ws_executor takes one per worker.
+#define WS_DEQUE_POOL_SIZE 16
+#endif
+
+#ifndef WS_DEQUE_MAX_CAPACITY
+/// Largest capacity when built with UTILS_NO_HEAP, which reserves it for every deque of the pool.
+#define WS_DEQUE_MAX_CAPACITY 256
+#endif
+
+/* === Public data type declarations =========================================================== */
+
+/// Opaque work-stealing deque structure
+typedef struct ws_deque_obj_t ws_deque_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef ws_deque_obj_t* ws_deque_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Creates an empty deque.
+/// @param capacity Maximum number of items. Must be a power of two.
+///
+ws_deque_t ws_deque_init(size_t capacity);
+
+///
+/// @brief Free a deque structure. Items are not free'd, since it's owner's responsibility.
+/// @param dq Deque to free. Set to NULL afterwards.
+///
+void ws_deque_deinit(ws_deque_t* dq);
+
+///
+/// @brief Returns the number of items in the deque. Exact for the owner, a hint for anyone else.
+/// @param dq Deque to check.
+///
+size_t ws_deque_size(ws_deque_t dq);
+
+///
+/// @brief Pushes an item at the bottom. Owner thread only.
+/// @param dq Deque to push to.
+/// @param item Item to push. Must not be NULL.
+/// @return 0 on success, or -1 if the deque is full.
+///
+int ws_deque_push(ws_deque_t dq, void* item);
+
+///
+/// @brief Pops the most recently pushed item. Owner thread only.
+/// @param dq Deque to pop from.
+/// @return The item, or NULL if the deque is empty (or a thief took the last one).
+///
+void* ws_deque_pop(ws_deque_t dq);
+
+///
+/// @brief Steals the oldest item. Any thread.
+/// @param dq Deque to steal from.
+/// @return The item, or NULL if the deque is empty or another thread won the race for it.
+///
+void* ws_deque_steal(ws_deque_t dq);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,275 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+///
+/// @file ws_executor.c
+/// @brief Work-stealing executor for uneven per-port work (implementation).
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <utils/obj_pool/obj_pool.h>
+#include <utils/ws_deque/ws_deque.h>
+
+#include "ws_executor.h"
+
+/* === Macros definitions ====================================================================== */
+
+/// Cache line size assumed to keep the workers apart.
+#define CACHE_LINE_SIZE 64
+
+/* === Private data type declarations ========================================================== */
+
+/// Per-worker state, on its own cache lines.
+typedef struct
+{
+    alignas(CACHE_LINE_SIZE) ws_deque_t deque;  ///< Tasks submitted by or to this worker.
+    _Atomic(ws_task_t*) inbox;                  ///< Tasks submitted from outside, not yet in the deque.
+    uint32_t seed;                              ///< Victim selection state.
+    unsigned int index;                         ///< Position in the executor.
+    pthread_t thread;                           ///< Worker thread.
+    ws_executor_t executor;                     ///< Owning executor.
+} worker_t;
+
+///
+/// @brief Structure representing an executor.
+///
+struct ws_executor_obj_t
+{
+    size_t count;                               ///< Number of workers.
+    atomic_bool running;                        ///< Cleared to stop the workers.
+    atomic_size_t pending;                      ///< Submitted tasks not finished yet.
+    atomic_uint_fast64_t steals;                ///< Tasks run by a thief.
+    worker_t workers[WS_EXECUTOR_MAX_WORKERS];  ///< Workers.
+};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static void run_task(worker_t* self, ws_task_t* task);
+static void drain_inbox(worker_t* self);
+static ws_task_t* steal_task(worker_t* self);
+static void* worker_thread(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(executor_pool, ws_executor_obj_t, WS_EXECUTOR_POOL_SIZE)
+
+/// Worker running on the calling thread, or NULL outside the executors.
+static _Thread_local worker_t* current_worker = NULL;
+
+/* === Private function implementation ========================================================= */
+
+static void run_task(worker_t* self, ws_task_t* task)
+{
+    atomic_store_explicit(&task->worker, self->index, memory_order_relaxed);
+
+    // Cleared right before running, so a submission from now on runs the task again. Acquire pairs with
+    // the submissions that found it still set, so their data is visible to this run.
+    atomic_exchange_explicit(&task->scheduled, false, memory_order_acquire);
+    task->fn(task->ctx);
+    atomic_fetch_sub_explicit(&self->executor->pending, 1, memory_order_release);
+}
+
+static void drain_inbox(worker_t* self)
+{
+    // Plain load first: the inbox is almost always empty, and this keeps the line shared with submitters.
+    if (!atomic_load_explicit(&self->inbox, memory_order_relaxed)) { return; }
+
+    ws_task_t* task = atomic_exchange_explicit(&self->inbox, NULL, memory_order_acquire);
+
+    while (task) {
+        ws_task_t* next = task->next;
+        if (ws_deque_push(self->deque, task) != 0) { run_task(self, task); }
+        task = next;
+    }
+}
+
+static ws_task_t* steal_task(worker_t* self)
+{
+    ws_executor_t ex = self->executor;
+
+    // xorshift32: a different first victim every time, so thieves don't all pile on the same worker.
+    self->seed ^= self->seed << 13;
+    self->seed ^= self->seed >> 17;
+    self->seed ^= self->seed << 5;
+
+    for (size_t i = 0, first = self->seed % ex->count; i < ex->count; i++) {
+        worker_t* victim = &ex->workers[(first + i) % ex->count];
+        if (victim == self) { continue; }
+
+        ws_task_t* task = ws_deque_steal(victim->deque);
+        if (task) {
+            atomic_fetch_add_explicit(&ex->steals, 1, memory_order_relaxed);
+            return task;
+        }
+    }
+
+    return NULL;
+}
+
+static void* worker_thread(void* arg)
+{
+    worker_t* self = arg;
+    ws_executor_t ex = self->executor;
+    struct timespec idle = {.tv_sec = 0, .tv_nsec = WS_EXECUTOR_IDLE_US * 1000L};
+
+    current_worker = self;
+
+    while (atomic_load_explicit(&ex->running, memory_order_acquire)) {
+        drain_inbox(self);
+
+        ws_task_t* task = ws_deque_pop(self->deque);
+        if (!task) { task = steal_task(self); }
+
+        if (task) {
+            run_task(self, task);
+        } else {
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    current_worker = NULL;
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+void ws_task_init(ws_task_t* task, ws_task_fn fn, void* ctx, unsigned int home)
+{
+    assert(task && fn);
+
+    task->fn = fn;
+    task->ctx = ctx;
+    task->next = NULL;
+    atomic_init(&task->worker, home);
+    atomic_init(&task->scheduled, false);
+}
+
+ws_executor_t ws_executor_init(size_t workers)
+{
+    assert(workers && workers <= WS_EXECUTOR_MAX_WORKERS);
+
+    ws_executor_t ex = executor_pool_take();
+    assert(ex);
+
+    ex->count = workers;
+    atomic_init(&ex->running, true);
+    atomic_init(&ex->pending, 0);
+    atomic_init(&ex->steals, 0);
+
+    for (size_t i = 0; i < workers; i++) {
+        worker_t* worker = &ex->workers[i];
+
+        worker->deque = ws_deque_init(WS_EXECUTOR_DEQUE_SIZE);
+        atomic_init(&worker->inbox, NULL);
+        worker->seed = 2463534242U + (uint32_t)i;
+        worker->index = (unsigned int)i;
+        worker->executor = ex;
+    }
+
+    // Workers may be submitted to as soon as the first thread runs, so all of them must exist by then.
+    for (size_t i = 0; i < workers; i++) {
+        if (pthread_create(&ex->workers[i].thread, NULL, worker_thread, &ex->workers[i]) != 0) {
+            atomic_store(&ex->running, false);
+            for (size_t j = 0; j < i; j++) { pthread_join(ex->workers[j].thread, NULL); }
+            for (size_t j = 0; j < workers; j++) {
+                ws_deque_deinit(&ex->workers[j].deque);
+            }
+            executor_pool_give(ex);
+            return NULL;
+        }
+    }
+
+    return ex;
+}
+
+void ws_executor_deinit(ws_executor_t* ex)
+{
+    assert(ex != NULL);
+
+    if (*ex) {
+        ws_executor_quiesce(*ex);
+        atomic_store_explicit(&(*ex)->running, false, memory_order_release);
+
+        for (size_t i = 0; i < (*ex)->count; i++) {
+            pthread_join((*ex)->workers[i].thread, NULL);
+            ws_deque_deinit(&(*ex)->workers[i].deque);
+        }
+    }
+
+    executor_pool_give(*ex);
+    *ex = NULL;
+}
+
+void ws_executor_submit(ws_executor_t ex, ws_task_t* task)
+{
+    assert(ex && task && task->fn);
+
+    // Already queued: that run will see whatever this submission is for. Queuing it again would link it
+    // to itself in the inbox, or run it twice at once from the deques.
+    if (atomic_exchange_explicit(&task->scheduled, true, memory_order_acq_rel)) { return; }
+
+    atomic_fetch_add_explicit(&ex->pending, 1, memory_order_relaxed);
+
+    worker_t* self = current_worker;
+
+    // From one of our workers: straight into its own deque, lock-free.
+    if (self && self->executor == ex) {
+        if (ws_deque_push(self->deque, task) != 0) { run_task(self, task); }
+        return;
+    }
+
+    worker_t* home = &ex->workers[atomic_load_explicit(&task->worker, memory_order_relaxed) % ex->count];
+
+    // Lock-free push; the worker takes the whole list at once, so there is no ABA on the head.
+    ws_task_t* head = atomic_load_explicit(&home->inbox, memory_order_relaxed);
+    do {
+        task->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&home->inbox, &head, task, memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+void ws_executor_quiesce(ws_executor_t ex)
+{
+    assert(ex && current_worker == NULL);
+
+    struct timespec idle = {.tv_sec = 0, .tv_nsec = WS_EXECUTOR_IDLE_US * 1000L};
+
+    while (atomic_load_explicit(&ex->pending, memory_order_acquire) != 0) { nanosleep(&idle, NULL); }
+}
+
+uint64_t ws_executor_steals(ws_executor_t ex)
+{
+    assert(ex);
+    return atomic_load_explicit(&ex->steals, memory_order_relaxed);
+}
+
+/* === End of documentation ==================================================================== */
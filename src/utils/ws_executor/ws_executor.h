@@ -0,0 +1,136 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file ws_executor.h
+/// @brief Work-stealing executor for uneven per-port work.
+///
+/// Each worker thread owns a ws_deque. Tasks submitted from a worker go to its own deque; tasks
+/// submitted from outside go to the worker that last ran them, so a port's work stays on the same
+/// core (and its ring in that core's cache) as long as that worker keeps up. Idle workers steal from
+/// the others, and a stolen task sticks to its thief from then on.
+///
+/// Tasks are intrusive and never allocated by the executor: embed a ws_task_t in the port structure
+/// and submit it whenever the port has work (e.g. "drain this ring"). Submitting a task that is still
+/// queued does nothing: it runs once for both. Once it has started running it can be submitted again.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef WS_EXECUTOR_POOL_SIZE
+/// Executors available when built with UTILS_NO_HEAP (see obj_pool.h).
+#define WS_EXECUTOR_POOL_SIZE 1
+#endif
+
+/// Maximum number of worker threads.
+#define WS_EXECUTOR_MAX_WORKERS 64
+
+/// Capacity of each worker's deque. Tasks that don't fit run inline.
+#define WS_EXECUTOR_DEQUE_SIZE 256
+
+/// Sleep time of a worker that found nothing to run nor steal, in microseconds.
+#define WS_EXECUTOR_IDLE_US 50
+
+/* === Public data type declarations =========================================================== */
+
+/// Task body.
+typedef void (*ws_task_fn)(void* ctx);
+
+/// Schedulable unit of work. Fields are private, see ws_task_init().
+typedef struct ws_task_t
+{
+    ws_task_fn fn;           ///< Task body.
+    void* ctx;               ///< Argument for @p fn.
+    atomic_uint worker;      ///< Worker that last ran the task, where outside submissions go.
+    atomic_bool scheduled;   ///< Set from submission until the task starts running.
+    struct ws_task_t* next;  ///< Link in a worker's inbox.
+} ws_task_t;
+
+/// Opaque executor structure
+typedef struct ws_executor_obj_t ws_executor_obj_t;
+
+/// Handle type, the way users interact with the API
+typedef ws_executor_obj_t* ws_executor_t;
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Prepares a task.
+/// @param task Task to prepare.
+/// @param fn Task body.
+/// @param ctx Argument for @p fn.
+/// @param home Worker the task is first submitted to (taken modulo the number of workers).
+///
+void ws_task_init(ws_task_t* task, ws_task_fn fn, void* ctx, unsigned int home);
+
+///
+/// @brief Starts the worker threads.
+/// @param workers Number of workers, at most WS_EXECUTOR_MAX_WORKERS.
+/// @return The executor, or NULL if the threads could not be started.
+///
+ws_executor_t ws_executor_init(size_t workers);
+
+///
+/// @brief Stops the worker threads once every submitted task has run, and frees the executor.
+/// @param ex Executor to free. Set to NULL afterwards.
+///
+void ws_executor_deinit(ws_executor_t* ex);
+
+///
+/// @brief Schedules a task, unless it is already queued. Can be called from any thread, including from a
+/// running task.
+/// @param ex Executor to use.
+/// @param task Task to run.
+///
+void ws_executor_submit(ws_executor_t ex, ws_task_t* task);
+
+///
+/// @brief Waits until every submitted task has run, including those submitted meanwhile. Not from a task.
+/// @param ex Executor to wait for.
+///
+void ws_executor_quiesce(ws_executor_t ex);
+
+///
+/// @brief Returns the number of tasks run by workers that stole them.
+/// @param ex Executor to check.
+///
+uint64_t ws_executor_steals(ws_executor_t ex);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
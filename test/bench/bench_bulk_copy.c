@@ -0,0 +1,296 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file bench_bulk_copy.c
+ ** @brief Benchmark of streaming stores in ring_buffer_write(), to check the BULK_COPY_STREAM_THRESHOLD default.
+ **
+ ** For each block size, a producer writes blocks into a large ring, and after every block walks a small
+ ** "hot" working set standing for the rest of the program (other rings' indices, the consumer's data).
+ ** Each size runs twice: through the cache and with streaming stores. The write throughput shows what
+ ** streaming costs or saves on the copy itself, and the time of the walk that follows shows how much of
+ ** the hot set the copy evicted. The last column is what the default threshold picks for that size.
+ **
+ ** A second table runs the same writes next to a latency-sensitive ring: one thread sends timestamped
+ ** messages through a small spsc_ring every few microseconds and another one busy-polls it, recording
+ ** how long each message took. Whatever the bulk writes evict from the shared cache shows up there as
+ ** latency, so the percentiles with cached and streaming stores compare what each costs the other cores.
+ **
+ ** Not part of the test suite: timings depend on the machine and its load. Build and run with `make run`.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <utils/bulk_copy/bulk_copy.h>
+#include <utils/ring_buffer/ring_buffer.h>
+#include <utils/spsc_ring/spsc_ring.h>
+
+/* === Macros definitions ====================================================================== */
+
+/// Ring size, larger than any last level cache so every block lands on cold lines.
+#define RING_SIZE (64U * 1024U * 1024U)
+
+/// Largest block written.
+#define MAX_BLOCK (16U * 1024U * 1024U)
+
+/// Bytes written per block size and mode.
+#define BYTES_PER_RUN (256ULL * 1024U * 1024U)
+
+/// Default size of the hot working set, in bytes. Can be changed from the command line.
+#define HOT_SIZE (256U * 1024U)
+
+/// Cache line size assumed by the hot set walk.
+#define LINE_SIZE 64U
+
+/// Size of the latency-sensitive ring, in bytes.
+#define LATENCY_RING_SIZE (256U * 1024U)
+
+/// Size of the messages sent through it, in bytes.
+#define LATENCY_MESSAGE_SIZE 64U
+
+/// Interval between those messages, in nanoseconds.
+#define LATENCY_INTERVAL_NS 5000U
+
+/// Most latency samples kept per run.
+#define LATENCY_SAMPLES 200000U
+
+/* === Private data type declarations ========================================================== */
+
+/// Result of a run.
+typedef struct
+{
+    double write_gbps;  ///< Write throughput, in GB/s.
+    double walk_ns;     ///< Average time of a hot set walk after a block, in nanoseconds.
+} result_t;
+
+/// Latency-sensitive ring and its two threads.
+typedef struct
+{
+    spsc_ring_t ring;                      ///< Ring the messages go through.
+    atomic_bool running;                   ///< Cleared to stop both threads.
+    size_t count;                          ///< Samples recorded by the consumer.
+    uint64_t latency_ns[LATENCY_SAMPLES];  ///< Time each message took to reach the consumer.
+} latency_t;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static uint64_t now_ns(void);
+static uint64_t walk(const uint8_t* hot, size_t len);
+static result_t run(ring_buffer_t rb, const uint8_t* block, size_t block_len, const uint8_t* hot, size_t hot_len);
+static void* latency_producer(void* arg);
+static void* latency_consumer(void* arg);
+static int compare(const void* a, const void* b);
+static void run_concurrent(ring_buffer_t rb, const uint8_t* block, size_t block_len, uint64_t percentiles[3]);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+/// Keeps the walks from being optimized away.
+static volatile uint64_t sink;
+
+static uint8_t latency_container[LATENCY_RING_SIZE];
+static latency_t latency;
+
+/* === Private function implementation ========================================================= */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t walk(const uint8_t* hot, size_t len)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < len; i += LINE_SIZE) { sum += hot[i]; }
+    return sum;
+}
+
+static result_t run(ring_buffer_t rb, const uint8_t* block, size_t block_len, const uint8_t* hot, size_t hot_len)
+{
+    uint64_t blocks = BYTES_PER_RUN / block_len;
+    uint64_t write_ns = 0;
+    uint64_t walk_ns = 0;
+
+    ring_buffer_reset(rb);
+    sink += walk(hot, hot_len);
+
+    for (uint64_t i = 0; i < blocks; i++) {
+        uint64_t start = now_ns();
+        ring_buffer_write(rb, block, block_len);
+        uint64_t middle = now_ns();
+        sink += walk(hot, hot_len);
+        uint64_t end = now_ns();
+
+        write_ns += middle - start;
+        walk_ns += end - middle;
+    }
+
+    return (result_t){
+        .write_gbps = (double)(blocks * block_len) / (double)write_ns,
+        .walk_ns = (double)walk_ns / (double)blocks,
+    };
+}
+
+static void* latency_producer(void* arg)
+{
+    latency_t* lat = arg;
+    uint8_t message[LATENCY_MESSAGE_SIZE] = {0};
+
+    while (atomic_load_explicit(&lat->running, memory_order_relaxed)) {
+        uint64_t sent = now_ns();
+        memcpy(message, &sent, sizeof(sent));
+        (void)spsc_ring_write(lat->ring, message, sizeof(message));
+
+        while (now_ns() - sent < LATENCY_INTERVAL_NS) {}
+    }
+
+    return NULL;
+}
+
+static void* latency_consumer(void* arg)
+{
+    latency_t* lat = arg;
+    uint8_t message[LATENCY_MESSAGE_SIZE];
+
+    while (atomic_load_explicit(&lat->running, memory_order_relaxed)) {
+        if (spsc_ring_read(lat->ring, message, sizeof(message)) != sizeof(message)) { continue; }
+
+        uint64_t sent;
+        memcpy(&sent, message, sizeof(sent));
+        if (lat->count < LATENCY_SAMPLES) { lat->latency_ns[lat->count++] = now_ns() - sent; }
+    }
+
+    return NULL;
+}
+
+static int compare(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void run_concurrent(ring_buffer_t rb, const uint8_t* block, size_t block_len, uint64_t percentiles[3])
+{
+    pthread_t producer;
+    pthread_t consumer;
+
+    spsc_ring_reset(latency.ring);
+    latency.count = 0;
+    atomic_store(&latency.running, true);
+    if (pthread_create(&consumer, NULL, latency_consumer, &latency) != 0 ||
+        pthread_create(&producer, NULL, latency_producer, &latency) != 0) {
+        fprintf(stderr, "could not start the latency threads\n");
+        exit(1);
+    }
+
+    ring_buffer_reset(rb);
+    for (uint64_t i = 0; i < BYTES_PER_RUN / block_len; i++) { ring_buffer_write(rb, block, block_len); }
+
+    atomic_store(&latency.running, false);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    qsort(latency.latency_ns, latency.count, sizeof(latency.latency_ns[0]), compare);
+    percentiles[0] = latency.count ? latency.latency_ns[latency.count / 2] : 0;
+    percentiles[1] = latency.count ? latency.latency_ns[latency.count * 99 / 100] : 0;
+    percentiles[2] = latency.count ? latency.latency_ns[latency.count - 1] : 0;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char** argv)
+{
+    static const size_t sizes[] = {4096, 16384, 65536, 262144, 1048576, 4194304, MAX_BLOCK};
+    size_t hot_len = (argc > 1) ? strtoul(argv[1], NULL, 0) : HOT_SIZE;
+
+    uint8_t* container = aligned_alloc(LINE_SIZE, RING_SIZE);
+    uint8_t* block = aligned_alloc(LINE_SIZE, MAX_BLOCK);
+    uint8_t* hot = aligned_alloc(LINE_SIZE, hot_len + LINE_SIZE);
+    if (!container || !block || !hot) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    // Touch everything first, so page faults are not timed.
+    memset(container, 0, RING_SIZE);
+    memset(block, 0x5A, MAX_BLOCK);
+    memset(hot, 1, hot_len + LINE_SIZE);
+
+    ring_buffer_t rb = ring_buffer_init(container, RING_SIZE);
+
+    printf("hot set %zu KiB, default threshold %u KiB\n\n", hot_len / 1024, BULK_COPY_STREAM_THRESHOLD / 1024);
+    printf("%11s | %21s | %21s | %s\n", "block", "cached: GB/s  walk ns", "stream: GB/s  walk ns", "default");
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        ring_buffer_set_stream_threshold(rb, BULK_COPY_NO_STREAM);
+        result_t cached = run(rb, block, sizes[i], hot, hot_len);
+
+        ring_buffer_set_stream_threshold(rb, 0);
+        result_t stream = run(rb, block, sizes[i], hot, hot_len);
+
+        printf("%7zu KiB | %10.2f %10.0f | %10.2f %10.0f | %s\n", sizes[i] / 1024, cached.write_gbps, cached.walk_ns,
+               stream.write_gbps, stream.walk_ns, (sizes[i] >= BULK_COPY_STREAM_THRESHOLD) ? "stream" : "cached");
+    }
+
+    latency.ring = spsc_ring_init(latency_container, LATENCY_RING_SIZE);
+
+    printf("\nconcurrent %u KiB ring, a %u-byte message every %u ns, latency in ns\n\n", LATENCY_RING_SIZE / 1024,
+           LATENCY_MESSAGE_SIZE, LATENCY_INTERVAL_NS);
+    printf("%11s | %26s | %26s\n", "block", "cached: p50    p99    max", "stream: p50    p99    max");
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint64_t cached[3];
+        uint64_t stream[3];
+
+        ring_buffer_set_stream_threshold(rb, BULK_COPY_NO_STREAM);
+        run_concurrent(rb, block, sizes[i], cached);
+
+        ring_buffer_set_stream_threshold(rb, 0);
+        run_concurrent(rb, block, sizes[i], stream);
+
+        printf("%7zu KiB | %8llu %8llu %8llu | %8llu %8llu %8llu\n", sizes[i] / 1024, (unsigned long long)cached[0],
+               (unsigned long long)cached[1], (unsigned long long)cached[2], (unsigned long long)stream[0],
+               (unsigned long long)stream[1], (unsigned long long)stream[2]);
+    }
+
+    spsc_ring_deinit(&latency.ring);
+
+    ring_buffer_deinit(&rb);
+    free(hot);
+    free(block);
+    free(container);
+
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,185 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file bench_core_runtime.c
+ ** @brief Benchmark of cross-core message throughput over the core_runtime mesh.
+ **
+ ** Every core sends fixed-size messages round-robin to every other core as fast as the rings take them,
+ ** and counts the messages it receives. With a single core it sends to itself. After a warm-up, the
+ ** delivered messages are counted over a fixed interval and reported in total and per core, for 1, 2,
+ ** 4... cores up to the cores online. Workers are pinned.
+ **
+ ** Not part of the test suite: timings depend on the machine and its load. Build and run with `make run`.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <utils/core_runtime/core_runtime.h>
+
+/* === Macros definitions ====================================================================== */
+
+/// Payload size of every message, in bytes: a timestamped MIDI event or a small command.
+#define MESSAGE_SIZE 16U
+
+/// Messages a core sends to each destination per poll, at most.
+#define BURST 32U
+
+/// Warm-up before counting, in milliseconds.
+#define WARMUP_MS 200
+
+/// Counting interval, in milliseconds.
+#define MEASURE_MS 1000
+
+/// Cache line size assumed to keep the cores' counters apart.
+#define LINE_SIZE 64
+
+/* === Private data type declarations ========================================================== */
+
+/// Per-core state, written only by its own worker.
+typedef struct
+{
+    alignas(LINE_SIZE) atomic_uint_fast64_t received;  ///< Messages delivered to this core.
+    size_t next;                                       ///< Next destination.
+} core_t;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static void sleep_ms(long ms);
+static uint64_t total_received(size_t cores);
+static void on_message(core_runtime_t rt, void* ctx, size_t core, size_t from, const uint8_t* data, size_t len);
+static size_t on_poll(core_runtime_t rt, void* ctx, size_t core);
+static double run(size_t cores);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+static core_t state[CORE_RUNTIME_MAX_CORES];
+
+/* === Private function implementation ========================================================= */
+
+static void sleep_ms(long ms)
+{
+    struct timespec ts = {.tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+static uint64_t total_received(size_t cores)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < cores; i++) { total += atomic_load_explicit(&state[i].received, memory_order_relaxed); }
+    return total;
+}
+
+static void on_message(core_runtime_t rt, void* ctx, size_t core, size_t from, const uint8_t* data, size_t len)
+{
+    (void)rt;
+    (void)ctx;
+    (void)from;
+    (void)data;
+    (void)len;
+
+    // Single writer: a plain load and store is enough.
+    uint_fast64_t received = atomic_load_explicit(&state[core].received, memory_order_relaxed);
+    atomic_store_explicit(&state[core].received, received + 1, memory_order_relaxed);
+}
+
+static size_t on_poll(core_runtime_t rt, void* ctx, size_t core)
+{
+    (void)ctx;
+
+    core_t* self = &state[core];
+    size_t cores = core_runtime_cores(rt);
+    uint8_t message[MESSAGE_SIZE] = {0};
+    size_t sent = 0;
+
+    for (size_t i = 0; i < cores; i++) {
+        size_t to = self->next;
+        self->next = (to + 1) % cores;
+        if (to == core && cores > 1) { continue; }
+
+        for (size_t n = 0; n < BURST && core_runtime_send(rt, to, message, sizeof(message)) == 0; n++) { sent++; }
+    }
+
+    return sent;
+}
+
+static double run(size_t cores)
+{
+    memset(state, 0, sizeof(state));
+
+    core_runtime_config_t config = {
+        .cores = cores,
+        .pin = true,
+        .on_message = on_message,
+        .on_poll = on_poll,
+        .ctx = NULL,
+    };
+
+    core_runtime_t rt = core_runtime_init(&config);
+    if (!rt) {
+        fprintf(stderr, "could not start %zu cores\n", cores);
+        exit(1);
+    }
+
+    sleep_ms(WARMUP_MS);
+    uint64_t first = total_received(cores);
+    sleep_ms(MEASURE_MS);
+    uint64_t last = total_received(cores);
+
+    core_runtime_deinit(&rt);
+
+    return (double)(last - first) * 1000.0 / MEASURE_MS;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char** argv)
+{
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max = (argc > 1) ? strtoul(argv[1], NULL, 0) : (size_t)(online > 0 ? online : 1);
+    if (max < 1) { max = 1; }
+    if (max > CORE_RUNTIME_MAX_CORES) { max = CORE_RUNTIME_MAX_CORES; }
+
+    printf("%u-byte messages, %u-byte rings, %ld cores online\n\n", MESSAGE_SIZE, CORE_RUNTIME_RING_SIZE, online);
+    printf("%5s | %12s | %15s\n", "cores", "Mmsg/s total", "Mmsg/s per core");
+
+    // 1, 2, 4... cores, and the maximum.
+    for (size_t cores = 1;; cores = (cores * 2 < max) ? cores * 2 : max) {
+        double rate = run(cores);
+        printf("%5zu | %12.2f | %15.2f\n", cores, rate / 1e6, rate / 1e6 / (double)cores);
+
+        if (cores == max) { break; }
+    }
+
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,153 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file bench_midi_capture.c
+ ** @brief Benchmark of the CPU cost of capturing 32 ports at full load, against the 5% target.
+ **
+ ** Full load is a DIN MIDI port saturated at 31250 baud, 3125 bytes/s, on each of 32 ports, drained
+ ** every millisecond: every drain hands about three bytes per port to midi_capture_record(). The
+ ** benchmark generates a number of seconds of that traffic, note messages with a varying note and
+ ** velocity, and feeds it to a writer on a temporary file as fast as it can, with and without
+ ** compression. The CPU time spent, block writes included, divided by the traffic's duration is the
+ ** share of a core the capture takes at full load.
+ **
+ ** Not part of the test suite: timings depend on the machine and its load. Build and run with `make run`.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <utils/midi_capture/midi_capture.h>
+
+/* === Macros definitions ====================================================================== */
+
+/// Number of captured ports.
+#define PORT_COUNT 32U
+
+/// Bytes per second a saturated DIN MIDI port carries.
+#define PORT_BYTES_PER_S 3125U
+
+/// Drain period, in nanoseconds.
+#define DRAIN_PERIOD_NS 1000000U
+
+/// Seconds of traffic generated. Can be changed from the command line.
+#define TRAFFIC_S 60
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static uint64_t clock_ns(clockid_t clock);
+static void run(bool compress, unsigned int seconds);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static uint64_t clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void run(bool compress, unsigned int seconds)
+{
+    FILE* file = tmpfile();
+    midi_capture_t cap = file ? midi_capture_init(fileno(file), compress) : NULL;
+    if (!cap) {
+        fprintf(stderr, "could not open the capture\n");
+        exit(1);
+    }
+
+    uint64_t drains = (uint64_t)seconds * 1000000000ULL / DRAIN_PERIOD_NS;
+    uint64_t bytes_per_drain_x1000 = (uint64_t)PORT_BYTES_PER_S * DRAIN_PERIOD_NS / 1000000U;
+    uint64_t owed[PORT_COUNT] = {0};
+    uint8_t chunk[64];
+    uint32_t note = 0;
+
+    uint64_t cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+
+    for (uint64_t d = 0; d < drains; d++) {
+        uint64_t timestamp = d * DRAIN_PERIOD_NS;
+
+        for (uint8_t port = 0; port < PORT_COUNT; port++) {
+            // Bytes the port received since the last drain, in thousandths, staggered so the ports differ.
+            owed[port] += bytes_per_drain_x1000 + port;
+            size_t len = (size_t)(owed[port] / 1000);
+            if (len > sizeof(chunk)) { len = sizeof(chunk); }
+            if (len == 0) { continue; }
+            owed[port] -= len * 1000;
+
+            for (size_t i = 0; i < len; i++, note++) {
+                switch (note % 3) {
+                    case 0: chunk[i] = (uint8_t)(0x90 | (port & 0x0F)); break;
+                    case 1: chunk[i] = (uint8_t)(36 + (note / 3) % 48); break;
+                    default: chunk[i] = (uint8_t)((note / 3) % 2 ? 0 : 64 + (note % 63)); break;
+                }
+            }
+
+            if (midi_capture_record(cap, port, MIDI_CAPTURE_TX, timestamp, chunk, len) != 0) {
+                fprintf(stderr, "could not write the capture\n");
+                exit(1);
+            }
+        }
+    }
+
+    midi_capture_stats_t stats;
+    midi_capture_get_stats(cap, &stats);
+    midi_capture_deinit(&cap);
+
+    double spent = (double)(clock_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu) / 1e9;
+    uint64_t traffic = (uint64_t)seconds * PORT_COUNT * PORT_BYTES_PER_S;
+
+    printf("%10s | %9llu | %11.2f | %9.2f | %10.1f | %7.3f\n", compress ? "compressed" : "raw",
+           (unsigned long long)stats.records, (double)stats.written_bytes / 1e6,
+           (double)stats.written_bytes / (double)traffic, spent * 1e9 / (double)stats.records,
+           100.0 * spent / seconds);
+
+    fclose(file);
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char** argv)
+{
+    unsigned int seconds = (argc > 1) ? (unsigned int)strtoul(argv[1], NULL, 0) : TRAFFIC_S;
+    if (seconds == 0) { seconds = TRAFFIC_S; }
+
+    printf("%u ports at %u bytes/s, drained every %u us, %u s of traffic\n\n", PORT_COUNT, PORT_BYTES_PER_S,
+           DRAIN_PERIOD_NS / 1000, seconds);
+    printf("%10s | %9s | %11s | %9s | %10s | %7s\n", "mode", "records", "MB written", "out / in", "ns/record",
+           "CPU %");
+
+    run(false, seconds);
+    run(true, seconds);
+
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,197 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file bench_pipeline.c
+ ** @brief Benchmark of the same pipeline stages fused into one loop and split onto a cursor per stage.
+ **
+ ** Four MIDI-like stages (parse, transpose, scale the velocity, checksum) run over a seq_ring in four
+ ** ways: fused and split, each polled from the producer's thread or started on worker threads. The
+ ** calling thread produces the entries and consumes the output in every case. The fused form walks
+ ** the ring once per batch and the split form once per stage; on threads, the split form spreads the
+ ** stages over cores at the cost of handing every entry between them.
+ **
+ ** Not part of the test suite: timings depend on the machine and its load. Build and run with `make run`.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <utils/pipeline/pipeline.h>
+#include <utils/seq_ring/seq_ring.h>
+
+/* === Macros definitions ====================================================================== */
+
+/// Entries in the ring.
+#define ENTRY_COUNT 4096U
+
+/// Entries run through each form.
+#define TRANSFER_COUNT (16U * 1024U * 1024U)
+
+/* === Private data type declarations ========================================================== */
+
+/// A MIDI message on its way through the pipeline.
+typedef struct
+{
+    uint8_t status;
+    uint8_t data[2];
+    uint8_t channel;
+    uint32_t port;
+    uint32_t checksum;
+    uint32_t sequence;
+} message_t;
+
+/// Calls of a form.
+typedef struct
+{
+    const char* name;
+    size_t stages;
+    size_t output;
+    size_t (*poll)(seq_ring_t ring);
+    pipeline_workers_t (*start)(seq_ring_t ring);
+} form_t;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static inline void parse(message_t* msg);
+static inline void transpose(message_t* msg);
+static inline void scale_velocity(message_t* msg);
+static inline void checksum(message_t* msg);
+static uint64_t now_ns(void);
+static double run(const form_t* form, bool threaded);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+#define BENCH_STAGES(X) X(parse) X(transpose) X(scale_velocity) X(checksum)
+
+PIPELINE_DEFINE_FUSED(fused, message_t, BENCH_STAGES)
+PIPELINE_DEFINE_SPLIT(split, message_t, BENCH_STAGES)
+
+static message_t entries[ENTRY_COUNT];
+
+/// Keeps the output from being optimized away.
+static volatile uint32_t sink;
+
+/* === Private function implementation ========================================================= */
+
+static inline void parse(message_t* msg) { msg->channel = msg->status & 0x0F; }
+
+static inline void transpose(message_t* msg)
+{
+    if ((msg->status & 0xE0) == 0x80 && msg->data[0] < 116) { msg->data[0] += 12; }
+}
+
+static inline void scale_velocity(message_t* msg)
+{
+    if ((msg->status & 0xF0) == 0x90) { msg->data[1] = (uint8_t)((msg->data[1] * 3U) / 4U); }
+}
+
+static inline void checksum(message_t* msg)
+{
+    msg->checksum = (msg->status * 16777619U) ^ (msg->data[0] * 65599U) ^ msg->data[1] ^ msg->port ^ msg->sequence;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static double run(const form_t* form, bool threaded)
+{
+    seq_ring_t ring = seq_ring_init(entries, sizeof(message_t), ENTRY_COUNT, form->stages);
+    pipeline_workers_t workers = threaded ? form->start(ring) : NULL;
+    if (threaded && !workers) {
+        fprintf(stderr, "could not start the %s workers\n", form->name);
+        exit(1);
+    }
+
+    uint32_t produced = 0;
+    uint32_t consumed = 0;
+    uint32_t sum = 0;
+    uint64_t start = now_ns();
+
+    while (consumed < TRANSFER_COUNT) {
+        size_t n = seq_ring_available(ring, 0);
+        size_t seq = seq_ring_cursor(ring, 0);
+        if (n > TRANSFER_COUNT - produced) { n = TRANSFER_COUNT - produced; }
+        for (size_t i = 0; i < n; i++) {
+            message_t* msg = seq_ring_entry(ring, seq + i);
+            msg->status = (uint8_t)(0x80 | ((produced + i) & 0x1F));
+            msg->data[0] = (uint8_t)((produced + i) & 0x7F);
+            msg->data[1] = 100;
+            msg->port = (uint32_t)(produced + i) % 32U;
+            msg->sequence = produced + (uint32_t)i;
+        }
+        seq_ring_advance(ring, 0, n);
+        produced += (uint32_t)n;
+
+        if (!threaded) { form->poll(ring); }
+
+        size_t out = seq_ring_available(ring, form->output);
+        seq = seq_ring_cursor(ring, form->output);
+        for (size_t i = 0; i < out; i++) { sum += ((message_t*)seq_ring_entry(ring, seq + i))->checksum; }
+        seq_ring_advance(ring, form->output, out);
+        consumed += (uint32_t)out;
+
+        if (threaded && out == 0) { sched_yield(); }
+    }
+
+    uint64_t elapsed = now_ns() - start;
+
+    sink = sum;
+    pipeline_stop(&workers);
+    seq_ring_deinit(&ring);
+
+    return (double)TRANSFER_COUNT * 1e3 / (double)elapsed;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(void)
+{
+    const form_t forms[] = {
+        {"fused", fused_RING_STAGES, fused_OUTPUT_STAGE, fused_poll, fused_start},
+        {"split", split_RING_STAGES, split_OUTPUT_STAGE, split_poll, split_start},
+    };
+
+    printf("%u-byte entries, %u entries per ring, %u entries per run\n\n", (unsigned)sizeof(message_t), ENTRY_COUNT,
+           TRANSFER_COUNT);
+    printf("%6s | %17s | %17s\n", "form", "polled: Mmsg/s", "threaded: Mmsg/s");
+
+    for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); i++) {
+        double polled = run(&forms[i], false);
+        double threaded = run(&forms[i], true);
+        printf("%6s | %17.1f | %17.1f\n", forms[i].name, polled, threaded);
+    }
+
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
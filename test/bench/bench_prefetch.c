@@ -0,0 +1,185 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file bench_prefetch.c
+ ** @brief Benchmark of software prefetching in ring reads and scans, on rings larger than the last level cache.
+ **
+ ** A ring_buffer and an spsc_ring of the same size are filled with streaming stores, so none of their
+ ** data is left in the caches. Then the whole ring_buffer is read in chunks, and spsc_ring_find() scans
+ ** the whole spsc_ring for a byte only found at its very end. Each walk runs with prefetching disabled
+ ** and with a few distances, the default among them, and the best of a few runs is reported.
+ **
+ ** Not part of the test suite: timings depend on the machine and its load. Build and run with `make run`.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <utils/bulk_copy/bulk_copy.h>
+#include <utils/ring_buffer/ring_buffer.h>
+#include <utils/spsc_ring/spsc_ring.h>
+
+/* === Macros definitions ====================================================================== */
+
+/// Default ring size, larger than any last level cache. Can be changed from the command line (power of two).
+#define RING_SIZE (256U * 1024U * 1024U)
+
+/// Size of the blocks the rings are filled with, and of the chunks the ring_buffer is read in.
+#define CHUNK_SIZE (64U * 1024U)
+
+/// Runs per measurement, the fastest one being reported.
+#define RUNS 3
+
+/// Byte spsc_ring_find() looks for, only written at the end of the ring.
+#define MARKER 0x7F
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static uint64_t now_ns(void);
+static double read_gbps(ring_buffer_t rb, size_t distance, const uint8_t* chunk, uint8_t* out);
+static double find_gbps(spsc_ring_t rb, size_t distance, const uint8_t* chunk);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static double read_gbps(ring_buffer_t rb, size_t distance, const uint8_t* chunk, uint8_t* out)
+{
+    size_t capacity = ring_buffer_capacity(rb);
+    uint64_t best = UINT64_MAX;
+
+    ring_buffer_set_prefetch_distance(rb, distance);
+
+    for (int run = 0; run < RUNS; run++) {
+        ring_buffer_reset(rb);
+        for (size_t done = 0; done < capacity; done += CHUNK_SIZE) {
+            ring_buffer_write(rb, chunk, (capacity - done < CHUNK_SIZE) ? capacity - done : CHUNK_SIZE);
+        }
+
+        uint64_t start = now_ns();
+        while (ring_buffer_read(rb, out, CHUNK_SIZE) > 0) {}
+        uint64_t elapsed = now_ns() - start;
+
+        if (elapsed < best) { best = elapsed; }
+    }
+
+    return (double)capacity / (double)best;
+}
+
+static double find_gbps(spsc_ring_t rb, size_t distance, const uint8_t* chunk)
+{
+    size_t capacity = spsc_ring_capacity(rb);
+    uint64_t best = UINT64_MAX;
+    const uint8_t marker = MARKER;
+
+    spsc_ring_set_prefetch_distance(rb, distance);
+
+    for (int run = 0; run < RUNS; run++) {
+        spsc_ring_reset(rb);
+        for (size_t done = 0; done < capacity - 1; done += CHUNK_SIZE) {
+            spsc_ring_write(rb, chunk, (capacity - 1 - done < CHUNK_SIZE) ? capacity - 1 - done : CHUNK_SIZE);
+        }
+        spsc_ring_write(rb, &marker, 1);
+
+        size_t position = 0;
+        uint64_t start = now_ns();
+        int found = spsc_ring_find(rb, MARKER, &position);
+        uint64_t elapsed = now_ns() - start;
+
+        if (found != 0 || position != capacity - 1) {
+            fprintf(stderr, "marker not found at the end of the ring\n");
+            exit(1);
+        }
+        if (elapsed < best) { best = elapsed; }
+    }
+
+    return (double)capacity / (double)best;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char** argv)
+{
+    static const size_t distances[] = {0, 256, BULK_COPY_PREFETCH_DISTANCE, 2048, 8192};
+    size_t size = (argc > 1) ? strtoul(argv[1], NULL, 0) : RING_SIZE;
+
+    if (size < CHUNK_SIZE || (size & (size - 1)) != 0) {
+        fprintf(stderr, "the ring size must be a power of two of at least %u bytes\n", CHUNK_SIZE);
+        return 1;
+    }
+
+    uint8_t* rb_container = aligned_alloc(BULK_COPY_LINE_SIZE, size);
+    uint8_t* spsc_container = aligned_alloc(BULK_COPY_LINE_SIZE, size);
+    uint8_t* chunk = aligned_alloc(BULK_COPY_LINE_SIZE, CHUNK_SIZE);
+    uint8_t* out = aligned_alloc(BULK_COPY_LINE_SIZE, CHUNK_SIZE);
+    if (!rb_container || !spsc_container || !chunk || !out) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    // Touch everything first, so page faults are not timed.
+    memset(rb_container, 0, size);
+    memset(spsc_container, 0, size);
+    memset(chunk, 0x5A, CHUNK_SIZE);
+    memset(out, 0, CHUNK_SIZE);
+
+    // Fill with streaming stores, so every walk starts on lines that are not cached.
+    ring_buffer_t rb = ring_buffer_init(rb_container, size);
+    spsc_ring_t spsc = spsc_ring_init(spsc_container, size);
+    ring_buffer_set_stream_threshold(rb, 0);
+    spsc_ring_set_stream_threshold(spsc, 0);
+
+    printf("%zu MiB rings, %u KiB read chunks, default distance %u bytes\n\n", size >> 20, CHUNK_SIZE / 1024,
+           BULK_COPY_PREFETCH_DISTANCE);
+    printf("%14s | %22s | %20s\n", "distance bytes", "ring_buffer_read GB/s", "spsc_ring_find GB/s");
+
+    for (size_t i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+        double read = read_gbps(rb, distances[i], chunk, out);
+        double find = find_gbps(spsc, distances[i], chunk);
+        printf("%14zu | %22.2f | %20.2f%s\n", distances[i], read, find,
+               distances[i] == BULK_COPY_PREFETCH_DISTANCE ? "  (default)" : "");
+    }
+
+    spsc_ring_deinit(&spsc);
+    ring_buffer_deinit(&rb);
+    free(out);
+    free(chunk);
+    free(spsc_container);
+    free(rb_container);
+
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
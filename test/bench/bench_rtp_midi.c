@@ -0,0 +1,162 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file bench_rtp_midi.c
+ ** @brief Benchmark of rtp_midi message throughput over loopback, against the 100k messages/s per core target.
+ **
+ ** A single thread plays both ends: it writes three-byte note messages into a TX ring, drains it with
+ ** rtp_midi_send() to a receiver on 127.0.0.1, reads the datagrams back with rtp_midi_receive() and
+ ** empties the RX ring. Each run writes a fixed number of messages per round, from enough to fill every
+ ** packet down to one message per packet: latency-bound traffic is limited by the packet rate instead.
+ ** Sending and receiving share the core, so the rate per CPU second is a lower bound for one direction.
+ ** The CPU time counts user and kernel time, which is where most of the cost of a UDP transport goes.
+ **
+ ** Not part of the test suite: timings depend on the machine and its load. Build and run with `make run`.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <utils/rtp_midi/rtp_midi.h>
+#include <utils/spsc_ring/spsc_ring.h>
+
+/* === Macros definitions ====================================================================== */
+
+/// Size of the TX and RX rings, in bytes.
+#define RING_SIZE 65536U
+
+/// Most messages written to the TX ring per round.
+#define MAX_PER_ROUND 2048U
+
+/// Duration of each run, in seconds.
+#define DURATION_S 1
+
+/// Loopback address both ends are bound to.
+#define LOOPBACK "127.0.0.1"
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static uint64_t clock_ns(clockid_t clock);
+static void run(size_t per_round);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+static uint8_t tx_container[RING_SIZE];
+static uint8_t rx_container[RING_SIZE];
+static uint8_t drained[RING_SIZE];
+
+/* === Private function implementation ========================================================= */
+
+static uint64_t clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void run(size_t per_round)
+{
+    rtp_midi_t sender = rtp_midi_init(LOOPBACK, 0, 0x1234);
+    rtp_midi_t receiver = rtp_midi_init(LOOPBACK, 0, 0x5678);
+    if (!sender || !receiver || rtp_midi_connect(sender, LOOPBACK, rtp_midi_local_port(receiver)) != 0) {
+        fprintf(stderr, "could not open the loopback endpoints\n");
+        exit(1);
+    }
+
+    spsc_ring_t tx = spsc_ring_init(tx_container, RING_SIZE);
+    spsc_ring_t rx = spsc_ring_init(rx_container, RING_SIZE);
+
+    uint8_t round[MAX_PER_ROUND * 3];
+    for (size_t i = 0; i < per_round; i++) {
+        round[3 * i] = 0x90 | (uint8_t)(i % 16);
+        round[3 * i + 1] = (uint8_t)(i % 128);
+        round[3 * i + 2] = 100;
+    }
+
+    uint64_t start = clock_ns(CLOCK_MONOTONIC);
+    uint64_t cpu_start = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t end = start + DURATION_S * 1000000000ULL;
+    uint64_t now = start;
+
+    while (now < end) {
+        // All or nothing: a round that does not fit waits for the transport to catch up.
+        (void)spsc_ring_write(tx, round, per_round * 3);
+
+        if (rtp_midi_send(sender, tx) < 0 || rtp_midi_receive(receiver, rx) < 0) {
+            fprintf(stderr, "socket error\n");
+            exit(1);
+        }
+        while (spsc_ring_read(rx, drained, sizeof(drained)) > 0) {}
+
+        now = clock_ns(CLOCK_MONOTONIC);
+    }
+
+    double seconds = (double)(now - start) / 1e9;
+    double cpu = (double)(clock_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu_start) / 1e9;
+
+    rtp_midi_stats_t sent;
+    rtp_midi_stats_t received;
+    rtp_midi_get_stats(sender, &sent);
+    rtp_midi_get_stats(receiver, &received);
+
+    printf("%9zu | %10.1f | %12.0f | %12.0f | %12.0f | %8llu\n", per_round,
+           sent.packets_sent ? (double)sent.messages_sent / (double)sent.packets_sent : 0.0,
+           (double)sent.packets_sent / seconds, (double)received.messages_received / seconds,
+           (double)received.messages_received / cpu,
+           (unsigned long long)(sent.messages_sent - received.messages_received));
+
+    spsc_ring_deinit(&rx);
+    spsc_ring_deinit(&tx);
+    rtp_midi_deinit(&receiver);
+    rtp_midi_deinit(&sender);
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char** argv)
+{
+    // Full packets by default, down to a few messages per packet, as latency-bound traffic sends them.
+    static const size_t rounds[] = {MAX_PER_ROUND, 256, 32, 4, 1};
+
+    printf("loopback, %u-byte command sections at most, %d packets per call, target 100000 msg/s per core\n\n",
+           RTP_MIDI_MAX_COMMANDS, RTP_MIDI_BATCH);
+    printf("%9s | %10s | %12s | %12s | %12s | %8s\n", "msg/round", "msg/packet", "packets/s", "msg/s",
+           "msg/CPU s", "lost");
+
+    if (argc > 1) {
+        size_t per_round = strtoul(argv[1], NULL, 0);
+        run((per_round >= 1 && per_round <= MAX_PER_ROUND) ? per_round : MAX_PER_ROUND);
+        return 0;
+    }
+
+    for (size_t i = 0; i < sizeof(rounds) / sizeof(rounds[0]); i++) { run(rounds[i]); }
+
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
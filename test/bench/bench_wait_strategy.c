@@ -0,0 +1,182 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file bench_wait_strategy.c
+ ** @brief Benchmark of wake-up latency against consumer CPU usage for each wait strategy.
+ **
+ ** A producer thread writes timestamps into an spsc_ring at a fixed interval, and a consumer blocks on
+ ** it with spsc_ring_read_byte_wait() under each strategy. The consumer records how long each timestamp
+ ** took to reach it, and its own CPU time over the run relative to the wall time. Short intervals favour
+ ** spinning, long ones show what it costs to keep a core busy for it; the adaptive strategy should get
+ ** close to spinning on the former and to parking on the latter.
+ **
+ ** Not part of the test suite: timings depend on the machine and its load. Build and run with `make run`.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+/// Size of the ring, in bytes.
+#define RING_SIZE 4096U
+
+/// Timestamps sent per run.
+#define SAMPLES 2000U
+
+/// Initial spin budget of the strategies, in relax iterations.
+#define SPIN_LIMIT 1000U
+
+/// Intervals shorter than this are busy-waited by the producer instead of slept, in nanoseconds.
+#define SLEEP_THRESHOLD_NS 20000U
+
+/* === Private data type declarations ========================================================== */
+
+/// A run: the ring, its interval and what the consumer measured.
+typedef struct
+{
+    spsc_ring_t ring;
+    uint64_t interval_ns;
+    uint64_t latency_ns[SAMPLES];
+    double cpu_ratio;
+} run_t;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static uint64_t clock_ns(clockid_t clock);
+static void* consumer_thread(void* arg);
+static int compare(const void* a, const void* b);
+static void run(run_t* r, wait_strategy_kind_t kind);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+static uint8_t container[RING_SIZE];
+static run_t result;
+
+/* === Private function implementation ========================================================= */
+
+static uint64_t clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void* consumer_thread(void* arg)
+{
+    run_t* r = arg;
+    uint64_t wall = clock_ns(CLOCK_MONOTONIC);
+    uint64_t cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+
+    for (size_t i = 0; i < SAMPLES; i++) {
+        uint64_t sent;
+        uint8_t* bytes = (uint8_t*)&sent;
+
+        // The producer writes each timestamp all at once, so its other bytes are there with the first one.
+        spsc_ring_read_byte_wait(r->ring, &bytes[0]);
+        spsc_ring_read(r->ring, &bytes[1], sizeof(sent) - 1);
+        r->latency_ns[i] = clock_ns(CLOCK_MONOTONIC) - sent;
+    }
+
+    r->cpu_ratio = (double)(clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu) / (double)(clock_ns(CLOCK_MONOTONIC) - wall);
+
+    return NULL;
+}
+
+static int compare(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void run(run_t* r, wait_strategy_kind_t kind)
+{
+    wait_strategy_t ws = wait_strategy_init(kind, SPIN_LIMIT);
+    r->ring = spsc_ring_init(container, RING_SIZE);
+    spsc_ring_set_wait_strategy(r->ring, ws);
+
+    pthread_t consumer;
+    if (pthread_create(&consumer, NULL, consumer_thread, r) != 0) {
+        fprintf(stderr, "could not start the consumer\n");
+        exit(1);
+    }
+
+    struct timespec pause = {.tv_sec = 0, .tv_nsec = (long)r->interval_ns};
+    for (size_t i = 0; i < SAMPLES; i++) {
+        if (r->interval_ns >= SLEEP_THRESHOLD_NS) {
+            nanosleep(&pause, NULL);
+        } else {
+            for (uint64_t until = clock_ns(CLOCK_MONOTONIC) + r->interval_ns; clock_ns(CLOCK_MONOTONIC) < until;) {}
+        }
+
+        uint64_t now = clock_ns(CLOCK_MONOTONIC);
+        while (spsc_ring_write(r->ring, (const uint8_t*)&now, sizeof(now)) != 0) {}
+    }
+
+    pthread_join(consumer, NULL);
+    spsc_ring_deinit(&r->ring);
+    wait_strategy_deinit(&ws);
+
+    qsort(r->latency_ns, SAMPLES, sizeof(r->latency_ns[0]), compare);
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(void)
+{
+    static const char* const names[] = {"spin", "yield", "park", "adaptive"};
+    static const wait_strategy_kind_t kinds[] = {WAIT_STRATEGY_SPIN, WAIT_STRATEGY_YIELD, WAIT_STRATEGY_PARK,
+                                                 WAIT_STRATEGY_ADAPTIVE};
+    static const uint64_t intervals_ns[] = {2000, 100000, 1000000};
+
+    printf("%u samples per run, initial spin budget %u\n\n", SAMPLES, SPIN_LIMIT);
+    printf("%9s | %8s | %10s | %10s | %10s | %10s | %9s\n", "interval", "strategy", "p50 ns", "p99 ns", "p99.9 ns",
+           "max ns", "CPU %");
+
+    for (size_t i = 0; i < sizeof(intervals_ns) / sizeof(intervals_ns[0]); i++) {
+        for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+            result.interval_ns = intervals_ns[i];
+            run(&result, kinds[k]);
+
+            printf("%6llu us | %8s | %10llu | %10llu | %10llu | %10llu | %9.1f\n",
+                   (unsigned long long)(intervals_ns[i] / 1000), names[k],
+                   (unsigned long long)result.latency_ns[SAMPLES / 2],
+                   (unsigned long long)result.latency_ns[SAMPLES * 99 / 100],
+                   (unsigned long long)result.latency_ns[SAMPLES * 999 / 1000],
+                   (unsigned long long)result.latency_ns[SAMPLES - 1], 100.0 * result.cpu_ratio);
+        }
+    }
+
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,167 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file bench_ws_executor.c
+ ** @brief Benchmark of ws_executor throughput against the number of workers, on uneven per-port loads.
+ **
+ ** Each port holds a Zipf-distributed amount of work (port i gets a share proportional to 1 / (i + 1)),
+ ** so a few ports are busy and most are nearly idle. A port's task processes a batch of work units, as
+ ** a "drain this ring" task would, and resubmits itself while the port has work left. Every port is
+ ** submitted from outside to worker 0, the worst start for balance, and the run ends when the executor
+ ** quiesces. The speedup column is relative to one worker; near-linear scaling up to the core count is
+ ** the target, and the steal count shows how much of it came from stealing.
+ **
+ ** Not part of the test suite: timings depend on the machine and its load. Build and run with `make run`.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <utils/ws_executor/ws_executor.h>
+
+/* === Macros definitions ====================================================================== */
+
+/// Number of ports.
+#define PORT_COUNT 256
+
+/// Work units spread over the ports on every run.
+#define TOTAL_UNITS 2000000U
+
+/// Work units a task processes before it resubmits itself.
+#define BATCH_UNITS 64U
+
+/// Iterations of the work loop per unit, roughly a message's worth of processing.
+#define UNIT_SPINS 200U
+
+/* === Private data type declarations ========================================================== */
+
+/// A port: its task, the work it has left and a result that keeps the work from being optimized away.
+typedef struct
+{
+    ws_task_t task;
+    ws_executor_t executor;
+    uint32_t remaining;
+    uint32_t state;
+} port_t;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static uint64_t now_ns(void);
+static void process_port(void* ctx);
+static double run(size_t workers, uint64_t* steals);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+static port_t ports[PORT_COUNT];
+
+/* === Private function implementation ========================================================= */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void process_port(void* ctx)
+{
+    port_t* port = ctx;
+    uint32_t units = port->remaining < BATCH_UNITS ? port->remaining : BATCH_UNITS;
+    uint32_t x = port->state;
+
+    for (uint32_t i = 0; i < units * UNIT_SPINS; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+
+    port->state = x;
+    port->remaining -= units;
+    if (port->remaining > 0) { ws_executor_submit(port->executor, &port->task); }
+}
+
+static double run(size_t workers, uint64_t* steals)
+{
+    double harmonic = 0;
+    for (size_t i = 0; i < PORT_COUNT; i++) { harmonic += 1.0 / (double)(i + 1); }
+
+    ws_executor_t ex = ws_executor_init(workers);
+    if (!ex) {
+        fprintf(stderr, "could not start %zu workers\n", workers);
+        exit(1);
+    }
+
+    for (size_t i = 0; i < PORT_COUNT; i++) {
+        ws_task_init(&ports[i].task, process_port, &ports[i], 0);
+        ports[i].executor = ex;
+        ports[i].remaining = (uint32_t)((double)TOTAL_UNITS / (harmonic * (double)(i + 1)) + 0.5);
+        if (ports[i].remaining == 0) { ports[i].remaining = 1; }
+        ports[i].state = (uint32_t)i + 1;
+    }
+
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < PORT_COUNT; i++) { ws_executor_submit(ex, &ports[i].task); }
+    ws_executor_quiesce(ex);
+    uint64_t elapsed = now_ns() - start;
+
+    *steals = ws_executor_steals(ex);
+    ws_executor_deinit(&ex);
+
+    return (double)elapsed / 1e9;
+}
+
+/* === Public function implementation ========================================================== */
+
+int main(int argc, char** argv)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max = (argc > 1) ? strtoul(argv[1], NULL, 0) : (size_t)(cores > 0 ? cores : 1);
+    if (max < 1) { max = 1; }
+    if (max > WS_EXECUTOR_MAX_WORKERS) { max = WS_EXECUTOR_MAX_WORKERS; }
+
+    printf("%d ports, %u units of %u spins, Zipf loads, %ld cores online\n\n", PORT_COUNT, TOTAL_UNITS, UNIT_SPINS,
+           cores);
+    printf("%7s | %10s | %14s | %7s | %8s\n", "workers", "seconds", "Munits/s", "speedup", "steals");
+
+    // 1, 2, 4... workers, and the maximum.
+    double base = 0;
+    for (size_t workers = 1;; workers = (workers * 2 < max) ? workers * 2 : max) {
+        uint64_t steals = 0;
+        double seconds = run(workers, &steals);
+        if (workers == 1) { base = seconds; }
+
+        printf("%7zu | %10.3f | %14.2f | %7.2f | %8llu\n", workers, seconds, (double)TOTAL_UNITS / seconds / 1e6,
+               base / seconds, (unsigned long long)steals);
+
+        if (workers == max) { break; }
+    }
+
+    return 0;
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,94 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file check.hpp
+/// @brief Minimal test harness for the C++ headers, which ceedling does not build.
+///
+/// Failed checks print their location and expression and are counted, like Unity's assertions, but
+/// the test goes on. check::run() prints the name of each failed test and returns how many failed.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <cstdio>
+#include <initializer_list>
+
+/* === Public macros definitions =============================================================== */
+
+/// Checks that @p expr is true.
+#define CHECK(expr) check::verify((expr), __FILE__, __LINE__, #expr)
+
+/// Checks that @p actual equals @p expected.
+#define CHECK_EQUAL(expected, actual) CHECK((expected) == (actual))
+
+/// A test case for check::run(), named after its function.
+#define TEST_CASE(fn) check::test_case{#fn, fn}
+
+/* === Public function declarations ============================================================ */
+
+namespace check {
+
+/// Failed checks since the current test started.
+inline int failures = 0;
+
+/// Counts and reports a failed check. Called by CHECK().
+inline void verify(bool ok, const char* file, int line, const char* expr)
+{
+    if (!ok) {
+        std::printf("  %s:%d: check failed: %s\n", file, line, expr);
+        failures++;
+    }
+}
+
+/// A test: its name, as printed when it fails, and its function.
+struct test_case
+{
+    const char* name;
+    void (*fn)();
+};
+
+///
+/// @brief Runs the given tests and prints a summary.
+/// @return Number of failed tests.
+///
+inline int run(std::initializer_list<test_case> tests)
+{
+    int failed = 0;
+
+    for (const test_case& test : tests) {
+        failures = 0;
+        test.fn();
+        if (failures > 0) {
+            std::printf("  FAIL %s\n", test.name);
+            failed++;
+        }
+    }
+
+    std::printf("%d tests, %d failed\n", static_cast<int>(tests.size()), failed);
+    return failed;
+}
+
+}  // namespace check
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,342 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_basic_ring.cpp
+ ** @brief Test suite for the policy-based C++ ring.
+ **
+ ** Every combination of policies is run against a model of the expected behaviour, with each index
+ ** width, for long enough for the free-running indices to wrap around. The spsc and mpsc policies are
+ ** also run from several threads. Built with -Wshadow and -Werror by `make`.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include <utils/basic_ring/basic_ring.hpp>
+
+#include "check.hpp"
+
+/* === Macros definitions ====================================================================== */
+/* === Private data type declarations ========================================================== */
+
+namespace {
+
+using namespace utils;
+
+template <class... Ts> struct type_list {};
+
+using index_types = type_list<std::uint8_t, std::uint16_t, std::uint32_t, std::uint64_t>;
+
+/// Reference behaviour of a ring, on a std::deque.
+struct ring_model
+{
+    std::size_t capacity;
+    bool overwrites;
+    std::deque<std::uint32_t> elements;
+    ring_stats stats;
+
+    std::size_t write(const std::uint32_t* data, std::size_t count)
+    {
+        std::size_t room = capacity - elements.size();
+
+        if (!overwrites && count > room) {
+            stats.overflows += count - room;
+            count = room;
+        } else if (overwrites && count > room) {
+            stats.overflows += count - room;
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            if (elements.size() == capacity) { elements.pop_front(); }
+            elements.push_back(data[i]);
+        }
+
+        stats.pushed += count;
+        return count;
+    }
+
+    std::size_t read(std::uint32_t* data, std::size_t count)
+    {
+        if (count > elements.size()) { count = elements.size(); }
+
+        for (std::size_t i = 0; i < count; i++) {
+            data[i] = elements.front();
+            elements.pop_front();
+        }
+
+        stats.popped += count;
+        return count;
+    }
+};
+
+/* === Private variable declarations =========================================================== */
+
+constexpr std::size_t CAPACITY = 8;
+
+/// Random operations per policy combination, enough for 8-bit indices to wrap around many times.
+constexpr int MODEL_OPERATIONS = 20000;
+
+/// Elements sent by each producer in the threaded tests.
+constexpr std::uint32_t THREADED_ELEMENTS = 200000;
+
+/// Producers of the threaded mpsc test.
+constexpr std::uint32_t PRODUCERS = 4;
+
+/* === Private function declarations =========================================================== */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+/// Small deterministic generator, so a failure can be reproduced.
+std::uint32_t next_random(std::uint32_t& state)
+{
+    state = state * 1664525U + 1013904223U;
+    return state >> 16;
+}
+
+template <class... Index, class F> void for_each_index(type_list<Index...>, F f) { (f(Index{}), ...); }
+
+/// Runs random pushes, pops, writes and reads on a ring and on the model, checking that they agree.
+template <class Concurrency, class Overflow, class Index, class Stats> void check_against_model()
+{
+    constexpr bool overwrites = std::is_same_v<Overflow, ring_policy::overwrite>;
+
+    basic_ring<std::uint32_t, CAPACITY, Concurrency, Overflow, Index, Stats> ring;
+    ring_model model{CAPACITY, overwrites, {}, {}};
+    std::uint32_t state = 1;
+    std::uint32_t next = 0;
+    std::uint32_t data[2 * CAPACITY + 1];
+    std::uint32_t expected[2 * CAPACITY + 1];
+
+    CHECK_EQUAL(CAPACITY, ring.capacity());
+    CHECK(ring.empty());
+
+    for (int op = 0; op < MODEL_OPERATIONS; op++) {
+        std::size_t count = next_random(state) % (2 * CAPACITY + 1);
+
+        switch (next_random(state) % 4) {
+        case 0: {
+            std::uint32_t value = next++;
+            CHECK_EQUAL(model.write(&value, 1) == 1, ring.push(value));
+            break;
+        }
+        case 1: {
+            std::uint32_t value = 0;
+            std::size_t popped = model.read(expected, 1);
+            CHECK_EQUAL(popped == 1, ring.pop(value));
+            if (popped == 1) { CHECK_EQUAL(expected[0], value); }
+            break;
+        }
+        case 2:
+            for (std::size_t i = 0; i < count; i++) { data[i] = next++; }
+            CHECK_EQUAL(model.write(data, count), ring.write(data, count));
+            break;
+        default: {
+            std::size_t read = model.read(expected, count);
+            CHECK_EQUAL(read, ring.read(data, count));
+            for (std::size_t i = 0; i < read; i++) { CHECK_EQUAL(expected[i], data[i]); }
+            break;
+        }
+        }
+
+        CHECK_EQUAL(model.elements.size(), ring.size());
+        CHECK_EQUAL(model.elements.empty(), ring.empty());
+        CHECK_EQUAL(model.elements.size() == CAPACITY, ring.full());
+    }
+
+    if constexpr (std::is_same_v<Stats, ring_policy::stats>) {
+        ring_stats stats = ring.stats();
+        CHECK_EQUAL(model.stats.pushed, stats.pushed);
+        CHECK_EQUAL(model.stats.popped, stats.popped);
+        CHECK_EQUAL(model.stats.overflows, stats.overflows);
+    }
+}
+
+template <class Concurrency, class Overflow> void check_every_index_and_stats()
+{
+    for_each_index(index_types{}, [](auto index) {
+        using Index = decltype(index);
+        check_against_model<Concurrency, Overflow, Index, ring_policy::no_stats>();
+        check_against_model<Concurrency, Overflow, Index, ring_policy::stats>();
+    });
+}
+
+/// One producer sends consecutive numbers, in single pushes and blocks, and the consumer checks they arrive in order.
+template <class Index> void check_spsc_threads()
+{
+    basic_ring<std::uint32_t, 64, ring_policy::spsc, ring_policy::reject, Index, ring_policy::stats> ring;
+
+    std::thread producer([&ring] {
+        std::uint32_t block[5];
+        for (std::uint32_t value = 0; value < THREADED_ELEMENTS;) {
+            if (value % 2 == 0) {
+                if (ring.push(value)) {
+                    value++;
+                } else {
+                    std::this_thread::yield();
+                }
+            } else {
+                std::size_t count = 0;
+                for (; count < 5 && value + count < THREADED_ELEMENTS; count++) {
+                    block[count] = value + static_cast<std::uint32_t>(count);
+                }
+                std::size_t written = ring.write(block, count);
+                value += static_cast<std::uint32_t>(written);
+                if (written == 0) { std::this_thread::yield(); }
+            }
+        }
+    });
+
+    std::uint32_t expected = 0;
+    std::uint32_t block[7];
+    bool ordered = true;
+
+    while (expected < THREADED_ELEMENTS) {
+        std::size_t read = (expected % 3 == 0) ? ring.pop(block[0]) : ring.read(block, 7);
+        for (std::size_t i = 0; i < read; i++) { ordered = ordered && block[i] == expected++; }
+        if (read == 0) { std::this_thread::yield(); }
+    }
+
+    producer.join();
+
+    CHECK(ordered);
+    CHECK(ring.empty());
+    CHECK_EQUAL(THREADED_ELEMENTS, ring.stats().pushed);
+    CHECK_EQUAL(THREADED_ELEMENTS, ring.stats().popped);
+}
+
+/// Several producers send tagged consecutive numbers, and the consumer checks each producer's arrive in order.
+template <class Index> void check_mpsc_threads()
+{
+    basic_ring<std::uint64_t, 64, ring_policy::mpsc, ring_policy::reject, Index, ring_policy::stats> ring;
+    std::vector<std::thread> producers;
+
+    for (std::uint32_t p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&ring, p] {
+            for (std::uint32_t i = 0; i < THREADED_ELEMENTS;) {
+                std::uint64_t value = (static_cast<std::uint64_t>(p) << 32) | i;
+                if (ring.push(value)) {
+                    i++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::uint32_t expected[PRODUCERS] = {};
+    std::uint64_t received = 0;
+    std::uint64_t block[8];
+    bool ordered = true;
+
+    while (received < static_cast<std::uint64_t>(PRODUCERS) * THREADED_ELEMENTS) {
+        std::size_t read = ring.read(block, 8);
+        for (std::size_t i = 0; i < read; i++) {
+            auto producer = static_cast<std::uint32_t>(block[i] >> 32);
+            ordered = ordered && producer < PRODUCERS && static_cast<std::uint32_t>(block[i]) == expected[producer]++;
+        }
+        received += read;
+        if (read == 0) { std::this_thread::yield(); }
+    }
+
+    for (std::thread& producer : producers) { producer.join(); }
+
+    std::uint64_t value;
+    CHECK(ordered);
+    CHECK(!ring.pop(value));
+    CHECK_EQUAL(received, ring.stats().pushed);
+    CHECK_EQUAL(received, ring.stats().popped);
+}
+
+/* === Public function implementation ========================================================== */
+
+/// @test This test verifies that unsynchronized rings refusing new elements when full behave like the model.
+void test_unsync_reject() { check_every_index_and_stats<ring_policy::unsync, ring_policy::reject>(); }
+
+/// @test This test verifies that unsynchronized rings overwriting the oldest elements behave like the model.
+void test_unsync_overwrite() { check_every_index_and_stats<ring_policy::unsync, ring_policy::overwrite>(); }
+
+/// @test This test verifies that spsc rings behave like the model from a single thread.
+void test_spsc() { check_every_index_and_stats<ring_policy::spsc, ring_policy::reject>(); }
+
+/// @test This test verifies that mpsc rings behave like the model from a single thread.
+void test_mpsc() { check_every_index_and_stats<ring_policy::mpsc, ring_policy::reject>(); }
+
+/// @test This test verifies that clear() discards every element of an unsynchronized ring.
+void test_clear()
+{
+    byte_ring<16> ring;
+    std::uint8_t byte;
+
+    ring.push(1);
+    ring.push(2);
+    ring.clear();
+
+    CHECK(ring.empty());
+    CHECK(!ring.pop(byte));
+    CHECK(ring.push(3));
+    CHECK(ring.pop(byte));
+    CHECK_EQUAL(3, byte);
+}
+
+/// @test This test verifies that the empty policies take no room.
+void test_policies_take_no_room()
+{
+    using plain = basic_ring<std::uint8_t, 16, ring_policy::unsync, ring_policy::overwrite, std::uint8_t>;
+
+    CHECK_EQUAL(2 + 16, sizeof(plain));
+}
+
+/// @test This test verifies that elements from one producer thread reach the consumer thread in order.
+void test_spsc_threads()
+{
+    check_spsc_threads<std::uint8_t>();
+    check_spsc_threads<std::size_t>();
+}
+
+/// @test This test verifies that elements from several producer threads are all received, each producer's in order.
+void test_mpsc_threads()
+{
+    check_mpsc_threads<std::uint8_t>();
+    check_mpsc_threads<std::uint32_t>();
+}
+
+}  // namespace
+
+int main()
+{
+    return check::run({
+               TEST_CASE(test_unsync_reject),
+               TEST_CASE(test_unsync_overwrite),
+               TEST_CASE(test_spsc),
+               TEST_CASE(test_mpsc),
+               TEST_CASE(test_clear),
+               TEST_CASE(test_policies_take_no_room),
+               TEST_CASE(test_spsc_threads),
+               TEST_CASE(test_mpsc_threads),
+           }) != 0;
+}
+
+/* === End of documentation ==================================================================== */
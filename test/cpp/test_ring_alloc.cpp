@@ -0,0 +1,199 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_ring_alloc.cpp
+ ** @brief Test suite for the `std::pmr::memory_resource` adapter of the circular allocator.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+#include <utils/ring_alloc/ring_alloc.hpp>
+
+#include "check.hpp"
+
+/* === Macros definitions ====================================================================== */
+/* === Private data type declarations ========================================================== */
+
+namespace {
+
+using namespace utils;
+
+/* === Private variable declarations =========================================================== */
+
+constexpr std::size_t STORAGE_SIZE = 1024;
+
+/* === Private function declarations =========================================================== */
+/* === Private variable definitions ============================================================ */
+
+alignas(RING_ALLOC_ALIGN) std::uint8_t storage[STORAGE_SIZE];
+
+/* === Private function implementation ========================================================= */
+
+/// Runs @p test on a resource over a fresh allocator, and checks that it left nothing allocated.
+template <class Test> void with_resource(Test test)
+{
+    ring_alloc_t ra = ring_alloc_init(storage, sizeof(storage));
+    CHECK(ra != nullptr);
+
+    {
+        ring_memory_resource resource(ra);
+        CHECK(resource.get() == ra);
+        test(resource);
+    }
+
+    CHECK_EQUAL(0U, ring_alloc_used(ra));
+    ring_alloc_deinit(&ra);
+}
+
+/// Checks that allocating @p bytes with @p alignment throws std::bad_alloc.
+bool allocation_throws(std::pmr::memory_resource& resource, std::size_t bytes, std::size_t alignment)
+{
+    try {
+        void* ptr = resource.allocate(bytes, alignment);
+        resource.deallocate(ptr, bytes, alignment);
+    } catch (const std::bad_alloc&) {
+        return true;
+    }
+    return false;
+}
+
+/* === Public function implementation ========================================================== */
+
+/// @test This test verifies that a std::pmr::vector takes its storage from the ring and gives it back.
+void test_pmr_vector()
+{
+    with_resource([](ring_memory_resource& resource) {
+        std::pmr::vector<std::uint8_t> message(&resource);
+        message.reserve(100);
+
+        auto* data = reinterpret_cast<std::uint8_t*>(message.data());
+        CHECK(data >= storage && data < storage + sizeof(storage));
+        CHECK(ring_alloc_used(resource.get()) >= 100);
+
+        for (std::uint8_t i = 0; i < 100; i++) { message.push_back(i); }
+        CHECK_EQUAL(100U, message.size());
+        CHECK_EQUAL(99, message.back());
+    });
+}
+
+/// @test This test verifies that a growing vector reallocates within the ring, since it frees the oldest block.
+void test_pmr_vector_grows()
+{
+    with_resource([](ring_memory_resource& resource) {
+        std::pmr::vector<std::uint32_t> values(&resource);
+
+        for (std::uint32_t i = 0; i < 60; i++) { values.push_back(i); }
+
+        bool intact = true;
+        for (std::uint32_t i = 0; i < 60; i++) { intact = intact && values[i] == i; }
+        CHECK(intact);
+    });
+}
+
+/// @test This test verifies that messages released in allocation order keep the ring going around its storage.
+void test_fifo_release_wraps_around()
+{
+    with_resource([](ring_memory_resource& resource) {
+        std::vector<std::pmr::vector<std::uint8_t>> in_flight;
+        std::size_t oldest = 0;
+        bool intact = true;
+
+        // Keep a few messages of varying sizes in flight, releasing the oldest one as each new one is built.
+        for (std::size_t n = 0; n < 1000; n++) {
+            in_flight.emplace_back(&resource);
+            in_flight.back().assign(16 + (n * 37) % 150, static_cast<std::uint8_t>(n));
+
+            if (in_flight.size() - oldest > 3) {
+                for (std::uint8_t byte : in_flight[oldest]) {
+                    intact = intact && byte == static_cast<std::uint8_t>(oldest);
+                }
+                in_flight[oldest] = std::pmr::vector<std::uint8_t>(&resource);
+                oldest++;
+            }
+        }
+
+        CHECK(intact);
+
+        for (; oldest < in_flight.size(); oldest++) { in_flight[oldest] = std::pmr::vector<std::uint8_t>(&resource); }
+    });
+}
+
+/// @test This test verifies that requests the ring cannot serve throw std::bad_alloc.
+void test_bad_alloc()
+{
+    with_resource([](ring_memory_resource& resource) {
+        // Larger than the whole storage, or more aligned than its blocks.
+        CHECK(allocation_throws(resource, STORAGE_SIZE, 1));
+        CHECK(allocation_throws(resource, 16, 2 * RING_ALLOC_ALIGN));
+
+        // Larger than the space left.
+        void* held = resource.allocate(STORAGE_SIZE / 2, 1);
+        CHECK(allocation_throws(resource, STORAGE_SIZE / 2, 1));
+        resource.deallocate(held, STORAGE_SIZE / 2, 1);
+
+        // A container that outgrows the ring gets the exception and keeps its elements.
+        std::pmr::vector<std::uint8_t> message(&resource);
+        bool threw = false;
+        try {
+            for (std::size_t i = 0; i < STORAGE_SIZE; i++) { message.push_back(static_cast<std::uint8_t>(i)); }
+        } catch (const std::bad_alloc&) {
+            threw = true;
+        }
+        CHECK(threw);
+        CHECK(!message.empty());
+        CHECK_EQUAL(static_cast<std::uint8_t>(message.size() - 1), message.back());
+    });
+}
+
+/// @test This test verifies that resources compare equal only to themselves.
+void test_is_equal()
+{
+    ring_alloc_t ra = ring_alloc_init(storage, sizeof(storage));
+    ring_memory_resource resource(ra);
+    ring_memory_resource other(ra);
+
+    CHECK(resource == resource);
+    CHECK(resource != other);
+    CHECK(resource != *std::pmr::new_delete_resource());
+
+    ring_alloc_deinit(&ra);
+}
+
+}  // namespace
+
+int main()
+{
+    return check::run({
+               TEST_CASE(test_pmr_vector),
+               TEST_CASE(test_pmr_vector_grows),
+               TEST_CASE(test_fifo_release_wraps_around),
+               TEST_CASE(test_bad_alloc),
+               TEST_CASE(test_is_equal),
+           }) != 0;
+}
+
+/* === End of documentation ==================================================================== */
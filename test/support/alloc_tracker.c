@@ -0,0 +1,108 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file alloc_tracker.c
+ ** @brief Heap allocation tracking for the tests.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "alloc_tracker.h"
+#include <utils/port_atomic/port_atomic.h>
+
+/* === Macros definitions ====================================================================== */
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static port_atomic_size_t allocations;
+static port_atomic_size_t violations;
+static port_atomic_bool_t steady;
+
+/* === Private function declarations =========================================================== */
+
+static void track(void);
+
+// The actual allocator, reached through the linker's --wrap.
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __real_aligned_alloc(size_t alignment, size_t size);
+void __real_free(void* ptr);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void track(void)
+{
+    PORT_ATOMIC_FETCH_ADD(&allocations, 1, PORT_ATOMIC_RELAXED);
+    if (PORT_ATOMIC_LOAD(&steady, PORT_ATOMIC_ACQUIRE)) { PORT_ATOMIC_FETCH_ADD(&violations, 1, PORT_ATOMIC_RELAXED); }
+}
+
+/* === Public function implementation ========================================================== */
+
+void* __wrap_malloc(size_t size)
+{
+    track();
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    track();
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    track();
+    return __real_realloc(ptr, size);
+}
+
+void* __wrap_aligned_alloc(size_t alignment, size_t size)
+{
+    track();
+    return __real_aligned_alloc(alignment, size);
+}
+
+void __wrap_free(void* ptr) { __real_free(ptr); }
+
+void alloc_tracker_reset(void)
+{
+    PORT_ATOMIC_STORE(&steady, false, PORT_ATOMIC_RELEASE);
+    PORT_ATOMIC_STORE(&allocations, 0, PORT_ATOMIC_RELAXED);
+    PORT_ATOMIC_STORE(&violations, 0, PORT_ATOMIC_RELAXED);
+}
+
+void alloc_tracker_steady_state(void)
+{
+    PORT_ATOMIC_STORE(&violations, 0, PORT_ATOMIC_RELAXED);
+    PORT_ATOMIC_STORE(&steady, true, PORT_ATOMIC_RELEASE);
+}
+
+size_t alloc_tracker_allocations(void) { return PORT_ATOMIC_LOAD(&allocations, PORT_ATOMIC_RELAXED); }
+
+size_t alloc_tracker_violations(void) { return PORT_ATOMIC_LOAD(&violations, PORT_ATOMIC_RELAXED); }
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,75 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file alloc_tracker.h
+/// @brief Heap allocation tracking for the tests.
+///
+/// The test build links every executable with `-Wl,--wrap` for malloc(), calloc(), realloc(),
+/// aligned_alloc() and free() (see project.yml), routing the calls made by the code under test through
+/// this module. It counts them, and once a test declares the steady state has been reached, every
+/// further allocation is a violation: the hot paths of the library are meant to run off memory set up
+/// at init time. Calls made inside the C library itself are not seen, since wrapping happens at link
+/// time on undefined references only.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+/* === Public data type declarations =========================================================== */
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Clears the counters and leaves the steady state.
+///
+void alloc_tracker_reset(void);
+
+///
+/// @brief Declares the steady state reached: from now on, allocations are counted as violations.
+///
+void alloc_tracker_steady_state(void);
+
+///
+/// @brief Returns the number of allocations since the last reset, from any thread.
+///
+size_t alloc_tracker_allocations(void);
+
+///
+/// @brief Returns the number of allocations since alloc_tracker_steady_state(), from any thread.
+///
+size_t alloc_tracker_violations(void);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,127 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file cycle_budget.h
+/// @brief Cycle-count assertions for hot-path functions.
+///
+/// Behavioural tests do not notice a hot path getting slower, say from an added division or lock. The
+/// helpers here time an operation over many calls with tsc_clock_cycles() and let a test assert a
+/// generous upper bound per call, so such a regression fails the normal test run instead of waiting
+/// for someone to run the benchmark. The cost reported is the best of several batches, which filters
+/// out preemption and cold caches; budgets should still leave a wide margin over the measured cost,
+/// since they must hold on any development machine and unoptimized builds. Instrumented builds
+/// (coverage, sanitizers) can scale every budget with CYCLE_BUDGET_SCALE.
+///
+/// tsc_clock_init() must be called first, or costs come out in nanoseconds rather than cycles. Header
+/// only, since test support sources are linked into every test: tests using it include tsc_clock.h too.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unity.h>
+
+#include <utils/tsc_clock/tsc_clock.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+
+#ifndef CYCLE_BUDGET_SCALE
+/// Factor applied to every budget, e.g. 10 for coverage builds.
+#define CYCLE_BUDGET_SCALE 1
+#endif
+
+/// Number of timed batches per measurement. The cheapest one is kept.
+#define CYCLE_BUDGET_ROUNDS 32
+
+/// Empty measurements taken to estimate the cost of reading the counter.
+#define CYCLE_BUDGET_OVERHEAD_SAMPLES 64
+
+/// Fails the current test if @p cycles, as returned by cycle_budget_measure(), exceeds @p budget.
+#define TEST_ASSERT_CYCLE_BUDGET(budget, cycles) \
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64_MESSAGE((uint64_t)(budget) * CYCLE_BUDGET_SCALE, (cycles), "over cycle budget")
+
+/* === Public data type declarations =========================================================== */
+
+///
+/// @brief Performs @p calls operations back to back, or prepares the state to do so.
+/// @param ctx Argument given to cycle_budget_measure().
+/// @param calls Number of operations in the batch.
+///
+typedef void (*cycle_budget_fn)(void* ctx, size_t calls);
+
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Measures the cost of an operation, in cycles per call.
+///
+/// Each round calls @p prepare, untimed, then times @p run. The cost of reading the counter is
+/// subtracted, and the cheapest round is divided by @p calls.
+///
+/// @param prepare Sets up the state a batch needs, e.g. fills a ring before timing reads. May be NULL.
+/// @param run Timed batch.
+/// @param ctx Argument for @p prepare and @p run.
+/// @param calls Operations per batch. Large enough to amortize the indirect call to @p run.
+/// @return Cycles per call, rounded up.
+///
+static inline uint64_t cycle_budget_measure(cycle_budget_fn prepare, cycle_budget_fn run, void* ctx, size_t calls)
+{
+    assert(run != NULL);
+    assert(calls > 0);
+
+    uint64_t overhead = UINT64_MAX;
+    for (size_t i = 0; i < CYCLE_BUDGET_OVERHEAD_SAMPLES; i++) {
+        uint64_t start = tsc_clock_cycles();
+        uint64_t cycles = tsc_clock_cycles_serialized() - start;
+        if (cycles < overhead) { overhead = cycles; }
+    }
+
+    uint64_t best = UINT64_MAX;
+    for (size_t round = 0; round < CYCLE_BUDGET_ROUNDS; round++) {
+        if (prepare) { prepare(ctx, calls); }
+
+        uint64_t start = tsc_clock_cycles();
+        run(ctx, calls);
+        uint64_t cycles = tsc_clock_cycles_serialized() - start;
+
+        cycles = (cycles > overhead) ? cycles - overhead : 0;
+        if (cycles < best) { best = cycles; }
+    }
+
+    return (best + calls - 1) / calls;
+}
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,84 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file send_fault.c
+ ** @brief Socket send buffer exhaustion for the tests.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include "send_fault.h"
+
+/* === Macros definitions ====================================================================== */
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static bool limited;
+static size_t remaining;
+
+/* === Private function declarations =========================================================== */
+
+#if defined(__linux__)
+// The actual system call, reached through the linker's --wrap.
+int __real_sendmmsg(int fd, struct mmsghdr* msgs, unsigned int count, int flags);
+#endif
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+/* === Public function implementation ========================================================== */
+
+#if defined(__linux__)
+int __wrap_sendmmsg(int fd, struct mmsghdr* msgs, unsigned int count, int flags)
+{
+    if (!limited) { return __real_sendmmsg(fd, msgs, count, flags); }
+
+    if (remaining == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    if (count > remaining) { count = (unsigned int)remaining; }
+
+    int sent = __real_sendmmsg(fd, msgs, count, flags);
+    if (sent > 0) { remaining -= (size_t)sent; }
+
+    return sent;
+}
+#endif
+
+void send_fault_limit(size_t datagrams)
+{
+    limited = true;
+    remaining = datagrams;
+}
+
+void send_fault_clear(void) { limited = false; }
+
+/* === End of documentation ==================================================================== */
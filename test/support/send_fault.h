@@ -0,0 +1,64 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+#pragma once
+
+///
+/// @file send_fault.h
+/// @brief Socket send buffer exhaustion for the tests.
+///
+/// The test build links every executable with `-Wl,--wrap=sendmmsg` (see project.yml), so the code
+/// under test reaches the kernel through this module. By default calls go straight through. Once a
+/// test sets a limit, the socket behaves as if its send buffer filled up after that many datagrams:
+/// calls take at most what is left, and then fail with EAGAIN. Loopback UDP never does that by itself.
+///
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+
+/* === C++ Guard =============================================================================== */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* === Public macros definitions =============================================================== */
+/* === Public data type declarations =========================================================== */
+/* === Public variable declarations ============================================================ */
+/* === Public function declarations ============================================================ */
+
+///
+/// @brief Lets at most @p datagrams more datagrams through sendmmsg(), failing with EAGAIN afterwards.
+/// @param datagrams Datagrams still accepted.
+///
+void send_fault_limit(size_t datagrams);
+
+///
+/// @brief Removes the limit: sendmmsg() goes straight to the kernel again.
+///
+void send_fault_clear(void);
+
+/* === End of documentation ==================================================================== */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,194 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_async_log.c
+ ** @brief Test suite for the asynchronous logger.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/async_log/async_log.h>
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define OUTPUT_SIZE 65536
+
+#define THREAD_COUNT 4
+
+#define RECORDS_PER_THREAD 2000
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static FILE* output = NULL;
+static char text[OUTPUT_SIZE];
+
+/* === Private function declarations =========================================================== */
+
+static size_t read_output(void);
+static size_t count_lines(const char* prefix);
+static void* logging_thread(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static size_t read_output(void)
+{
+    fflush(output);
+    rewind(output);
+    size_t len = fread(text, 1, sizeof(text) - 1, output);
+    text[len] = '\0';
+    return len;
+}
+
+static size_t count_lines(const char* prefix)
+{
+    size_t count = 0;
+    size_t prefix_len = strlen(prefix);
+
+    for (const char* line = text; *line; line = strchr(line, '\n') + 1) {
+        if (strncmp(line, prefix, prefix_len) == 0) { count++; }
+        if (!strchr(line, '\n')) { break; }
+    }
+
+    return count;
+}
+
+static void* logging_thread(void* arg)
+{
+    uint64_t id = (uint64_t)(uintptr_t)arg;
+
+    for (uint64_t i = 0; i < RECORDS_PER_THREAD; i++) { ASYNC_LOG("t%" PRIu64 " %" PRIu64 "\n", id, i); }
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    output = tmpfile();
+    TEST_ASSERT_NOT_NULL(output);
+    TEST_ASSERT_EQUAL_INT(0, async_log_init(fileno(output)));
+}
+
+void tearDown(void)
+{
+    async_log_deinit();
+    fclose(output);
+}
+
+/// @test This test verifies that messages are formatted with up to the maximum number of arguments.
+void test_formats_messages(void)
+{
+    ASYNC_LOG("started\n");
+    ASYNC_LOG("port %" PRIu64 " rate %" PRIu64 "\n", (uint64_t)3, (uint64_t)31250);
+    ASYNC_LOG("%" PRIu64 "-%" PRIu64 "-%" PRIu64 "-%" PRIu64 "\n", (uint64_t)1, (uint64_t)2, (uint64_t)3, (uint64_t)4);
+
+    async_log_deinit();
+    read_output();
+
+    TEST_ASSERT_EQUAL_STRING("started\nport 3 rate 31250\n1-2-3-4\n", text);
+    TEST_ASSERT_EQUAL_UINT64(0, async_log_dropped());
+}
+
+/// @test This test verifies that narrower and signed arguments are widened to 64 bits before being formatted.
+void test_widens_arguments(void)
+{
+    int8_t negative = -5;
+    uint8_t byte = 0xAB;
+
+    ASYNC_LOG("%" PRId64 " 0x%" PRIX64 " %" PRIu64 "\n", negative, byte, 7);
+
+    async_log_deinit();
+    read_output();
+
+    TEST_ASSERT_EQUAL_STRING("-5 0xAB 7\n", text);
+}
+
+/// @test This test verifies that the background thread writes records out without waiting for deinit.
+void test_background_thread_writes(void)
+{
+    ASYNC_LOG("tick %" PRIu64 "\n", (uint64_t)1);
+
+    for (int i = 0; i < 1000 && read_output() == 0; i++) { usleep(1000); }
+
+    TEST_ASSERT_EQUAL_STRING("tick 1\n", text);
+}
+
+/// @test This test verifies that messages from several threads are all either written or counted as dropped, and
+/// that each thread's messages keep their order.
+void test_concurrent_threads(void)
+{
+    pthread_t threads[THREAD_COUNT];
+
+    for (uintptr_t i = 0; i < THREAD_COUNT; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, logging_thread, (void*)i));
+    }
+    for (size_t i = 0; i < THREAD_COUNT; i++) { pthread_join(threads[i], NULL); }
+
+    async_log_deinit();
+    read_output();
+
+    size_t written = 0;
+    for (uint64_t id = 0; id < THREAD_COUNT; id++) {
+        char prefix[8];
+        snprintf(prefix, sizeof(prefix), "t%" PRIu64 " ", id);
+        written += count_lines(prefix);
+
+        // Sequence numbers of one thread only grow.
+        long last = -1;
+        for (const char* line = strstr(text, prefix); line; line = strstr(line + 1, prefix)) {
+            if (line != text && line[-1] != '\n') { continue; }
+            long seq = strtol(line + strlen(prefix), NULL, 10);
+            TEST_ASSERT(seq > last);
+            last = seq;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT64(THREAD_COUNT * RECORDS_PER_THREAD, written + async_log_dropped());
+}
+
+/// @test This test verifies that logging while the logger is stopped drops the record instead of failing.
+void test_write_when_stopped_is_dropped(void)
+{
+    async_log_deinit();
+
+    ASYNC_LOG("lost\n");
+
+    TEST_ASSERT_EQUAL_UINT64(1, async_log_dropped());
+    read_output();
+    TEST_ASSERT_EQUAL_STRING("", text);
+}
+
+/* === End of documentation ==================================================================== */
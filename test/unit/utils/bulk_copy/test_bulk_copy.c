@@ -0,0 +1,119 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_bulk_copy.c
+ ** @brief Test suite for the ring bulk copies.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <string.h>
+#include <unity.h>
+
+#include <utils/bulk_copy/bulk_copy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define DATA_SIZE 1024
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static uint8_t source[DATA_SIZE];
+static uint8_t destination[DATA_SIZE + 64];
+
+/* === Private function declarations =========================================================== */
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    for (size_t i = 0; i < DATA_SIZE; i++) { source[i] = (uint8_t)(i * 7 + 1); }
+    memset(destination, 0, sizeof(destination));
+}
+
+void tearDown(void) {}
+
+/// @test This test verifies streaming copies for every destination alignment and awkward lengths.
+void test_stream_copy(void)
+{
+    const size_t lengths[] = {1, 15, 16, 17, 63, 64, 65, 200, DATA_SIZE - 16};
+
+    for (size_t align = 0; align < 16; align++) {
+        for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+            memset(destination, 0, sizeof(destination));
+            bulk_copy_stream(&destination[align], &source[3], lengths[i]);
+
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(&source[3], &destination[align], lengths[i]);
+            // Nothing written past the end.
+            TEST_ASSERT_EQUAL_UINT8(0, destination[align + lengths[i]]);
+        }
+    }
+}
+
+/// @test This test verifies that copies into a ring wrap around its end, with and without streaming stores.
+void test_copy_in_wraps(void)
+{
+    const size_t thresholds[] = {0, BULK_COPY_NO_STREAM};
+
+    for (size_t i = 0; i < 2; i++) {
+        memset(destination, 0, sizeof(destination));
+        bulk_copy_in(destination, 256, 200, source, 100, thresholds[i]);
+
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(source, &destination[200], 56);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(&source[56], destination, 44);
+        TEST_ASSERT_EQUAL_UINT8(0, destination[44]);
+    }
+}
+
+/// @test This test verifies that windowed, prefetching copies out of a ring match a plain copy.
+void test_copy_out_wraps(void)
+{
+    const size_t distances[] = {0, 1, 7, 64, 512};
+    uint8_t out[DATA_SIZE];
+
+    for (size_t i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+        memset(out, 0, sizeof(out));
+        bulk_copy_out(source, 256, 200, out, 250, distances[i]);
+
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(&source[200], out, 56);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(source, &out[56], 194);
+        TEST_ASSERT_EQUAL_UINT8(0, out[250]);
+    }
+}
+
+/// @test This test verifies that scans find the first match on both sides of the wrap, or report none.
+void test_find_wraps(void)
+{
+    const size_t distances[] = {0, 3, 64};
+
+    // source[i] = i * 7 + 1: 0x08 is at 1 only within the first 256 bytes, 0x01 at 0.
+    for (size_t i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+        TEST_ASSERT_EQUAL_UINT(57, bulk_copy_find(source, 256, 200, 100, 0x08, distances[i]));
+        TEST_ASSERT_EQUAL_UINT(4, bulk_copy_find(source, 256, 200, 100, source[204], distances[i]));
+        TEST_ASSERT_EQUAL_UINT(50, bulk_copy_find(source, 256, 200, 50, 0x08, distances[i]));
+    }
+}
+
+/* === End of documentation ==================================================================== */
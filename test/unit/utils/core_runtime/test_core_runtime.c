@@ -0,0 +1,170 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_core_runtime.c
+ ** @brief Test suite for the thread-per-core runtime.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/core_runtime/core_runtime.h>
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define CORE_COUNT 4
+
+#define MESSAGES_PER_PAIR 2000
+
+#define PORT_COUNT 1000
+
+/* === Private data type declarations ========================================================== */
+
+/// Per-core test state, only touched by its own worker.
+typedef struct
+{
+    uint32_t sent[CORE_COUNT];      ///< Messages sent to each core so far.
+    uint32_t received[CORE_COUNT];  ///< Messages received from each core so far.
+    uint32_t out_of_order;          ///< Messages received with an unexpected sequence number.
+    int wrong_core;                 ///< Times a callback ran on a thread not owning its core.
+} core_state_t;
+
+/* === Private variable declarations =========================================================== */
+
+static core_runtime_t runtime = NULL;
+static core_state_t state[CORE_COUNT];
+static atomic_uint delivered;
+
+/* === Private function declarations =========================================================== */
+
+static void on_message(core_runtime_t rt, void* ctx, size_t core, size_t from, const uint8_t* data, size_t len);
+static size_t on_poll(core_runtime_t rt, void* ctx, size_t core);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void on_message(core_runtime_t rt, void* ctx, size_t core, size_t from, const uint8_t* data, size_t len)
+{
+    core_state_t* self = &((core_state_t*)ctx)[core];
+    uint32_t seq;
+
+    (void)rt;
+
+    if (core_runtime_current_core() != (int)core || len != sizeof(seq)) { self->wrong_core++; }
+
+    memcpy(&seq, data, sizeof(seq));
+    if (seq != self->received[from]) { self->out_of_order++; }
+    self->received[from]++;
+
+    atomic_fetch_add(&delivered, 1);
+}
+
+static size_t on_poll(core_runtime_t rt, void* ctx, size_t core)
+{
+    core_state_t* self = &((core_state_t*)ctx)[core];
+    size_t work = 0;
+
+    if (core_runtime_current_core() != (int)core) { self->wrong_core++; }
+
+    // Send to every core, itself included, as fast as the rings allow.
+    for (size_t to = 0; to < CORE_COUNT; to++) {
+        while (self->sent[to] < MESSAGES_PER_PAIR &&
+               core_runtime_send(rt, to, &self->sent[to], sizeof(self->sent[to])) == 0) {
+            self->sent[to]++;
+            work++;
+        }
+    }
+
+    return work;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    memset(state, 0, sizeof(state));
+    atomic_store(&delivered, 0);
+}
+
+void tearDown(void)
+{
+    core_runtime_deinit(&runtime);
+    TEST_ASSERT_NULL(runtime);
+}
+
+/// @test This test verifies that ports are spread over the cores, always to the same one.
+void test_port_assignment(void)
+{
+    core_runtime_config_t config = {.cores = CORE_COUNT, .on_message = on_message, .ctx = state};
+    size_t per_core[CORE_COUNT] = {0};
+
+    runtime = core_runtime_init(&config);
+    TEST_ASSERT_NOT_NULL(runtime);
+    TEST_ASSERT_EQUAL_UINT(CORE_COUNT, core_runtime_cores(runtime));
+    TEST_ASSERT_EQUAL_INT(-1, core_runtime_current_core());
+
+    for (uint32_t port = 0; port < PORT_COUNT; port++) {
+        size_t core = core_runtime_port_core(runtime, port);
+        TEST_ASSERT(core < CORE_COUNT);
+        TEST_ASSERT_EQUAL_UINT(core, core_runtime_port_core(runtime, port));
+        per_core[core]++;
+    }
+
+    // Roughly even: no core gets less than half its share.
+    for (size_t core = 0; core < CORE_COUNT; core++) { TEST_ASSERT(per_core[core] > PORT_COUNT / CORE_COUNT / 2); }
+}
+
+/// @test This test verifies that every core can message every core, and that messages between two cores keep their
+/// order.
+void test_mesh_delivery(void)
+{
+    core_runtime_config_t config = {
+        .cores = CORE_COUNT, .pin = true, .on_message = on_message, .on_poll = on_poll, .ctx = state};
+
+    runtime = core_runtime_init(&config);
+    TEST_ASSERT_NOT_NULL(runtime);
+
+    for (int i = 0; i < 10000 && atomic_load(&delivered) < CORE_COUNT * CORE_COUNT * MESSAGES_PER_PAIR; i++) {
+        usleep(1000);
+    }
+
+    core_runtime_deinit(&runtime);
+
+    TEST_ASSERT_EQUAL_UINT(CORE_COUNT * CORE_COUNT * MESSAGES_PER_PAIR, atomic_load(&delivered));
+    for (size_t core = 0; core < CORE_COUNT; core++) {
+        TEST_ASSERT_EQUAL_INT(0, state[core].wrong_core);
+        TEST_ASSERT_EQUAL_UINT(0, state[core].out_of_order);
+        for (size_t from = 0; from < CORE_COUNT; from++) {
+            TEST_ASSERT_EQUAL_UINT(MESSAGES_PER_PAIR, state[core].received[from]);
+        }
+    }
+}
+
+/* === End of documentation ==================================================================== */
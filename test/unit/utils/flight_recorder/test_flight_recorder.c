@@ -0,0 +1,309 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_flight_recorder.c
+ ** @brief Test suite for the per-thread flight recorder.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/flight_recorder/flight_recorder.h>
+#include <utils/tsc_clock/tsc_clock.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define DUMP_MAX (sizeof(flight_recorder_header_t) + 4 * FLIGHT_RECORDER_RECORDS * sizeof(flight_recorder_record_t))
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static uint8_t dump[DUMP_MAX];
+
+/* === Private function declarations =========================================================== */
+
+static size_t dump_to_memory(void);
+static int decode_to_text(size_t len, char* text, size_t size);
+static void* recorder_thread(void* arg);
+static void* busy_recorder_thread(void* arg);
+static int overflow_stack(int depth);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+/// Tells busy_recorder_thread() to stop.
+static atomic_bool stop;
+
+/* === Private function implementation ========================================================= */
+
+static size_t dump_to_memory(void)
+{
+    FILE* tmp = tmpfile();
+    TEST_ASSERT_NOT_NULL(tmp);
+
+    TEST_ASSERT_EQUAL_INT(0, flight_recorder_dump(fileno(tmp)));
+
+    rewind(tmp);
+    size_t len = fread(dump, 1, sizeof(dump), tmp);
+    fclose(tmp);
+
+    return len;
+}
+
+static int decode_to_text(size_t len, char* text, size_t size)
+{
+    memset(text, 0, size);
+
+    FILE* out = fmemopen(text, size - 1, "w");
+    TEST_ASSERT_NOT_NULL(out);
+
+    int count = flight_recorder_decode(dump, len, out);
+    fclose(out);
+
+    return count;
+}
+
+static void* recorder_thread(void* arg)
+{
+    flight_recorder_record(200, (uint64_t)(uintptr_t)arg, 0);
+    return NULL;
+}
+
+static void* busy_recorder_thread(void* arg)
+{
+    (void)arg;
+
+    // Every record carries a value and its complement, so a torn one is easy to spot.
+    for (uint64_t i = 0; !atomic_load(&stop); i++) { flight_recorder_record(300, i, ~i); }
+
+    return NULL;
+}
+
+static int overflow_stack(int depth)
+{
+    volatile char frame[1024];
+
+    // Never true, but the compiler can't tell, so it keeps the recursion and doesn't warn about it.
+    frame[0] = 1;
+    if (frame[0] == 0) { return depth; }
+
+    return overflow_stack(depth + 1) + frame[0];
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void) { TEST_ASSERT_EQUAL_INT(0, flight_recorder_init()); }
+
+void tearDown(void) {}
+
+/// @test This test verifies that recorded events show up in the dump, in order, and are decoded as text.
+void test_record_dump_and_decode(void)
+{
+    char text[256];
+
+    flight_recorder_record(1, 0xA, 0xB);
+    flight_recorder_record(2, 0xC, 0xD);
+
+    size_t len = dump_to_memory();
+    TEST_ASSERT_EQUAL_UINT(sizeof(flight_recorder_header_t) + 2 * sizeof(flight_recorder_record_t), len);
+
+    // Dumping leaves the records in place.
+    TEST_ASSERT_EQUAL_UINT(len, dump_to_memory());
+
+    TEST_ASSERT_EQUAL_INT(2, decode_to_text(len, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING_LEN("[0 ns] thread=", text, 14);
+    TEST_ASSERT_NOT_NULL(strstr(text, "event=1 args=0xa,0xb"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "event=2 args=0xc,0xd"));
+    TEST_ASSERT(strstr(text, "event=1") < strstr(text, "event=2"));
+}
+
+/// @test This test verifies that only the most recent records are kept once a thread's ring wraps around.
+void test_overwrites_oldest_records(void)
+{
+    flight_recorder_record_t record;
+
+    for (uint64_t i = 0; i < FLIGHT_RECORDER_RECORDS + 10; i++) { flight_recorder_record(100, i, 0); }
+
+    size_t len = dump_to_memory();
+    TEST_ASSERT_EQUAL_UINT(sizeof(flight_recorder_header_t) + FLIGHT_RECORDER_RECORDS * sizeof(record), len);
+
+    // The oldest surviving record is number 10, the eleventh recorded.
+    memcpy(&record, &dump[sizeof(flight_recorder_header_t)], sizeof(record));
+    TEST_ASSERT_EQUAL_UINT64(10, record.args[0]);
+    TEST_ASSERT_EQUAL_UINT64(11, record.seq);
+}
+
+/// @test This test verifies that records from other threads are included in the dump.
+void test_records_from_several_threads(void)
+{
+    pthread_t thread;
+    flight_recorder_record_t record;
+
+    flight_recorder_record(1, 0, 0);
+    pthread_create(&thread, NULL, recorder_thread, (void*)(uintptr_t)42);
+    pthread_join(thread, NULL);
+
+    size_t len = dump_to_memory();
+    TEST_ASSERT_EQUAL_UINT(sizeof(flight_recorder_header_t) + 2 * sizeof(record), len);
+
+    memcpy(&record, &dump[sizeof(flight_recorder_header_t) + sizeof(record)], sizeof(record));
+    TEST_ASSERT_EQUAL_UINT32(200, record.event);
+    TEST_ASSERT_EQUAL_UINT64(42, record.args[0]);
+}
+
+/// @test This test verifies that threads give their slots back when they exit, keeping their records.
+void test_slots_are_recycled(void)
+{
+    pthread_t thread;
+    char text[8192];
+
+    for (uintptr_t i = 0; i < 4 * FLIGHT_RECORDER_MAX_THREADS; i++) {
+        pthread_create(&thread, NULL, recorder_thread, (void*)i);
+        pthread_join(thread, NULL);
+    }
+
+    size_t len = dump_to_memory();
+    TEST_ASSERT_EQUAL_INT(4 * FLIGHT_RECORDER_MAX_THREADS, decode_to_text(len, text, sizeof(text)));
+
+    char last[32];
+    snprintf(last, sizeof(last), "args=0x%x,0x0", 4 * FLIGHT_RECORDER_MAX_THREADS - 1);
+    TEST_ASSERT_NOT_NULL(strstr(text, last));
+}
+
+/// @test This test verifies that the crash handler dumps the records when the process aborts.
+void test_crash_handler_dumps_on_abort(void)
+{
+    FILE* tmp = tmpfile();
+    char text[256];
+    int status = 0;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        flight_recorder_install_crash_handler(fileno(tmp));
+        flight_recorder_record(7, 1, 2);
+        abort();
+    }
+
+    waitpid(pid, &status, 0);
+    TEST_ASSERT(WIFSIGNALED(status));
+    TEST_ASSERT_EQUAL_INT(SIGABRT, WTERMSIG(status));
+
+    rewind(tmp);
+    size_t len = fread(dump, 1, sizeof(dump), tmp);
+    fclose(tmp);
+
+    TEST_ASSERT_EQUAL_INT(1, decode_to_text(len, text, sizeof(text)));
+    TEST_ASSERT_NOT_NULL(strstr(text, "event=7 args=0x1,0x2"));
+}
+
+/// @test This test verifies that the crash handler still dumps the records after a stack overflow.
+void test_crash_handler_dumps_on_stack_overflow(void)
+{
+    FILE* tmp = tmpfile();
+    char text[256];
+    int status = 0;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        flight_recorder_install_crash_handler(fileno(tmp));
+        flight_recorder_record(8, 3, 4);
+        overflow_stack(0);
+        _exit(0);
+    }
+
+    waitpid(pid, &status, 0);
+    TEST_ASSERT(WIFSIGNALED(status));
+    TEST_ASSERT_EQUAL_INT(SIGSEGV, WTERMSIG(status));
+
+    rewind(tmp);
+    size_t len = fread(dump, 1, sizeof(dump), tmp);
+    fclose(tmp);
+
+    TEST_ASSERT_EQUAL_INT(1, decode_to_text(len, text, sizeof(text)));
+    TEST_ASSERT_NOT_NULL(strstr(text, "event=8 args=0x3,0x4"));
+}
+
+/// @test This test verifies that the decoder skips records marked as torn.
+void test_decode_skips_torn_records(void)
+{
+    flight_recorder_record_t record;
+    char text[256];
+
+    flight_recorder_record(1, 0, 0);
+    flight_recorder_record(2, 0, 0);
+    flight_recorder_record(3, 0, 0);
+
+    size_t len = dump_to_memory();
+    size_t offset = sizeof(flight_recorder_header_t) + sizeof(record);
+    memcpy(&record, &dump[offset], sizeof(record));
+    record.seq = 0;
+    memcpy(&dump[offset], &record, sizeof(record));
+
+    TEST_ASSERT_EQUAL_INT(2, decode_to_text(len, text, sizeof(text)));
+    TEST_ASSERT_NOT_NULL(strstr(text, "event=1"));
+    TEST_ASSERT_NULL(strstr(text, "event=2"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "event=3"));
+}
+
+/// @test This test verifies that a dump taken while another thread records holds no torn records.
+void test_dump_while_recording(void)
+{
+    pthread_t thread;
+    flight_recorder_record_t record;
+
+    atomic_store(&stop, false);
+    pthread_create(&thread, NULL, busy_recorder_thread, NULL);
+
+    for (int round = 0; round < 200; round++) {
+        size_t len = dump_to_memory();
+        for (size_t offset = sizeof(flight_recorder_header_t); offset + sizeof(record) <= len;
+             offset += sizeof(record)) {
+            memcpy(&record, &dump[offset], sizeof(record));
+            if (record.seq != 0) { TEST_ASSERT_EQUAL_UINT64(~record.args[0], record.args[1]); }
+        }
+    }
+
+    atomic_store(&stop, true);
+    pthread_join(thread, NULL);
+}
+
+/// @test This test verifies that the decoder rejects data that is not a dump.
+void test_decode_rejects_garbage(void)
+{
+    char text[64];
+
+    memset(dump, 0, 32);
+    TEST_ASSERT_EQUAL_INT(-1, decode_to_text(32, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("", text);
+}
+
+/* === End of documentation ==================================================================== */
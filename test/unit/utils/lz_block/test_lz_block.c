@@ -0,0 +1,131 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_lz_block.c
+ ** @brief Test suite for the LZ4-style block compression.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <string.h>
+#include <unity.h>
+
+#include <utils/lz_block/lz_block.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define DATA_SIZE 4096
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static uint8_t input[DATA_SIZE];
+static uint8_t compressed[DATA_SIZE * 2];
+static uint8_t output[DATA_SIZE];
+
+/* === Private function declarations =========================================================== */
+
+static void fill_random(uint8_t* data, size_t len);
+static size_t round_trip(size_t len);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void fill_random(uint8_t* data, size_t len)
+{
+    uint32_t state = 12345;
+
+    for (size_t i = 0; i < len; i++) {
+        state = state * 1103515245U + 12345U;
+        data[i] = (uint8_t)(state >> 16);
+    }
+}
+
+static size_t round_trip(size_t len)
+{
+    size_t stored = lz_block_compress(input, len, compressed, sizeof(compressed));
+
+    TEST_ASSERT(stored > 0);
+    TEST_ASSERT_EQUAL_INT((long)len, lz_block_decompress(compressed, stored, output, sizeof(output)));
+    TEST_ASSERT_EQUAL_MEMORY(input, output, len);
+
+    return stored;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    memset(input, 0, sizeof(input));
+    memset(output, 0, sizeof(output));
+}
+
+void tearDown(void) {}
+
+/// @test This test verifies that repetitive MIDI traffic shrinks and decompresses back unchanged.
+void test_repetitive_data(void)
+{
+    const uint8_t notes[] = {0x90, 0x3C, 0x64, 0x80, 0x3C, 0x00, 0xF8};
+
+    for (size_t i = 0; i < DATA_SIZE; i++) { input[i] = notes[i % sizeof(notes)]; }
+
+    TEST_ASSERT(round_trip(DATA_SIZE) < DATA_SIZE / 16);
+}
+
+/// @test This test verifies long runs, whose matches overlap their own output, and long literal stretches.
+void test_runs_and_literals(void)
+{
+    fill_random(input, DATA_SIZE / 2);
+    memset(&input[DATA_SIZE / 2], 0xF8, DATA_SIZE / 2);
+
+    TEST_ASSERT(round_trip(DATA_SIZE) < DATA_SIZE / 2 + 64);
+}
+
+/// @test This test verifies short and incompressible inputs, and that a small destination is reported.
+void test_incompressible_data(void)
+{
+    fill_random(input, DATA_SIZE);
+
+    round_trip(0);
+    round_trip(5);
+    TEST_ASSERT(round_trip(DATA_SIZE) > DATA_SIZE);
+    TEST_ASSERT_EQUAL_UINT(0, lz_block_compress(input, DATA_SIZE, compressed, DATA_SIZE - 1));
+}
+
+/// @test This test verifies that corrupted or truncated blocks are rejected instead of overrunning buffers.
+void test_corrupted_data(void)
+{
+    const uint8_t notes[] = {0x90, 0x3C, 0x64};
+
+    for (size_t i = 0; i < DATA_SIZE; i++) { input[i] = notes[i % sizeof(notes)]; }
+    size_t stored = lz_block_compress(input, DATA_SIZE, compressed, sizeof(compressed));
+
+    TEST_ASSERT_EQUAL_INT(-1, lz_block_decompress(compressed, stored, output, DATA_SIZE - 1));
+    TEST_ASSERT_EQUAL_INT(-1, lz_block_decompress(compressed, 5, output, sizeof(output)));
+
+    // First sequence pointing before the start of the output.
+    const uint8_t bad_offset[] = {0x10, 0x90, 0x05, 0x00};
+    TEST_ASSERT_EQUAL_INT(-1, lz_block_decompress(bad_offset, sizeof(bad_offset), output, sizeof(output)));
+}
+
+/* === End of documentation ==================================================================== */
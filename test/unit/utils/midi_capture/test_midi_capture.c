@@ -0,0 +1,334 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_midi_capture.c
+ ** @brief Test suite for the binary MIDI capture.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/lz_block/lz_block.h>
+#include <utils/midi_capture/midi_capture.h>
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define CAPTURE_SIZE (4 * MIDI_CAPTURE_BLOCK_SIZE)
+
+#define STREAM_RING_SIZE 2048
+
+/// Records in the indexed capture, spread over a dozen blocks.
+#define INDEXED_RECORDS 100000
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static FILE* file = NULL;
+static midi_capture_t cap = NULL;
+static uint8_t capture[CAPTURE_SIZE];
+static char path[64];
+
+/* === Private function declarations =========================================================== */
+
+static size_t load_capture(void);
+static void write_indexed_capture(void);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static size_t load_capture(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, midi_capture_flush(cap));
+
+    long len = ftell(file);
+    TEST_ASSERT(len >= 0 && len <= CAPTURE_SIZE);
+    rewind(file);
+    TEST_ASSERT_EQUAL_UINT((size_t)len, fread(capture, 1, (size_t)len, file));
+
+    return (size_t)len;
+}
+
+static void write_indexed_capture(void)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    TEST_ASSERT(fd >= 0);
+
+    // Port 1 sends a note every millisecond, port 0 receives clock in between.
+    midi_capture_t writer = midi_capture_init(fd, false);
+    for (uint64_t i = 0; i < INDEXED_RECORDS; i++) {
+        const uint8_t note[] = {0x90, (uint8_t)(i & 0x7F), 0x64};
+        const uint8_t clock[] = {0xF8};
+
+        if (i % 2) {
+            TEST_ASSERT_EQUAL_INT(0, midi_capture_record(writer, 0, MIDI_CAPTURE_RX, i * 500, clock, sizeof(clock)));
+        } else {
+            TEST_ASSERT_EQUAL_INT(0, midi_capture_record(writer, 1, MIDI_CAPTURE_TX, i * 500, note, sizeof(note)));
+        }
+    }
+    midi_capture_deinit(&writer);
+    close(fd);
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    file = tmpfile();
+    snprintf(path, sizeof(path), "/tmp/test_midi_capture.%d", (int)getpid());
+}
+
+void tearDown(void)
+{
+    midi_capture_deinit(&cap);
+    fclose(file);
+    unlink(path);
+}
+
+/// @test This test verifies that records come back with their port, direction, timestamp and bytes.
+void test_record_and_read_back(void)
+{
+    const uint8_t note[] = {0x90, 0x3C, 0x64};
+    const uint8_t clock[] = {0xF8};
+    midi_capture_record_t record;
+
+    cap = midi_capture_init(fileno(file), false);
+    TEST_ASSERT_EQUAL_INT(0, midi_capture_record(cap, 3, MIDI_CAPTURE_TX, 1000000, note, sizeof(note)));
+    TEST_ASSERT_EQUAL_INT(0, midi_capture_record(cap, 31, MIDI_CAPTURE_RX, 1000320, clock, sizeof(clock)));
+    // Earlier timestamps, e.g. from another drain, are clamped.
+    TEST_ASSERT_EQUAL_INT(0, midi_capture_record(cap, 0, MIDI_CAPTURE_TX, 999000, clock, sizeof(clock)));
+
+    size_t len = load_capture();
+    TEST_ASSERT_EQUAL_UINT(MIDI_CAPTURE_HEADER_SIZE + 6 + 5 + 4, len);
+
+    midi_capture_reader_t reader = midi_capture_reader_init(capture, len);
+
+    TEST_ASSERT_TRUE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT64(1000000, record.timestamp_ns);
+    TEST_ASSERT_EQUAL_UINT8(3, record.port);
+    TEST_ASSERT_EQUAL_INT(MIDI_CAPTURE_TX, record.dir);
+    TEST_ASSERT_EQUAL_UINT(sizeof(note), record.len);
+    TEST_ASSERT_EQUAL_MEMORY(note, record.data, sizeof(note));
+
+    TEST_ASSERT_TRUE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT64(1000320, record.timestamp_ns);
+    TEST_ASSERT_EQUAL_UINT8(31, record.port);
+    TEST_ASSERT_EQUAL_INT(MIDI_CAPTURE_RX, record.dir);
+
+    TEST_ASSERT_TRUE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT64(1000320, record.timestamp_ns);
+
+    TEST_ASSERT_FALSE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT(0, midi_capture_reader_skipped(reader));
+    midi_capture_reader_deinit(&reader);
+}
+
+/// @test This test verifies that full blocks are written out and compressed, and long chunks are split.
+void test_compressed_blocks(void)
+{
+    const uint8_t note[] = {0x90, 0x3C, 0x64};
+    uint8_t chunk[MIDI_CAPTURE_MAX_RECORD + 10];
+    midi_capture_stats_t stats;
+    midi_capture_record_t record;
+    size_t count = 0;
+
+    memset(chunk, 0xFE, sizeof(chunk));
+    cap = midi_capture_init(fileno(file), true);
+
+    for (uint64_t t = 0; t < 30000; t++) { TEST_ASSERT_EQUAL_INT(0, midi_capture_record(cap, 1, 0, t * 960, note, 3)); }
+    TEST_ASSERT_EQUAL_INT(0, midi_capture_record(cap, 2, MIDI_CAPTURE_RX, 30000 * 960, chunk, sizeof(chunk)));
+
+    size_t len = load_capture();
+    midi_capture_get_stats(cap, &stats);
+    TEST_ASSERT_EQUAL_UINT64(30002, stats.records);
+    TEST_ASSERT(stats.blocks >= 3);
+    TEST_ASSERT_EQUAL_UINT64(len, stats.written_bytes);
+    TEST_ASSERT(stats.written_bytes < stats.raw_bytes / 8);
+
+    midi_capture_reader_t reader = midi_capture_reader_init(capture, len);
+    for (; count < 30000 && midi_capture_reader_next(reader, &record); count++) {
+        TEST_ASSERT_EQUAL_UINT64(count * 960, record.timestamp_ns);
+        TEST_ASSERT_EQUAL_MEMORY(note, record.data, sizeof(note));
+    }
+    TEST_ASSERT_EQUAL_UINT(30000, count);
+
+    TEST_ASSERT_TRUE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT(MIDI_CAPTURE_MAX_RECORD, record.len);
+    TEST_ASSERT_TRUE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT(10, record.len);
+    TEST_ASSERT_EQUAL_UINT64(30000 * 960, record.timestamp_ns);
+    TEST_ASSERT_FALSE(midi_capture_reader_next(reader, &record));
+    midi_capture_reader_deinit(&reader);
+}
+
+/// @test This test verifies that the reader skips a damaged block and resynchronizes on the next one.
+void test_resync_after_damage(void)
+{
+    const uint8_t note[] = {0x90, 0x3C, 0x64};
+    midi_capture_record_t record;
+    uint64_t seen[4];
+    size_t count = 0;
+
+    cap = midi_capture_init(fileno(file), false);
+    for (uint64_t block = 0; block < 3; block++) {
+        TEST_ASSERT_EQUAL_INT(0, midi_capture_record(cap, 0, MIDI_CAPTURE_TX, block * 1000, note, sizeof(note)));
+        TEST_ASSERT_EQUAL_INT(0, midi_capture_flush(cap));
+    }
+
+    size_t len = load_capture();
+    size_t block_len = len / 3;
+    capture[block_len + MIDI_CAPTURE_HEADER_SIZE + 3] ^= 0xFF;
+
+    midi_capture_reader_t reader = midi_capture_reader_init(capture, len);
+    while (count < 4 && midi_capture_reader_next(reader, &record)) { seen[count++] = record.timestamp_ns; }
+
+    TEST_ASSERT_EQUAL_UINT(2, count);
+    TEST_ASSERT_EQUAL_UINT64(0, seen[0]);
+    TEST_ASSERT_EQUAL_UINT64(2000, seen[1]);
+    TEST_ASSERT_EQUAL_UINT(block_len, midi_capture_reader_skipped(reader));
+    midi_capture_reader_deinit(&reader);
+}
+
+/// @test This test verifies that the footer index is written and used to seek into a mapped capture.
+void test_seek_with_index(void)
+{
+    midi_capture_record_t record;
+
+    write_indexed_capture();
+    midi_capture_reader_t reader = midi_capture_reader_open(path);
+    TEST_ASSERT_NOT_NULL(reader);
+    TEST_ASSERT_TRUE(midi_capture_reader_indexed(reader));
+
+    TEST_ASSERT_TRUE(midi_capture_reader_seek(reader, 54321 * 500 + 1));
+    TEST_ASSERT_TRUE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT64(54322 * 500, record.timestamp_ns);
+    TEST_ASSERT_EQUAL_UINT8(1, record.port);
+    TEST_ASSERT_EQUAL_UINT8(54322 & 0x7F, record.data[1]);
+    TEST_ASSERT_TRUE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT64(54323 * 500, record.timestamp_ns);
+
+    TEST_ASSERT_TRUE(midi_capture_reader_seek(reader, 0));
+    TEST_ASSERT_TRUE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT64(0, record.timestamp_ns);
+
+    TEST_ASSERT_FALSE(midi_capture_reader_seek(reader, INDEXED_RECORDS * 500));
+    TEST_ASSERT_FALSE(midi_capture_reader_next(reader, &record));
+
+    // The footer is not mistaken for damaged blocks.
+    TEST_ASSERT_EQUAL_UINT(0, midi_capture_reader_skipped(reader));
+    midi_capture_reader_deinit(&reader);
+
+    TEST_ASSERT_NULL(midi_capture_reader_open("/tmp/test_midi_capture.missing"));
+}
+
+/// @test This test verifies that an index pointing past its own footer is ignored, seeking by scanning instead.
+void test_index_out_of_bounds(void)
+{
+    const uint8_t note[] = {0x90, 0x3C, 0x64};
+    midi_capture_record_t record;
+
+    cap = midi_capture_init(fileno(file), false);
+    for (uint64_t block = 0; block < 3; block++) {
+        TEST_ASSERT_EQUAL_INT(0, midi_capture_record(cap, 0, MIDI_CAPTURE_TX, block * 1000, note, sizeof(note)));
+        TEST_ASSERT_EQUAL_INT(0, midi_capture_flush(cap));
+    }
+    midi_capture_deinit(&cap);
+
+    off_t len = lseek(fileno(file), 0, SEEK_END);
+    TEST_ASSERT(len > 0 && len <= CAPTURE_SIZE);
+    TEST_ASSERT_EQUAL_INT((int)len, pread(fileno(file), capture, (size_t)len, 0));
+
+    // Point the second block past the end of the capture, with a matching FNV-1a checksum. The trailer starts with
+    // the index offset and holds the checksum at byte 12, both little-endian.
+    uint8_t* trailer = &capture[len - MIDI_CAPTURE_TRAILER_SIZE];
+    uint32_t checksum = 2166136261U;
+    size_t offset = 0;
+
+    for (size_t i = 0; i < 8; i++) { offset |= (size_t)trailer[i] << (8 * i); }
+    uint8_t* index = &capture[offset];
+    memset(&index[MIDI_CAPTURE_INDEX_ENTRY_SIZE + 8], 0xFF, 8);
+    for (size_t i = 0; i < 3 * MIDI_CAPTURE_INDEX_ENTRY_SIZE; i++) { checksum = (checksum ^ index[i]) * 16777619U; }
+    for (size_t i = 0; i < 4; i++) { trailer[12 + i] = (uint8_t)(checksum >> (8 * i)); }
+
+    midi_capture_reader_t reader = midi_capture_reader_init(capture, (size_t)len);
+    TEST_ASSERT_FALSE(midi_capture_reader_indexed(reader));
+    TEST_ASSERT_TRUE(midi_capture_reader_seek(reader, 2000));
+    TEST_ASSERT_TRUE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT64(2000, record.timestamp_ns);
+    midi_capture_reader_deinit(&reader);
+}
+
+/// @test This test verifies that seeking still works by scanning a capture without index.
+void test_seek_without_index(void)
+{
+    const uint8_t clock[] = {0xF8};
+    midi_capture_record_t record;
+
+    cap = midi_capture_init(fileno(file), true);
+    for (uint64_t t = 0; t < 1000; t++) { midi_capture_record(cap, 0, MIDI_CAPTURE_RX, t * 10, clock, 1); }
+
+    midi_capture_reader_t reader = midi_capture_reader_init(capture, load_capture());
+    TEST_ASSERT_FALSE(midi_capture_reader_indexed(reader));
+    TEST_ASSERT_TRUE(midi_capture_reader_seek(reader, 5000));
+    TEST_ASSERT_TRUE(midi_capture_reader_next(reader, &record));
+    TEST_ASSERT_EQUAL_UINT64(5000, record.timestamp_ns);
+    midi_capture_reader_deinit(&reader);
+}
+
+/// @test This test verifies that records of one port are streamed into a ring, resuming once it drains.
+void test_stream_into_ring(void)
+{
+    uint8_t container[STREAM_RING_SIZE];
+    uint8_t data[STREAM_RING_SIZE];
+    spsc_ring_t ring = spsc_ring_init(container, STREAM_RING_SIZE);
+    size_t total = 0;
+
+    write_indexed_capture();
+    midi_capture_reader_t reader = midi_capture_reader_open(path);
+    TEST_ASSERT_TRUE(midi_capture_reader_seek(reader, 1000 * 500));
+
+    // Only whole notes fit: 682 of them in 2048 bytes.
+    size_t count = midi_capture_reader_stream(reader, ring, 1, MIDI_CAPTURE_TX);
+    TEST_ASSERT_EQUAL_UINT(STREAM_RING_SIZE / 3, count);
+    TEST_ASSERT_EQUAL_UINT(count * 3, spsc_ring_read(ring, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_HEX8(0x90, data[0]);
+    TEST_ASSERT_EQUAL_HEX8(1000 & 0x7F, data[1]);
+
+    for (total = count; count > 0; total += count) {
+        count = midi_capture_reader_stream(reader, ring, 1, MIDI_CAPTURE_TX);
+        spsc_ring_read(ring, data, sizeof(data));
+    }
+    TEST_ASSERT_EQUAL_UINT((INDEXED_RECORDS - 1000) / 2, total);
+
+    midi_capture_reader_deinit(&reader);
+    spsc_ring_deinit(&ring);
+}
+
+/* === End of documentation ==================================================================== */
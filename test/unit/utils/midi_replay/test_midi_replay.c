@@ -0,0 +1,239 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_midi_replay.c
+ ** @brief Test suite for the capture replay engine.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/lz_block/lz_block.h>
+#include <utils/midi_capture/midi_capture.h>
+#include <utils/midi_replay/midi_replay.h>
+#include <utils/ring_buffer/ring_buffer.h>
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/tsc_clock/tsc_clock.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define PORT_COUNT 2
+
+#define RX_RING_SIZE 64
+
+#define TX_RING_SIZE 16
+
+/// Notes in the capture, one every NOTE_GAP_NS.
+#define NOTES 10
+
+#define NOTE_GAP_NS 10000000ULL
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static char path[64];
+static ring_buffer_t rx[PORT_COUNT];
+static uint8_t rx_containers[PORT_COUNT][RX_RING_SIZE];
+static midi_replay_t replay = NULL;
+
+/* === Private function declarations =========================================================== */
+
+static void write_capture(void);
+static void transpose_port0(void);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void write_capture(void)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    TEST_ASSERT(fd >= 0);
+
+    // Port 0 receives notes and sends them an octave up, port 1 receives clock.
+    midi_capture_t cap = midi_capture_init(fd, true);
+    for (uint8_t i = 0; i < NOTES; i++) {
+        const uint8_t in[] = {0x90, (uint8_t)(60 + i), 100};
+        const uint8_t out[] = {0x90, (uint8_t)(72 + i), 100};
+        const uint8_t clock[] = {0xF8};
+        uint64_t t = i * NOTE_GAP_NS;
+
+        midi_capture_record(cap, 0, MIDI_CAPTURE_RX, t, in, sizeof(in));
+        midi_capture_record(cap, 1, MIDI_CAPTURE_RX, t, clock, sizeof(clock));
+        midi_capture_record(cap, 0, MIDI_CAPTURE_TX, t + 1000, out, sizeof(out));
+    }
+    midi_capture_deinit(&cap);
+    close(fd);
+}
+
+static void transpose_port0(void)
+{
+    // Stand-in for the pipeline under test.
+    uint8_t data[RX_RING_SIZE];
+    size_t len = ring_buffer_read(rx[0], data, sizeof(data));
+
+    for (size_t i = 1; i < len; i += 3) { data[i] += 12; }
+    TEST_ASSERT_EQUAL_INT(0, midi_replay_check(replay, 0, data, len));
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    snprintf(path, sizeof(path), "/tmp/test_midi_replay.%d", (int)getpid());
+    for (size_t i = 0; i < PORT_COUNT; i++) { rx[i] = ring_buffer_init(rx_containers[i], RX_RING_SIZE); }
+    write_capture();
+}
+
+void tearDown(void)
+{
+    midi_replay_deinit(&replay);
+    for (size_t i = 0; i < PORT_COUNT; i++) { ring_buffer_deinit(&rx[i]); }
+    unlink(path);
+}
+
+/// @test This test verifies that a fast replay feeds every RX record to its port, in order.
+void test_fast_replay(void)
+{
+    midi_replay_config_t config = {.mode = MIDI_REPLAY_FAST, .port_count = PORT_COUNT, .rx = rx};
+    midi_replay_stats_t stats;
+    uint8_t data[RX_RING_SIZE];
+
+    TEST_ASSERT_NULL(midi_replay_init("/tmp/test_midi_replay.missing", &config));
+    replay = midi_replay_init(path, &config);
+    TEST_ASSERT_NOT_NULL(replay);
+
+    TEST_ASSERT_EQUAL_UINT(5, midi_replay_poll(replay, 5));
+    TEST_ASSERT_EQUAL_UINT(2 * NOTES - 5, midi_replay_poll(replay, 100));
+    TEST_ASSERT_TRUE(midi_replay_done(replay));
+
+    TEST_ASSERT_EQUAL_UINT(3 * NOTES, ring_buffer_read(rx[0], data, sizeof(data)));
+    TEST_ASSERT_EQUAL_HEX8(0x90, data[0]);
+    TEST_ASSERT_EQUAL_UINT8(60 + NOTES - 1, data[3 * NOTES - 2]);
+    TEST_ASSERT_EQUAL_UINT(NOTES, ring_buffer_read(rx[1], data, sizeof(data)));
+
+    midi_replay_get_stats(replay, &stats);
+    TEST_ASSERT_EQUAL_UINT64(2 * NOTES, stats.records);
+    TEST_ASSERT_EQUAL_UINT64(4 * NOTES, stats.bytes);
+    TEST_ASSERT_EQUAL_UINT64((NOTES - 1) * NOTE_GAP_NS, stats.span_ns);
+}
+
+/// @test This test verifies that a paced replay follows the capture timing, from the requested start.
+void test_paced_replay(void)
+{
+    midi_replay_config_t config = {
+        .mode = MIDI_REPLAY_PACED, .start_ns = 5 * NOTE_GAP_NS, .port_count = PORT_COUNT, .rx = rx};
+    uint8_t data[RX_RING_SIZE];
+
+    replay = midi_replay_init(path, &config);
+
+    TEST_ASSERT_EQUAL_UINT(2, midi_replay_poll(replay, 100));
+    TEST_ASSERT_EQUAL_UINT(3, ring_buffer_read(rx[0], data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT8(65, data[1]);
+    TEST_ASSERT_EQUAL_UINT(0, midi_replay_poll(replay, 100));
+
+    usleep(NOTE_GAP_NS / 1000 + 2000);
+    TEST_ASSERT(midi_replay_poll(replay, 100) >= 2);
+    TEST_ASSERT_FALSE(midi_replay_done(replay));
+}
+
+/// @test This test verifies that output matching the recorded TX traffic passes the check, and extra output does not.
+void test_check_matching_output(void)
+{
+    midi_replay_config_t config = {.mode = MIDI_REPLAY_FAST, .port_count = PORT_COUNT, .rx = rx, .check = true};
+    midi_replay_divergence_t divergence;
+    midi_replay_stats_t stats;
+
+    replay = midi_replay_init(path, &config);
+    while (!midi_replay_done(replay)) {
+        midi_replay_poll(replay, 4);
+        transpose_port0();
+    }
+
+    midi_replay_get_stats(replay, &stats);
+    TEST_ASSERT_EQUAL_UINT64(3 * NOTES, stats.checked);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.divergent_ports);
+    TEST_ASSERT_FALSE(midi_replay_divergence(replay, 0, &divergence));
+
+    TEST_ASSERT_EQUAL_INT(-1, midi_replay_check(replay, 0, (const uint8_t[]){0xF8}, 1));
+    TEST_ASSERT_TRUE(midi_replay_divergence(replay, 0, &divergence));
+    TEST_ASSERT_EQUAL_UINT64(3 * NOTES, divergence.offset);
+    TEST_ASSERT_EQUAL_INT(-1, divergence.expected);
+}
+
+/// @test This test verifies that the first divergent byte is reported with its position and capture time.
+void test_check_divergence(void)
+{
+    midi_replay_config_t config = {.mode = MIDI_REPLAY_FAST, .port_count = PORT_COUNT, .rx = rx, .check = true};
+    const uint8_t output[] = {0x90, 72, 100, 0x90, 73, 100, 0x90, 74, 100, 0x90, 99, 100};
+    midi_replay_divergence_t divergence;
+    midi_replay_stats_t stats;
+
+    replay = midi_replay_init(path, &config);
+
+    TEST_ASSERT_EQUAL_INT(-1, midi_replay_check(replay, 0, output, sizeof(output)));
+    TEST_ASSERT_TRUE(midi_replay_divergence(replay, 0, &divergence));
+    TEST_ASSERT_EQUAL_UINT64(10, divergence.offset);
+    TEST_ASSERT_EQUAL_UINT64(3 * NOTE_GAP_NS + 1000, divergence.timestamp_ns);
+    TEST_ASSERT_EQUAL_INT(75, divergence.expected);
+    TEST_ASSERT_EQUAL_UINT8(99, divergence.actual);
+
+    // The port stays diverged, the other ones are unaffected.
+    TEST_ASSERT_EQUAL_INT(-1, midi_replay_check(replay, 0, output, 3));
+    TEST_ASSERT_FALSE(midi_replay_divergence(replay, 1, &divergence));
+    midi_replay_get_stats(replay, &stats);
+    TEST_ASSERT_EQUAL_UINT64(10, stats.checked);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.divergent_ports);
+}
+
+/// @test This test verifies that recorded TX traffic is injected into the TX rings, pausing while they are full.
+void test_tx_injection(void)
+{
+    uint8_t container[TX_RING_SIZE];
+    uint8_t data[TX_RING_SIZE];
+    spsc_ring_t tx[PORT_COUNT] = {spsc_ring_init(container, TX_RING_SIZE), NULL};
+    midi_replay_config_t config = {.mode = MIDI_REPLAY_FAST, .port_count = PORT_COUNT, .tx = tx};
+    size_t total = 0;
+
+    replay = midi_replay_init(path, &config);
+
+    TEST_ASSERT_EQUAL_UINT(TX_RING_SIZE / 3, midi_replay_poll(replay, 100));
+    TEST_ASSERT_EQUAL_UINT(0, midi_replay_poll(replay, 100));
+
+    for (total = TX_RING_SIZE / 3; !midi_replay_done(replay);) {
+        spsc_ring_read(tx[0], data, sizeof(data));
+        total += midi_replay_poll(replay, 100);
+    }
+    TEST_ASSERT_EQUAL_UINT(NOTES, total);
+
+    size_t len = spsc_ring_read(tx[0], data, sizeof(data));
+    TEST_ASSERT_EQUAL_UINT8(72 + NOTES - 1, data[len - 2]);
+    spsc_ring_deinit(&tx[0]);
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,152 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_obj_pool.c
+ ** @brief Test suite for the static object pools.
+ **
+ ** The heap flavour is exercised by every module's test suite. This one builds the pools used with
+ ** UTILS_NO_HEAP.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#ifndef UTILS_NO_HEAP
+#define UTILS_NO_HEAP
+#endif
+
+#include <pthread.h>
+#include <stdint.h>
+#include <unity.h>
+
+#include "alloc_tracker.h"
+#include <utils/obj_pool/obj_pool.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define POOL_SIZE 4
+
+#define THREADS 4
+
+#define ROUNDS 20000
+
+/* === Private data type declarations ========================================================== */
+
+typedef struct
+{
+    _Alignas(64) uint32_t owner;
+    uint8_t payload[40];
+} item_t;
+
+/* === Private variable declarations =========================================================== */
+
+static port_atomic_size_t clashes;
+
+/* === Private function declarations =========================================================== */
+
+static void* churn(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+OBJ_POOL_DEFINE(item_pool, item_t, POOL_SIZE)
+
+/* === Private function implementation ========================================================= */
+
+static void* churn(void* arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+
+    for (size_t i = 0; i < ROUNDS; i++) {
+        item_t* item = item_pool_take();
+        if (!item) { continue; }
+
+        // Nobody else may see the slot while it is taken.
+        item->owner = id;
+        for (volatile int spin = 0; spin < 16; spin++) {}
+        if (item->owner != id) { PORT_ATOMIC_FETCH_ADD(&clashes, 1, PORT_ATOMIC_RELAXED); }
+        item_pool_give(item);
+    }
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void) { alloc_tracker_reset(); }
+
+void tearDown(void) {}
+
+/// @test This test verifies that the pool hands out distinct, aligned, zeroed objects without using the heap.
+void test_take(void)
+{
+    item_t* items[POOL_SIZE];
+
+    for (size_t i = 0; i < POOL_SIZE; i++) {
+        items[i] = item_pool_take();
+        TEST_ASSERT_NOT_NULL(items[i]);
+        TEST_ASSERT_EQUAL_UINT(0, (uintptr_t)items[i] % _Alignof(item_t));
+        TEST_ASSERT_EQUAL_UINT32(0, items[i]->owner);
+        for (size_t j = 0; j < i; j++) { TEST_ASSERT_TRUE(items[i] != items[j]); }
+    }
+    TEST_ASSERT_EQUAL_UINT(0, alloc_tracker_allocations());
+
+    for (size_t i = 0; i < POOL_SIZE; i++) { item_pool_give(items[i]); }
+}
+
+/// @test This test verifies that an exhausted pool returns NULL until an object is given back.
+void test_exhaustion(void)
+{
+    item_t* items[POOL_SIZE];
+
+    for (size_t i = 0; i < POOL_SIZE; i++) { items[i] = item_pool_take(); }
+    TEST_ASSERT_NULL(item_pool_take());
+
+    items[2]->owner = 7;
+    item_pool_give(items[2]);
+    item_pool_give(NULL);
+
+    // The freed slot is the one reused, cleared.
+    item_t* again = item_pool_take();
+    TEST_ASSERT_EQUAL_PTR(items[2], again);
+    TEST_ASSERT_EQUAL_UINT32(0, again->owner);
+    TEST_ASSERT_NULL(item_pool_take());
+
+    for (size_t i = 0; i < POOL_SIZE; i++) { item_pool_give(items[i]); }
+}
+
+/// @test This test verifies that concurrent takers never share a slot.
+void test_concurrent_take(void)
+{
+    pthread_t threads[THREADS];
+
+    PORT_ATOMIC_STORE(&clashes, 0, PORT_ATOMIC_RELAXED);
+    for (size_t i = 0; i < THREADS; i++) { pthread_create(&threads[i], NULL, churn, (void*)(uintptr_t)(i + 1)); }
+    for (size_t i = 0; i < THREADS; i++) { pthread_join(threads[i], NULL); }
+
+    TEST_ASSERT_EQUAL_UINT(0, PORT_ATOMIC_LOAD(&clashes, PORT_ATOMIC_RELAXED));
+
+    // Everything was given back.
+    item_t* items[POOL_SIZE];
+    for (size_t i = 0; i < POOL_SIZE; i++) { TEST_ASSERT_NOT_NULL(items[i] = item_pool_take()); }
+    for (size_t i = 0; i < POOL_SIZE; i++) { item_pool_give(items[i]); }
+}
+
+/* === End of documentation ==================================================================== */
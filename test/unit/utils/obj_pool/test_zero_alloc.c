@@ -0,0 +1,218 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_zero_alloc.c
+ ** @brief Checks that the hot paths of the library do not touch the heap.
+ **
+ ** Each scenario sets its modules up, warms them up, declares the steady state reached and then runs
+ ** traffic through them, failing if anything is allocated meanwhile. Built with UTILS_NO_HEAP, the
+ ** scenarios also check that setting up did not allocate either.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "alloc_tracker.h"
+#include <utils/async_log/async_log.h>
+#include <utils/lz_block/lz_block.h>
+#include <utils/midi_capture/midi_capture.h>
+#include <utils/ring_buffer/ring_buffer.h>
+#include <utils/seq_ring/seq_ring.h>
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/tsc_clock/tsc_clock.h>
+#include <utils/tx_drain/tx_drain.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define RING_SIZE 1024
+
+#define MAX_BATCH 256
+
+/// Iterations of steady-state traffic per scenario.
+#define ROUNDS 2000
+
+#define ENTRY_COUNT 64
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static uint8_t ring_container[RING_SIZE];
+static uint8_t batch[MAX_BATCH];
+static size_t sunk;
+
+/* === Private function declarations =========================================================== */
+
+static int count_sink(void* ctx, const uint8_t* data, size_t len);
+static void assert_steady(void);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static int count_sink(void* ctx, const uint8_t* data, size_t len)
+{
+    (void)ctx;
+    (void)data;
+    sunk += len;
+    return 0;
+}
+
+static void assert_steady(void)
+{
+    TEST_ASSERT_EQUAL_UINT(0, alloc_tracker_violations());
+#if defined(UTILS_NO_HEAP)
+    TEST_ASSERT_EQUAL_UINT(0, alloc_tracker_allocations());
+#endif
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    tsc_clock_init();
+    alloc_tracker_reset();
+    sunk = 0;
+}
+
+void tearDown(void) {}
+
+/// @test This test verifies that the MIDI TX path, a ring with statistics and a wait strategy drained in batches,
+/// does not allocate.
+void test_tx_path(void)
+{
+    const tx_drain_config_t config = {.max_batch = MAX_BATCH, .max_latency_us = 0};
+    uint8_t message[3] = {0x90, 0x3C, 0x40};
+    uint8_t byte;
+
+    spsc_ring_t ring = spsc_ring_init(ring_container, RING_SIZE);
+    wait_strategy_t ws = wait_strategy_init(WAIT_STRATEGY_PARK, 64);
+    spsc_ring_enable_stats(ring);
+    spsc_ring_set_wait_strategy(ring, ws);
+    tx_drain_t drain = tx_drain_init(ring, &config, batch, count_sink, NULL);
+
+    alloc_tracker_steady_state();
+    for (size_t i = 0; i < ROUNDS; i++) {
+        spsc_ring_write(ring, message, sizeof(message));
+        spsc_ring_write_byte(ring, 0xF8);
+        spsc_ring_read_byte_wait(ring, &byte);
+        while (tx_drain_poll(drain) > 0) {}
+    }
+    assert_steady();
+    TEST_ASSERT_EQUAL_UINT(ROUNDS * sizeof(message), sunk);
+
+    tx_drain_deinit(&drain);
+    spsc_ring_deinit(&ring);
+    wait_strategy_deinit(&ws);
+}
+
+/// @test This test verifies that the single-threaded ring does not allocate.
+void test_ring_buffer(void)
+{
+    uint8_t data[48];
+    uint8_t out[48];
+
+    memset(data, 0x5A, sizeof(data));
+    ring_buffer_t ring = ring_buffer_init(ring_container, RING_SIZE);
+
+    alloc_tracker_steady_state();
+    for (size_t i = 0; i < ROUNDS; i++) {
+        ring_buffer_write(ring, data, sizeof(data));
+        ring_buffer_write_byte(ring, (uint8_t)i);
+        TEST_ASSERT_EQUAL_UINT(sizeof(out), ring_buffer_read(ring, out, sizeof(out)));
+        TEST_ASSERT_EQUAL_INT(0, ring_buffer_read_byte(ring, out));
+    }
+    assert_steady();
+
+    ring_buffer_deinit(&ring);
+}
+
+/// @test This test verifies that moving entries through a multi-stage sequenced ring does not allocate.
+void test_seq_ring(void)
+{
+    static uint32_t entries[ENTRY_COUNT];
+    seq_ring_t ring = seq_ring_init(entries, sizeof(uint32_t), ENTRY_COUNT, 3);
+
+    alloc_tracker_steady_state();
+    for (size_t i = 0; i < ROUNDS; i++) {
+        for (size_t stage = 0; stage < 3; stage++) {
+            size_t seq = seq_ring_cursor(ring, stage);
+            size_t n = seq_ring_available(ring, stage);
+
+            for (size_t j = 0; j < n; j++) { *(uint32_t*)seq_ring_entry(ring, seq + j) += 1; }
+            seq_ring_advance(ring, stage, n);
+        }
+    }
+    assert_steady();
+
+    seq_ring_deinit(&ring);
+}
+
+/// @test This test verifies that logging does not allocate once the thread has logged once.
+void test_async_log(void)
+{
+    FILE* file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_INT(0, async_log_init(fileno(file)));
+
+    // The first record sets up the calling thread's ring, from the heap unless built with UTILS_NO_HEAP.
+    ASYNC_LOG("warm up\n");
+
+    alloc_tracker_steady_state();
+    for (uint64_t i = 0; i < ROUNDS; i++) { ASYNC_LOG("record %" PRIu64 " of %" PRIu64 "\n", i, (uint64_t)ROUNDS); }
+    assert_steady();
+
+    async_log_deinit();
+    fclose(file);
+}
+
+/// @test This test verifies that recording a capture does not allocate while its time index has room.
+void test_midi_capture(void)
+{
+    const uint8_t note[3] = {0x90, 0x40, 0x7F};
+    midi_capture_stats_t stats;
+
+    FILE* file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    midi_capture_t cap = midi_capture_init(fileno(file), true);
+
+    alloc_tracker_steady_state();
+    for (uint64_t i = 0; i < 20 * ROUNDS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, midi_capture_record(cap, (uint8_t)(i % 4), MIDI_CAPTURE_TX, i * 1000, note, 3));
+    }
+    TEST_ASSERT_EQUAL_INT(0, midi_capture_flush(cap));
+    assert_steady();
+
+    // Several blocks went out, each one indexed.
+    midi_capture_get_stats(cap, &stats);
+    TEST_ASSERT_TRUE(stats.blocks > 1);
+
+    midi_capture_deinit(&cap);
+    fclose(file);
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,222 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_pipeline.c
+ ** @brief Test suite for the compile-time pipeline builder.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <sched.h>
+#include <stddef.h>
+#include <unity.h>
+
+#include <utils/pipeline/pipeline.h>
+#include <utils/seq_ring/seq_ring.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define ENTRY_COUNT 8
+
+#define TRANSFER_COUNT 4096
+
+/* === Private data type declarations ========================================================== */
+
+typedef struct
+{
+    uint32_t value;
+    uint32_t trace;
+} entry_t;
+
+/* === Private variable declarations =========================================================== */
+
+static entry_t entries[ENTRY_COUNT];
+
+/* === Private function declarations =========================================================== */
+
+static inline void increment(entry_t* entry);
+static inline void twice(entry_t* entry);
+static inline void negate(entry_t* entry);
+static size_t produce(seq_ring_t ring, uint32_t first, uint32_t count);
+static void check_output(seq_ring_t ring, size_t output_stage, uint32_t first, size_t count);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+
+#define TEST_STAGES(X) X(increment) X(twice) X(negate)
+
+PIPELINE_DEFINE_FUSED(fused, entry_t, TEST_STAGES)
+PIPELINE_DEFINE_SPLIT(split, entry_t, TEST_STAGES)
+
+/// Shares stages with the pipelines above.
+#define OTHER_STAGES(X) X(twice) X(increment)
+
+PIPELINE_DEFINE_SPLIT(other, entry_t, OTHER_STAGES)
+
+/* === Private function implementation ========================================================= */
+
+static inline void increment(entry_t* entry)
+{
+    entry->value += 1;
+    entry->trace = entry->trace * 10 + 1;
+}
+
+static inline void twice(entry_t* entry)
+{
+    entry->value *= 2;
+    entry->trace = entry->trace * 10 + 2;
+}
+
+static inline void negate(entry_t* entry)
+{
+    entry->value = (uint32_t)-entry->value;
+    entry->trace = entry->trace * 10 + 3;
+}
+
+static size_t produce(seq_ring_t ring, uint32_t first, uint32_t count)
+{
+    size_t n = seq_ring_available(ring, 0);
+    size_t seq = seq_ring_cursor(ring, 0);
+
+    if (n > count) { n = count; }
+    for (size_t i = 0; i < n; i++) {
+        entry_t* entry = seq_ring_entry(ring, seq + i);
+        entry->value = first + (uint32_t)i;
+        entry->trace = 0;
+    }
+
+    seq_ring_advance(ring, 0, n);
+    return n;
+}
+
+static void check_output(seq_ring_t ring, size_t output_stage, uint32_t first, size_t count)
+{
+    size_t seq = seq_ring_cursor(ring, output_stage);
+
+    TEST_ASSERT(seq_ring_available(ring, output_stage) >= count);
+    for (size_t i = 0; i < count; i++) {
+        entry_t* entry = seq_ring_entry(ring, seq + i);
+        TEST_ASSERT_EQUAL_UINT32((uint32_t)-(2 * (first + i + 1)), entry->value);
+        TEST_ASSERT_EQUAL_UINT32(123, entry->trace);
+    }
+
+    seq_ring_advance(ring, output_stage, count);
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+/// @test This test verifies the ring layout each form needs.
+void test_ring_stages(void)
+{
+    TEST_ASSERT_EQUAL_INT(3, fused_RING_STAGES);
+    TEST_ASSERT_EQUAL_INT(2, fused_OUTPUT_STAGE);
+    TEST_ASSERT_EQUAL_INT(5, split_RING_STAGES);
+    TEST_ASSERT_EQUAL_INT(4, split_OUTPUT_STAGE);
+}
+
+/// @test This test verifies that a fused pipeline applies every stage in order, across the end of the ring.
+void test_fused_poll(void)
+{
+    seq_ring_t ring = seq_ring_init(entries, sizeof(entry_t), ENTRY_COUNT, fused_RING_STAGES);
+
+    // Move the cursors close to the end of the entries.
+    TEST_ASSERT_EQUAL_UINT(5, produce(ring, 0, 5));
+    TEST_ASSERT_EQUAL_UINT(5, fused_poll(ring));
+    check_output(ring, fused_OUTPUT_STAGE, 0, 5);
+
+    // The producer sees the 3 entries up to the end first, then the recycled ones.
+    TEST_ASSERT_EQUAL_UINT(3, produce(ring, 100, ENTRY_COUNT));
+    TEST_ASSERT_EQUAL_UINT(5, produce(ring, 103, ENTRY_COUNT - 3));
+    TEST_ASSERT_EQUAL_UINT(ENTRY_COUNT, fused_poll(ring));
+    TEST_ASSERT_EQUAL_UINT(0, fused_poll(ring));
+    TEST_ASSERT_EQUAL_UINT(ENTRY_COUNT, seq_ring_available(ring, fused_OUTPUT_STAGE));
+    check_output(ring, fused_OUTPUT_STAGE, 100, ENTRY_COUNT);
+
+    seq_ring_deinit(&ring);
+}
+
+/// @test This test verifies that a split pipeline gives the same results as the fused one.
+void test_split_poll(void)
+{
+    seq_ring_t ring = seq_ring_init(entries, sizeof(entry_t), ENTRY_COUNT, split_RING_STAGES);
+
+    TEST_ASSERT_EQUAL_UINT(ENTRY_COUNT, produce(ring, 7, ENTRY_COUNT));
+
+    // Each stage processes all the entries, one after the other.
+    TEST_ASSERT_EQUAL_UINT(3 * ENTRY_COUNT, split_poll(ring));
+    check_output(ring, split_OUTPUT_STAGE, 7, ENTRY_COUNT);
+
+    seq_ring_deinit(&ring);
+}
+
+/// @test This test verifies that split pipelines sharing a stage function keep their own stage order.
+void test_split_pipelines_share_stages(void)
+{
+    seq_ring_t ring = seq_ring_init(entries, sizeof(entry_t), ENTRY_COUNT, other_RING_STAGES);
+
+    TEST_ASSERT_EQUAL_UINT(ENTRY_COUNT, produce(ring, 5, ENTRY_COUNT));
+    TEST_ASSERT_EQUAL_UINT(2 * ENTRY_COUNT, other_poll(ring));
+
+    size_t seq = seq_ring_cursor(ring, other_OUTPUT_STAGE);
+    TEST_ASSERT_EQUAL_UINT(ENTRY_COUNT, seq_ring_available(ring, other_OUTPUT_STAGE));
+    for (uint32_t i = 0; i < ENTRY_COUNT; i++) {
+        entry_t* entry = seq_ring_entry(ring, seq + i);
+        TEST_ASSERT_EQUAL_UINT32(2 * (5 + i) + 1, entry->value);
+        TEST_ASSERT_EQUAL_UINT32(21, entry->trace);
+    }
+
+    seq_ring_deinit(&ring);
+}
+
+/// @test This test verifies both forms running on their own threads.
+void test_threaded_pipelines(void)
+{
+    const size_t layouts[][2] = {{fused_RING_STAGES, fused_OUTPUT_STAGE}, {split_RING_STAGES, split_OUTPUT_STAGE}};
+
+    for (size_t form = 0; form < 2; form++) {
+        seq_ring_t ring = seq_ring_init(entries, sizeof(entry_t), ENTRY_COUNT, layouts[form][0]);
+        pipeline_workers_t workers = (form == 0) ? fused_start(ring) : split_start(ring);
+        TEST_ASSERT_NOT_NULL(workers);
+
+        uint32_t produced = 0;
+        uint32_t consumed = 0;
+
+        while (consumed < TRANSFER_COUNT) {
+            produced += (uint32_t)produce(ring, produced, TRANSFER_COUNT - produced);
+
+            size_t n = seq_ring_available(ring, layouts[form][1]);
+            check_output(ring, layouts[form][1], consumed, n);
+            consumed += (uint32_t)n;
+
+            if (n == 0) { sched_yield(); }
+        }
+
+        pipeline_stop(&workers);
+        TEST_ASSERT_NULL(workers);
+        seq_ring_deinit(&ring);
+    }
+}
+
+/* === End of documentation ==================================================================== */
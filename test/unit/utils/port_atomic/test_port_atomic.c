@@ -0,0 +1,126 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_port_atomic.c
+ ** @brief Test suite for the portable atomics, critical section backend.
+ **
+ ** The C11 and builtin backends are exercised by the ring test suites. This one runs the backend used
+ ** on single-core targets, with a signal handler standing in for the interrupt.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#define PORT_ATOMIC_USE_CRITICAL
+
+#include <signal.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unity.h>
+
+#include <utils/port_atomic/port_atomic.h>
+
+/* === Macros definitions ====================================================================== */
+
+/// Increments performed by the interrupted code.
+#define MAIN_INCREMENTS 500000
+
+/// Timer period of the simulated interrupt, in microseconds.
+#define ISR_PERIOD_US 50
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static port_atomic_size_t counter;
+static port_atomic_size_t interrupts;
+static port_atomic_bool_t flag;
+
+/* === Private function declarations =========================================================== */
+
+static void isr(int signal);
+static void start_timer(long period_us);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void isr(int signal)
+{
+    (void)signal;
+    PORT_ATOMIC_FETCH_ADD(&counter, 1, PORT_ATOMIC_RELAXED);
+    PORT_ATOMIC_STORE(&interrupts, PORT_ATOMIC_LOAD(&interrupts, PORT_ATOMIC_RELAXED) + 1, PORT_ATOMIC_RELEASE);
+}
+
+static void start_timer(long period_us)
+{
+    struct itimerval timer = {.it_interval = {0, period_us}, .it_value = {0, period_us}};
+    setitimer(ITIMER_REAL, &timer, NULL);
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = isr;
+    sigaction(SIGALRM, &action, NULL);
+
+    PORT_ATOMIC_INIT(&counter, 0);
+    PORT_ATOMIC_INIT(&interrupts, 0);
+    PORT_ATOMIC_INIT(&flag, false);
+}
+
+void tearDown(void)
+{
+    start_timer(0);
+    signal(SIGALRM, SIG_DFL);
+}
+
+/// @test This test verifies that the backend is selected by the build flag and that plain operations work.
+void test_load_store(void)
+{
+    TEST_ASSERT_EQUAL_STRING("critical", PORT_ATOMIC_BACKEND);
+
+    PORT_ATOMIC_STORE(&flag, true, PORT_ATOMIC_SEQ_CST);
+    TEST_ASSERT_TRUE(PORT_ATOMIC_LOAD(&flag, PORT_ATOMIC_ACQUIRE));
+    TEST_ASSERT_EQUAL_UINT(0, PORT_ATOMIC_FETCH_ADD(&counter, 5, PORT_ATOMIC_RELAXED));
+    TEST_ASSERT_EQUAL_UINT(5, PORT_ATOMIC_LOAD(&counter, PORT_ATOMIC_RELAXED));
+    TEST_ASSERT_EQUAL_UINT(5, PORT_ATOMIC_EXCHANGE(&counter, 7, PORT_ATOMIC_SEQ_CST));
+    TEST_ASSERT_TRUE(PORT_ATOMIC_EXCHANGE(&flag, false, PORT_ATOMIC_ACQUIRE));
+    TEST_ASSERT_FALSE(PORT_ATOMIC_LOAD(&flag, PORT_ATOMIC_RELAXED));
+    PORT_ATOMIC_FENCE(PORT_ATOMIC_SEQ_CST);
+}
+
+/// @test This test verifies that read-modify-write operations are not torn by an interrupting handler.
+void test_fetch_add_against_interrupts(void)
+{
+    start_timer(ISR_PERIOD_US);
+    for (size_t i = 0; i < MAIN_INCREMENTS; i++) { PORT_ATOMIC_FETCH_ADD(&counter, 1, PORT_ATOMIC_RELAXED); }
+    start_timer(0);
+
+    size_t fired = PORT_ATOMIC_LOAD(&interrupts, PORT_ATOMIC_ACQUIRE);
+    TEST_ASSERT(fired > 0);
+    TEST_ASSERT_EQUAL_UINT(MAIN_INCREMENTS + fired, PORT_ATOMIC_LOAD(&counter, PORT_ATOMIC_RELAXED));
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,226 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_ring_alloc.c
+ ** @brief Test suite for the circular allocator.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <unity.h>
+
+#include <utils/ring_alloc/ring_alloc.h>
+#include <utils/seq_ring/seq_ring.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define STORAGE_SIZE 256
+
+/// Messages sent from the allocating thread to the freeing one.
+#define MESSAGE_COUNT 20000
+
+/// Largest message of the threaded test.
+#define MESSAGE_MAX 200
+
+#define SLOT_COUNT 16
+
+/* === Private data type declarations ========================================================== */
+
+/// Message handed over from the allocating thread to the freeing one.
+typedef struct
+{
+    uint8_t* data;
+    size_t len;
+} message_t;
+
+/* === Private variable declarations =========================================================== */
+
+static ring_alloc_t ra = NULL;
+static alignas(RING_ALLOC_ALIGN) uint8_t storage[STORAGE_SIZE];
+static alignas(RING_ALLOC_ALIGN) uint8_t big_storage[4 * 1024];
+
+/* === Private function declarations =========================================================== */
+
+static void* producer_thread(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void* producer_thread(void* arg)
+{
+    seq_ring_t slots = arg;
+
+    for (size_t i = 0; i < MESSAGE_COUNT;) {
+        if (seq_ring_available(slots, 0) == 0) {
+            sched_yield();
+            continue;
+        }
+
+        size_t len = 1 + (i * 7) % MESSAGE_MAX;
+        uint8_t* data = ring_alloc_alloc(ra, len);
+        if (!data) {
+            sched_yield();
+            continue;
+        }
+        for (size_t j = 0; j < len; j++) { data[j] = (uint8_t)(i + j); }
+
+        message_t* message = seq_ring_entry(slots, seq_ring_cursor(slots, 0));
+        message->data = data;
+        message->len = len;
+        seq_ring_advance(slots, 0, 1);
+        i++;
+    }
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void) { ra = ring_alloc_init(storage, STORAGE_SIZE); }
+
+void tearDown(void) { ring_alloc_deinit(&ra); }
+
+/// @test This test verifies the initial state: nothing in use, and a single block can take all but its header.
+void test_initial_state(void)
+{
+    TEST_ASSERT_NOT_NULL(ra);
+    TEST_ASSERT_EQUAL_UINT(STORAGE_SIZE, ring_alloc_capacity(ra));
+    TEST_ASSERT_EQUAL_UINT(0, ring_alloc_used(ra));
+    TEST_ASSERT_EQUAL_UINT(STORAGE_SIZE - RING_ALLOC_ALIGN, ring_alloc_max_size(ra));
+}
+
+/// @test This test verifies that blocks are aligned, laid out one after the other, and released in order.
+void test_alloc_and_free_in_order(void)
+{
+    uint8_t* a = ring_alloc_alloc(ra, 1);
+    uint8_t* b = ring_alloc_alloc(ra, 17);
+    uint8_t* c = ring_alloc_alloc(ra, 0);
+
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_EQUAL_UINT(0, (uintptr_t)a % RING_ALLOC_ALIGN);
+    TEST_ASSERT_EQUAL_PTR(&storage[RING_ALLOC_ALIGN], a);
+
+    // Each block takes a header plus its size rounded up to the alignment.
+    TEST_ASSERT_EQUAL_PTR(a + 2 * RING_ALLOC_ALIGN, b);
+    TEST_ASSERT_EQUAL_PTR(b + (RING_ALLOC_ALIGN + 2 * RING_ALLOC_ALIGN), c);
+    TEST_ASSERT_EQUAL_UINT(6 * RING_ALLOC_ALIGN, ring_alloc_used(ra));
+
+    ring_alloc_free(ra, a);
+    TEST_ASSERT_EQUAL_UINT(4 * RING_ALLOC_ALIGN, ring_alloc_used(ra));
+    ring_alloc_free(ra, b);
+    ring_alloc_free(ra, NULL);
+    ring_alloc_free(ra, c);
+    TEST_ASSERT_EQUAL_UINT(0, ring_alloc_used(ra));
+}
+
+/// @test This test verifies that a full allocator refuses blocks until the oldest one is released.
+void test_full(void)
+{
+    uint8_t* blocks[STORAGE_SIZE / (2 * RING_ALLOC_ALIGN) + 1];
+    size_t count = 0;
+
+    while ((blocks[count] = ring_alloc_alloc(ra, RING_ALLOC_ALIGN)) != NULL) { count++; }
+    TEST_ASSERT_EQUAL_UINT(STORAGE_SIZE / (2 * RING_ALLOC_ALIGN), count);
+    TEST_ASSERT_EQUAL_UINT(STORAGE_SIZE, ring_alloc_used(ra));
+
+    ring_alloc_free(ra, blocks[0]);
+    TEST_ASSERT_NULL(ring_alloc_alloc(ra, 2 * RING_ALLOC_ALIGN));
+    TEST_ASSERT_EQUAL_PTR(blocks[0], ring_alloc_alloc(ra, RING_ALLOC_ALIGN));
+}
+
+/// @test This test verifies that a block not fitting before the end of the storage starts over at its beginning, and
+/// that the space skipped is reclaimed along with that block.
+void test_wrap_skips_end(void)
+{
+    // `a` takes the first half, `b` leaves less than a header and 64 bytes before the end.
+    uint8_t* a = ring_alloc_alloc(ra, STORAGE_SIZE / 2 - RING_ALLOC_ALIGN);
+    uint8_t* b = ring_alloc_alloc(ra, 64);
+    size_t skipped = STORAGE_SIZE / 2 - 64 - RING_ALLOC_ALIGN;
+    TEST_ASSERT_NOT_NULL(b);
+
+    // Not enough room before the end, nor at the beginning until `a` goes.
+    TEST_ASSERT_NULL(ring_alloc_alloc(ra, 64));
+    ring_alloc_free(ra, a);
+
+    uint8_t* c = ring_alloc_alloc(ra, 64);
+    TEST_ASSERT_EQUAL_PTR(&storage[RING_ALLOC_ALIGN], c);
+    TEST_ASSERT_EQUAL_UINT(2 * (64 + RING_ALLOC_ALIGN) + skipped, ring_alloc_used(ra));
+
+    ring_alloc_free(ra, b);
+    TEST_ASSERT_EQUAL_UINT(64 + RING_ALLOC_ALIGN + skipped, ring_alloc_used(ra));
+    ring_alloc_free(ra, c);
+    TEST_ASSERT_EQUAL_UINT(0, ring_alloc_used(ra));
+}
+
+/// @test This test verifies that blocks too large for the storage are refused.
+void test_too_large(void)
+{
+    TEST_ASSERT_NULL(ring_alloc_alloc(ra, ring_alloc_max_size(ra) + 1));
+    TEST_ASSERT_NULL(ring_alloc_alloc(ra, SIZE_MAX));
+
+    uint8_t* all = ring_alloc_alloc(ra, ring_alloc_max_size(ra));
+    TEST_ASSERT_EQUAL_PTR(&storage[RING_ALLOC_ALIGN], all);
+    TEST_ASSERT_EQUAL_UINT(STORAGE_SIZE, ring_alloc_used(ra));
+    ring_alloc_free(ra, all);
+}
+
+/// @test This test verifies that blocks allocated on one thread can be released on another, in order, intact.
+void test_allocate_and_free_across_threads(void)
+{
+    message_t messages[SLOT_COUNT];
+    seq_ring_t slots = seq_ring_init(messages, sizeof(message_t), SLOT_COUNT, 2);
+    pthread_t producer;
+    size_t corrupted = 0;
+
+    ring_alloc_deinit(&ra);
+    ra = ring_alloc_init(big_storage, sizeof(big_storage));
+    pthread_create(&producer, NULL, producer_thread, slots);
+
+    for (size_t i = 0; i < MESSAGE_COUNT;) {
+        size_t n = seq_ring_available(slots, 1);
+        size_t seq = seq_ring_cursor(slots, 1);
+
+        for (size_t k = 0; k < n; k++, i++) {
+            message_t* message = seq_ring_entry(slots, seq + k);
+            if (message->len != 1 + (i * 7) % MESSAGE_MAX) { corrupted++; }
+            for (size_t j = 0; j < message->len; j++) { corrupted += message->data[j] != (uint8_t)(i + j); }
+            ring_alloc_free(ra, message->data);
+        }
+
+        seq_ring_advance(slots, 1, n);
+        if (n == 0) { sched_yield(); }
+    }
+
+    pthread_join(producer, NULL);
+    seq_ring_deinit(&slots);
+
+    TEST_ASSERT_EQUAL_UINT(0, corrupted);
+    TEST_ASSERT_EQUAL_UINT(0, ring_alloc_used(ra));
+}
+
+/* === End of documentation ==================================================================== */
@@ -28,22 +28,90 @@ SPDX-License-Identifier: MIT
 #include <stddef.h>
 #include <unity.h>
 
+#include "cycle_budget.h"
 #include <utils/ring_buffer/ring_buffer.h>
+#include <utils/tsc_clock/tsc_clock.h>
 
 /* === Macros definitions ====================================================================== */
 
 #define BUFFER_SIZE 16
 
+/// Ring used by the cycle budget tests, large enough to time a batch without wrapping around.
+#define BUDGET_BUFFER_SIZE 1024
+
+/// Block size of the timed bulk operations.
+#define BUDGET_BLOCK_SIZE 64
+
+/// Upper bound for a single-byte write or read, about four times its unoptimized cost.
+#define BYTE_BUDGET_CYCLES 100
+
+/// Upper bound for a BUDGET_BLOCK_SIZE bulk write or read, about four times its unoptimized cost.
+#define BLOCK_BUDGET_CYCLES 250
+
 /* === Private data type declarations ========================================================== */
 
 static ring_buffer_t ring_buffer = NULL;
 static uint8_t ring_buffer_container[BUFFER_SIZE] = {0};
 
 /* === Private variable declarations =========================================================== */
+
+static uint8_t budget_container[BUDGET_BUFFER_SIZE] = {0};
+static uint8_t budget_block[BUDGET_BLOCK_SIZE] = {0};
+
 /* === Private function declarations =========================================================== */
+
+static void clear(void* ctx, size_t calls);
+static void fill_bytes(void* ctx, size_t calls);
+static void write_bytes(void* ctx, size_t calls);
+static void read_bytes(void* ctx, size_t calls);
+static void fill_blocks(void* ctx, size_t calls);
+static void write_blocks(void* ctx, size_t calls);
+static void read_blocks(void* ctx, size_t calls);
+
 /* === Public variable definitions ============================================================= */
 /* === Private variable definitions ============================================================ */
 /* === Private function implementation ========================================================= */
+
+static void clear(void* ctx, size_t calls)
+{
+    (void)calls;
+    ring_buffer_reset(ctx);
+}
+
+static void fill_bytes(void* ctx, size_t calls)
+{
+    ring_buffer_reset(ctx);
+    for (size_t i = 0; i < calls; i++) { ring_buffer_write_byte(ctx, (uint8_t)i); }
+}
+
+static void write_bytes(void* ctx, size_t calls)
+{
+    for (size_t i = 0; i < calls; i++) { ring_buffer_write_byte(ctx, (uint8_t)i); }
+}
+
+static void read_bytes(void* ctx, size_t calls)
+{
+    uint8_t data;
+    for (size_t i = 0; i < calls; i++) { ring_buffer_read_byte(ctx, &data); }
+}
+
+static void fill_blocks(void* ctx, size_t calls)
+{
+    ring_buffer_reset(ctx);
+    for (size_t i = 0; i < calls; i++) { ring_buffer_write(ctx, budget_block, BUDGET_BLOCK_SIZE); }
+}
+
+static void write_blocks(void* ctx, size_t calls)
+{
+    for (size_t i = 0; i < calls; i++) { ring_buffer_write(ctx, budget_block, BUDGET_BLOCK_SIZE); }
+}
+
+static void read_blocks(void* ctx, size_t calls)
+{
+    uint8_t data[BUDGET_BLOCK_SIZE];
+    for (size_t i = 0; i < calls; i++) { ring_buffer_read(ctx, data, BUDGET_BLOCK_SIZE); }
+}
+
 /* === Public function implementation ========================================================== */
 
 void setUp(void) { ring_buffer = ring_buffer_init(ring_buffer_container, BUFFER_SIZE); }
@@ -233,4 +301,106 @@ void test_buffer_read_and_write_with_wrapping(void)
     TEST_ASSERT(!ring_buffer_is_full(ring_buffer));
 }
 
+/// @test This test verifies that a bulk write followed by a bulk read preserves the data and handles the wraparound
+/// of the buffer.
+void test_bulk_write_and_read_with_wrapping(void)
+{
+    uint8_t block[BUFFER_SIZE] = {0};
+    uint8_t data[BUFFER_SIZE] = {0};
+
+    for (size_t i = 0; i < BUFFER_SIZE; i++) { block[i] = (uint8_t)i; }
+
+    // Move the indices close to the end of the buffer.
+    ring_buffer_write(ring_buffer, block, BUFFER_SIZE - 3);
+    TEST_ASSERT_EQUAL_UINT(BUFFER_SIZE - 3, ring_buffer_read(ring_buffer, data, BUFFER_SIZE));
+    TEST_ASSERT(ring_buffer_is_empty(ring_buffer));
+
+    // This block crosses the end of the buffer.
+    ring_buffer_write(ring_buffer, block, 8);
+    TEST_ASSERT_EQUAL_UINT(8, ring_buffer_size(ring_buffer));
+
+    TEST_ASSERT_EQUAL_UINT(8, ring_buffer_read(ring_buffer, data, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(block, data, 8);
+    TEST_ASSERT_EQUAL_UINT(0, ring_buffer_read(ring_buffer, data, BUFFER_SIZE));
+}
+
+/// @test This test verifies that a bulk write overwrites the oldest data exactly like ring_buffer_write_byte() does,
+/// including blocks larger than the buffer.
+void test_bulk_write_overwrites_oldest(void)
+{
+    uint8_t block[2 * BUFFER_SIZE] = {0};
+    uint8_t data = 0;
+
+    for (size_t i = 0; i < sizeof(block); i++) { block[i] = (uint8_t)i; }
+
+    ring_buffer_write(ring_buffer, block, BUFFER_SIZE - 1);
+    ring_buffer_write(ring_buffer, &block[BUFFER_SIZE - 1], 3);
+
+    // Two bytes were overwritten, so the oldest one is now `2`.
+    TEST_ASSERT(ring_buffer_is_full(ring_buffer));
+    TEST_ASSERT_EQUAL_INT(0, ring_buffer_read_byte(ring_buffer, &data));
+    TEST_ASSERT_EQUAL_UINT8(2, data);
+
+    // A block larger than the buffer keeps only its tail.
+    ring_buffer_write(ring_buffer, block, sizeof(block));
+    TEST_ASSERT(ring_buffer_is_full(ring_buffer));
+    TEST_ASSERT_EQUAL_INT(0, ring_buffer_read_byte(ring_buffer, &data));
+    TEST_ASSERT_EQUAL_UINT8(BUFFER_SIZE, data);
+    TEST_ASSERT_EQUAL_UINT(BUFFER_SIZE - 1, ring_buffer_size(ring_buffer));
+}
+
+/// @test This test verifies that peeking copies data from any offset, across the wraparound, without consuming it.
+void test_peek_does_not_consume(void)
+{
+    uint8_t block[BUFFER_SIZE] = {0};
+    uint8_t data[BUFFER_SIZE] = {0};
+
+    for (size_t i = 0; i < BUFFER_SIZE; i++) { block[i] = (uint8_t)i; }
+
+    // Leave 8 bytes stored across the end of the buffer.
+    ring_buffer_write(ring_buffer, block, BUFFER_SIZE - 3);
+    ring_buffer_read(ring_buffer, data, BUFFER_SIZE - 3);
+    ring_buffer_write(ring_buffer, block, 8);
+
+    TEST_ASSERT_EQUAL_UINT(8, ring_buffer_peek(ring_buffer, 0, data, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(block, data, 8);
+    TEST_ASSERT_EQUAL_UINT(3, ring_buffer_peek(ring_buffer, 5, data, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&block[5], data, 3);
+    TEST_ASSERT_EQUAL_UINT(0, ring_buffer_peek(ring_buffer, 8, data, BUFFER_SIZE));
+
+    TEST_ASSERT_EQUAL_UINT(8, ring_buffer_size(ring_buffer));
+    TEST_ASSERT_EQUAL_UINT(8, ring_buffer_read(ring_buffer, data, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(block, data, 8);
+}
+
+/// @test This test verifies that the single-byte operations, the ones an ISR calls once per byte, stay within their
+/// cycle budget.
+void test_byte_cycle_budget(void)
+{
+    tsc_clock_init();
+    ring_buffer_t rb = ring_buffer_init(budget_container, BUDGET_BUFFER_SIZE);
+
+    uint64_t write = cycle_budget_measure(clear, write_bytes, rb, BUDGET_BUFFER_SIZE / 2);
+    uint64_t read = cycle_budget_measure(fill_bytes, read_bytes, rb, BUDGET_BUFFER_SIZE / 2);
+    TEST_ASSERT_CYCLE_BUDGET(BYTE_BUDGET_CYCLES, write);
+    TEST_ASSERT_CYCLE_BUDGET(BYTE_BUDGET_CYCLES, read);
+
+    ring_buffer_deinit(&rb);
+}
+
+/// @test This test verifies that the bulk operations stay within their cycle budget.
+void test_block_cycle_budget(void)
+{
+    tsc_clock_init();
+    ring_buffer_t rb = ring_buffer_init(budget_container, BUDGET_BUFFER_SIZE);
+    size_t blocks = BUDGET_BUFFER_SIZE / BUDGET_BLOCK_SIZE / 2;
+
+    uint64_t write = cycle_budget_measure(clear, write_blocks, rb, blocks);
+    uint64_t read = cycle_budget_measure(fill_blocks, read_blocks, rb, blocks);
+    TEST_ASSERT_CYCLE_BUDGET(BLOCK_BUDGET_CYCLES, write);
+    TEST_ASSERT_CYCLE_BUDGET(BLOCK_BUDGET_CYCLES, read);
+
+    ring_buffer_deinit(&rb);
+}
+
 /* === End of documentation ==================================================================== */
@@ -0,0 +1,260 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_rtp_midi.c
+ ** @brief Test suite for the RTP-MIDI network transport, over loopback.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stddef.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include "send_fault.h"
+#include <utils/rtp_midi/rtp_midi.h>
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/tsc_clock/tsc_clock.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define LOOPBACK "127.0.0.1"
+
+#define RING_SIZE 16384
+
+#define BULK_COUNT 3000
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static rtp_midi_t sender = NULL;
+static rtp_midi_t receiver = NULL;
+static spsc_ring_t tx = NULL;
+static spsc_ring_t rx = NULL;
+static uint8_t tx_container[RING_SIZE];
+static uint8_t rx_container[RING_SIZE];
+
+/* === Private function declarations =========================================================== */
+
+static void write_bytes(const uint8_t* data, size_t len);
+static int receive_messages(int expected);
+static void send_raw(const uint8_t* data, size_t len);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void write_bytes(const uint8_t* data, size_t len) { TEST_ASSERT_EQUAL_INT(0, spsc_ring_write(tx, data, len)); }
+
+static int receive_messages(int expected)
+{
+    int received = 0;
+
+    // Loopback delivery is immediate in practice, but leave the kernel some slack.
+    for (int i = 0; i < 1000 && received < expected; i++) {
+        int n = rtp_midi_receive(receiver, rx);
+        TEST_ASSERT(n >= 0);
+        received += n;
+        if (n == 0) { usleep(1000); }
+    }
+
+    return received;
+}
+
+static void send_raw(const uint8_t* data, size_t len)
+{
+    struct sockaddr_in to = {.sin_family = AF_INET, .sin_port = htons(rtp_midi_local_port(receiver))};
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    inet_pton(AF_INET, LOOPBACK, &to.sin_addr);
+    TEST_ASSERT_EQUAL_INT((int)len, sendto(fd, data, len, 0, (struct sockaddr*)&to, sizeof(to)));
+    close(fd);
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    sender = rtp_midi_init(LOOPBACK, 0, 0x1234);
+    receiver = rtp_midi_init(LOOPBACK, 0, 0x5678);
+    TEST_ASSERT_NOT_NULL(sender);
+    TEST_ASSERT_NOT_NULL(receiver);
+    TEST_ASSERT_EQUAL_INT(0, rtp_midi_connect(sender, LOOPBACK, rtp_midi_local_port(receiver)));
+
+    tx = spsc_ring_init(tx_container, RING_SIZE);
+    rx = spsc_ring_init(rx_container, RING_SIZE);
+}
+
+void tearDown(void)
+{
+    send_fault_clear();
+    rtp_midi_deinit(&sender);
+    rtp_midi_deinit(&receiver);
+    spsc_ring_deinit(&tx);
+    spsc_ring_deinit(&rx);
+}
+
+/// @test This test verifies the message length derived from each kind of status byte.
+void test_message_length(void)
+{
+    TEST_ASSERT_EQUAL_UINT(3, rtp_midi_message_length(0x90));
+    TEST_ASSERT_EQUAL_UINT(3, rtp_midi_message_length(0xE5));
+    TEST_ASSERT_EQUAL_UINT(2, rtp_midi_message_length(0xC0));
+    TEST_ASSERT_EQUAL_UINT(2, rtp_midi_message_length(0xDF));
+    TEST_ASSERT_EQUAL_UINT(2, rtp_midi_message_length(0xF1));
+    TEST_ASSERT_EQUAL_UINT(3, rtp_midi_message_length(0xF2));
+    TEST_ASSERT_EQUAL_UINT(1, rtp_midi_message_length(0xF8));
+    TEST_ASSERT_EQUAL_UINT(0, rtp_midi_message_length(0xF0));
+    TEST_ASSERT_EQUAL_UINT(0, rtp_midi_message_length(0x40));
+}
+
+/// @test This test verifies a round trip of a stream with running status, real-time and system exclusive bytes.
+void test_loopback_round_trip(void)
+{
+    const uint8_t stream[] = {0x90, 0x3C, 0x64, 0x3E, 0x64, 0xC0, 0x05, 0x90, 0x40,
+                              0xF8, 0x7F, 0xF0, 0x01, 0x02, 0xF7, 0x80, 0x3C, 0x00};
+    const uint8_t expected[] = {0x90, 0x3C, 0x64, 0x90, 0x3E, 0x64, 0xC0, 0x05, 0xF8,
+                                0x90, 0x40, 0x7F, 0x80, 0x3C, 0x00};
+    uint8_t received[sizeof(expected)];
+
+    write_bytes(stream, sizeof(stream));
+
+    TEST_ASSERT_EQUAL_INT(6, rtp_midi_send(sender, tx));
+    TEST_ASSERT_EQUAL_INT(6, receive_messages(6));
+
+    TEST_ASSERT_EQUAL_UINT(sizeof(expected), spsc_ring_read(rx, received, sizeof(received)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, received, sizeof(expected));
+    TEST_ASSERT(spsc_ring_is_empty(rx));
+}
+
+/// @test This test verifies that a message still being written is held back until it is complete.
+void test_partial_message_is_held(void)
+{
+    const uint8_t head[] = {0x90, 0x3C};
+    const uint8_t tail[] = {0x64};
+
+    write_bytes(head, sizeof(head));
+    TEST_ASSERT_EQUAL_INT(0, rtp_midi_send(sender, tx));
+
+    write_bytes(tail, sizeof(tail));
+    TEST_ASSERT_EQUAL_INT(1, rtp_midi_send(sender, tx));
+    TEST_ASSERT_EQUAL_INT(1, receive_messages(1));
+}
+
+/// @test This test verifies that many messages are packed per packet, and many packets per batch.
+void test_batching(void)
+{
+    rtp_midi_stats_t stats;
+
+    for (size_t i = 0; i < BULK_COUNT; i++) {
+        const uint8_t note[] = {0x90, (uint8_t)(i & 0x7F), 0x40};
+        write_bytes(note, sizeof(note));
+    }
+
+    TEST_ASSERT_EQUAL_INT(BULK_COUNT, rtp_midi_send(sender, tx));
+    TEST_ASSERT_EQUAL_INT(BULK_COUNT, receive_messages(BULK_COUNT));
+
+    // 256 messages fit in a 1024-byte command list: 3 bytes for the first, 4 with its delta time for the others.
+    rtp_midi_get_stats(sender, &stats);
+    TEST_ASSERT_EQUAL_UINT((BULK_COUNT + 255) / 256, stats.packets_sent);
+
+    rtp_midi_get_stats(receiver, &stats);
+    TEST_ASSERT_EQUAL_UINT((BULK_COUNT + 255) / 256, stats.packets_received);
+    TEST_ASSERT_EQUAL_UINT(BULK_COUNT, stats.messages_received);
+    TEST_ASSERT_EQUAL_UINT(0, stats.dropped);
+}
+
+/// @test This test verifies that packets a full socket does not take are kept and sent first by the next call.
+void test_socket_full(void)
+{
+    rtp_midi_stats_t stats;
+    uint8_t received[3];
+
+    for (size_t i = 0; i < BULK_COUNT; i++) {
+        const uint8_t note[] = {0x90, (uint8_t)(i & 0x7F), 0x40};
+        write_bytes(note, sizeof(note));
+    }
+
+    // Only the first two packets fit, the rest of the batch waits.
+    send_fault_limit(2);
+    TEST_ASSERT_EQUAL_INT(2 * 256, rtp_midi_send(sender, tx));
+    TEST_ASSERT_EQUAL_INT(0, rtp_midi_send(sender, tx));
+
+    rtp_midi_get_stats(sender, &stats);
+    TEST_ASSERT_EQUAL_UINT(2, stats.packets_sent);
+    TEST_ASSERT_EQUAL_UINT(2 * 256, stats.messages_sent);
+
+    send_fault_clear();
+    TEST_ASSERT_EQUAL_INT(BULK_COUNT - 2 * 256, rtp_midi_send(sender, tx));
+    TEST_ASSERT_EQUAL_INT(BULK_COUNT, receive_messages(BULK_COUNT));
+
+    rtp_midi_get_stats(sender, &stats);
+    TEST_ASSERT_EQUAL_UINT((BULK_COUNT + 255) / 256, stats.packets_sent);
+    TEST_ASSERT_EQUAL_UINT(BULK_COUNT, stats.messages_sent);
+
+    // Nothing was lost or reordered.
+    for (size_t i = 0; i < BULK_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT(sizeof(received), spsc_ring_read(rx, received, sizeof(received)));
+        TEST_ASSERT_EQUAL_UINT8(i & 0x7F, received[1]);
+    }
+}
+
+/// @test This test verifies the decoding of a packet from another implementation: short header, running status
+/// and a recovery journal.
+void test_foreign_packet(void)
+{
+    const uint8_t packet[] = {0x80, RTP_MIDI_PAYLOAD_TYPE, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0xCA, 0xFE, 0xBA, 0xBE,
+                              0x40 | 6, 0x90, 0x3C, 0x64, 0x00, 0x3E, 0x64, 0xDE, 0xAD};
+    const uint8_t expected[] = {0x90, 0x3C, 0x64, 0x90, 0x3E, 0x64};
+    uint8_t received[sizeof(expected)];
+
+    send_raw(packet, sizeof(packet));
+    TEST_ASSERT_EQUAL_INT(2, receive_messages(2));
+
+    TEST_ASSERT_EQUAL_UINT(sizeof(expected), spsc_ring_read(rx, received, sizeof(received)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, received, sizeof(expected));
+}
+
+/// @test This test verifies that datagrams that are not RTP-MIDI are counted and ignored.
+void test_malformed_datagram(void)
+{
+    const uint8_t garbage[] = {0x12, 0x34, 0x56};
+    rtp_midi_stats_t stats;
+
+    send_raw(garbage, sizeof(garbage));
+
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT_EQUAL_INT(0, rtp_midi_receive(receiver, rx));
+        rtp_midi_get_stats(receiver, &stats);
+        if (stats.malformed) { break; }
+        usleep(1000);
+    }
+
+    TEST_ASSERT_EQUAL_UINT(1, stats.malformed);
+    TEST_ASSERT(spsc_ring_is_empty(rx));
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,195 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_seq_ring.c
+ ** @brief Test suite for the sequenced pipeline ring.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <unity.h>
+
+#include <utils/seq_ring/seq_ring.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define ENTRY_COUNT 8
+
+#define STAGE_COUNT 3
+
+#define TRANSFER_COUNT 4096
+
+/* === Private data type declarations ========================================================== */
+
+typedef struct
+{
+    uint32_t value;
+    uint32_t hops;
+} entry_t;
+
+/* === Private variable declarations =========================================================== */
+
+static seq_ring_t ring = NULL;
+static entry_t entries[ENTRY_COUNT];
+
+/* === Private function declarations =========================================================== */
+
+static void* producer_thread(void* arg);
+static void* transform_thread(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void* producer_thread(void* arg)
+{
+    seq_ring_t rb = arg;
+
+    for (uint32_t i = 0; i < TRANSFER_COUNT;) {
+        size_t n = seq_ring_available(rb, 0);
+        size_t seq = seq_ring_cursor(rb, 0);
+
+        if (n > TRANSFER_COUNT - i) { n = TRANSFER_COUNT - i; }
+        for (size_t j = 0; j < n; j++, i++) {
+            entry_t* entry = seq_ring_entry(rb, seq + j);
+            entry->value = i;
+            entry->hops = 0;
+        }
+
+        seq_ring_advance(rb, 0, n);
+        if (n == 0) { sched_yield(); }
+    }
+
+    return NULL;
+}
+
+static void* transform_thread(void* arg)
+{
+    seq_ring_t rb = arg;
+
+    for (size_t done = 0; done < TRANSFER_COUNT;) {
+        size_t n = seq_ring_available(rb, 1);
+        size_t seq = seq_ring_cursor(rb, 1);
+
+        for (size_t j = 0; j < n; j++) {
+            entry_t* entry = seq_ring_entry(rb, seq + j);
+            entry->value *= 2;
+            entry->hops++;
+        }
+
+        seq_ring_advance(rb, 1, n);
+        done += n;
+        if (n == 0) { sched_yield(); }
+    }
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void) { ring = seq_ring_init(entries, sizeof(entry_t), ENTRY_COUNT, STAGE_COUNT); }
+
+void tearDown(void) { seq_ring_deinit(&ring); }
+
+/// @test This test verifies the initial state: only the producer has entries available.
+void test_initial_state(void)
+{
+    TEST_ASSERT_EQUAL_UINT(ENTRY_COUNT, seq_ring_count(ring));
+    TEST_ASSERT_EQUAL_UINT(sizeof(entry_t), seq_ring_entry_size(ring));
+    TEST_ASSERT_EQUAL_UINT(STAGE_COUNT, seq_ring_stages(ring));
+    TEST_ASSERT_EQUAL_UINT(ENTRY_COUNT, seq_ring_available(ring, 0));
+
+    for (size_t stage = 1; stage < STAGE_COUNT; stage++) {
+        TEST_ASSERT_EQUAL_UINT(0, seq_ring_cursor(ring, stage));
+        TEST_ASSERT_EQUAL_UINT(0, seq_ring_available(ring, stage));
+    }
+}
+
+/// @test This test verifies that each stage only sees what its upstream stage is done with, and that entries are
+/// shared in place.
+void test_stages_follow_upstream(void)
+{
+    entry_t* entry = seq_ring_entry(ring, 0);
+    entry->value = 21;
+    seq_ring_advance(ring, 0, 1);
+
+    TEST_ASSERT_EQUAL_UINT(1, seq_ring_available(ring, 1));
+    TEST_ASSERT_EQUAL_UINT(0, seq_ring_available(ring, 2));
+
+    entry_t* same = seq_ring_entry(ring, seq_ring_cursor(ring, 1));
+    TEST_ASSERT_EQUAL_PTR(entry, same);
+    same->value *= 2;
+    seq_ring_advance(ring, 1, 1);
+
+    TEST_ASSERT_EQUAL_UINT(0, seq_ring_available(ring, 1));
+    TEST_ASSERT_EQUAL_UINT(1, seq_ring_available(ring, 2));
+    TEST_ASSERT_EQUAL_UINT32(42, ((entry_t*)seq_ring_entry(ring, seq_ring_cursor(ring, 2)))->value);
+}
+
+/// @test This test verifies that the producer can't reuse entries the last stage is not done with, and that
+/// sequences wrap around the entries.
+void test_producer_waits_for_last_stage(void)
+{
+    seq_ring_advance(ring, 0, ENTRY_COUNT);
+    TEST_ASSERT_EQUAL_UINT(0, seq_ring_available(ring, 0));
+
+    // Done by the middle stage only: still not reusable.
+    seq_ring_advance(ring, 1, seq_ring_available(ring, 1));
+    TEST_ASSERT_EQUAL_UINT(0, seq_ring_available(ring, 0));
+
+    TEST_ASSERT_EQUAL_UINT(ENTRY_COUNT, seq_ring_available(ring, 2));
+    seq_ring_advance(ring, 2, 3);
+    TEST_ASSERT_EQUAL_UINT(3, seq_ring_available(ring, 0));
+    TEST_ASSERT_EQUAL_PTR(seq_ring_entry(ring, 0), seq_ring_entry(ring, seq_ring_cursor(ring, 0)));
+}
+
+/// @test This test verifies a three-stage pipeline with each stage running on its own thread.
+void test_threaded_pipeline(void)
+{
+    pthread_t producer;
+    pthread_t transform;
+
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&producer, NULL, producer_thread, ring));
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&transform, NULL, transform_thread, ring));
+
+    // Every entry must arrive exactly once, in order and transformed exactly once.
+    for (uint32_t i = 0; i < TRANSFER_COUNT;) {
+        size_t n = seq_ring_available(ring, 2);
+        size_t seq = seq_ring_cursor(ring, 2);
+
+        for (size_t j = 0; j < n; j++, i++) {
+            entry_t* entry = seq_ring_entry(ring, seq + j);
+            TEST_ASSERT_EQUAL_UINT32(2 * i, entry->value);
+            TEST_ASSERT_EQUAL_UINT32(1, entry->hops);
+        }
+
+        seq_ring_advance(ring, 2, n);
+        if (n == 0) { sched_yield(); }
+    }
+
+    pthread_join(producer, NULL);
+    pthread_join(transform, NULL);
+}
+
+/* === End of documentation ==================================================================== */
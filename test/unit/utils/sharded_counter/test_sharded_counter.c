@@ -0,0 +1,106 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_sharded_counter.c
+ ** @brief Test suite for the per-thread sharded counters.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <unity.h>
+
+#include <utils/sharded_counter/sharded_counter.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define THREAD_COUNT 4
+
+#define INCREMENTS 100000
+
+/* === Private data type declarations ========================================================== */
+
+static sharded_counter_t counter = NULL;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static void* incrementer_thread(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void* incrementer_thread(void* arg)
+{
+    sharded_counter_t c = arg;
+
+    for (size_t i = 0; i < INCREMENTS; i++) { sharded_counter_add(c, 1); }
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void) { counter = sharded_counter_init(); }
+
+void tearDown(void) { sharded_counter_deinit(&counter); }
+
+/// @test This test verifies that a new counter reads zero.
+void test_initial_state(void)
+{
+    TEST_ASSERT_NOT_NULL(counter);
+    TEST_ASSERT_EQUAL_UINT64(0, sharded_counter_sum(counter));
+}
+
+/// @test This test verifies single-threaded additions and reset.
+void test_add_and_reset(void)
+{
+    sharded_counter_add(counter, 5);
+    sharded_counter_add(counter, 7);
+    TEST_ASSERT_EQUAL_UINT64(12, sharded_counter_sum(counter));
+
+    sharded_counter_reset(counter);
+    TEST_ASSERT_EQUAL_UINT64(0, sharded_counter_sum(counter));
+}
+
+/// @test This test verifies that concurrent increments from several threads are not lost.
+void test_concurrent_increments(void)
+{
+    pthread_t threads[THREAD_COUNT];
+
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, incrementer_thread, counter));
+    }
+    for (size_t i = 0; i < THREAD_COUNT; i++) { pthread_join(threads[i], NULL); }
+
+    TEST_ASSERT_EQUAL_UINT64(THREAD_COUNT * INCREMENTS, sharded_counter_sum(counter));
+}
+
+/// @test This test verifies that deinit sets the handle to NULL.
+void test_deinit(void)
+{
+    sharded_counter_deinit(&counter);
+    TEST_ASSERT_NULL(counter);
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,278 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_shm_submit.c
+ ** @brief Test suite for the shared-memory submission API.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/shm_submit/shm_submit.h>
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define PORT_COUNT 2
+
+#define PORT_RING_SIZE 16
+
+/* === Private data type declarations ========================================================== */
+
+/// A client that skips the library and maps its ring by hand, to corrupt it.
+typedef struct
+{
+    int conn;      ///< Connection to the daemon.
+    uint8_t* map;  ///< Mapped ring: `head` is its first field and the data fills its end.
+    size_t size;   ///< Size of the mapping.
+} rogue_t;
+
+/* === Private variable declarations =========================================================== */
+
+static char path[64];
+static spsc_ring_t ports[PORT_COUNT];
+static uint8_t port_containers[PORT_COUNT][PORT_RING_SIZE];
+static shm_server_t server = NULL;
+
+/* === Private function declarations =========================================================== */
+
+static void* connect_thread(void* arg);
+static shm_client_t connect_client(void);
+static void* delayed_submit(void* arg);
+static rogue_t rogue_connect(void);
+static void rogue_set_head(rogue_t* rogue, uint64_t head);
+static void rogue_disconnect(rogue_t* rogue);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void* connect_thread(void* arg) { return shm_client_connect(arg); }
+
+static shm_client_t connect_client(void)
+{
+    // The client blocks until the daemon accepts it and hands over the ring.
+    shm_client_t client = NULL;
+    pthread_t thread;
+
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, connect_thread, path));
+    while (shm_server_accept(server) == 0) { usleep(100); }
+    pthread_join(thread, (void**)&client);
+
+    TEST_ASSERT_NOT_NULL(client);
+    return client;
+}
+
+static void* delayed_submit(void* arg)
+{
+    const uint8_t note[] = {0x90, 0x3C, 0x64};
+
+    usleep(20000);
+    shm_client_submit(arg, 0, note, sizeof(note));
+
+    return NULL;
+}
+
+static rogue_t rogue_connect(void)
+{
+    rogue_t rogue = {.conn = socket(AF_UNIX, SOCK_STREAM, 0), .map = MAP_FAILED};
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    int fds[2];
+    char control[CMSG_SPACE(sizeof(fds))];
+    uint8_t byte;
+    struct iovec iov = {.iov_base = &byte, .iov_len = 1};
+    struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = control, .msg_controllen = sizeof(control)};
+    struct stat st;
+
+    strcpy(addr.sun_path, path);
+    TEST_ASSERT_EQUAL_INT(0, connect(rogue.conn, (struct sockaddr*)&addr, sizeof(addr)));
+    TEST_ASSERT_EQUAL_UINT(1, shm_server_accept(server));
+    TEST_ASSERT_EQUAL_INT(1, recvmsg(rogue.conn, &msg, 0));
+
+    memcpy(fds, CMSG_DATA(CMSG_FIRSTHDR(&msg)), sizeof(fds));
+    TEST_ASSERT_EQUAL_INT(0, fstat(fds[0], &st));
+    rogue.size = (size_t)st.st_size;
+    rogue.map = mmap(NULL, rogue.size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    TEST_ASSERT_TRUE(rogue.map != MAP_FAILED);
+    close(fds[0]);
+    close(fds[1]);
+
+    return rogue;
+}
+
+static void rogue_set_head(rogue_t* rogue, uint64_t head)
+{
+    __atomic_store_n((uint64_t*)rogue->map, head, __ATOMIC_RELEASE);
+}
+
+static void rogue_disconnect(rogue_t* rogue)
+{
+    munmap(rogue->map, rogue->size);
+    close(rogue->conn);
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    snprintf(path, sizeof(path), "/tmp/test_shm_submit.%d", (int)getpid());
+    for (size_t i = 0; i < PORT_COUNT; i++) { ports[i] = spsc_ring_init(port_containers[i], PORT_RING_SIZE); }
+
+    server = shm_server_init(path, ports, PORT_COUNT);
+    TEST_ASSERT_NOT_NULL(server);
+}
+
+void tearDown(void)
+{
+    shm_server_deinit(&server);
+    for (size_t i = 0; i < PORT_COUNT; i++) { spsc_ring_deinit(&ports[i]); }
+}
+
+/// @test This test verifies that connecting to a missing daemon fails cleanly.
+void test_connect_without_daemon(void)
+{
+    TEST_ASSERT_NULL(shm_client_connect("/tmp/test_shm_submit.missing"));
+    TEST_ASSERT_EQUAL_UINT(0, shm_server_clients(server));
+}
+
+/// @test This test verifies that submitted messages are merged into the TX ring of their port.
+void test_submit_and_merge(void)
+{
+    const uint8_t note[] = {0x90, 0x3C, 0x64};
+    const uint8_t program[] = {0xC1, 0x05};
+    uint8_t data[PORT_RING_SIZE];
+    shm_client_t client = connect_client();
+
+    TEST_ASSERT_EQUAL_UINT(1, shm_server_clients(server));
+
+    TEST_ASSERT_EQUAL_INT(0, shm_client_submit(client, 0, note, sizeof(note)));
+    TEST_ASSERT_EQUAL_INT(0, shm_client_submit(client, 1, program, sizeof(program)));
+    TEST_ASSERT_EQUAL_INT(0, shm_client_submit(client, PORT_COUNT, program, sizeof(program)));
+
+    // The message for the unknown port is consumed and discarded.
+    TEST_ASSERT_EQUAL_UINT(3, shm_server_merge(server));
+
+    TEST_ASSERT_EQUAL_UINT(sizeof(note), spsc_ring_read(ports[0], data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(note, data, sizeof(note));
+    TEST_ASSERT_EQUAL_UINT(sizeof(program), spsc_ring_read(ports[1], data, sizeof(data)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(program, data, sizeof(program));
+
+    shm_client_disconnect(&client);
+    TEST_ASSERT_NULL(client);
+}
+
+/// @test This test verifies that messages wait in the client ring while their port is congested.
+void test_congested_port(void)
+{
+    const uint8_t note[] = {0x90, 0x3C, 0x64};
+    uint8_t data[PORT_RING_SIZE];
+    shm_client_t client = connect_client();
+
+    for (size_t i = 0; i < 6; i++) { TEST_ASSERT_EQUAL_INT(0, shm_client_submit(client, 0, note, sizeof(note))); }
+
+    TEST_ASSERT_EQUAL_UINT(PORT_RING_SIZE / sizeof(note), shm_server_merge(server));
+    TEST_ASSERT_EQUAL_UINT(0, shm_server_merge(server));
+
+    spsc_ring_read(ports[0], data, sizeof(data));
+    TEST_ASSERT_EQUAL_UINT(6 - PORT_RING_SIZE / sizeof(note), shm_server_merge(server));
+
+    shm_client_disconnect(&client);
+}
+
+/// @test This test verifies that a sleeping daemon is woken up by a submission.
+void test_wait_wakes_on_submit(void)
+{
+    shm_client_t client = connect_client();
+    pthread_t thread;
+
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, delayed_submit, client));
+
+    // Far shorter than the timeout, unless the wake-up is missed.
+    for (int i = 0; i < 5 && shm_server_merge(server) == 0; i++) { shm_server_wait(server, 10000); }
+    TEST_ASSERT_EQUAL_UINT(3, spsc_ring_size(ports[0]));
+
+    pthread_join(thread, NULL);
+    shm_client_disconnect(&client);
+}
+
+/// @test This test verifies that a client leaving is noticed, after its last messages are delivered.
+void test_client_leaves(void)
+{
+    const uint8_t note[] = {0x90, 0x3C, 0x64};
+    shm_client_t client = connect_client();
+
+    shm_client_submit(client, 0, note, sizeof(note));
+    shm_client_disconnect(&client);
+
+    shm_server_wait(server, 1000);
+    TEST_ASSERT_EQUAL_UINT(1, shm_server_merge(server));
+    TEST_ASSERT_EQUAL_UINT(3, spsc_ring_size(ports[0]));
+
+    // Nothing pending anymore, so the wait watches the connection.
+    shm_server_wait(server, 1000);
+    shm_server_merge(server);
+    TEST_ASSERT_EQUAL_UINT(0, shm_server_clients(server));
+}
+
+/// @test This test verifies that a client publishing more than its ring can hold is disconnected.
+void test_bogus_head(void)
+{
+    rogue_t rogue = rogue_connect();
+
+    rogue_set_head(&rogue, UINT64_C(1) << 63);
+
+    TEST_ASSERT_EQUAL_UINT(0, shm_server_merge(server));
+    TEST_ASSERT_EQUAL_UINT(0, shm_server_clients(server));
+
+    rogue_disconnect(&rogue);
+}
+
+/// @test This test verifies that a client whose record runs past its head is disconnected.
+void test_record_overruns_head(void)
+{
+    rogue_t rogue = rogue_connect();
+
+    // A record for port 0 claiming a whole byte of payload, but only its header is published.
+    memset(rogue.map + rogue.size - SHM_SUBMIT_RING_SIZE, 0, SHM_SUBMIT_RING_SIZE);
+    rogue.map[rogue.size - SHM_SUBMIT_RING_SIZE + 1] = 1;
+    rogue_set_head(&rogue, 2);
+
+    TEST_ASSERT_EQUAL_UINT(0, shm_server_merge(server));
+    TEST_ASSERT_EQUAL_UINT(0, shm_server_clients(server));
+    TEST_ASSERT_EQUAL_UINT(0, spsc_ring_size(ports[0]));
+
+    rogue_disconnect(&rogue);
+}
+
+/* === End of documentation ==================================================================== */
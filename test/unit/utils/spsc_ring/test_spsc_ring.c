@@ -0,0 +1,378 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_spsc_ring.c
+ ** @brief Test suite for the SPSC Ring data structure.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <string.h>
+#include <unity.h>
+
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define BUFFER_SIZE 16
+
+#define TRANSFER_COUNT 4096
+
+/* === Private data type declarations ========================================================== */
+
+/// Collects what spsc_ring_consume() hands over.
+typedef struct
+{
+    size_t limit;               ///< Bytes to accept in total.
+    size_t calls;               ///< Number of callback calls.
+    size_t len;                 ///< Bytes accepted so far.
+    uint8_t data[BUFFER_SIZE];  ///< Bytes accepted.
+} consumed_t;
+
+static spsc_ring_t ring = NULL;
+static uint8_t ring_container[BUFFER_SIZE] = {0};
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static void* producer_thread(void* arg);
+static void* consumer_thread(void* arg);
+static void transfer_with_strategy(wait_strategy_kind_t kind);
+static size_t consume_some(void* ctx, const uint8_t* data, size_t len);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void* producer_thread(void* arg)
+{
+    spsc_ring_t rb = arg;
+
+    for (size_t i = 0; i < TRANSFER_COUNT; i++) {
+        while (spsc_ring_write_byte(rb, (uint8_t)i) != 0) { sched_yield(); }
+    }
+
+    return NULL;
+}
+
+static void* consumer_thread(void* arg)
+{
+    spsc_ring_t rb = arg;
+    uint8_t data;
+
+    for (size_t i = 0; i < TRANSFER_COUNT; i++) {
+        while (spsc_ring_read_byte(rb, &data) != 0) { sched_yield(); }
+    }
+
+    return NULL;
+}
+
+static void transfer_with_strategy(wait_strategy_kind_t kind)
+{
+    pthread_t producer;
+    wait_strategy_t ws = wait_strategy_init(kind, 128);
+    uint8_t data = 0;
+
+    spsc_ring_set_wait_strategy(ring, ws);
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&producer, NULL, producer_thread, ring));
+
+    // Every byte must arrive exactly once and in order.
+    for (size_t i = 0; i < TRANSFER_COUNT; i++) {
+        spsc_ring_read_byte_wait(ring, &data);
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)i, data);
+    }
+
+    pthread_join(producer, NULL);
+    TEST_ASSERT(spsc_ring_is_empty(ring));
+
+    spsc_ring_set_wait_strategy(ring, NULL);
+    wait_strategy_deinit(&ws);
+}
+
+static size_t consume_some(void* ctx, const uint8_t* data, size_t len)
+{
+    consumed_t* consumed = ctx;
+    size_t take = consumed->limit - consumed->len;
+
+    if (take > len) { take = len; }
+    memcpy(&consumed->data[consumed->len], data, take);
+    consumed->len += take;
+    consumed->calls++;
+
+    return take;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void) { ring = spsc_ring_init(ring_container, BUFFER_SIZE); }
+
+void tearDown(void) { spsc_ring_deinit(&ring); }
+
+/// @test This test verifies that the ring is initialized empty and with the expected capacity.
+void test_initial_state(void)
+{
+    TEST_ASSERT_NOT_NULL(ring);
+    TEST_ASSERT_EQUAL_UINT(BUFFER_SIZE, spsc_ring_capacity(ring));
+    TEST_ASSERT_EQUAL_UINT(0, spsc_ring_size(ring));
+    TEST_ASSERT(spsc_ring_is_empty(ring));
+    TEST_ASSERT(!spsc_ring_is_full(ring));
+}
+
+/// @test This test verifies that reading an empty ring returns -1.
+void test_read_empty_ring(void)
+{
+    uint8_t data = 0;
+
+    TEST_ASSERT_EQUAL_INT(-1, spsc_ring_read_byte(ring, &data));
+}
+
+/// @test This test verifies that, unlike ring_buffer_write_byte(), writing to a full ring is rejected and the old data
+/// is kept.
+void test_write_full_ring_is_rejected(void)
+{
+    uint8_t data = 0;
+
+    for (size_t i = 0; i < BUFFER_SIZE; i++) { TEST_ASSERT_EQUAL_INT(0, spsc_ring_write_byte(ring, (uint8_t)i)); }
+
+    TEST_ASSERT(spsc_ring_is_full(ring));
+    TEST_ASSERT_EQUAL_INT(-1, spsc_ring_write_byte(ring, 0xFF));
+    TEST_ASSERT_EQUAL_UINT(BUFFER_SIZE, spsc_ring_size(ring));
+
+    // The oldest byte is still the first one written.
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_read_byte(ring, &data));
+    TEST_ASSERT_EQUAL_UINT8(0, data);
+}
+
+/// @test This test verifies FIFO behavior across several wraparounds of the free-running indices.
+void test_read_and_write_with_wrapping(void)
+{
+    uint8_t data = 0;
+
+    for (size_t i = 0; i < 5 * BUFFER_SIZE; i++) {
+        TEST_ASSERT_EQUAL_INT(0, spsc_ring_write_byte(ring, (uint8_t)i));
+        TEST_ASSERT_EQUAL_INT(0, spsc_ring_write_byte(ring, (uint8_t)(i + 1)));
+        TEST_ASSERT_EQUAL_INT(0, spsc_ring_read_byte(ring, &data));
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)i, data);
+        TEST_ASSERT_EQUAL_INT(0, spsc_ring_read_byte(ring, &data));
+        TEST_ASSERT_EQUAL_UINT8((uint8_t)(i + 1), data);
+    }
+
+    TEST_ASSERT(spsc_ring_is_empty(ring));
+}
+
+/// @test This test verifies that a bulk read stops at the available data and handles the wraparound of the buffer.
+void test_bulk_read_with_wrapping(void)
+{
+    uint8_t data[BUFFER_SIZE] = {0};
+
+    // Move the indices close to the end of the buffer.
+    for (size_t i = 0; i < BUFFER_SIZE - 2; i++) { spsc_ring_write_byte(ring, 0); }
+    TEST_ASSERT_EQUAL_UINT(BUFFER_SIZE - 2, spsc_ring_read(ring, data, BUFFER_SIZE));
+
+    for (size_t i = 0; i < 6; i++) { spsc_ring_write_byte(ring, (uint8_t)i); }
+
+    TEST_ASSERT_EQUAL_UINT(6, spsc_ring_read(ring, data, BUFFER_SIZE));
+    for (size_t i = 0; i < 6; i++) { TEST_ASSERT_EQUAL_UINT8(i, data[i]); }
+
+    TEST_ASSERT_EQUAL_UINT(0, spsc_ring_read(ring, data, BUFFER_SIZE));
+    TEST_ASSERT(spsc_ring_is_empty(ring));
+}
+
+/// @test This test verifies that a bulk write is all or nothing.
+void test_bulk_write_all_or_nothing(void)
+{
+    const uint8_t block[BUFFER_SIZE] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    uint8_t data[BUFFER_SIZE] = {0};
+
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_write(ring, block, 12));
+
+    // Only 4 bytes are free, so a 5 byte block is refused entirely.
+    TEST_ASSERT_EQUAL_INT(-1, spsc_ring_write(ring, block, 5));
+    TEST_ASSERT_EQUAL_UINT(12, spsc_ring_size(ring));
+
+    // Free some room and write across the end of the buffer.
+    TEST_ASSERT_EQUAL_UINT(8, spsc_ring_read(ring, data, 8));
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_write(ring, block, 12));
+    TEST_ASSERT(spsc_ring_is_full(ring));
+
+    TEST_ASSERT_EQUAL_UINT(BUFFER_SIZE, spsc_ring_read(ring, data, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&block[8], data, 4);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(block, &data[4], 12);
+}
+
+/// @test This test verifies that blocks written with streaming stores wrap around like regular ones.
+void test_bulk_write_streaming(void)
+{
+    const uint8_t block[BUFFER_SIZE] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    uint8_t data[BUFFER_SIZE] = {0};
+
+    spsc_ring_set_stream_threshold(ring, 0);
+
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_write(ring, block, 5));
+    TEST_ASSERT_EQUAL_UINT(5, spsc_ring_read(ring, data, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_write(ring, block, BUFFER_SIZE));
+
+    TEST_ASSERT_EQUAL_UINT(BUFFER_SIZE, spsc_ring_read(ring, data, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(block, data, BUFFER_SIZE);
+}
+
+/// @test This test verifies that data is handed over in place, in windows, until the callback stops.
+void test_consume_in_place(void)
+{
+    const uint8_t block[BUFFER_SIZE] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    uint8_t data[BUFFER_SIZE] = {0};
+    consumed_t consumed = {.limit = 9};
+
+    spsc_ring_set_prefetch_distance(ring, 4);
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_write(ring, block, 10));
+    TEST_ASSERT_EQUAL_UINT(10, spsc_ring_read(ring, data, 10));
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_write(ring, block, 12));
+
+    // Windows of 4 bytes, split at the end of the buffer: 4, 2, then 4 of which only 3 are taken.
+    TEST_ASSERT_EQUAL_UINT(9, spsc_ring_consume(ring, consume_some, &consumed, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL_UINT(3, consumed.calls);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(block, consumed.data, 9);
+
+    TEST_ASSERT_EQUAL_UINT(3, spsc_ring_size(ring));
+    TEST_ASSERT_EQUAL_UINT(3, spsc_ring_read(ring, data, BUFFER_SIZE));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&block[9], data, 3);
+}
+
+/// @test This test verifies that a byte is found in the pending data across the end of the buffer.
+void test_find(void)
+{
+    const uint8_t sysex[] = {0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7, 0x90};
+    uint8_t data[BUFFER_SIZE] = {0};
+    size_t position = 0;
+
+    spsc_ring_set_prefetch_distance(ring, 2);
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_write(ring, data, 12));
+    TEST_ASSERT_EQUAL_UINT(12, spsc_ring_read(ring, data, 12));
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_write(ring, sysex, sizeof(sysex)));
+
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_find(ring, 0xF7, &position));
+    TEST_ASSERT_EQUAL_UINT(5, position);
+    TEST_ASSERT_EQUAL_INT(-1, spsc_ring_find(ring, 0xF8, &position));
+    TEST_ASSERT_EQUAL_UINT(sizeof(sysex), spsc_ring_size(ring));
+}
+
+/// @test This test verifies that spsc_ring_reset() leaves the ring empty.
+void test_ring_reset(void)
+{
+    for (size_t i = 0; i < BUFFER_SIZE; i++) { spsc_ring_write_byte(ring, (uint8_t)i); }
+
+    spsc_ring_reset(ring);
+
+    TEST_ASSERT(spsc_ring_is_empty(ring));
+    TEST_ASSERT_EQUAL_UINT(0, spsc_ring_size(ring));
+}
+
+/// @test This test verifies the written, read and rejected byte statistics.
+void test_statistics(void)
+{
+    spsc_ring_stats_t stats;
+    uint8_t data[4];
+
+    // Disabled by default.
+    spsc_ring_write_byte(ring, 0);
+    spsc_ring_get_stats(ring, &stats);
+    TEST_ASSERT_EQUAL_UINT(0, stats.written);
+
+    spsc_ring_enable_stats(ring);
+
+    for (size_t i = 0; i < BUFFER_SIZE + 3; i++) { spsc_ring_write_byte(ring, (uint8_t)i); }
+    spsc_ring_read_byte(ring, &data[0]);
+    spsc_ring_read(ring, data, sizeof(data));
+
+    spsc_ring_get_stats(ring, &stats);
+    TEST_ASSERT_EQUAL_UINT(BUFFER_SIZE - 1, stats.written);
+    TEST_ASSERT_EQUAL_UINT(4, stats.rejected);
+    TEST_ASSERT_EQUAL_UINT(5, stats.read);
+}
+
+/// @test This test verifies that a snapshot copies the pending data without consuming it.
+void test_snapshot(void)
+{
+    uint8_t data[BUFFER_SIZE];
+    size_t seq;
+    bool torn;
+
+    TEST_ASSERT_EQUAL_UINT(0, spsc_ring_snapshot(ring, data, sizeof(data), &seq, &torn));
+
+    // Wrap the indices around the end of the buffer.
+    for (size_t i = 0; i < BUFFER_SIZE - 2; i++) { spsc_ring_write_byte(ring, 0); }
+    spsc_ring_read(ring, data, BUFFER_SIZE - 2);
+    for (size_t i = 0; i < 5; i++) { spsc_ring_write_byte(ring, (uint8_t)('a' + i)); }
+
+    TEST_ASSERT_EQUAL_UINT(5, spsc_ring_snapshot(ring, data, sizeof(data), &seq, &torn));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("abcde", data, 5);
+    TEST_ASSERT_EQUAL_UINT(BUFFER_SIZE - 2, seq);
+    TEST_ASSERT(!torn);
+    TEST_ASSERT_EQUAL_UINT(5, spsc_ring_size(ring));
+
+    // Limited to the destination size.
+    TEST_ASSERT_EQUAL_UINT(2, spsc_ring_snapshot(ring, data, 2, &seq, &torn));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("ab", data, 2);
+}
+
+/// @test This test verifies that snapshots taken while both sides are running always hold the bytes at the reported
+/// stream positions.
+void test_snapshot_while_running(void)
+{
+    pthread_t producer;
+    pthread_t consumer;
+    uint8_t data[BUFFER_SIZE];
+    size_t seq;
+    size_t written;
+    size_t read;
+    bool torn;
+
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&producer, NULL, producer_thread, ring));
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&consumer, NULL, consumer_thread, ring));
+
+    do {
+        size_t count = spsc_ring_snapshot(ring, data, sizeof(data), &seq, &torn);
+        for (size_t i = 0; i < count; i++) { TEST_ASSERT_EQUAL_UINT8((uint8_t)(seq + i), data[i]); }
+        spsc_ring_positions(ring, &written, &read);
+    } while (read < TRANSFER_COUNT);
+
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+}
+
+/// @test This test verifies a producer thread and a consumer thread exchanging data with a spinning consumer.
+void test_threaded_transfer_spin(void) { transfer_with_strategy(WAIT_STRATEGY_SPIN); }
+
+/// @test This test verifies a producer thread and a consumer thread exchanging data with a yielding consumer.
+void test_threaded_transfer_yield(void) { transfer_with_strategy(WAIT_STRATEGY_YIELD); }
+
+/// @test This test verifies a producer thread and a consumer thread exchanging data with a parking consumer.
+void test_threaded_transfer_park(void) { transfer_with_strategy(WAIT_STRATEGY_PARK); }
+
+/// @test This test verifies a producer thread and a consumer thread exchanging data with an adaptive consumer.
+void test_threaded_transfer_adaptive(void) { transfer_with_strategy(WAIT_STRATEGY_ADAPTIVE); }
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,108 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_tsc_clock.c
+ ** @brief Test suite for the calibrated TSC clock.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/tsc_clock/tsc_clock.h>
+
+/* === Macros definitions ====================================================================== */
+
+/// Accepted difference against CLOCK_MONOTONIC, in nanoseconds.
+#define TOLERANCE_NS 2000000ULL
+
+#define SLEEP_US 20000
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static uint64_t monotonic_ns(void);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void) { tsc_clock_init(); }
+
+void tearDown(void) {}
+
+/// @test This test verifies that the clock reports times on the CLOCK_MONOTONIC time base.
+void test_now_matches_monotonic_clock(void)
+{
+    uint64_t reference = monotonic_ns();
+    uint64_t now = tsc_clock_now_ns();
+
+    TEST_ASSERT_UINT_WITHIN(TOLERANCE_NS, reference, now);
+}
+
+/// @test This test verifies that a measured interval converted to nanoseconds matches the elapsed time.
+void test_cycles_to_ns_measures_interval(void)
+{
+    uint64_t start = tsc_clock_cycles();
+    uint64_t reference = monotonic_ns();
+
+    usleep(SLEEP_US);
+
+    uint64_t elapsed = tsc_clock_cycles_to_ns(tsc_clock_cycles_serialized() - start);
+    uint64_t expected = monotonic_ns() - reference;
+
+    TEST_ASSERT_UINT_WITHIN(TOLERANCE_NS, expected, elapsed);
+}
+
+/// @test This test verifies that the raw calibration converts cycles the same way tsc_clock_cycles_to_ns() does.
+void test_raw_calibration(void)
+{
+    TEST_ASSERT_EQUAL_UINT64(tsc_clock_cycles_to_ns(1ULL << 32), tsc_clock_cycles_mult());
+}
+
+/// @test This test verifies that recalibrating keeps the clock monotonic and on the CLOCK_MONOTONIC time base.
+void test_recalibrate_keeps_time_base(void)
+{
+    uint64_t before = tsc_clock_now_ns();
+
+    usleep(SLEEP_US);
+    tsc_clock_recalibrate();
+
+    uint64_t after = tsc_clock_now_ns();
+
+    TEST_ASSERT(after >= before);
+    TEST_ASSERT_UINT_WITHIN(TOLERANCE_NS, monotonic_ns(), after);
+}
+
+/* === End of documentation ==================================================================== */
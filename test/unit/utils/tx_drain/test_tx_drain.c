@@ -0,0 +1,203 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_tx_drain.c
+ ** @brief Test suite for the load-adaptive TX drain loop.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/tsc_clock/tsc_clock.h>
+#include <utils/tx_drain/tx_drain.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define BUFFER_SIZE 1024
+
+#define MAX_BATCH 256
+
+#define MAX_LATENCY_US 50000
+
+/* === Private data type declarations ========================================================== */
+
+static spsc_ring_t ring = NULL;
+static uint8_t ring_container[BUFFER_SIZE] = {0};
+
+static tx_drain_t drain = NULL;
+static uint8_t batch[MAX_BATCH] = {0};
+
+static const tx_drain_config_t config = {.max_batch = MAX_BATCH, .max_latency_us = MAX_LATENCY_US};
+
+/* === Private variable declarations =========================================================== */
+
+static uint8_t sunk[BUFFER_SIZE];
+static size_t sunk_len;
+static size_t sink_calls;
+
+/* === Private function declarations =========================================================== */
+
+static int test_sink(void* ctx, const uint8_t* data, size_t len);
+static void write_bytes(size_t count);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static int test_sink(void* ctx, const uint8_t* data, size_t len)
+{
+    (void)ctx;
+    memcpy(&sunk[sunk_len], data, len);
+    sunk_len += len;
+    sink_calls++;
+    return 0;
+}
+
+static void write_bytes(size_t count)
+{
+    for (size_t i = 0; i < count; i++) { spsc_ring_write_byte(ring, (uint8_t)i); }
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    tsc_clock_init();
+    ring = spsc_ring_init(ring_container, BUFFER_SIZE);
+    drain = tx_drain_init(ring, &config, batch, test_sink, NULL);
+    sunk_len = 0;
+    sink_calls = 0;
+}
+
+void tearDown(void)
+{
+    tx_drain_deinit(&drain);
+    spsc_ring_deinit(&ring);
+}
+
+/// @test This test verifies the batch target: 1 under light load, proportional to the arrival rate in between, and
+/// capped at the maximum batch under heavy load.
+void test_target_batch_follows_rate(void)
+{
+    TEST_ASSERT_EQUAL_UINT(1, tx_drain_target_batch(&config, 0));
+    TEST_ASSERT_EQUAL_UINT(1, tx_drain_target_batch(&config, 10));
+
+    // 1000 bytes/s during 50 ms is 50 bytes.
+    TEST_ASSERT_EQUAL_UINT(50, tx_drain_target_batch(&config, 1000));
+
+    TEST_ASSERT_EQUAL_UINT(MAX_BATCH, tx_drain_target_batch(&config, 100000000));
+}
+
+/// @test This test verifies that polling an empty ring does not call the sink.
+void test_poll_empty_ring(void)
+{
+    TEST_ASSERT_EQUAL_UINT(0, tx_drain_poll(drain));
+    TEST_ASSERT_EQUAL_UINT(0, sink_calls);
+}
+
+/// @test This test verifies that under light load a single message is sent right away.
+void test_light_load_sends_immediately(void)
+{
+    tx_drain_stats_t stats;
+
+    usleep(10000);
+    write_bytes(3);
+
+    TEST_ASSERT_EQUAL_UINT(3, tx_drain_poll(drain));
+    TEST_ASSERT_EQUAL_UINT(1, sink_calls);
+
+    tx_drain_get_stats(drain, &stats);
+    TEST_ASSERT_EQUAL_UINT(3, stats.last_batch);
+    TEST_ASSERT_EQUAL_UINT(1, stats.batches);
+    TEST_ASSERT(spsc_ring_is_empty(ring));
+}
+
+/// @test This test verifies that under heavy load the drain holds data back until a full batch is available, never
+/// exceeds the batch cap, and flushes the rest once the latency budget expires.
+void test_heavy_load_batches_up_to_latency(void)
+{
+    tx_drain_stats_t stats;
+
+    // A burst right after init looks like a very high arrival rate.
+    write_bytes(64);
+    TEST_ASSERT_EQUAL_UINT(0, tx_drain_poll(drain));
+
+    tx_drain_get_stats(drain, &stats);
+    TEST_ASSERT_EQUAL_UINT(MAX_BATCH, stats.target_batch);
+
+    // Once a full batch is pending it goes out in a single sink call.
+    write_bytes(MAX_BATCH);
+    TEST_ASSERT_EQUAL_UINT(MAX_BATCH, tx_drain_poll(drain));
+    TEST_ASSERT_EQUAL_UINT(1, sink_calls);
+
+    // The remaining 64 bytes are sent after the latency budget.
+    usleep(2 * MAX_LATENCY_US);
+    TEST_ASSERT_EQUAL_UINT(64, tx_drain_poll(drain));
+    TEST_ASSERT_EQUAL_UINT(2, sink_calls);
+    TEST_ASSERT_EQUAL_UINT(64 + MAX_BATCH, sunk_len);
+
+    tx_drain_get_stats(drain, &stats);
+    TEST_ASSERT_EQUAL_UINT(64 + MAX_BATCH, stats.bytes);
+    TEST_ASSERT_EQUAL_UINT(64, stats.last_batch);
+}
+
+/// @test This test verifies that a flush carried out by the drain's read neither reaches the sink nor is mistaken for
+/// a burst of arrivals on the next poll.
+void test_flush_between_polls(void)
+{
+    tx_drain_stats_t stats;
+    uint64_t rate;
+
+    usleep(20000);
+    write_bytes(5);
+    TEST_ASSERT_EQUAL_UINT(5, tx_drain_poll(drain));
+    TEST_ASSERT_EQUAL_UINT(1, sink_calls);
+
+    // The flush happens inside the drain's read, so the poll finds nothing left to send.
+    write_bytes(100);
+    spsc_ring_request_flush(ring);
+    usleep(2 * MAX_LATENCY_US);
+    TEST_ASSERT_EQUAL_UINT(0, tx_drain_poll(drain));
+    TEST_ASSERT_EQUAL_UINT(1, sink_calls);
+
+    tx_drain_get_stats(drain, &stats);
+    TEST_ASSERT_EQUAL_UINT(1, stats.batches);
+    TEST_ASSERT_EQUAL_UINT(5, stats.bytes);
+    TEST_ASSERT_EQUAL_UINT(5, stats.last_batch);
+    rate = stats.arrival_rate;
+
+    // A single byte after a pause must lower the arrival rate, not blow it up.
+    usleep(10000);
+    write_bytes(1);
+    tx_drain_poll(drain);
+
+    tx_drain_get_stats(drain, &stats);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT64(rate, stats.arrival_rate);
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,198 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_tx_watchdog.c
+ ** @brief Test suite for the stalled-consumer watchdog.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/sharded_counter/sharded_counter.h>
+#include <utils/spsc_ring/spsc_ring.h>
+#include <utils/tsc_clock/tsc_clock.h>
+#include <utils/tx_watchdog/tx_watchdog.h>
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define BUFFER_SIZE 16
+
+#define DEADLINE_MS 20
+
+/* === Private data type declarations ========================================================== */
+
+static spsc_ring_t ring = NULL;
+static uint8_t ring_container[BUFFER_SIZE] = {0};
+
+/* === Private variable declarations =========================================================== */
+
+static int last_event_id;
+static bool last_event_stalled;
+static size_t event_count;
+
+/* === Private function declarations =========================================================== */
+
+static void on_event(void* ctx, int id, bool stalled);
+static void wait_past_deadline(void);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void on_event(void* ctx, int id, bool stalled)
+{
+    (void)ctx;
+    last_event_id = id;
+    last_event_stalled = stalled;
+    event_count++;
+}
+
+static void wait_past_deadline(void) { usleep(2 * DEADLINE_MS * 1000); }
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    ring = spsc_ring_init(ring_container, BUFFER_SIZE);
+    spsc_ring_enable_stats(ring);
+    last_event_id = -1;
+    last_event_stalled = false;
+    event_count = 0;
+}
+
+void tearDown(void) { spsc_ring_deinit(&ring); }
+
+/// @test This test verifies that an idle ring is never reported as stalled, no matter how long it stays idle.
+void test_idle_ring_is_not_stalled(void)
+{
+    tx_watchdog_t wd = tx_watchdog_init(DEADLINE_MS, TX_WATCHDOG_ACTION_NONE, on_event, NULL);
+    int id = tx_watchdog_add(wd, ring);
+
+    wait_past_deadline();
+
+    TEST_ASSERT_EQUAL_UINT(0, tx_watchdog_sample(wd));
+    TEST_ASSERT(!tx_watchdog_is_stalled(wd, id));
+    TEST_ASSERT_EQUAL_UINT(0, event_count);
+
+    tx_watchdog_deinit(&wd);
+    TEST_ASSERT_NULL(wd);
+}
+
+/// @test This test verifies that pending data without consumer progress raises a stall event after the deadline,
+/// but not before, and that the recovery is reported too.
+void test_stall_and_recovery_events(void)
+{
+    uint8_t data;
+    tx_watchdog_t wd = tx_watchdog_init(DEADLINE_MS, TX_WATCHDOG_ACTION_NONE, on_event, NULL);
+    int id = tx_watchdog_add(wd, ring);
+
+    spsc_ring_write_byte(ring, 'a');
+    spsc_ring_write_byte(ring, 'b');
+
+    TEST_ASSERT_EQUAL_UINT(0, tx_watchdog_sample(wd));
+
+    wait_past_deadline();
+    TEST_ASSERT_EQUAL_UINT(1, tx_watchdog_sample(wd));
+    TEST_ASSERT(tx_watchdog_is_stalled(wd, id));
+    TEST_ASSERT_EQUAL_UINT(1, event_count);
+    TEST_ASSERT_EQUAL_INT(id, last_event_id);
+    TEST_ASSERT(last_event_stalled);
+
+    // Further samples don't repeat the event.
+    tx_watchdog_sample(wd);
+    TEST_ASSERT_EQUAL_UINT(1, event_count);
+
+    // The consumer makes progress again.
+    spsc_ring_read_byte(ring, &data);
+    TEST_ASSERT_EQUAL_UINT(0, tx_watchdog_sample(wd));
+    TEST_ASSERT_EQUAL_UINT(2, event_count);
+    TEST_ASSERT(!last_event_stalled);
+
+    tx_watchdog_deinit(&wd);
+}
+
+/// @test This test verifies the drop action: a stalled ring drops new data until its consumer recovers.
+void test_drop_action(void)
+{
+    uint8_t data;
+    spsc_ring_stats_t stats;
+    tx_watchdog_t wd = tx_watchdog_init(DEADLINE_MS, TX_WATCHDOG_ACTION_DROP, NULL, NULL);
+
+    tx_watchdog_add(wd, ring);
+    for (size_t i = 0; i < BUFFER_SIZE; i++) { spsc_ring_write_byte(ring, (uint8_t)i); }
+
+    wait_past_deadline();
+    tx_watchdog_sample(wd);
+    TEST_ASSERT(spsc_ring_drop_mode(ring));
+
+    // Writes succeed, but their data is discarded.
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_write_byte(ring, 0xFF));
+    spsc_ring_get_stats(ring, &stats);
+    TEST_ASSERT_EQUAL_UINT(1, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT(0, stats.rejected);
+
+    spsc_ring_read_byte(ring, &data);
+    tx_watchdog_sample(wd);
+    TEST_ASSERT(!spsc_ring_drop_mode(ring));
+
+    tx_watchdog_deinit(&wd);
+}
+
+/// @test This test verifies the flush action: the pending data is discarded as soon as the consumer reads again.
+void test_flush_action(void)
+{
+    uint8_t data;
+    tx_watchdog_t wd = tx_watchdog_init(DEADLINE_MS, TX_WATCHDOG_ACTION_FLUSH, NULL, NULL);
+
+    tx_watchdog_add(wd, ring);
+    for (size_t i = 0; i < 4; i++) { spsc_ring_write_byte(ring, (uint8_t)i); }
+
+    wait_past_deadline();
+    TEST_ASSERT_EQUAL_UINT(1, tx_watchdog_sample(wd));
+
+    // Stale data is gone, fresh data goes through.
+    spsc_ring_write_byte(ring, 'z');
+    TEST_ASSERT_EQUAL_INT(-1, spsc_ring_read_byte(ring, &data));
+    spsc_ring_write_byte(ring, 'y');
+    TEST_ASSERT_EQUAL_INT(0, spsc_ring_read_byte(ring, &data));
+    TEST_ASSERT_EQUAL_UINT8('y', data);
+
+    TEST_ASSERT_EQUAL_UINT(0, tx_watchdog_sample(wd));
+
+    tx_watchdog_deinit(&wd);
+}
+
+/// @test This test verifies that a watchdog refuses rings beyond its capacity.
+void test_add_beyond_capacity(void)
+{
+    tx_watchdog_t wd = tx_watchdog_init(DEADLINE_MS, TX_WATCHDOG_ACTION_NONE, NULL, NULL);
+
+    for (int i = 0; i < TX_WATCHDOG_MAX_RINGS; i++) { TEST_ASSERT_EQUAL_INT(i, tx_watchdog_add(wd, ring)); }
+    TEST_ASSERT_EQUAL_INT(-1, tx_watchdog_add(wd, ring));
+
+    tx_watchdog_deinit(&wd);
+}
+
+/* === End of documentation ==================================================================== */
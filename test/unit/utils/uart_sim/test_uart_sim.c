@@ -0,0 +1,275 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_uart_sim.c
+ ** @brief Test suite for the UART TX-empty interrupt simulator.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <unity.h>
+
+#include <utils/ring_buffer/ring_buffer.h>
+#include <utils/tsc_clock/tsc_clock.h>
+#include <utils/uart_sim/uart_sim.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define RING_SIZE 64
+
+#define STREAM_SIZE 256
+
+/// Byte period used by the tests, much shorter than MIDI's to keep them fast.
+#define PERIOD_NS 50000U
+
+/// How long to wait for the simulator to reach a given point before giving up.
+#define TIMEOUT_NS 2000000000ULL
+
+/* === Private data type declarations ========================================================== */
+
+/// Scripted ISR: each character of the script says whether an interrupt finds a byte ('x') or not.
+typedef struct
+{
+    const char* script;
+    size_t calls;
+    uint64_t stall_ns;
+} script_t;
+
+/* === Private variable declarations =========================================================== */
+
+static ring_buffer_t ring;
+static uint8_t ring_container[RING_SIZE];
+static uint8_t line[STREAM_SIZE];
+static uart_sim_t sim = NULL;
+
+/* === Private function declarations =========================================================== */
+
+static int ring_isr(void* ctx, uint8_t* byte);
+static int script_isr(void* ctx, uint8_t* byte);
+static void nap(unsigned int periods);
+static bool wait_for_bytes(uint64_t count);
+static uint64_t interrupts(void);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static int ring_isr(void* ctx, uint8_t* byte) { return ring_buffer_read_byte(ctx, byte); }
+
+static int script_isr(void* ctx, uint8_t* byte)
+{
+    script_t* script = ctx;
+    size_t call = script->calls++;
+
+    if (call == 0 && script->stall_ns) {
+        uint64_t until = tsc_clock_now_ns() + script->stall_ns;
+        while (tsc_clock_now_ns() < until) {}
+    }
+    if (call >= strlen(script->script) || script->script[call] != 'x') { return -1; }
+
+    *byte = (uint8_t)call;
+    return 0;
+}
+
+static void nap(unsigned int periods)
+{
+    // Against an absolute deadline, so the simulator's signal interrupting the sleep cannot stretch it.
+    uint64_t until = tsc_clock_now_ns() + (uint64_t)periods * PERIOD_NS;
+    struct timespec due = {.tv_sec = (time_t)(until / 1000000000ULL), .tv_nsec = (long)(until % 1000000000ULL)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) != 0) {}
+}
+
+static bool wait_for_bytes(uint64_t count)
+{
+    uint64_t deadline = tsc_clock_now_ns() + TIMEOUT_NS;
+    uart_sim_stats_t stats;
+
+    do {
+        uart_sim_get_stats(sim, &stats);
+        if (stats.bytes >= count) { return true; }
+        nap(1);
+    } while (tsc_clock_now_ns() < deadline);
+
+    return false;
+}
+
+static uint64_t interrupts(void)
+{
+    uart_sim_stats_t stats;
+    uart_sim_get_stats(sim, &stats);
+    return stats.interrupts;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    tsc_clock_init();
+    ring = ring_buffer_init(ring_container, RING_SIZE);
+    memset(line, 0, sizeof(line));
+}
+
+void tearDown(void)
+{
+    uart_sim_deinit(&sim);
+    ring_buffer_deinit(&ring);
+}
+
+/// @test This test verifies that the signal handler ISR drains a ring onto the line, in order, and measures it.
+void test_signal_drains_ring(void)
+{
+    uart_sim_config_t config = {.mode = UART_SIM_SIGNAL, .byte_period_ns = PERIOD_NS, .isr = ring_isr, .ctx = ring};
+    config.line = line;
+    config.line_size = 8;
+    uint8_t data[RING_SIZE];
+    uart_sim_stats_t stats;
+    uint64_t binned = 0;
+
+    for (size_t i = 0; i < RING_SIZE; i++) { data[i] = (uint8_t)(i * 3); }
+    ring_buffer_write(ring, data, RING_SIZE);
+
+    sim = uart_sim_init(&config);
+    TEST_ASSERT_EQUAL_INT(0, uart_sim_start(sim));
+    TEST_ASSERT_TRUE(wait_for_bytes(RING_SIZE));
+    uart_sim_stop(sim);
+
+    TEST_ASSERT_TRUE(ring_buffer_is_empty(ring));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, line, 8);
+    TEST_ASSERT_EQUAL_UINT8(0, line[8]);
+
+    uart_sim_get_stats(sim, &stats);
+    TEST_ASSERT_EQUAL_UINT64(RING_SIZE, stats.bytes);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.underruns);
+    TEST_ASSERT_TRUE(stats.interrupts >= RING_SIZE);
+    TEST_ASSERT_TRUE(stats.min_cycles <= stats.mean_cycles && stats.mean_cycles <= stats.max_cycles);
+    for (size_t i = 0; i < UART_SIM_HISTOGRAM_BINS; i++) { binned += stats.histogram[i]; }
+    TEST_ASSERT_EQUAL_UINT64(stats.interrupts, binned);
+
+    // Stopped for good: no interrupt fires anymore.
+    nap(10);
+    TEST_ASSERT_EQUAL_UINT64(stats.interrupts, interrupts());
+}
+
+/// @test This test verifies that only one simulator can own the signal at a time.
+void test_signal_is_exclusive(void)
+{
+    uart_sim_config_t config = {.mode = UART_SIM_SIGNAL, .byte_period_ns = PERIOD_NS, .isr = ring_isr, .ctx = ring};
+    uart_sim_t other = uart_sim_init(&config);
+
+    sim = uart_sim_init(&config);
+    TEST_ASSERT_EQUAL_INT(0, uart_sim_start(sim));
+    TEST_ASSERT_EQUAL_INT(-1, uart_sim_start(other));
+
+    uart_sim_stop(sim);
+    TEST_ASSERT_EQUAL_INT(0, uart_sim_start(other));
+    uart_sim_deinit(&other);
+}
+
+/// @test This test verifies that a masked interrupt does not fire, and fires once unmasked.
+void test_signal_irq_disable(void)
+{
+    uart_sim_config_t config = {.mode = UART_SIM_SIGNAL, .byte_period_ns = PERIOD_NS, .isr = ring_isr, .ctx = ring};
+
+    sim = uart_sim_init(&config);
+    TEST_ASSERT_EQUAL_INT(0, uart_sim_start(sim));
+
+    uart_sim_irq_disable(sim);
+    uint64_t fired = interrupts();
+    nap(10);
+    TEST_ASSERT_EQUAL_UINT64(fired, interrupts());
+
+    uart_sim_irq_enable(sim);
+    TEST_ASSERT_TRUE(interrupts() > fired);
+}
+
+/// @test This test verifies that underruns are counted only when a stream resumes after running dry.
+void test_underruns(void)
+{
+    script_t script = {.script = "xxx..x.xxx"};
+    uart_sim_config_t config = {
+        .mode = UART_SIM_THREAD, .byte_period_ns = PERIOD_NS, .isr = script_isr, .ctx = &script};
+    uart_sim_stats_t stats;
+
+    sim = uart_sim_init(&config);
+    TEST_ASSERT_EQUAL_INT(0, uart_sim_start(sim));
+    TEST_ASSERT_TRUE(wait_for_bytes(7));
+    nap(4);
+    uart_sim_stop(sim);
+
+    uart_sim_get_stats(sim, &stats);
+    TEST_ASSERT_EQUAL_UINT64(7, stats.bytes);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.underruns);
+    TEST_ASSERT_EQUAL_UINT64(script.calls, stats.interrupts);
+}
+
+/// @test This test verifies that an interrupt fired more than a byte period late is reported.
+void test_late_interrupts(void)
+{
+    script_t script = {.script = "xx", .stall_ns = 4 * PERIOD_NS};
+    uart_sim_config_t config = {
+        .mode = UART_SIM_THREAD, .byte_period_ns = PERIOD_NS, .isr = script_isr, .ctx = &script};
+    uart_sim_stats_t stats;
+
+    sim = uart_sim_init(&config);
+    TEST_ASSERT_EQUAL_INT(0, uart_sim_start(sim));
+    TEST_ASSERT_TRUE(wait_for_bytes(2));
+    uart_sim_stop(sim);
+
+    uart_sim_get_stats(sim, &stats);
+    TEST_ASSERT_TRUE(stats.late >= 1);
+    TEST_ASSERT_TRUE(tsc_clock_cycles_to_ns(stats.max_cycles) >= 3 * PERIOD_NS);
+}
+
+/// @test This test verifies that a producer masking the ISR thread around ring updates streams without corruption.
+void test_thread_streams_ring(void)
+{
+    uart_sim_config_t config = {.mode = UART_SIM_THREAD, .byte_period_ns = PERIOD_NS, .isr = ring_isr, .ctx = ring};
+    config.line = line;
+    config.line_size = STREAM_SIZE;
+    uint8_t data[STREAM_SIZE];
+    size_t written = 0;
+
+    for (size_t i = 0; i < STREAM_SIZE; i++) { data[i] = (uint8_t)(255 - i); }
+
+    sim = uart_sim_init(&config);
+    TEST_ASSERT_EQUAL_INT(0, uart_sim_start(sim));
+
+    uint64_t deadline = tsc_clock_now_ns() + TIMEOUT_NS;
+    while (written < STREAM_SIZE && tsc_clock_now_ns() < deadline) {
+        uart_sim_irq_disable(sim);
+        size_t room = RING_SIZE - ring_buffer_size(ring);
+        size_t chunk = (room < STREAM_SIZE - written) ? room : STREAM_SIZE - written;
+        ring_buffer_write(ring, &data[written], chunk);
+        uart_sim_irq_enable(sim);
+
+        written += chunk;
+        nap(4);
+    }
+
+    TEST_ASSERT_TRUE(wait_for_bytes(STREAM_SIZE));
+    uart_sim_stop(sim);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, line, STREAM_SIZE);
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,123 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_wait_strategy.c
+ ** @brief Test suite for the consumer wait strategies.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/wait_strategy/wait_strategy.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define SPIN_LIMIT 256
+
+/* === Private data type declarations ========================================================== */
+
+static wait_strategy_t strategy = NULL;
+static atomic_bool flag;
+
+/* === Private variable declarations =========================================================== */
+/* === Private function declarations =========================================================== */
+
+static bool flag_is_set(void* ctx);
+static void* delayed_setter(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static bool flag_is_set(void* ctx) { return atomic_load((atomic_bool*)ctx); }
+
+static void* delayed_setter(void* arg)
+{
+    wait_strategy_t ws = arg;
+
+    usleep(20000);
+    atomic_store(&flag, true);
+    wait_strategy_notify(ws);
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void)
+{
+    strategy = wait_strategy_init(WAIT_STRATEGY_ADAPTIVE, SPIN_LIMIT);
+    atomic_store(&flag, false);
+}
+
+void tearDown(void) { wait_strategy_deinit(&strategy); }
+
+/// @test This test verifies the initial state of a wait strategy.
+void test_initial_state(void)
+{
+    TEST_ASSERT_NOT_NULL(strategy);
+    TEST_ASSERT_EQUAL_INT(WAIT_STRATEGY_ADAPTIVE, wait_strategy_kind(strategy));
+    TEST_ASSERT_EQUAL_UINT(SPIN_LIMIT, wait_strategy_spin_limit(strategy));
+}
+
+/// @test This test verifies that waiting on a condition that already holds returns immediately, and that the adaptive
+/// budget shrinks towards the minimum when data is always there.
+void test_ready_condition_shrinks_budget(void)
+{
+    atomic_store(&flag, true);
+
+    for (size_t i = 0; i < 100; i++) { wait_strategy_wait(strategy, flag_is_set, &flag); }
+
+    TEST_ASSERT_EQUAL_UINT(WAIT_STRATEGY_MIN_SPINS, wait_strategy_spin_limit(strategy));
+}
+
+/// @test This test verifies that a parked consumer is woken up by wait_strategy_notify().
+void test_notify_wakes_parked_consumer(void)
+{
+    pthread_t setter;
+
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&setter, NULL, delayed_setter, strategy));
+
+    wait_strategy_wait(strategy, flag_is_set, &flag);
+    TEST_ASSERT(flag_is_set(&flag));
+
+    pthread_join(setter, NULL);
+
+    // The consumer had to park, so the adaptive budget must have been reduced.
+    TEST_ASSERT_LESS_THAN_UINT(SPIN_LIMIT, wait_strategy_spin_limit(strategy));
+}
+
+/// @test This test verifies that notifying a consumer that is not waiting has no effect.
+void test_notify_without_waiter(void)
+{
+    wait_strategy_notify(strategy);
+
+    atomic_store(&flag, true);
+    wait_strategy_wait(strategy, flag_is_set, &flag);
+    TEST_ASSERT(flag_is_set(&flag));
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,143 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_ws_deque.c
+ ** @brief Test suite for the Chase-Lev work-stealing deque.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unity.h>
+
+#include <utils/ws_deque/ws_deque.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define CAPACITY 8
+
+#define THIEF_COUNT 3
+
+#define ITEM_COUNT 20000
+
+/* === Private data type declarations ========================================================== */
+/* === Private variable declarations =========================================================== */
+
+static ws_deque_t deque = NULL;
+static uint8_t items[ITEM_COUNT];
+static atomic_uint taken[ITEM_COUNT];
+static atomic_bool owner_done;
+
+/* === Private function declarations =========================================================== */
+
+static void take(void* item);
+static void* thief_thread(void* arg);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void take(void* item) { atomic_fetch_add(&taken[(uint8_t*)item - items], 1); }
+
+static void* thief_thread(void* arg)
+{
+    (void)arg;
+
+    while (!atomic_load(&owner_done) || ws_deque_size(deque) > 0) {
+        void* item = ws_deque_steal(deque);
+        if (item) { take(item); }
+    }
+
+    return NULL;
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void) { deque = ws_deque_init(CAPACITY); }
+
+void tearDown(void) { ws_deque_deinit(&deque); }
+
+/// @test This test verifies that the owner pops in LIFO order and thieves steal in FIFO order.
+void test_pop_lifo_steal_fifo(void)
+{
+    TEST_ASSERT_NULL(ws_deque_pop(deque));
+    TEST_ASSERT_NULL(ws_deque_steal(deque));
+
+    for (size_t i = 0; i < 4; i++) { TEST_ASSERT_EQUAL_INT(0, ws_deque_push(deque, &items[i])); }
+    TEST_ASSERT_EQUAL_UINT(4, ws_deque_size(deque));
+
+    TEST_ASSERT_EQUAL_PTR(&items[3], ws_deque_pop(deque));
+    TEST_ASSERT_EQUAL_PTR(&items[0], ws_deque_steal(deque));
+    TEST_ASSERT_EQUAL_PTR(&items[2], ws_deque_pop(deque));
+    TEST_ASSERT_EQUAL_PTR(&items[1], ws_deque_steal(deque));
+
+    TEST_ASSERT_NULL(ws_deque_pop(deque));
+    TEST_ASSERT_EQUAL_UINT(0, ws_deque_size(deque));
+}
+
+/// @test This test verifies that a full deque refuses pushes, and accepts them again once there is room.
+void test_push_full_deque(void)
+{
+    for (size_t i = 0; i < CAPACITY; i++) { TEST_ASSERT_EQUAL_INT(0, ws_deque_push(deque, &items[i])); }
+    TEST_ASSERT_EQUAL_INT(-1, ws_deque_push(deque, &items[CAPACITY]));
+
+    TEST_ASSERT_EQUAL_PTR(&items[0], ws_deque_steal(deque));
+    TEST_ASSERT_EQUAL_INT(0, ws_deque_push(deque, &items[CAPACITY]));
+    TEST_ASSERT_EQUAL_PTR(&items[CAPACITY], ws_deque_pop(deque));
+}
+
+/// @test This test verifies that with the owner and several thieves racing, every item is taken exactly once.
+void test_concurrent_steal(void)
+{
+    pthread_t thieves[THIEF_COUNT];
+
+    atomic_store(&owner_done, false);
+    for (size_t i = 0; i < ITEM_COUNT; i++) { atomic_store(&taken[i], 0); }
+
+    for (size_t i = 0; i < THIEF_COUNT; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&thieves[i], NULL, thief_thread, NULL));
+    }
+
+    for (size_t i = 0; i < ITEM_COUNT; i++) {
+        while (ws_deque_push(deque, &items[i]) != 0) {
+            void* item = ws_deque_pop(deque);
+            if (item) { take(item); }
+        }
+        // Pop now and then, so the owner also races for the last item.
+        if ((i % 3) == 0) {
+            void* item = ws_deque_pop(deque);
+            if (item) { take(item); }
+        }
+    }
+
+    for (void* item = ws_deque_pop(deque); item; item = ws_deque_pop(deque)) { take(item); }
+    atomic_store(&owner_done, true);
+
+    for (size_t i = 0; i < THIEF_COUNT; i++) { pthread_join(thieves[i], NULL); }
+
+    for (size_t i = 0; i < ITEM_COUNT; i++) { TEST_ASSERT_EQUAL_UINT(1, atomic_load(&taken[i])); }
+}
+
+/* === End of documentation ==================================================================== */
@@ -0,0 +1,193 @@
+/************************************************************************************************
+Copyright (c) 2024, Leandro Soria <leandromsoria@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial
+portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+SPDX-License-Identifier: MIT
+*************************************************************************************************/
+
+/** @file test_ws_executor.c
+ ** @brief Test suite for the work-stealing executor.
+ **/
+
+/* === Headers files inclusions ================================================================ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <utils/ws_deque/ws_deque.h>
+#include <utils/ws_executor/ws_executor.h>
+
+/* === Macros definitions ====================================================================== */
+
+#define WORKER_COUNT 4
+
+#define PORT_COUNT 200
+
+#define RESUBMIT_COUNT 1000
+
+/* === Private data type declarations ========================================================== */
+
+/// Stand-in for a port: its task, how many times it ran and how many more times it reschedules itself.
+typedef struct
+{
+    ws_task_t task;
+    ws_executor_t executor;
+    atomic_uint runs;
+    unsigned int remaining;
+    unsigned int sleep_us;
+} port_t;
+
+/* === Private variable declarations =========================================================== */
+
+static ws_executor_t executor = NULL;
+static port_t ports[PORT_COUNT];
+static atomic_uint held;
+static atomic_bool release;
+
+/* === Private function declarations =========================================================== */
+
+static void process_port(void* ctx);
+static void hold_worker(void* ctx);
+/// Keeps a worker busy until `release` is set.
+static void hold_worker(void* ctx)
+{
+    (void)ctx;
+
+    atomic_fetch_add(&held, 1);
+    while (!atomic_load(&release)) { usleep(100); }
+}
+
+static void prepare_ports(unsigned int remaining, unsigned int home);
+
+/* === Public variable definitions ============================================================= */
+/* === Private variable definitions ============================================================ */
+/* === Private function implementation ========================================================= */
+
+static void process_port(void* ctx)
+{
+    port_t* port = ctx;
+
+    atomic_fetch_add(&port->runs, 1);
+    if (port->sleep_us) { usleep(port->sleep_us); }
+
+    if (port->remaining > 0) {
+        port->remaining--;
+        ws_executor_submit(port->executor, &port->task);
+    }
+}
+
+static void prepare_ports(unsigned int remaining, unsigned int home)
+{
+    for (unsigned int i = 0; i < PORT_COUNT; i++) {
+        ws_task_init(&ports[i].task, process_port, &ports[i], home == UINT32_MAX ? i : home);
+        ports[i].executor = executor;
+        atomic_store(&ports[i].runs, 0);
+        ports[i].remaining = remaining;
+        ports[i].sleep_us = 0;
+    }
+}
+
+/* === Public function implementation ========================================================== */
+
+void setUp(void) { executor = ws_executor_init(WORKER_COUNT); }
+
+void tearDown(void)
+{
+    ws_executor_deinit(&executor);
+    TEST_ASSERT_NULL(executor);
+}
+
+/// @test This test verifies that every task submitted from outside runs exactly once.
+void test_external_submissions_run_once(void)
+{
+    prepare_ports(0, UINT32_MAX);
+
+    for (size_t i = 0; i < PORT_COUNT; i++) { ws_executor_submit(executor, &ports[i].task); }
+    ws_executor_quiesce(executor);
+
+    for (size_t i = 0; i < PORT_COUNT; i++) { TEST_ASSERT_EQUAL_UINT(1, atomic_load(&ports[i].runs)); }
+}
+
+/// @test This test verifies that tasks resubmitted from inside the executor keep running until done.
+void test_resubmission_from_tasks(void)
+{
+    prepare_ports(0, UINT32_MAX);
+    ports[0].remaining = RESUBMIT_COUNT;
+    ports[1].remaining = RESUBMIT_COUNT / 2;
+
+    ws_executor_submit(executor, &ports[0].task);
+    ws_executor_submit(executor, &ports[1].task);
+    ws_executor_quiesce(executor);
+
+    TEST_ASSERT_EQUAL_UINT(RESUBMIT_COUNT + 1, atomic_load(&ports[0].runs));
+    TEST_ASSERT_EQUAL_UINT(RESUBMIT_COUNT / 2 + 1, atomic_load(&ports[1].runs));
+}
+
+/// @test This test verifies that idle workers steal from a busy one.
+void test_idle_workers_steal(void)
+{
+    // Every port lands on worker 0, and each takes a while.
+    prepare_ports(0, 0);
+    for (size_t i = 0; i < PORT_COUNT; i++) { ports[i].sleep_us = 200; }
+
+    for (size_t i = 0; i < PORT_COUNT; i++) { ws_executor_submit(executor, &ports[i].task); }
+    ws_executor_quiesce(executor);
+
+    for (size_t i = 0; i < PORT_COUNT; i++) { TEST_ASSERT_EQUAL_UINT(1, atomic_load(&ports[i].runs)); }
+    TEST_ASSERT_GREATER_THAN_UINT(0, ws_executor_steals(executor));
+
+    // Stolen ports now belong to their thief.
+    size_t moved = 0;
+    for (size_t i = 0; i < PORT_COUNT; i++) { moved += (atomic_load(&ports[i].task.worker) != 0); }
+    TEST_ASSERT_EQUAL_UINT(ws_executor_steals(executor), moved);
+}
+
+/// @test This test verifies that submitting a task that is still queued runs it once.
+void test_double_submission_runs_once(void)
+{
+    ws_task_t holders[WORKER_COUNT];
+
+    // Keep every worker busy, so the port stays queued while it is submitted again.
+    atomic_store(&held, 0);
+    atomic_store(&release, false);
+    for (unsigned int i = 0; i < WORKER_COUNT; i++) {
+        ws_task_init(&holders[i], hold_worker, NULL, i);
+        ws_executor_submit(executor, &holders[i]);
+    }
+    for (int i = 0; i < 10000 && atomic_load(&held) < WORKER_COUNT; i++) { usleep(100); }
+    TEST_ASSERT_EQUAL_UINT(WORKER_COUNT, atomic_load(&held));
+
+    prepare_ports(0, 0);
+    ws_executor_submit(executor, &ports[0].task);
+    ws_executor_submit(executor, &ports[0].task);
+    ws_executor_submit(executor, &ports[0].task);
+
+    atomic_store(&release, true);
+    ws_executor_quiesce(executor);
+    TEST_ASSERT_EQUAL_UINT(1, atomic_load(&ports[0].runs));
+
+    // Once it has run, it can be submitted again.
+    ws_executor_submit(executor, &ports[0].task);
+    ws_executor_quiesce(executor);
+    TEST_ASSERT_EQUAL_UINT(2, atomic_load(&ports[0].runs));
+}
+
+/* === End of documentation ==================================================================== */